@@ -7,14 +7,27 @@ use utf8;
 # A dedicated GTK theme management application for Linux Mint Cinnamon
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use JSON qw(encode_json decode_json);
 use Data::Dumper;
-use Digest::MD5 qw(md5_hex);
 use File::Basename;
 use File::HomeDir;
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::CssColorTable;
+use CinnamonSettings::SystemCache;
+use CinnamonSettings::PreviewCache;
+use CinnamonSettings::Session;
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::BudgetCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
+use CinnamonSettings::ArchivePreviewDialog;
+use CinnamonSettings::Prewarm;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -25,7 +38,9 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CinnamonApplicationThemesManager {
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
     use File::HomeDir;
+    use File::Basename qw(basename dirname);
 
     has 'window' => (is => 'rw');
     has 'directory_list' => (is => 'rw');
@@ -34,21 +49,60 @@ package CinnamonApplicationThemesManager {
     has 'themes_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
     has 'zoom_level' => (is => 'rw', default => sub { 300 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_widgets' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'themes_view' => (is => 'rw');
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
     has 'loading_box' => (is => 'rw');
     has 'current_directory' => (is => 'rw');
-    has 'cached_theme_lists' => (is => 'rw', default => sub { {} });
+    has 'cached_theme_lists' => (is => 'ro', default => sub {
+        CinnamonSettings::BudgetCache->new(name => 'theme lists', budget_bytes => 16 * 1024 * 1024)
+    });
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
     has 'current_theme' => (is => 'rw');
+    has 'preview_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::PreviewCache->new(
+            name => 'theme previews',
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-application-themes-manager/previews',
+        )
+    });
+    has 'css_colors' => (is => 'rw', default => sub {
+        CinnamonSettings::CssColorTable->new(
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-application-themes-manager/colors',
+            shared => CinnamonSettings::SystemCache->new(section => 'colors'),
+        )
+    });
+    has 'session' => (is => 'ro', default => sub {
+        CinnamonSettings::Session->new(app_name => 'cinnamon-application-themes-manager')
+    });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-application-themes-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-application-themes-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
+    has 'zoom_token' => (is => 'rw');
+    # Headless --prewarm run: configuration only, no windows
+    has 'prewarm' => (is => 'ro', default => sub { 0 });
+
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Frame address lookups into the current directory's view
+    sub theme_paths { $_[0]->view->paths }
+    sub theme_widgets { $_[0]->view->widgets }
 
     sub BUILD {
         my $self = shift;
         $self->_initialize_configuration();
+        return if $self->prewarm;
         $self->_setup_ui();
         $self->_populate_theme_directories();
         $self->_restore_last_selected_directory();
@@ -150,10 +204,11 @@ package CinnamonApplicationThemesManager {
         $control_container->set_margin_top(6);
         $control_container->set_margin_bottom(6);
 
-        my ($add_dir_button, $remove_dir_button) = $self->_create_directory_buttons();
+        my ($add_dir_button, $remove_dir_button, $archive_button) = $self->_create_directory_buttons();
 
         $control_container->pack_start($add_dir_button, 1, 1, 0);
         $control_container->pack_start($remove_dir_button, 1, 1, 0);
+        $control_container->pack_start($archive_button, 1, 1, 0);
 
         $left_container->pack_start($control_container, 0, 0, 0);
 
@@ -249,6 +304,7 @@ package CinnamonApplicationThemesManager {
         $self->window($window);
         $self->directory_list($directory_list);
         $self->themes_grid($themes_grid);
+        $self->themes_view($themes_view);
         $self->content_switcher($content_switcher);
         $self->themes_mode($themes_mode);
         $self->settings_mode($settings_mode);
@@ -257,13 +313,13 @@ package CinnamonApplicationThemesManager {
         $self->loading_box($loading_box);
 
         # Connect signals
-        $self->_connect_signals($add_dir_button, $remove_dir_button, $zoom_in, $zoom_out);
+        $self->_connect_signals($add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out);
 
         print "UI setup completed\n";
     }
 
     sub _connect_signals {
-        my ($self, $add_dir_button, $remove_dir_button, $zoom_in, $zoom_out) = @_;
+        my ($self, $add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out) = @_;
 
         # Connect signals for mode buttons
         $self->_connect_mode_button_signals($self->themes_mode, $self->settings_mode, $self->content_switcher);
@@ -276,7 +332,7 @@ package CinnamonApplicationThemesManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_themes_from_directory_async($row);
@@ -290,13 +346,17 @@ package CinnamonApplicationThemesManager {
             $self->_remove_theme_directory();
         });
 
+        $archive_button->signal_connect('clicked' => sub {
+            $self->_preview_theme_archive();
+        });
+
         $zoom_in->signal_connect('clicked' => sub {
             my $new_zoom = ($self->zoom_level < 600) ? $self->zoom_level + 50 : 600;
             $self->zoom_level($new_zoom);
             $self->_update_theme_zoom_async();
             # Save zoom level to config
             $self->config->{preview_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $zoom_out->signal_connect('clicked' => sub {
@@ -305,7 +365,7 @@ package CinnamonApplicationThemesManager {
             $self->_update_theme_zoom_async();
             # Save zoom level to config
             $self->config->{preview_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $self->themes_grid->signal_connect('child-activated' => sub {
@@ -313,11 +373,32 @@ package CinnamonApplicationThemesManager {
             $self->_set_gtk_theme($child);
         });
 
+        # Realistic previews are refined for visible and hovered cards only
+        $self->themes_grid->add_events(['pointer-motion-mask']);
+        $self->themes_grid->signal_connect('motion-notify-event' => sub {
+            my ($widget, $event) = @_;
+            my $child = $widget->get_child_at_pos($event->x, $event->y);
+            my $frame = $child ? $child->get_child() : undef;
+            if ($frame && (!$self->{hovered_theme_frame} || $self->{hovered_theme_frame} != $frame)) {
+                $self->{hovered_theme_frame} = $frame;
+                $self->_kick_preview_refinement();
+            }
+            return 0;
+        });
+
+        $self->themes_view->get_vadjustment()->signal_connect('value-changed' => sub {
+            $self->_kick_preview_refinement();
+        });
+
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
             # Clean up any running background processes
             $self->_cleanup_background_processes();
+            $self->session->report_stats();
+            $self->preview_cache->report_stats();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -604,7 +685,7 @@ package CinnamonApplicationThemesManager {
             shift @{$self->config->{theme_backups}};
         }
 
-        $self->_save_config($self->config);
+        $self->config_store->save();
 
         my $dialog = Gtk3::MessageDialog->new(
             $self->window,
@@ -636,7 +717,108 @@ package CinnamonApplicationThemesManager {
         my $remove_icon = Gtk3::Image->new_from_icon_name('list-remove-symbolic', 1);
         $remove_button->add($remove_icon);
 
-        return ($add_button, $remove_button);
+        my $archive_button = Gtk3::Button->new();
+        $archive_button->set_relief('none');
+        $archive_button->set_size_request(32, 32);
+        $archive_button->set_tooltip_text('Preview and install a theme archive');
+
+        my $archive_icon = Gtk3::Image->new_from_icon_name('package-x-generic-symbolic', 1);
+        $archive_button->add($archive_icon);
+
+        return ($add_button, $remove_button, $archive_button);
+    }
+
+    # Preview a downloaded GTK theme archive from its stylesheets and
+    # thumbnail, read into memory, and install it into ~/.themes once
+    # confirmed
+    sub _preview_theme_archive {
+        my $self = shift;
+
+        my $themes_dir = File::HomeDir->my_home . '/.themes';
+
+        CinnamonSettings::ArchivePreviewDialog->new(
+            parent => $self->window,
+            session => $self->session,
+            kind => 'gtk',
+            install_dir => $themes_dir,
+            render => sub { $self->_render_archive_theme(@_) },
+            on_installed => sub {
+                $self->cached_theme_lists->remove($themes_dir);
+                my $row = $self->directory_list->get_selected_row();
+                if ($row && ($self->directory_paths->{$row + 0} // '') eq $themes_dir) {
+                    $self->{last_loaded_directory} = undef;
+                    $self->_load_themes_from_directory_async($row);
+                }
+            },
+        )->run();
+    }
+
+    sub _render_archive_theme {
+        my ($self, $archive, $theme) = @_;
+
+        my $box = Gtk3::Box->new('vertical', 12);
+
+        foreach my $thumbnail ('gtk-3.0/thumbnail.png', 'thumbnail.png') {
+            my $data = $archive->theme_member($theme, $thumbnail);
+            next unless defined $data;
+            my $pixbuf = eval {
+                my $loader = Gtk3::Gdk::PixbufLoader->new();
+                $loader->write($data);
+                $loader->close();
+                $loader->get_pixbuf();
+            };
+            next unless $pixbuf;
+            $box->pack_start(Gtk3::Image->new_from_pixbuf($pixbuf), 0, 0, 0);
+            last;
+        }
+
+        # The stylesheets are only in memory, so the table is built from
+        # there and not kept in the on-disk color cache
+        my $css_file = length $theme->{root} ? "$theme->{root}/gtk-3.0/gtk.css" : 'gtk-3.0/gtk.css';
+        my $table = $self->css_colors->build_table($css_file, $archive->theme_members($theme));
+        my $colors = $self->css_colors;
+
+        my $bg = $colors->define_color($table, qw(theme_bg_color bg_color window_bg_color base_color))
+            || $colors->selector_color($table, 'window', 'background') || [0.98, 0.98, 0.98];
+        my $fg = $colors->define_color($table, qw(theme_fg_color fg_color)) || $table->{first}{color} || [0.2, 0.2, 0.2];
+        my $selected = $colors->define_color($table, qw(theme_selected_bg_color selected_bg_color))
+            || $colors->selector_color($table, 'suggested_action', 'background') || $self->_get_system_selection_color();
+        my $headerbar = $colors->selector_color($table, 'headerbar', 'background') || $bg;
+        my $button = $colors->selector_color($table, 'button', 'background') || $bg;
+
+        my $sample = Gtk3::DrawingArea->new();
+        $sample->set_size_request(360, 180);
+        $sample->signal_connect(draw => sub {
+            my ($widget, $cr) = @_;
+            my ($width, $height) = ($widget->get_allocated_width(), $widget->get_allocated_height());
+
+            $cr->set_source_rgb(@$bg);
+            $cr->rectangle(0, 0, $width, $height);
+            $cr->fill();
+            $cr->set_source_rgb(@$headerbar);
+            $cr->rectangle(0, 0, $width, 36);
+            $cr->fill();
+            $cr->set_source_rgb(@$button);
+            $cr->rectangle(16, 56, 96, 32);
+            $cr->fill();
+            $cr->set_source_rgb(@$selected);
+            $cr->rectangle(0, 108, $width, 28);
+            $cr->fill();
+
+            $cr->set_source_rgb(@$fg);
+            $cr->select_font_face('Sans', 'normal', 'normal');
+            $cr->set_font_size(13);
+            $cr->move_to(16, 23);
+            $cr->show_text($theme->{display_name});
+            $cr->move_to(36, 77);
+            $cr->show_text('Button');
+            $cr->move_to(16, 156);
+            $cr->show_text('Window text');
+            return 0;
+        });
+        $box->pack_start($sample, 0, 0, 0);
+
+        return $box;
     }
 
     sub _create_zoom_buttons {
@@ -698,36 +880,29 @@ package CinnamonApplicationThemesManager {
     sub _populate_theme_directories {
         my $self = shift;
 
-        my $home = File::HomeDir->my_home;
-
-        # Default GTK theme directories
-        my @default_dirs = (
-            { name => 'System Themes', path => '/usr/share/themes' },
-            { name => 'User Themes',   path => "$home/.themes" },
-            { name => 'Local Themes',  path => "$home/.local/share/themes" },
-        );
-
-        # Add default directories
-        foreach my $dir_info (@default_dirs) {
-            next unless -d $dir_info->{path};
-
+        foreach my $dir_info ($self->_theme_directories()) {
             my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
+            $self->directory_view->track($row, $dir_info->{path});
             $self->directory_list->add($row);
         }
 
-        # Add custom directories from config
-        if ($self->config->{custom_directories}) {
-            foreach my $custom_dir (@{$self->config->{custom_directories}}) {
-                next unless -d $custom_dir->{path};
+        print "Populated theme directories\n";
+    }
 
-                my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
-                $self->directory_list->add($row);
-            }
-        }
+    # Default GTK theme directories followed by custom ones from the
+    # config, as far as they exist
+    sub _theme_directories {
+        my $self = shift;
 
-        print "Populated theme directories\n";
+        my $home = File::HomeDir->my_home;
+        my @dirs = (
+            { name => 'System Themes', path => '/usr/share/themes' },
+            { name => 'User Themes',   path => "$home/.themes" },
+            { name => 'Local Themes',  path => "$home/.local/share/themes" },
+            @{$self->config->{custom_directories} || []},
+        );
+
+        return grep { -d $_->{path} } @dirs;
     }
 
 
@@ -834,23 +1009,34 @@ package CinnamonApplicationThemesManager {
         my $flowbox = $self->themes_grid;
         foreach my $child ($flowbox->get_children()) {
             $flowbox->remove($child);
+            $child->destroy();
         }
 
         # Clear references
-        $self->theme_paths({});
-        $self->theme_widgets({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
         $self->current_directory($dir_path);
 
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Widget creation still queued for the previous directory is stale
+        $self->scheduler->cancel($self->load_token);
+        $self->scheduler->cancel($self->zoom_token);
+        $self->load_token($self->scheduler->new_token());
+
+        # Theme files are fingerprinted again on every directory load
+        $self->{theme_fingerprints} = {};
+
         # Get or scan themes
         my $themes_ref;
-        if (exists $self->cached_theme_lists->{$dir_path}) {
-            $themes_ref = $self->cached_theme_lists->{$dir_path};
+        if ($self->cached_theme_lists->contains($dir_path)) {
+            $themes_ref = $self->cached_theme_lists->get($dir_path);
             print "Using cached theme list for $dir_path (" . @$themes_ref . " themes)\n";
         } else {
             my @themes = $self->_scan_gtk_themes($dir_path);
             @themes = sort { lc($a->{name}) cmp lc($b->{name}) } @themes;
             $themes_ref = \@themes;
-            $self->cached_theme_lists->{$dir_path} = $themes_ref;
+            $self->cached_theme_lists->set($dir_path, $themes_ref);
             print "Scanned $dir_path: " . @themes . " GTK themes found\n";
         }
 
@@ -873,127 +1059,39 @@ package CinnamonApplicationThemesManager {
 
         print "Starting progressive loading of $total_themes themes\n";
 
-        # Initialize progress tracking
-        $self->{preview_progress} = {
-            total => $total_themes,
-            loaded_widgets => 0,
-            completed_previews => 0,
-            active_generations => 0,
-            max_parallel => 3,  # Generate 3 previews simultaneously
-            generation_queue => [],
-            dir_path => $dir_path
-        };
+        # Realistic refinements queued for the previous directory are stale
+        $self->_reset_preview_refinement();
 
-        # Phase 1: Quickly create all theme widgets with placeholders
+        # Every card gets its instant Cairo preview while it is created
         $self->_update_loading_progress("Creating theme widgets...", 0);
 
-        my $create_widgets;
-        $create_widgets = sub {
-            return 0 if $self->current_directory ne $dir_path;  # Directory changed
-
-            my $batch_size = 8;
-            my $batch_end = ($loaded_widgets + $batch_size - 1 < $total_themes - 1)
-                        ? $loaded_widgets + $batch_size - 1
-                        : $total_themes - 1;
-
-            # Create widgets for this batch
-            for my $i ($loaded_widgets..$batch_end) {
-                my $theme_info = $themes_ref->[$i];
+        $self->scheduler->foreach_item(
+            label => 'gtk themes: create theme widgets',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $self->load_token,
+            items => $themes_ref,
+            each => sub {
+                my $theme_info = shift;
 
-                # Create widget with placeholder preview
+                # Create widget with its instant preview
                 my $theme_widget = $self->_create_theme_widget_with_placeholder($theme_info);
                 $self->themes_grid->add($theme_widget);
-
-                # Add to preview generation queue
-                push @{$self->{preview_progress}->{generation_queue}}, {
-                    theme_info => $theme_info,
-                    widget => $theme_widget,
-                    index => $i
-                };
-            }
-
-            $loaded_widgets = $batch_end + 1;
-            $self->{preview_progress}->{loaded_widgets} = $loaded_widgets;
-
-            # Update progress
-            my $widget_progress = int(($loaded_widgets / $total_themes) * 30);  # 30% for widget creation
-            $self->_update_loading_progress("Creating theme widgets...", $widget_progress);
-
-            $self->themes_grid->show_all();
-
-            if ($loaded_widgets < $total_themes) {
-                # Continue with next batch
-                Glib::Timeout->add(10, $create_widgets);
-                return 0;
-            } else {
-                # Widget creation complete, start preview generation
-                print "All widgets created, starting parallel preview generation\n";
-                $self->_start_parallel_preview_generation();
-                return 0;
-            }
-        };
-
-        # Start widget creation
-        Glib::Timeout->add(10, $create_widgets);
-    }
-
-    sub _start_parallel_preview_generation {
-        my $self = shift;
-
-        my $progress = $self->{preview_progress};
-        return unless $progress;
-
-        print "Starting parallel preview generation (max " . $progress->{max_parallel} . " concurrent)\n";
-
-        # Start initial parallel workers
-        for my $worker_id (0..$progress->{max_parallel}-1) {
-            $self->_start_preview_worker($worker_id);
-        }
-
-        # Start progress monitor
-        $self->_start_progress_monitor();
-    }
-
-    sub _start_preview_worker {
-        my ($self, $worker_id) = @_;
-
-        my $progress = $self->{preview_progress};
-        return unless $progress && @{$progress->{generation_queue}};
-
-        # Get next item from queue
-        my $item = shift @{$progress->{generation_queue}};
-        return unless $item;
-
-        $progress->{active_generations}++;
-
-        print "Worker $worker_id: Starting preview for " . $item->{theme_info}->{name} . "\n";
-
-        # Generate preview in background
-        Glib::Timeout->add(50, sub {
-            return 0 if $self->current_directory ne $progress->{dir_path};
-
-            my $success = $self->_generate_theme_preview_fast($item->{theme_info}, $item->{widget});
-
-            # Update progress
-            $progress->{completed_previews}++;
-            $progress->{active_generations}--;
-
-            my $preview_progress = 30 + int(($progress->{completed_previews} / $progress->{total}) * 70);
-            $self->_update_loading_progress(
-                "Generating previews... (" . $progress->{completed_previews} . "/" . $progress->{total} . ")",
-                $preview_progress
-            );
-
-            print "Worker $worker_id: Completed " . $item->{theme_info}->{name} . " (" .
-                $progress->{completed_previews} . "/" . $progress->{total} . ")\n";
-
-            # Start next item if available
-            if (@{$progress->{generation_queue}}) {
-                $self->_start_preview_worker($worker_id);
-            }
-
-            return 0;
-        });
+                $theme_widget->show_all();
+
+                $loaded_widgets++;
+
+                # Update progress
+                my $widget_progress = int(($loaded_widgets / $total_themes) * 100);
+                $self->_update_loading_progress("Creating theme previews...", $widget_progress);
+            },
+            on_done => sub {
+                # Grid complete; realistic refinement continues at low priority
+                print "All $total_themes theme previews shown\n";
+                delete $self->{load_span};
+                $self->_hide_loading_indicator();
+                $self->_kick_preview_refinement();
+            },
+        );
     }
 
     sub _create_theme_widget_with_placeholder {
@@ -1012,9 +1110,22 @@ package CinnamonApplicationThemesManager {
         $box->set_margin_top(6);
         $box->set_margin_bottom(6);
 
-        # Create placeholder preview (fast)
-        my $placeholder = $self->_create_fast_placeholder($theme_info);
-        $placeholder->set_size_request($self->zoom_level, int($self->zoom_level * 0.75));
+        # Use the cached realistic preview when there is one, otherwise the
+        # instant in-process Cairo rendering of the theme colors
+        my $width = $self->zoom_level;
+        my $height = int($self->zoom_level * 0.75);
+        my $realistic_path = $self->_get_realistic_preview_path($theme_info);
+        my ($pixbuf, $tier);
+        if ($self->_is_realistic_preview_current($realistic_path)) {
+            $pixbuf = eval { Gtk3::Gdk::Pixbuf->new_from_file_at_scale($realistic_path, $width, $height, 1) };
+            $tier = 'gtk' if $pixbuf;
+        }
+        unless ($pixbuf) {
+            $pixbuf = $self->_create_instant_preview_pixbuf($theme_info, $width, $height);
+            $tier = 'cairo';
+        }
+        my $placeholder = Gtk3::Image->new_from_pixbuf($pixbuf);
+        $placeholder->set_size_request($width, $height);
 
         $box->pack_start($placeholder, 1, 1, 0);
 
@@ -1028,75 +1139,200 @@ package CinnamonApplicationThemesManager {
         $frame->add($box);
 
         # Store references - use frame as key like backgrounds manager
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $placeholder;
+        $self->view->track($frame, $theme_info, $placeholder);
+
+        $self->_queue_preview_refinement($theme_info, $frame) if $tier eq 'cairo';
 
         return $frame;
     }
 
-    sub _create_fast_placeholder {
+    sub _create_instant_preview_pixbuf {
+        my ($self, $theme_info, $width, $height) = @_;
+
+        my $span = TRACING && trace_span('instant gtk preview', theme => $theme_info->{name});
+
+        # Colors come from the cached per-theme color table, so this is cheap
+        my $colors = $self->_extract_comprehensive_theme_colors($theme_info);
+        my $surface = $self->_render_enhanced_cairo_surface($colors, $width, $height);
+
+        return Gtk3::Gdk::pixbuf_get_from_surface($surface, 0, 0, $width, $height);
+    }
+
+    sub _get_realistic_preview_path {
+        my ($self, $theme_info, $size) = @_;
+
+        $size //= $self->zoom_level;
+
+        # Keyed by theme location, theme content and render size, so a preview
+        # lives exactly as long as the theme files it was rendered from
+        return $self->preview_cache->path_for(CinnamonSettings::PreviewCache->key(
+            $theme_info->{path}, $self->_get_theme_fingerprint($theme_info), "-$size.png"
+        ));
+    }
+
+    sub _get_theme_fingerprint {
         my ($self, $theme_info) = @_;
 
-        # Quick background color detection
-        my $bg_color = $self->_extract_theme_background_color_fast($theme_info);
+        my $theme_path = $theme_info->{path};
+        my $gtk_dir = "$theme_path/gtk-3.0";
+
+        # The color table records every stylesheet and bundle the parser read,
+        # @imports outside gtk-3.0 included, and is rebuilt when one changes
+        my $table = $self->_get_theme_color_table($theme_info);
+
+        # Reused until the gtk-3.0 directory or one of those sources changes,
+        # so a theme edited while the manager runs gets a new key
+        my $dir_mtime = (stat($gtk_dir))[9] // 0;
+        my $fingerprints = $self->{theme_fingerprints} ||= {};
+        my $known = $fingerprints->{$theme_path};
+        return $known->[2] if $known && $known->[0] == $dir_mtime && ($known->[1] // 0) == ($table // 0);
+
+        # Names, mtimes and sizes of the gtk-3.0 files (stylesheets and any
+        # compiled gtk.gresource bundle) and of the imported files elsewhere
+        # identify the rendered content
+        my @parts;
+        if (opendir(my $dh, $gtk_dir)) {
+            foreach my $entry (sort readdir($dh)) {
+                next if $entry =~ /^\./;
+                my @st = stat("$gtk_dir/$entry");
+                next unless @st && -f _;
+                push @parts, "$entry:$st[9]:$st[7]";
+            }
+            closedir($dh);
+        }
+        if ($table && $table->{sources}) {
+            foreach my $source (sort keys %{$table->{sources}}) {
+                next if dirname($source) eq $gtk_dir;
+                push @parts, join(':', $source, @{$table->{sources}{$source}});
+            }
+        }
 
-        # Create simple colored rectangle
-        my $width = $self->zoom_level;
-        my $height = int($self->zoom_level * 0.75);
+        my $fingerprint = join('|', $theme_path, @parts);
+        $fingerprints->{$theme_path} = [$dir_mtime, $table, $fingerprint];
+        return $fingerprint;
+    }
 
-        my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
-        my $cr = Cairo::Context->create($surface);
+    sub _is_realistic_preview_current {
+        my ($self, $preview_path) = @_;
 
-        # Fill with theme background color
-        $cr->set_source_rgb(@$bg_color);
-        $cr->rectangle(0, 0, $width, $height);
-        $cr->fill();
+        # The fingerprinted name already encodes freshness; no time-based expiry
+        return $self->preview_cache->lookup(basename($preview_path)) ? 1 : 0;
+    }
 
-        # Add subtle border
-        $cr->set_source_rgb(0.7, 0.7, 0.7);
-        $cr->set_line_width(1);
-        $cr->rectangle(0.5, 0.5, $width - 1, $height - 1);
-        $cr->stroke();
+    # Account for a render a helper process wrote; renders of older theme
+    # content are no longer looked up and age out of the disk budget
+    sub _adopt_realistic_preview {
+        my ($self, $preview_path) = @_;
 
-        # Convert to pixbuf
-        $surface->write_to_png("/tmp/fast_placeholder_$$.png");
-        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file("/tmp/fast_placeholder_$$.png");
-        unlink("/tmp/fast_placeholder_$$.png");
+        $self->session->note_file_created();
+        $self->preview_cache->adopt(basename($preview_path));
+    }
+
+    sub _reset_preview_refinement {
+        my $self = shift;
 
-        return Gtk3::Image->new_from_pixbuf($pixbuf);
+        my $refine = $self->{preview_refinement} ||= { queue => [], active => 0, max_parallel => 2 };
+        $refine->{queue} = [];
+        delete $self->{hovered_theme_frame};
     }
 
-    sub _extract_theme_background_color_fast {
-        my ($self, $theme_info) = @_;
+    sub _queue_preview_refinement {
+        my ($self, $theme_info, $frame) = @_;
 
-        # Fast color detection - just basic patterns
-        my $theme_name = $theme_info->{name};
+        # Realistic GTK renders are optional; the Cairo preview stays otherwise
+        return unless $self->config->{realistic_previews};
+
+        $self->_reset_preview_refinement() unless $self->{preview_refinement};
+        my $queue = $self->{preview_refinement}->{queue};
+        return if grep { $_->{frame} == $frame && $_->{size} == $self->zoom_level } @$queue;
 
-        # Quick theme name-based detection
-        if ($theme_name =~ /dark|noir|black/i) {
-            return [0.22, 0.22, 0.22];  # Dark theme
-        } elsif ($theme_name =~ /mint/i) {
-            return [0.96, 0.96, 0.96];  # Mint light
-        } elsif ($theme_name =~ /adwaita/i) {
-            return [0.98, 0.98, 0.98];  # Adwaita light
+        push @$queue, {
+            theme_info => $theme_info,
+            frame => $frame,
+            size => $self->zoom_level,
+        };
+    }
+
+    sub _kick_preview_refinement {
+        my $self = shift;
+
+        my $refine = $self->{preview_refinement};
+        return unless $refine && @{$refine->{queue}} && !$refine->{task};
+
+        # Low priority so creating widgets, scrolling and drawing come first
+        $refine->{task} = $self->scheduler->defer(
+            label => 'gtk themes: refine previews',
+            priority => CinnamonSettings::Scheduler::PRIORITY_LOW,
+            run => sub {
+                delete $refine->{task};
+                $self->_run_preview_refinement();
+            },
+        );
+    }
+
+    sub _run_preview_refinement {
+        my $self = shift;
+
+        my $refine = $self->{preview_refinement} or return;
+
+        while ($refine->{active} < $refine->{max_parallel}) {
+            my $item = $self->_take_refinement_candidate() or last;
+
+            $refine->{active}++;
+            my $preview_path = $self->_get_realistic_preview_path($item->{theme_info}, $item->{size});
+            print "Refining preview for visible theme: " . $item->{theme_info}->{name} . "\n";
+
+            $self->_generate_preview_async($item->{theme_info}, $item->{frame}, $preview_path, $item->{size}, sub {
+                $refine->{active}--;
+                $self->_kick_preview_refinement();
+            });
         }
+    }
 
-        # Default light theme
-        return [0.95, 0.95, 0.95];
+    sub _take_refinement_candidate {
+        my $self = shift;
+
+        my $refine = $self->{preview_refinement};
+        my $queue = $refine->{queue};
+
+        # Drop entries for cards that were removed or re-rendered at another size
+        @$queue = grep {
+            $self->theme_paths->{$_->{frame} + 0} && $_->{size} == $self->zoom_level
+        } @$queue;
+
+        my $hovered = $self->{hovered_theme_frame};
+        for my $i (0 .. $#$queue) {
+            return splice(@$queue, $i, 1) if $hovered && $queue->[$i]->{frame} == $hovered;
+        }
+        for my $i (0 .. $#$queue) {
+            return splice(@$queue, $i, 1) if CinnamonSettings::ViewState->frame_visible($queue->[$i]->{frame}, $self->themes_view);
+        }
+
+        return undef;
     }
 
     sub _update_widget_preview {
         my ($self, $widget_container, $preview_path) = @_;
 
         # Load new theme preview
-        my $new_preview = eval {
-            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale(
+        my $pixbuf = eval {
+            Gtk3::Gdk::Pixbuf->new_from_file_at_scale(
                 $preview_path, $self->zoom_level, int($self->zoom_level * 0.75), 1
             );
-            return $pixbuf ? Gtk3::Image->new_from_pixbuf($pixbuf) : undef;
         };
 
-        return unless $new_preview && !$@;
+        return unless $pixbuf && !$@;
+
+        $self->_set_widget_preview_pixbuf($widget_container, $pixbuf);
+    }
+
+    sub _set_widget_preview_pixbuf {
+        my ($self, $widget_container, $pixbuf) = @_;
+
+        # Card may have been removed by a directory switch meanwhile
+        return unless $self->theme_paths->{$widget_container + 0};
+
+        my $new_preview = Gtk3::Image->new_from_pixbuf($pixbuf);
 
         # Get the box container from the frame
         my $box = $widget_container->get_child();
@@ -1111,7 +1347,7 @@ package CinnamonApplicationThemesManager {
         $box->show_all();
 
         # Update reference
-        $self->theme_widgets->{$widget_container + 0} = $new_preview;
+        $self->view->set_widget($widget_container, $new_preview);
 
         print "Updated theme preview for widget\n";
     }
@@ -1170,6 +1406,53 @@ package CinnamonApplicationThemesManager {
         return @themes;
     }
 
+    # Headless --prewarm: build every theme's color table and, when a
+    # display is available for the GTK helper, its realistic preview at the
+    # configured size
+    sub prewarm_caches {
+        my ($self, @dirs) = @_;
+
+        my $prewarm = CinnamonSettings::Prewarm->new(app_name => 'cinnamon-application-themes-manager');
+        $prewarm->lower_priority();
+        @dirs = map { $_->{path} } $self->_theme_directories() unless @dirs;
+
+        my $render = $ENV{DISPLAY} || $ENV{WAYLAND_DISPLAY};
+        $prewarm->note("no display, only color tables are built") unless $render;
+
+        my $size = $self->zoom_level;
+        foreach my $dir_path (grep { -d } @dirs) {
+            my @themes = $self->_scan_gtk_themes($dir_path);
+            $prewarm->note("$dir_path: " . @themes . " GTK themes");
+
+            foreach my $theme_info (@themes) {
+                $prewarm->add($theme_info->{name}, sub { $self->_prewarm_theme_preview($theme_info, $size, $render) });
+            }
+        }
+
+        return $prewarm->run();
+    }
+
+    sub _prewarm_theme_preview {
+        my ($self, $theme_info, $size, $render) = @_;
+
+        # color_table() keeps a current table and rebuilds a stale one
+        my $table_file = $self->css_colors->cache_file_for("$theme_info->{path}/gtk-3.0/gtk.css");
+        my $before = $table_file && (stat($table_file))[9];
+        $self->_get_theme_color_table($theme_info);
+        my $after = $table_file && (stat($table_file))[9];
+        my $result = $after && (!$before || $before != $after) ? 'created' : 'current';
+        return $result unless $render;
+
+        # The render _run_preview_refinement would request for a visible card
+        my $preview_path = $self->_get_realistic_preview_path($theme_info, $size);
+        return $result if $self->_is_realistic_preview_current($preview_path);
+
+        my $script = $self->_create_improved_preview_script(
+            $theme_info->{name}, $theme_info->{path}, $preview_path, $size, int($size * 0.75)
+        );
+        return $self->_run_preview_script($script, $preview_path, 30) ? 'created' : 'failed';
+    }
+
     sub _parse_theme_info {
         my ($self, $theme_path, $theme_name) = @_;
 
@@ -1208,11 +1491,7 @@ package CinnamonApplicationThemesManager {
         my $width = $size;
         my $height = int($size * 0.75);
 
-        # Preview cache directory
-        $self->{preview_cache_dir} //= "$ENV{HOME}/.local/share/cinnamon-application-themes-manager/previews";
-        system("mkdir -p '$self->{preview_cache_dir}'") unless -d $self->{preview_cache_dir};
-
-        my $preview_path = "$self->{preview_cache_dir}/${theme_name}-preview.png";
+        my $preview_path = $self->_get_realistic_preview_path($theme_info, $width);
 
     # Try to load existing preview first
         my $preview_widget;
@@ -1286,7 +1565,7 @@ package CinnamonApplicationThemesManager {
     }
 
     sub _generate_preview_async {
-        my ($self, $theme_info, $widget_container, $preview_path, $size) = @_;
+        my ($self, $theme_info, $widget_container, $preview_path, $size, $on_done) = @_;
 
         my $theme_name = $theme_info->{name};
         my $theme_path = $theme_info->{path};
@@ -1298,200 +1577,78 @@ package CinnamonApplicationThemesManager {
             $theme_name, $theme_path, $preview_path, $size, int($size * 0.75)
         );
 
-        # Write script to temporary file
-        my $script_path = "/tmp/preview_${$}_${theme_name}_" . time() . ".pl";
-        $script_path =~ s/[^a-zA-Z0-9_\/\-\.]/_/g;  # Sanitize filename
+        # The script is piped to the helper's stdin and its output comes back
+        # over a pipe, so nothing is written to /tmp and no polling is needed
+        my $pid = $self->session->spawn_perl(
+            script => $script_content,
+            label => 'gtk preview',
+            timeout => 30,
+            on_exit => sub {
+                my ($exit_code, $output) = @_;
+                $self->_finish_preview_generation($preview_path, $widget_container, $theme_name, $exit_code, $output);
+                $on_done->() if $on_done;
+            },
+        );
 
-        open my $fh, '>', $script_path or do {
-            print "ERROR: Cannot create preview script: $!\n";
+        unless ($pid) {
+            print "ERROR: Cannot start preview helper: $!\n";
+            $on_done->() if $on_done;
             return 0;
-        };
-        print $fh $script_content;
-        close $fh;
-        chmod 0755, $script_path;
+        }
 
-        print "Created script: $script_path\n";
+        print "Started background preview generation for $theme_name (pid $pid)\n";
         print "Target preview: $preview_path\n";
 
-        # Create a log file for debugging
-        my $log_path = "/tmp/preview_${$}_${theme_name}_" . time() . ".log";
-        $log_path =~ s/[^a-zA-Z0-9_\/\-\.]/_/g;
-
-        # Start background process with logging
-        my $cmd = "timeout 30s perl '$script_path' > '$log_path' 2>&1 &";
-        print "Executing: $cmd\n";
-        system($cmd);
-
-        print "Started background preview generation for $theme_name\n";
-
-        # Monitor for completion using a timer
-        $self->_monitor_preview_file($preview_path, $widget_container, $theme_name, $script_path, $log_path);
-
         return 1;
     }
 
-    sub _monitor_preview_file {
-        my ($self, $preview_path, $widget_container, $theme_name, $script_path, $log_path) = @_;
-
-        my $check_count = 0;
-        my $max_checks = 60;  # Check for 30 seconds (60 * 500ms)
-
-        my $monitor;
-        $monitor = sub {
-            $check_count++;
+    sub _finish_preview_generation {
+        my ($self, $preview_path, $widget_container, $theme_name, $exit_code, $output) = @_;
 
-            print "Checking preview for $theme_name (attempt $check_count)\n";
+        # Check if preview file exists and has content
+        if ($exit_code == 0 && -f $preview_path && -s $preview_path > 1000) {
+            print "Preview completed for $theme_name (file size: " . (-s $preview_path) . " bytes)\n";
+            $self->_adopt_realistic_preview($preview_path);
 
-            # Check if preview file exists and has content
-            if (-f $preview_path && -s $preview_path > 1000) {
-                print "Preview completed for $theme_name (file size: " . (-s $preview_path) . " bytes)\n";
-
-                # Update the widget preview
-                $self->_update_widget_preview($widget_container, $preview_path);
-
-                # Clean up files
-                unlink $script_path if -f $script_path;
-                unlink $log_path if -f $log_path;
-
-                return 0;  # Stop monitoring
-            }
-
-            # Check if we've exceeded max wait time
-            if ($check_count >= $max_checks) {
-                print "Preview generation timed out for $theme_name\n";
-
-                # Show error log if available
-                if (-f $log_path && -s $log_path) {
-                    print "Error log for $theme_name:\n";
-                    open my $log_fh, '<', $log_path;
-                    while (my $line = <$log_fh>) {
-                        print "  $line";
-                    }
-                    close $log_fh;
-                } else {
-                    print "No log file found for $theme_name\n";
-                }
-
-                # Clean up files
-                unlink $script_path if -f $script_path;
-                unlink $log_path if -f $log_path;
-
-                return 0;  # Stop monitoring
-            }
+            # Update the widget preview
+            $self->_update_widget_preview($widget_container, $preview_path);
+            return;
+        }
 
-            # Continue monitoring
-            Glib::Timeout->add(500, $monitor);
-            return 0;
-        };
+        print $exit_code == 124
+            ? "Preview generation timed out for $theme_name\n"
+            : "Preview generation failed for $theme_name (exit $exit_code)\n";
 
-        # Start monitoring after a brief delay
-        Glib::Timeout->add(500, $monitor);
+        if (length $output) {
+            print "Helper output for $theme_name:\n";
+            print "  $_\n" for split /\n/, $output;
+        }
     }
 
     sub _generate_theme_preview_fast {
         my ($self, $theme_info, $widget_container) = @_;
 
         my $size = $self->zoom_level;
-        my $cache_dir = $self->{preview_cache_dir} || "$ENV{HOME}/.local/share/cinnamon-application-themes-manager/previews";
-        system("mkdir -p '$cache_dir'") unless -d $cache_dir;
+        my $preview_path = $self->_get_realistic_preview_path($theme_info);
 
-        my $preview_path = "$cache_dir/" . $theme_info->{name} . "-preview.png";
-
-        print "Checking for existing preview: $preview_path\n";
-
-        # Check if preview already exists and is recent
-        if (-f $preview_path && -s $preview_path > 1000) {
-            my $preview_age = time() - (stat($preview_path))[9];
-            if ($preview_age < 86400) {  # Less than 24 hours old
-                print "Using existing preview for " . $theme_info->{name} . "\n";
-                $self->_update_widget_preview($widget_container, $preview_path);
-                return 1;
-            }
+        # Tier 2: a realistic GTK render is already cached
+        if ($self->_is_realistic_preview_current($preview_path)) {
+            $self->_update_widget_preview($widget_container, $preview_path);
+            return 1;
         }
 
-        # Check if _create_improved_preview_script method exists
-        if ($self->can('_create_improved_preview_script')) {
-            print "Using _create_improved_preview_script for " . $theme_info->{name} . "\n";
-            # Generate preview asynchronously
-            $self->_generate_preview_async($theme_info, $widget_container, $preview_path, $size);
+        # Tier 1: instant Cairo preview now, realistic refinement later if visible
+        my $pixbuf = eval { $self->_create_instant_preview_pixbuf($theme_info, $size, int($size * 0.75)) };
+        if ($pixbuf) {
+            $self->_set_widget_preview_pixbuf($widget_container, $pixbuf);
         } else {
-            print "No _create_improved_preview_script method, using fallback for " . $theme_info->{name} . "\n";
-            # Use your existing _generate_dynamic_preview method synchronously but with shorter timeout
-            my $success = eval {
-                local $SIG{ALRM} = sub { die "timeout\n" };
-                alarm(5);  # 5 second timeout per preview
-
-                my $result = $self->_generate_dynamic_preview(
-                    $theme_info->{name},
-                    $theme_info->{path},
-                    $preview_path,
-                    $size,
-                    int($size * 0.75)
-                );
-
-                alarm(0);
-                return $result;
-            };
-
-            if ($@ || !$success) {
-                print "Preview generation failed for " . $theme_info->{name} . ": $@\n";
-            } elsif (-f $preview_path && -s $preview_path > 1000) {
-                print "Preview generated successfully for " . $theme_info->{name} . "\n";
-                $self->_update_widget_preview($widget_container, $preview_path);
-            }
+            print "Instant preview failed for " . $theme_info->{name} . ": $@\n";
         }
 
-        return 1;
-    }
-
-    sub _start_progress_monitor {
-        my $self = shift;
-
-        my $last_check_time = time();
-
-        my $monitor;
-        $monitor = sub {
-            my $progress = $self->{preview_progress};
-            return 0 unless $progress;
-
-            my $current_time = time();
-
-            # Update progress every 2 seconds
-            if ($current_time - $last_check_time >= 2) {
-                # Count how many previews actually exist
-                my $actual_completed = 0;
-                foreach my $item (@{$progress->{generation_queue}}) {
-                    my $cache_dir = $self->{preview_cache_dir} || "$ENV{HOME}/.local/share/cinnamon-application-themes-manager/previews";
-                    my $preview_path = "$cache_dir/" . $item->{theme_info}->{name} . "-preview.png";
+        $self->_queue_preview_refinement($theme_info, $widget_container);
+        $self->_kick_preview_refinement();
 
-                    if (-f $preview_path && -s $preview_path > 1000) {
-                        $actual_completed++;
-                    }
-                }
-
-                my $progress_percentage = 30 + int(($actual_completed / $progress->{total}) * 70);
-                $self->_update_loading_progress(
-                    "Generating previews... ($actual_completed/" . $progress->{total} . ")",
-                    $progress_percentage
-                );
-
-                $last_check_time = $current_time;
-
-                # Check if all are complete
-                if ($actual_completed >= $progress->{total}) {
-                    print "All preview generation completed!\n";
-                    $self->_hide_loading_indicator();
-                    delete $self->{preview_progress};
-                    return 0;  # Stop monitoring
-                }
-            }
-
-            # Continue monitoring
-            Glib::Timeout->add(1000, $monitor);
-            return 0;
-        };
-
-        Glib::Timeout->add(1000, $monitor);
+        return 1;
     }
 
     sub _process_preview_generation_queue {
@@ -1501,39 +1658,37 @@ package CinnamonApplicationThemesManager {
 
         $self->{preview_generation_active} = 1;
 
-        my $item = shift @{$self->{preview_generation_queue}};
-
-        print "Processing preview generation for: " . $item->{theme_name} . "\n";
-
-        # Generate preview in background
-        Glib::Timeout->add(50, sub {
-            my $success = $self->_generate_dynamic_preview(
-                $item->{theme_name},
-                $item->{theme_path},
-                $item->{cache_file},
-                $item->{width},
-                $item->{height}
-            );
+        # One preview per step, behind anything the user is waiting for
+        $self->scheduler->add_task(
+            label => 'gtk themes: generate queued previews',
+            priority => CinnamonSettings::Scheduler::PRIORITY_LOW,
+            step => sub {
+                my $item = shift @{$self->{preview_generation_queue}} or return 0;
+
+                print "Processing preview generation for: " . $item->{theme_name} . "\n";
+
+                my $success = $self->_generate_dynamic_preview(
+                    $item->{theme_name},
+                    $item->{theme_path},
+                    $item->{cache_file},
+                    $item->{width},
+                    $item->{height}
+                );
 
-            if ($success) {
-                print "Auto-generated preview for " . $item->{theme_name} . "\n";
-                # Trigger a refresh of this specific theme widget
-                $self->_refresh_theme_widget_if_visible($item->{theme_name});
-            }
+                if ($success) {
+                    print "Auto-generated preview for " . $item->{theme_name} . "\n";
+                    # Trigger a refresh of this specific theme widget
+                    $self->_refresh_theme_widget_if_visible($item->{theme_name});
+                }
 
-            # Continue with next item in queue
-            if (@{$self->{preview_generation_queue}}) {
-                Glib::Timeout->add(100, sub {
-                    $self->_process_preview_generation_queue();
-                    return 0;
-                });
-            } else {
+                # Continue with next item in queue
+                return scalar @{$self->{preview_generation_queue}};
+            },
+            on_done => sub {
                 $self->{preview_generation_active} = 0;
                 print "Preview generation queue completed\n";
-            }
-
-            return 0; # Don't repeat
-        });
+            },
+        );
     }
 
     sub _refresh_theme_widget_if_visible {
@@ -1548,7 +1703,7 @@ package CinnamonApplicationThemesManager {
             if ($theme_info && $theme_info->{name} eq $theme_name) {
                 print "Refreshing widget for $theme_name\n";
                 # Replace the placeholder with the new preview
-                my $cache_file = $self->{preview_cache_dir} . "/${theme_name}-preview.png";
+                my $cache_file = $self->_get_realistic_preview_path($theme_info);
                 if (-f $cache_file && -s $cache_file) {
                     my $new_preview = eval {
                         my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale(
@@ -1573,7 +1728,7 @@ package CinnamonApplicationThemesManager {
                         $container->show_all();
 
                         # Update widget reference
-                        $self->theme_widgets->{$container + 0} = $new_preview;
+                        $self->view->set_widget($container, $new_preview);
                     }
                 }
                 last;
@@ -1609,19 +1764,18 @@ package CinnamonApplicationThemesManager {
 
         my $script = $self->_create_improved_preview_script($theme_name, $theme_path, $output_file, $width, $height);
 
-        # Write script to temporary file
-        my $script_path = "/tmp/theme_preview_${$}_" . time() . ".pl";
-        open my $fh, '>', $script_path or return 0;
-        print $fh $script;
-        close $fh;
-        chmod 0755, $script_path;
+        return $self->_run_preview_script($script, $output_file, 30);
+    }
+
+    sub _run_preview_script {
+        my ($self, $script, $output_file, $timeout) = @_;
 
-        # Run the script with timeout
-        my $result = system("timeout 30s perl '$script_path' 2>/dev/null");
-        unlink $script_path;
+        # Blocking variant for callers that need the image right away
+        my ($exit_code) = $self->session->run_perl(script => $script, timeout => $timeout, label => 'gtk preview');
 
         # Check if output file was created successfully
-        my $success = ($result == 0 && -f $output_file && -s $output_file > 1000);
+        my $success = ($exit_code == 0 && -f $output_file && -s $output_file > 1000);
+        $self->_adopt_realistic_preview($output_file) if $success;
 
         return $success;
     }
@@ -1631,83 +1785,50 @@ package CinnamonApplicationThemesManager {
 
         print "Creating enhanced themed placeholder for: " . $theme_info->{name} . "\n";
 
-        # Extract comprehensive theme colors
-        my $colors = $self->_extract_comprehensive_theme_colors($theme_info);
-
-        # Create output file path for the enhanced preview
-        my $temp_file = "/tmp/enhanced_preview_" . $theme_info->{name} . "_$$.png";
+        # Rendered in memory; no scratch PNG round-trip
+        my $pixbuf = eval { $self->_create_instant_preview_pixbuf($theme_info, $width, $height) };
+        return $pixbuf if $pixbuf;
 
-        # Generate enhanced Cairo preview instead of just solid color
-        my $success = $self->_create_enhanced_cairo_preview($colors, $width, $height, $temp_file);
+        # Final fallback: create simple solid color pixbuf
+        my $colors = $self->_extract_comprehensive_theme_colors($theme_info);
+        my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
+        my $cr = Cairo::Context->create($surface);
 
-        if ($success && -f $temp_file && -s $temp_file > 100) {
-            # Load the enhanced preview
-            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($temp_file);
-            unlink($temp_file); # Clean up temp file
-            return $pixbuf;
-        } else {
-            # Final fallback: create simple solid color pixbuf
-            my $bg_color = $colors->{bg_color};
-            my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
-            my $cr = Cairo::Context->create($surface);
+        $cr->set_source_rgb(@{$colors->{bg_color}});
+        $cr->rectangle(0, 0, $width, $height);
+        $cr->fill();
 
-            $cr->save();
-            $cr->set_source_rgb(@$bg_color);
-            $cr->rectangle(0, 0, $width, $height);
-            $cr->fill();
-            $cr->restore();
+        return Gtk3::Gdk::pixbuf_get_from_surface($surface, 0, 0, $width, $height);
+    }
 
-            # Convert Cairo surface to GdkPixbuf
-            $surface->write_to_png("/tmp/simple_placeholder_$$.png");
-            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file("/tmp/simple_placeholder_$$.png");
-            unlink("/tmp/simple_placeholder_$$.png");
+    sub _get_theme_color_table {
+        my ($self, $theme_info) = @_;
 
-            return $pixbuf;
-        }
+        # Parsed once per theme and stylesheet mtime, shared by all extractors
+        return $self->css_colors->color_table("$theme_info->{path}/gtk-3.0/gtk.css");
     }
 
     sub _extract_theme_background_color {
         my ($self, $theme_info) = @_;
 
-        my $theme_path = $theme_info->{path};
         my $theme_name = $theme_info->{name};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
 
         # Default colors
         my $default_light = [0.98, 0.98, 0.98];  # Light gray
         my $default_dark = [0.22, 0.22, 0.22];   # Dark gray
 
-        return $default_light unless -f $css_file;
-
-        # Read CSS file
-        open my $fh, '<', $css_file or return $default_light;
-        my $css_content = do { local $/; <$fh> };
-        close $fh;
+        my $table = $self->_get_theme_color_table($theme_info);
+        return $default_light unless $table;
 
         # Priority-based color extraction
-        my $bg_color;
-
-        # 1. Look for @define-color variables (highest priority)
-        if ($css_content =~ /\@define-color\s+theme_bg_color\s+([^;]+);/i) {
-            $bg_color = $self->_parse_css_color_value($1, $css_content);
-        }
-        elsif ($css_content =~ /\@define-color\s+bg_color\s+([^;]+);/i) {
-            $bg_color = $self->_parse_css_color_value($1, $css_content);
-        }
-        elsif ($css_content =~ /\@define-color\s+window_bg_color\s+([^;]+);/i) {
-            $bg_color = $self->_parse_css_color_value($1, $css_content);
-        }
-        elsif ($css_content =~ /\@define-color\s+base_color\s+([^;]+);/i) {
-            $bg_color = $self->_parse_css_color_value($1, $css_content);
-        }
-
-        # 2. Look for window background declarations
-        elsif ($css_content =~ /window\s*\{[^}]*background(?:-color)?\s*:\s*([^;}]+)/si) {
-            $bg_color = $self->_parse_css_color_value($1, $css_content);
-        }
+        # 1. @define-color variables, 2. window background declarations
+        my $bg_color = $self->css_colors->define_color($table,
+            qw(theme_bg_color bg_color window_bg_color base_color))
+            || $self->css_colors->selector_color($table, 'window', 'background');
+        return $bg_color if $bg_color;
 
         # 3. Look for specific theme patterns
-        elsif ($theme_name =~ /breeze/i) {
+        if ($theme_name =~ /breeze/i) {
             if ($theme_name =~ /dark/i) {
                 $bg_color = [0.19, 0.20, 0.22];  # Breeze Dark proper color
             } else {
@@ -1733,7 +1854,7 @@ package CinnamonApplicationThemesManager {
         }
 
         # 4. Fallback: detect dark vs light theme
-        elsif ($css_content =~ /dark/i || $theme_name =~ /dark/i) {
+        elsif ($table->{mentions_dark} || $theme_name =~ /dark/i) {
             $bg_color = $default_dark;
         }
 
@@ -1781,61 +1902,6 @@ package CinnamonApplicationThemesManager {
         return undef;
     }
 
-    sub _parse_css_color_value {
-        my ($self, $color_value, $css_content) = @_;
-
-        return unless $color_value;
-
-        # Clean up the value
-        $color_value =~ s/^\s+|\s+$//g;
-        $color_value =~ s/["']//g;
-
-        # Handle @color references
-        if ($color_value =~ /^\@([a-zA-Z_][a-zA-Z0-9_-]*)$/) {
-            my $var_name = $1;
-            # Look up the variable in the CSS
-            if ($css_content =~ /\@define-color\s+$var_name\s+([^;]+);/i) {
-                return $self->_parse_css_color_value($1, $css_content);
-            }
-            return undef;
-        }
-
-        # Handle hex colors
-        if ($color_value =~ /^#?([0-9a-fA-F]{3,6})$/) {
-            my $hex = $1;
-            if (length($hex) == 3) {
-                $hex = join('', map { $_ x 2 } split //, $hex);
-            }
-            if (length($hex) == 6) {
-                my $r = hex(substr($hex, 0, 2)) / 255.0;
-                my $g = hex(substr($hex, 2, 2)) / 255.0;
-                my $b = hex(substr($hex, 4, 2)) / 255.0;
-                return [$r, $g, $b];
-            }
-        }
-
-        # Handle rgb() and rgba()
-        elsif ($color_value =~ /rgba?\(\s*([0-9]+)\s*,\s*([0-9]+)\s*,\s*([0-9]+)\s*(?:,\s*[0-9.]+)?\s*\)/i) {
-            my $r = $1 / 255.0;
-            my $g = $2 / 255.0;
-            my $b = $3 / 255.0;
-            return [$r, $g, $b];
-        }
-
-        # Handle common color names
-        elsif ($color_value =~ /^white$/i) {
-            return [1.0, 1.0, 1.0];
-        }
-        elsif ($color_value =~ /^black$/i) {
-            return [0.0, 0.0, 0.0];
-        }
-        elsif ($color_value =~ /^transparent$/i) {
-            return undef; # Let it fallback
-        }
-
-        return undef;
-    }
-
     sub _create_improved_preview_script {
         my ($self, $theme_name, $theme_path, $output_file, $width, $height) = @_;
 
@@ -1997,37 +2063,20 @@ package CinnamonApplicationThemesManager {
     sub _extract_theme_foreground_color {
         my ($self, $theme_info) = @_;
 
-        my $theme_path = $theme_info->{path};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
-
         # Default colors
         my $default_light_fg = [0.13, 0.13, 0.13];  # Dark gray text
         my $default_dark_fg = [0.87, 0.87, 0.87];   # Light gray text
 
-        return $default_light_fg unless -f $css_file;
-
-        open my $fh, '<', $css_file or return $default_light_fg;
-        my $css_content = do { local $/; <$fh> };
-        close $fh;
+        my $table = $self->_get_theme_color_table($theme_info);
+        return $default_light_fg unless $table;
 
         # Look for foreground color patterns
-        if ($css_content =~ /\@define-color\s+theme_fg_color\s+[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/i ||
-            $css_content =~ /color\s*:\s*[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/i) {
-
-            my $hex_color = $1;
-            if ($hex_color && length($hex_color) >= 3) {
-                if (length($hex_color) == 3) {
-                    $hex_color = join('', map { $_ x 2 } split //, $hex_color);
-                }
-                my $r = hex(substr($hex_color, 0, 2)) / 255.0;
-                my $g = hex(substr($hex_color, 2, 2)) / 255.0;
-                my $b = hex(substr($hex_color, 4, 2)) / 255.0;
-                return [$r, $g, $b];
-            }
-        }
+        my $fg_color = $self->css_colors->define_color($table, qw(theme_fg_color fg_color))
+            || $table->{first}{color};
+        return $fg_color if $fg_color;
 
         # Check if it's a dark theme
-        if ($css_content =~ /dark/i || $theme_info->{name} =~ /dark/i) {
+        if ($table->{mentions_dark} || $theme_info->{name} =~ /dark/i) {
             return $default_dark_fg;
         }
 
@@ -2037,35 +2086,17 @@ package CinnamonApplicationThemesManager {
     sub _extract_theme_selected_color {
         my ($self, $theme_info) = @_;
 
-        my $theme_path = $theme_info->{path};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
-
-        # Get system selection color as fallback
-        my $default_selection = $self->_get_system_selection_color();
-
-        return $default_selection unless -f $css_file;
-
-        open my $fh, '<', $css_file or return $default_selection;
-        my $css_content = do { local $/; <$fh> };
-        close $fh;
+        my $table = $self->_get_theme_color_table($theme_info);
 
         # Look for selected/accent color patterns
-        if ($css_content =~ /\@define-color\s+theme_selected_bg_color\s+[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/i ||
-            $css_content =~ /suggested-action[^}]*background[^}]*?[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/si) {
-
-            my $hex_color = $1;
-            if ($hex_color && length($hex_color) >= 3) {
-                if (length($hex_color) == 3) {
-                    $hex_color = join('', map { $_ x 2 } split //, $hex_color);
-                }
-                my $r = hex(substr($hex_color, 0, 2)) / 255.0;
-                my $g = hex(substr($hex_color, 2, 2)) / 255.0;
-                my $b = hex(substr($hex_color, 4, 2)) / 255.0;
-                return [$r, $g, $b];
-            }
+        if ($table) {
+            my $selected = $self->css_colors->define_color($table, qw(theme_selected_bg_color selected_bg_color))
+                || $self->css_colors->selector_color($table, 'suggested_action', 'background');
+            return $selected if $selected;
         }
 
-        return $default_selection;
+        # Get system selection color as fallback
+        return $self->_get_system_selection_color();
     }
 
     sub _get_system_selection_color {
@@ -2093,15 +2124,8 @@ package CinnamonApplicationThemesManager {
         my $theme_colors = $self->_extract_comprehensive_theme_colors($theme_info);
 
         # Step 2: Check if this is a resource-based theme
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
-        my $is_resource_theme = 0;
-
-        if (-f $css_file) {
-            open my $fh, '<', $css_file or return 0;
-            my $css_content = do { local $/; <$fh> };
-            close $fh;
-            $is_resource_theme = ($css_content =~ /resource:\/\/.*gtk.*css/i);
-        }
+        my $table = $self->_get_theme_color_table($theme_info);
+        my $is_resource_theme = $table && @{$table->{resource_imports}} ? 1 : 0;
 
         if ($is_resource_theme) {
             print "Resource-based theme detected, using enhanced Cairo rendering\n";
@@ -2120,36 +2144,14 @@ package CinnamonApplicationThemesManager {
         # Create the preview script that will actually apply the theme and render widgets
         my $preview_script = $self->_create_realistic_preview_script($theme_name, $theme_path, $colors, $width, $height, $output_file);
 
-        # Write script to temporary file
-        my $script_path = "/tmp/realistic_preview_${$}_" . time() . ".pl";
-        open my $fh, '>', $script_path or do {
-            print "ERROR: Cannot create preview script: $!\n";
-            return $self->_create_enhanced_cairo_preview($colors, $width, $height, $output_file);
-        };
-        print $fh $preview_script;
-        close $fh;
-        chmod 0755, $script_path;
-
         # Execute the script with timeout
-        my $success = 0;
-        eval {
-            local $SIG{ALRM} = sub { die "timeout\n" };
-            alarm(15); # 15 second timeout
-
-            my $result = system("timeout 10s perl '$script_path' 2>/dev/null");
-            $success = ($result == 0 && -f $output_file && -s $output_file > 1000);
-
-            alarm(0);
-        };
+        my $success = $self->_run_preview_script($preview_script, $output_file, 10);
 
-        if ($@ || !$success) {
+        if (!$success) {
             print "Widget preview generation failed or timed out, using enhanced Cairo fallback\n";
             $success = $self->_create_enhanced_cairo_preview($colors, $width, $height, $output_file);
         }
 
-        # Clean up
-        unlink $script_path if -f $script_path;
-
         return $success;
     }
 
@@ -2344,6 +2346,18 @@ package CinnamonApplicationThemesManager {
 
         print "Creating enhanced Cairo preview with realistic styling\n";
 
+        my $surface = $self->_render_enhanced_cairo_surface($colors, $width, $height);
+
+        # Save the surface
+        $surface->write_to_png($output_file);
+        $self->session->note_file_created();
+
+        return (-f $output_file && -s $output_file > 100);
+    }
+
+    sub _render_enhanced_cairo_surface {
+        my ($self, $colors, $width, $height) = @_;
+
         # Create Cairo surface
         my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
         my $cr = Cairo::Context->create($surface);
@@ -2357,18 +2371,13 @@ package CinnamonApplicationThemesManager {
         # Draw realistic UI elements
         $self->_draw_realistic_ui_elements($cr, $width, $height, $colors);
 
-        # Save the surface
-        $surface->write_to_png($output_file);
-
-        return (-f $output_file && -s $output_file > 100);
+        return $surface;
     }
 
     sub _extract_comprehensive_theme_colors {
         my ($self, $theme_info) = @_;
 
-        my $theme_path = $theme_info->{path};
         my $theme_name = $theme_info->{name};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
 
         # Initialize with intelligent defaults
         my $colors = {
@@ -2407,14 +2416,11 @@ package CinnamonApplicationThemesManager {
             $colors->{sidebar_bg} = [0.22, 0.22, 0.22];
         }
 
-        return $colors unless -f $css_file;
-
-        # Read CSS content
-        my $css_content = $self->_read_css_with_imports($css_file, "$theme_path/gtk-3.0");
-        return $colors if $css_content =~ /resource:\/\/.*gtk.*css/i;
+        my $table = $self->_get_theme_color_table($theme_info);
+        return $colors unless $table;
 
-        # Extract colors from CSS
-        $self->_parse_theme_colors($css_content, $colors);
+        # Extract colors from the parsed stylesheet
+        $self->_parse_theme_colors($table, $colors);
 
         # Apply intelligent color derivations
         $self->_derive_missing_colors($colors);
@@ -2477,6 +2483,36 @@ package CinnamonApplicationThemesManager {
         $cr->restore();
     }
 
+    sub _draw_realistic_scale {
+        my ($self, $cr, $x, $y, $w, $h, $colors, $value) = @_;
+
+        $cr->save();
+
+        # Slider trough centered vertically
+        my $trough_h = 4;
+        my $trough_y = $y + ($h - $trough_h) / 2;
+        $cr->set_source_rgb(@{$colors->{border_color}});
+        $cr->rectangle($x, $trough_y, $w, $trough_h);
+        $cr->fill();
+
+        # Filled part up to the knob
+        my $knob_x = $x + ($w * $value);
+        $cr->set_source_rgb(@{$colors->{selected_bg_color}});
+        $cr->rectangle($x, $trough_y, $knob_x - $x, $trough_h);
+        $cr->fill();
+
+        # Knob
+        my $radius = $h / 2 - 2;
+        $cr->arc($knob_x, $y + $h / 2, $radius, 0, 2 * 3.14159);
+        $cr->set_source_rgb(@{$colors->{button_bg}});
+        $cr->fill_preserve();
+        $cr->set_source_rgb(@{$colors->{button_border}});
+        $cr->set_line_width(1);
+        $cr->stroke();
+
+        $cr->restore();
+    }
+
     sub _draw_realistic_ui_elements {
         my ($self, $cr, $width, $height, $colors) = @_;
 
@@ -2765,7 +2801,7 @@ package CinnamonApplicationThemesManager {
     }
 
     sub _parse_theme_colors {
-        my ($self, $css_content, $colors) = @_;
+        my ($self, $table, $colors) = @_;
 
         # Color variable mappings
         my %color_vars = (
@@ -2790,46 +2826,36 @@ package CinnamonApplicationThemesManager {
             'toolbar_bg_color' => 'headerbar_bg',
         );
 
-        # Parse @define-color variables
-        foreach my $var_name (keys %color_vars) {
+        # Resolved @define-color variables
+        foreach my $var_name (sort keys %color_vars) {
             my $color_key = $color_vars{$var_name};
-            if ($css_content =~ /\@define-color\s+$var_name\s+([^;]+);/i) {
-                my $color_value = $1;
-                my $parsed_color = $self->_parse_css_color_value($color_value, $css_content);
-                if ($parsed_color) {
-                    $colors->{$color_key} = $parsed_color;
-                    print "  Found $var_name -> $color_key\n";
-                }
+            my $parsed_color = $table->{colors}{$var_name};
+            if ($parsed_color) {
+                $colors->{$color_key} = [@$parsed_color];
+                print "  Found $var_name -> $color_key\n";
             }
         }
 
-        # Parse specific selectors for additional colors
-        my %selector_patterns = (
+        # Key selector backgrounds for additional colors
+        my %selector_keys = (
             'button' => 'button_bg',
             'entry' => 'entry_bg',
             'headerbar' => 'headerbar_bg',
-            'window\.background' => 'bg_color',
-            '\.sidebar' => 'sidebar_bg',
+            'window' => 'bg_color',
+            'sidebar' => 'sidebar_bg',
         );
 
-        foreach my $selector (keys %selector_patterns) {
-            my $color_key = $selector_patterns{$selector};
-            if ($css_content =~ /$selector[^}]*\{([^}]+)\}/si) {
-                my $rule_content = $1;
-                if ($rule_content =~ /background(?:-color)?\s*:\s*([^;}]+)/i) {
-                    my $color_value = $1;
-                    $color_value =~ s/\s+$//;
-                    my $parsed_color = $self->_parse_css_color_value($color_value, $css_content);
-                    if ($parsed_color) {
-                        $colors->{$color_key} = $parsed_color;
-                        print "  Found $selector background -> $color_key\n";
-                    }
-                }
+        foreach my $selector (sort keys %selector_keys) {
+            my $color_key = $selector_keys{$selector};
+            my $parsed_color = $self->css_colors->selector_color($table, $selector, 'background');
+            if ($parsed_color) {
+                $colors->{$color_key} = [@$parsed_color];
+                print "  Found $selector background -> $color_key\n";
             }
         }
 
         # Check for dark theme indicators in CSS
-        if ($css_content =~ /dark/i ||
+        if ($table->{mentions_dark} ||
             ($colors->{bg_color}->[0] + $colors->{bg_color}->[1] + $colors->{bg_color}->[2]) / 3 < 0.5) {
             $colors->{is_dark_theme} = 1;
         }
@@ -2939,21 +2965,7 @@ package CinnamonApplicationThemesManager {
         # Use the existing working GTK script
         my $script = $self->_create_improved_preview_script($theme_name, $theme_path, $output_file, $width, $height);
 
-        # Write script to temporary file
-        my $script_path = "/tmp/normal_widgets_${$}_" . time() . ".pl";
-        open my $fh, '>', $script_path or return 0;
-        print $fh $script;
-        close $fh;
-        chmod 0755, $script_path;
-
-        # Run the script with timeout
-        my $result = system("timeout 30s perl '$script_path' 2>/dev/null");
-        unlink $script_path;
-
-        # Check if output file was created successfully
-        my $success = ($result == 0 && -f $output_file && -s $output_file > 1000);
-
-        return $success;
+        return $self->_run_preview_script($script, $output_file, 30);
     }
 
     sub _generate_transparent_gtk_widgets {
@@ -2961,21 +2973,7 @@ package CinnamonApplicationThemesManager {
 
             my $script = $self->_create_transparent_widget_script($theme_name, $theme_path, $output_file, $width, $height);
 
-            # Write script to temporary file
-            my $script_path = "/tmp/transparent_widgets_${$}_" . time() . ".pl";
-            open my $fh, '>', $script_path or return 0;
-            print $fh $script;
-            close $fh;
-            chmod 0755, $script_path;
-
-            # Run the script with timeout
-            my $result = system("timeout 30s perl '$script_path' 2>/dev/null");
-            unlink $script_path;
-
-            # Check if output file was created successfully
-            my $success = ($result == 0 && -f $output_file && -s $output_file > 1000);
-
-            return $success;
+            return $self->_run_preview_script($script, $output_file, 30);
         }
 
         sub _create_transparent_widget_script {
@@ -3407,24 +3405,15 @@ package CinnamonApplicationThemesManager {
         my ($self, $theme_info) = @_;
 
         my $theme_name = $theme_info->{name};
-        my $theme_path = $theme_info->{path};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
 
         # Check theme name patterns
         return 1 if $theme_name =~ /mint-?[lyx]/i;  # Mint-L, Mint-X, Mint-Y are flat
         return 1 if $theme_name =~ /flat|material|paper/i;
 
-        # Check CSS for flat indicators
-        if (-f $css_file) {
-            open my $fh, '<', $css_file or return 0;
-            my $css_content = do { local $/; <$fh> };
-            close $fh;
-
-            # Look for flat design indicators in CSS
-            return 1 if $css_content =~ /border-radius\s*:\s*[01]px/i;  # Very small border radius
-            return 1 if $css_content =~ /box-shadow\s*:\s*none/i;       # No shadows
-            return 1 if $css_content =~ /gradient.*none/i;              # No gradients
-        }
+        # Flat design indicators (tiny border radius, no shadows, no gradients)
+        # are collected while the stylesheet is tokenized
+        my $table = $self->_get_theme_color_table($theme_info);
+        return 1 if $table && $table->{flat};
 
         return 0;  # Default to 3D styling
     }
@@ -3432,37 +3421,20 @@ package CinnamonApplicationThemesManager {
     sub _extract_theme_border_color {
         my ($self, $theme_info) = @_;
 
-        my $theme_path = $theme_info->{path};
-        my $css_file = "$theme_path/gtk-3.0/gtk.css";
-
         # Default border colors
         my $default_light_border = [0.8, 0.8, 0.8];  # Light gray border
         my $default_dark_border = [0.4, 0.4, 0.4];   # Dark gray border
 
-        return $default_light_border unless -f $css_file;
-
-        open my $fh, '<', $css_file or return $default_light_border;
-        my $css_content = do { local $/; <$fh> };
-        close $fh;
+        my $table = $self->_get_theme_color_table($theme_info);
+        return $default_light_border unless $table;
 
         # Look for border color patterns
-        if ($css_content =~ /\@define-color\s+borders\s+[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/i ||
-            $css_content =~ /border-color\s*:\s*[#@]?([0-9a-fA-F]{6}|[0-9a-fA-F]{3})/i) {
-
-            my $hex_color = $1;
-            if ($hex_color && length($hex_color) >= 3) {
-                if (length($hex_color) == 3) {
-                    $hex_color = join('', map { $_ x 2 } split //, $hex_color);
-                }
-                my $r = hex(substr($hex_color, 0, 2)) / 255.0;
-                my $g = hex(substr($hex_color, 2, 2)) / 255.0;
-                my $b = hex(substr($hex_color, 4, 2)) / 255.0;
-                return [$r, $g, $b];
-            }
-        }
+        my $border_color = $self->css_colors->define_color($table, qw(borders border_color))
+            || $table->{first}{border};
+        return $border_color if $border_color;
 
         # Check if it's a dark theme
-        if ($css_content =~ /dark/i || $theme_info->{name} =~ /dark/i) {
+        if ($table->{mentions_dark} || $theme_info->{name} =~ /dark/i) {
             return $default_dark_border;
         }
 
@@ -3506,8 +3478,7 @@ package CinnamonApplicationThemesManager {
         $frame->add($box);
 
         # Store references - use frame as key like backgrounds manager
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $preview_widget;
+        $self->view->track($frame, $theme_info, $preview_widget);
 
         print "DEBUG: Successfully created theme widget for: " . $theme_info->{name} . "\n";
         return $frame;
@@ -3528,11 +3499,7 @@ package CinnamonApplicationThemesManager {
         $cr->restore();
 
         # Convert Cairo surface to GdkPixbuf
-        $surface->write_to_png("/tmp/placeholder.png");
-        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file("/tmp/placeholder.png");
-        unlink("/tmp/placeholder.png");
-
-        return $pixbuf;
+        return Gtk3::Gdk::pixbuf_get_from_surface($surface, 0, 0, $width, $height);
     }
 
     sub _update_theme_zoom_async {
@@ -3548,23 +3515,24 @@ package CinnamonApplicationThemesManager {
         $self->loading_spinner->start();
         $self->loading_label->set_text('Updating zoom level...');
 
-        # Get all children and process in batches
+        # A newer zoom request supersedes whatever is still queued
+        $self->scheduler->cancel($self->zoom_token);
+        my $token = $self->scheduler->new_token();
+        $self->zoom_token($token);
+
         my @children = $flowbox->get_children();
         my $total_children = @children;
         my $processed = 0;
-        my $batch_size = 6;
 
         return unless $total_children > 0;
 
-        my $process_batch;
-        $process_batch = sub {
-            my $batch_start = $processed;
-            my $batch_end = ($processed + $batch_size - 1 < $total_children - 1)
-                        ? $processed + $batch_size - 1
-                        : $total_children - 1;
-
-            for my $i ($batch_start..$batch_end) {
-                my $child = $children[$i];
+        $self->scheduler->foreach_item(
+            label => 'gtk themes: update zoom',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $token,
+            items => \@children,
+            each => sub {
+                my $child = shift;
                 my $frame = $child->get_child();  # FlowBoxChild -> Frame
 
                 my $image_widget = $self->theme_widgets->{$frame + 0};
@@ -3577,36 +3545,30 @@ package CinnamonApplicationThemesManager {
                     # Load new theme preview asynchronously
                     $self->_generate_theme_preview_fast($theme_info, $frame);
                 }
-            }
-
-            $processed = $batch_end + 1;
 
-            # Update progress
-            my $progress = int(($processed / $total_children) * 100);
-            $self->loading_label->set_text("Updating zoom... ${progress}%");
+                $processed++;
 
-            if ($processed < $total_children) {
-                # Schedule next batch
-                Glib::Timeout->add(50, $process_batch);
-                return 0;
-            } else {
+                # Update progress
+                my $progress = int(($processed / $total_children) * 100);
+                $self->loading_label->set_text("Updating zoom... ${progress}%");
+            },
+            on_done => sub {
                 # Zoom update complete
                 $self->loading_spinner->stop();
                 $self->loading_box->hide();
                 print "Zoom update completed for $total_children theme previews\n";
-                return 0;
-            }
-        };
-
-        # Start processing first batch
-        Glib::Timeout->add(10, $process_batch);
+            },
+        );
     }
 
     sub _cleanup_background_processes {
         my $self = shift;
 
         # Clear cached theme lists to free memory
-        $self->cached_theme_lists({});
+        $self->cached_theme_lists->clear();
+
+        # Stop preview helpers that are still rendering
+        $self->session->terminate_children();
 
         print "Background processes cleaned up\n";
     }
@@ -3639,7 +3601,7 @@ package CinnamonApplicationThemesManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -3651,7 +3613,7 @@ package CinnamonApplicationThemesManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -3701,11 +3663,11 @@ package CinnamonApplicationThemesManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -3758,7 +3720,7 @@ package CinnamonApplicationThemesManager {
             path => $theme_info->{path},
             timestamp => time()
         };
-        $self->_save_config($self->config);
+        $self->config_store->save();
     }
 
     sub _detect_current_theme {
@@ -3790,101 +3752,71 @@ package CinnamonApplicationThemesManager {
         return $ENV{HOME} . '/.local/share/cinnamon-application-themes-manager/config/settings.json';
     }
 
-    sub _load_config {
+    sub _build_config_store {
         my $self = shift;
 
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            preview_size => 450,
-            custom_directories => [],
-            last_selected_directory => undef,
-            theme_backups => [],
-        };
-
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-
-                    # Validate preview_size range
-                    if ($config->{preview_size} < 40 || $config->{preview_size} > 450) {
-                        print "Invalid preview size in config, using default\n";
-                        $config->{preview_size} = 450;
-                    }
-
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
-
-                    # Ensure theme_backups is an array ref
-                    if (!ref($config->{theme_backups}) || ref($config->{theme_backups}) ne 'ARRAY') {
-                        $config->{theme_backups} = [];
-                    }
-
-                    print "Loaded configuration from $config_file\n";
-                } else {
-                    print "Config file is empty, using defaults\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration\n";
-            }
-        } else {
-            print "Config file not found, using defaults\n";
-        }
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                preview_size => 450,
+                realistic_previews => 1,
+                custom_directories => [],
+                last_selected_directory => undef,
+                theme_backups => [],
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
 
-        return $config;
+    sub _load_config {
+        my $self = shift;
+        return $self->config_store->load();
     }
 
-    sub _save_config {
+    sub _validate_config {
         my ($self, $config) = @_;
 
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
+        # Validate preview_size range
+        if (!$config->{preview_size} || $config->{preview_size} < 40 || $config->{preview_size} > 450) {
+            print "Invalid preview size in config, using default\n";
+            $config->{preview_size} = 450;
+        }
 
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-            }
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
 
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
+        # Ensure theme_backups is an array ref
+        if (!ref($config->{theme_backups}) || ref($config->{theme_backups}) ne 'ARRAY') {
+            $config->{theme_backups} = [];
+        }
+    }
 
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
 
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
+        return unless $self->themes_grid;
 
-            print "Successfully saved configuration\n";
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
+        if (grep { $_ eq 'preview_size' } @$keys) {
+            $self->zoom_level($self->config->{preview_size});
+            $self->_update_theme_zoom_async();
         }
     }
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-application-themes-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Cinnamon Application Themes Manager started\n";
         Gtk3::main();
     }
@@ -3892,6 +3824,12 @@ package CinnamonApplicationThemesManager {
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit CinnamonApplicationThemesManager->new(prewarm => 1)->prewarm_caches(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = CinnamonApplicationThemesManager->new();
     $app->run();
 }
@@ -7,12 +7,24 @@ use utf8;
 # A dedicated wallpaper and background management application for Linux Mint Cinnamon
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use JSON qw(encode_json decode_json);
 use Data::Dumper;
-use Digest::MD5 qw(md5_hex);
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::BudgetCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
+use CinnamonSettings::SystemCache;
+use CinnamonSettings::PreviewCache;
+use CinnamonSettings::PreviewClient;
+use CinnamonSettings::ThumbnailCache;
+use CinnamonSettings::Prewarm;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -23,6 +35,7 @@ $SIG{__WARN__} = sub {
 # Main application class
 package DesktopBackgroundsManager {
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
 
     has 'window' => (is => 'rw');
     has 'directory_list' => (is => 'rw');
@@ -31,21 +44,52 @@ package DesktopBackgroundsManager {
     has 'wallpaper_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
     has 'zoom_level' => (is => 'rw', default => sub { 200 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'image_paths' => (is => 'rw', default => sub { {} });
-    has 'image_widgets' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
     has 'loading_box' => (is => 'rw');
     has 'current_directory' => (is => 'rw');
-    has 'cached_file_lists' => (is => 'rw', default => sub { {} });
+    has 'cached_file_lists' => (is => 'ro', default => sub {
+        CinnamonSettings::BudgetCache->new(name => 'file lists', budget_bytes => 16 * 1024 * 1024)
+    });
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
-    has 'thumbnail_cache' => (is => 'rw', default => sub { {} });
+    has 'thumbnail_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::PreviewCache->new(
+            name => 'thumbnails',
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-backgrounds-manager/thumbnails',
+            memory_budget => 96 * 1024 * 1024,
+            shared => CinnamonSettings::SystemCache->new(section => 'backgrounds'),
+        )
+    });
+    has 'preview_service' => (is => 'ro', default => sub { CinnamonSettings::PreviewClient->new() });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-backgrounds-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-backgrounds-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
+    has 'zoom_token' => (is => 'rw');
+    # Headless --prewarm run: configuration only, no windows
+    has 'prewarm' => (is => 'ro', default => sub { 0 });
+
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Frame address lookups into the current directory's view
+    sub image_paths { $_[0]->view->paths }
+    sub image_widgets { $_[0]->view->widgets }
 
     sub BUILD {
         my $self = shift;
         $self->_initialize_configuration();
+        return if $self->prewarm;
         $self->_setup_ui();
         $self->_initialize_thumbnail_cache();
         $self->_populate_background_directories();
@@ -273,7 +317,7 @@ package DesktopBackgroundsManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_wallpapers_from_directory_async($row);
@@ -293,7 +337,7 @@ package DesktopBackgroundsManager {
             $self->_update_wallpaper_zoom_async();
             # Save zoom level to config
             $self->config->{thumbnail_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $zoom_out->signal_connect('clicked' => sub {
@@ -302,7 +346,7 @@ package DesktopBackgroundsManager {
             $self->_update_wallpaper_zoom_async();
             # Save zoom level to config
             $self->config->{thumbnail_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $self->wallpaper_grid->signal_connect('child-activated' => sub {
@@ -311,10 +355,14 @@ package DesktopBackgroundsManager {
         });
 
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
             # Clean up any running background processes
+            $self->thumbnail_cache->report_stats();
+            $self->preview_service->report_stats();
             $self->_cleanup_background_processes();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -657,54 +705,35 @@ package DesktopBackgroundsManager {
     sub _initialize_thumbnail_cache {
         my $self = shift;
 
-        # Create cache directory structure
-        my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-backgrounds-manager';
-        my $thumb_dir = "$cache_dir/thumbnails";
+        # The cache creates its directory when it is constructed
+        print "Thumbnail cache initialized at: " . $self->thumbnail_cache->cache_dir . "\n";
+    }
 
-        unless (-d $cache_dir) {
-            system("mkdir -p '$cache_dir'");
-        }
-        unless (-d $thumb_dir) {
-            system("mkdir -p '$thumb_dir'");
-        }
+    sub _populate_background_directories {
+        my $self = shift;
 
-        # Initialize cache hash
-        $self->thumbnail_cache({});
+        foreach my $dir_info ($self->_background_directories()) {
+            my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
+            $self->directory_view->track($row, $dir_info->{path});
+            $self->directory_list->add($row);
+        }
 
-        print "Thumbnail cache initialized at: $thumb_dir\n";
+        print "Populated background directories\n";
     }
 
-    sub _populate_background_directories {
+    # Default wallpaper directories followed by custom ones from the
+    # config, as far as they exist
+    sub _background_directories {
         my $self = shift;
 
-        # Default wallpaper directories - only directories that actually contain wallpapers
-        my @default_dirs = (
+        my @dirs = (
             { name => 'Pictures', path => $ENV{HOME} . '/Pictures' },
             { name => 'Linux Mint', path => '/usr/share/backgrounds/linuxmint' },
             { name => 'Linux Mint Wallpapers', path => '/usr/share/backgrounds/linuxmint-wallpapers' },
+            @{$self->config->{custom_directories} || []},
         );
 
-        # Add default directories
-        foreach my $dir_info (@default_dirs) {
-            next unless -d $dir_info->{path};
-
-            my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
-            $self->directory_list->add($row);
-        }
-
-        # Add custom directories from config
-        if ($self->config->{custom_directories}) {
-            foreach my $custom_dir (@{$self->config->{custom_directories}}) {
-                next unless -d $custom_dir->{path};
-
-                my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
-                $self->directory_list->add($row);
-            }
-        }
-
-        print "Populated background directories\n";
+        return grep { -d $_->{path} } @dirs;
     }
 
     sub _create_directory_row {
@@ -809,103 +838,105 @@ package DesktopBackgroundsManager {
         $self->loading_spinner->start();
         $self->loading_label->set_text('Scanning directory...');
 
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Drop queued widget and thumbnail work for the previous directory
+        $self->scheduler->cancel($self->load_token);
+        $self->preview_service->cancel_token($self->load_token);
+        $self->scheduler->cancel($self->zoom_token);
+        my $token = $self->scheduler->new_token();
+        $self->load_token($token);
+
         # Clear existing wallpapers immediately - this prevents duplicates
         my $flowbox = $self->wallpaper_grid;
         foreach my $child ($flowbox->get_children()) {
             $flowbox->remove($child);
+            $child->destroy();
         }
 
         # Clear the image references to prevent memory leaks
-        $self->image_paths({});
-        $self->image_widgets({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
 
         # Store current directory for reference
         $self->current_directory($dir_path);
 
         # Use cached file list if available
         my $files_ref;
-        if (exists $self->cached_file_lists->{$dir_path}) {
-            $files_ref = $self->cached_file_lists->{$dir_path};
+        if ($self->cached_file_lists->contains($dir_path)) {
+            $files_ref = $self->cached_file_lists->get($dir_path);
             print "Using cached file list for $dir_path (" . @$files_ref . " files)\n";
         } else {
-            # Scan directory for image files
-            opendir(my $dh, $dir_path) or return;
-            my @files = grep { /\.(jpg|jpeg|png|bmp|gif|webp|tiff|tif)$/i } readdir($dh);
-            closedir($dh);
-
-            # Sort files naturally
-            @files = sort {
-                my ($a_name, $a_num);
-                if ($a =~ /^(.*?)(\d+)/) {
-                    ($a_name, $a_num) = ($1, $2);
-                } else {
-                    ($a_name, $a_num) = ($a, 0);
-                }
-
-                my ($b_name, $b_num);
-                if ($b =~ /^(.*?)(\d+)/) {
-                    ($b_name, $b_num) = ($1, $2);
-                } else {
-                    ($b_name, $b_num) = ($b, 0);
-                }
-
-                $a_name cmp $b_name || $a_num <=> $b_num;
-            } @files;
-
-            $files_ref = \@files;
-            $self->cached_file_lists->{$dir_path} = $files_ref;
-            print "Scanned $dir_path: " . @files . " image files found\n";
+            $files_ref = $self->_scan_image_files($dir_path) or return;
+            $self->cached_file_lists->set($dir_path, $files_ref);
+            print "Scanned $dir_path: " . @$files_ref . " image files found\n";
         }
 
         # Update loading label
         $self->loading_label->set_text("Loading " . @$files_ref . " wallpapers...");
 
-        # Load wallpapers in batches to prevent UI freezing
-        my $batch_size = 8;
+        # Create wallpaper widgets within the scheduler's frame budget
         my $loaded_count = 0;
         my $total_files = @$files_ref;
 
-        my $load_batch;
-        $load_batch = sub {
-            my $batch_start = $loaded_count;
-            my $batch_end = ($loaded_count + $batch_size - 1 < $total_files - 1)
-                           ? $loaded_count + $batch_size - 1
-                           : $total_files - 1;
-
-            # Check if directory changed while loading
-            return if $self->current_directory ne $dir_path;
-
-            for my $i ($batch_start..$batch_end) {
-                my $file = $files_ref->[$i];
+        $self->scheduler->foreach_item(
+            label => 'backgrounds: create wallpaper widgets',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $token,
+            items => $files_ref,
+            each => sub {
+                my $file = shift;
                 my $full_path = "$dir_path/$file";
 
                 my $wallpaper_widget = $self->_create_wallpaper_widget_fast($full_path, $self->zoom_level);
                 $flowbox->add($wallpaper_widget);
-            }
-
-            $loaded_count = $batch_end + 1;
-
-            # Update progress
-            my $progress = int(($loaded_count / $total_files) * 100);
-            $self->loading_label->set_text("Loading wallpapers... ${progress}%");
+                $wallpaper_widget->show_all();
 
-            $flowbox->show_all();
+                $loaded_count++;
 
-            if ($loaded_count < $total_files) {
-                # Schedule next batch
-                Glib::Timeout->add(10, $load_batch);
-                return 0; # Don't repeat this timeout
-            } else {
+                # Update progress
+                my $progress = int(($loaded_count / $total_files) * 100);
+                $self->loading_label->set_text("Loading wallpapers... ${progress}%");
+            },
+            on_done => sub {
                 # Loading complete
                 $self->loading_spinner->stop();
                 $self->loading_box->hide();
                 print "Finished loading $total_files wallpapers from $dir_path\n";
-                return 0;
+                delete $self->{load_span};
+            },
+        );
+    }
+
+    # Image files in $dir_path in natural sort order, or undef if it
+    # cannot be read
+    sub _scan_image_files {
+        my ($self, $dir_path) = @_;
+
+        opendir(my $dh, $dir_path) or return undef;
+        my @files = grep { /\.(jpg|jpeg|png|bmp|gif|webp|tiff|tif)$/i } readdir($dh);
+        closedir($dh);
+
+        # Sort files naturally
+        @files = sort {
+            my ($a_name, $a_num);
+            if ($a =~ /^(.*?)(\d+)/) {
+                ($a_name, $a_num) = ($1, $2);
+            } else {
+                ($a_name, $a_num) = ($a, 0);
             }
-        };
 
-        # Start loading first batch
-        Glib::Timeout->add(10, $load_batch);
+            my ($b_name, $b_num);
+            if ($b =~ /^(.*?)(\d+)/) {
+                ($b_name, $b_num) = ($1, $2);
+            } else {
+                ($b_name, $b_num) = ($b, 0);
+            }
+
+            $a_name cmp $b_name || $a_num <=> $b_num;
+        } @files;
+
+        return \@files;
     }
 
     sub _create_wallpaper_widget_fast {
@@ -937,14 +968,14 @@ package DesktopBackgroundsManager {
         $frame->add($box);
 
         # Store image path and widget reference
-        $self->image_paths->{$frame + 0} = $image_path;
-        $self->image_widgets->{$frame + 0} = $image;
+        $self->view->track($frame, $image_path, $image);
 
-        # Load thumbnail immediately but asynchronously using the SIZE from app_data
-        Glib::Timeout->add(50, sub {
-            $self->_load_thumbnail_async($image_path, $self->zoom_level, $image);
-            return 0; # Don't repeat
-        });
+        # Load thumbnail once the visible widgets exist, using the SIZE from app_data
+        $self->scheduler->defer(
+            label => 'backgrounds: load thumbnail',
+            token => $self->load_token,
+            run => sub { $self->_load_thumbnail_async($image_path, $self->zoom_level, $image) },
+        );
 
         return $frame;
     }
@@ -952,43 +983,50 @@ package DesktopBackgroundsManager {
     sub _load_thumbnail_async {
         my ($self, $image_path, $size, $image_widget) = @_;
 
+        my $span = TRACING && trace_span('request thumbnail', file => $image_path, size => $size);
+
         print "DEBUG: Loading thumbnail for $image_path (size: $size)\n";
 
-        # Generate cache key
-        my $cache_key = $image_path . '_' . $size;
+        # Keys include the wallpaper's mtime and size, so a hit is current
+        my $cache_key = $self->_thumbnail_key($image_path, $size);
 
         # Check memory cache first
-        if (exists $self->thumbnail_cache->{$cache_key}) {
+        if (my $pixbuf = $self->thumbnail_cache->get($cache_key)) {
             print "DEBUG: Found in memory cache\n";
-            my $pixbuf = $self->thumbnail_cache->{$cache_key};
             $image_widget->set_from_pixbuf($pixbuf);
             return;
         }
 
-        # Check disk cache
-        my $cache_file = $self->_get_cache_filename($image_path, $size);
-        print "DEBUG: Checking cache file: $cache_file\n";
+        # Then the system cache and the disk cache
+        my $cache_file = $self->thumbnail_cache->lookup($cache_key);
 
-        if (-f $cache_file && (stat($cache_file))[9] > (stat($image_path))[9]) {
+        if ($cache_file) {
             print "DEBUG: Loading from disk cache\n";
             # Load from disk cache in background
-            Glib::Timeout->add(1, sub {
-                eval {
-                    my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($cache_file);
-                    $self->thumbnail_cache->{$cache_key} = $pixbuf;
-                    $image_widget->set_from_pixbuf($pixbuf);
-                    print "DEBUG: Successfully loaded from cache\n";
-                };
-                if ($@) {
-                    print "Error loading cached thumbnail: $@\n";
-                    # Fall back to creating new thumbnail
-                    $self->_create_thumbnail_async($image_path, $size, $image_widget, $cache_key);
-                }
-                return 0; # Don't repeat
-            });
+            $self->scheduler->defer(
+                label => 'backgrounds: load cached thumbnail',
+                token => $self->load_token,
+                run => sub {
+                    my $span = TRACING && trace_span('load cached thumbnail', file => $cache_file);
+                    eval {
+                        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($cache_file);
+                        $self->thumbnail_cache->put($cache_key, $pixbuf);
+                        $image_widget->set_from_pixbuf($pixbuf);
+                        print "DEBUG: Successfully loaded from cache\n";
+                    };
+                    if ($@) {
+                        print "Error loading cached thumbnail: $@\n";
+                        # Fall back to creating new thumbnail
+                        $self->_create_thumbnail_async($image_path, $size, $image_widget, $cache_key);
+                    }
+                },
+            );
         } else {
             print "DEBUG: Creating new thumbnail\n";
-            # Create new thumbnail
+            # The session's preview daemon decodes off the UI thread and
+            # keeps the pixels hot for the other managers; without it the
+            # thumbnail is created here
+            return if $self->_request_daemon_thumbnail($image_path, $size, $image_widget, $cache_key);
             $self->_create_thumbnail_async($image_path, $size, $image_widget, $cache_key);
         }
     }
@@ -998,45 +1036,106 @@ package DesktopBackgroundsManager {
 
         print "DEBUG: Creating thumbnail async for $image_path\n";
 
-        Glib::Timeout->add(1, sub {
-            eval {
-                print "DEBUG: Actually creating pixbuf for $image_path\n";
-                # Create thumbnail with proper scaling
-                my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale($image_path, $size, $size, 1);
+        $self->scheduler->defer(
+            label => 'backgrounds: create thumbnail',
+            token => $self->load_token,
+            run => sub {
+                my $span = TRACING && trace_span('create thumbnail', file => $image_path, size => $size);
+                eval {
+                    print "DEBUG: Actually creating pixbuf for $image_path\n";
+                    # Create thumbnail with proper scaling
+                    my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale($image_path, $size, $size, 1);
+
+                    # Cache in memory
+                    $self->thumbnail_cache->put($cache_key, $pixbuf);
 
-                # Cache in memory
-                $self->thumbnail_cache->{$cache_key} = $pixbuf;
+                    # Update widget
+                    $image_widget->set_from_pixbuf($pixbuf);
+                    print "DEBUG: Successfully set pixbuf on widget\n";
 
-                # Manage cache size to prevent memory bloat
-                $self->_manage_thumbnail_cache();
+                    # Save to disk cache
+                    if (my $cache_file = $self->thumbnail_cache->store_pixbuf($cache_key, $pixbuf)) {
+                        print "DEBUG: Saved to cache: $cache_file\n";
+                    }
+
+                };
+                if ($@) {
+                    print "Error creating thumbnail for $image_path: $@\n";
+                    # Set fallback icon
+                    $image_widget->set_from_icon_name('image-x-generic', 6);
+                }
+            },
+        );
+    }
+
+    sub _request_daemon_thumbnail {
+        my ($self, $image_path, $size, $image_widget, $cache_key) = @_;
 
-                # Update widget
+        my $id = $self->preview_service->request(
+            kind => 'thumbnail',
+            source => $image_path,
+            width => $size,
+            height => $size,
+            token => $self->load_token,
+            cache_dir => $self->thumbnail_cache->cache_dir,
+            section => 'backgrounds',
+            on_done => sub {
+                my $pixbuf = CinnamonSettings::PreviewClient->pixbuf_from_argb32(shift);
+                unless ($pixbuf) {
+                    # The daemon failed; decode in-process, which also
+                    # shows the fallback icon for an unreadable image
+                    return $self->_create_thumbnail_async($image_path, $size, $image_widget, $cache_key);
+                }
+
+                $self->thumbnail_cache->put($cache_key, $pixbuf);
                 $image_widget->set_from_pixbuf($pixbuf);
-                print "DEBUG: Successfully set pixbuf on widget\n";
+            },
+        );
 
-                # Save to disk cache
-                my $cache_file = $self->_get_cache_filename($image_path, $size);
-                $pixbuf->savev($cache_file, 'png', [], []);
-                print "DEBUG: Saved to cache: $cache_file\n";
+        return defined $id;
+    }
 
-            };
-            if ($@) {
-                print "Error creating thumbnail for $image_path: $@\n";
-                # Set fallback icon
-                $image_widget->set_from_icon_name('image-x-generic', 6);
+    # Same naming as the system cache built at install time
+    sub _thumbnail_key {
+        my ($self, $image_path, $size) = @_;
+        return CinnamonSettings::PreviewCache->file_key($image_path, "-${size}x${size}.png");
+    }
+
+    # Headless --prewarm: write the thumbnail of every wallpaper at the
+    # configured size unless the system or disk cache already has it
+    sub prewarm_caches {
+        my ($self, @dirs) = @_;
+
+        my $prewarm = CinnamonSettings::Prewarm->new(app_name => 'cinnamon-backgrounds-manager');
+        $prewarm->lower_priority();
+        $self->_initialize_thumbnail_cache();
+        @dirs = map { $_->{path} } $self->_background_directories() unless @dirs;
+
+        my $size = $self->zoom_level;
+        foreach my $dir_path (grep { -d } @dirs) {
+            my $files = $self->_scan_image_files($dir_path) or next;
+            $prewarm->note("$dir_path: " . @$files . " wallpapers");
+
+            foreach my $file (@$files) {
+                my $image_path = "$dir_path/$file";
+                $prewarm->add($file, sub { $self->_prewarm_thumbnail($image_path, $size) });
             }
-            return 0; # Don't repeat
-        });
+        }
+
+        return $prewarm->run();
     }
 
-    sub _get_cache_filename {
+    sub _prewarm_thumbnail {
         my ($self, $image_path, $size) = @_;
 
-        # Create hash of the full path for unique identification
-        my $path_hash = Digest::MD5::md5_hex($image_path);
-        my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-backgrounds-manager/thumbnails';
+        # The check _load_thumbnail_async makes before decoding
+        my $cache_key = $self->_thumbnail_key($image_path, $size) or return 'failed';
+        return 'current' if $self->thumbnail_cache->lookup($cache_key);
 
-        return "$cache_dir/${path_hash}_${size}.png";
+        my $cache_file = $self->thumbnail_cache->path_for($cache_key);
+        return 'failed' unless CinnamonSettings::ThumbnailCache->scale_file($image_path, $cache_file, $size, $size);
+        $self->thumbnail_cache->adopt($cache_key);
+        return 'created';
     }
 
     sub _update_wallpaper_zoom_async {
@@ -1050,21 +1149,22 @@ package DesktopBackgroundsManager {
         $self->loading_spinner->start();
         $self->loading_label->set_text('Updating zoom level...');
 
-        # Get all children and process in batches
+        # A newer zoom request supersedes whatever is still queued
+        $self->scheduler->cancel($self->zoom_token);
+        my $token = $self->scheduler->new_token();
+        $self->zoom_token($token);
+
         my @children = $flowbox->get_children();
         my $total_children = @children;
         my $processed = 0;
-        my $batch_size = 6;
-
-        my $process_batch;
-        $process_batch = sub {
-            my $batch_start = $processed;
-            my $batch_end = ($processed + $batch_size - 1 < $total_children - 1)
-                           ? $processed + $batch_size - 1
-                           : $total_children - 1;
 
-            for my $i ($batch_start..$batch_end) {
-                my $child = $children[$i];
+        $self->scheduler->foreach_item(
+            label => 'backgrounds: update zoom',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $token,
+            items => \@children,
+            each => sub {
+                my $child = shift;
                 my $frame = $child->get_child();  # FlowBoxChild -> Frame
 
                 my $image_widget = $self->image_widgets->{$frame + 0};
@@ -1077,62 +1177,31 @@ package DesktopBackgroundsManager {
                     # Load new thumbnail asynchronously
                     $self->_load_thumbnail_async($image_path, $size, $image_widget);
                 }
-            }
-
-            $processed = $batch_end + 1;
 
-            # Update progress
-            my $progress = int(($processed / $total_children) * 100);
-            $self->loading_label->set_text("Updating zoom... ${progress}%");
+                $processed++;
 
-            if ($processed < $total_children) {
-                # Schedule next batch
-                Glib::Timeout->add(50, $process_batch);
-                return 0;
-            } else {
+                # Update progress
+                my $progress = int(($processed / $total_children) * 100);
+                $self->loading_label->set_text("Updating zoom... ${progress}%");
+            },
+            on_done => sub {
                 # Zoom update complete
                 $self->loading_spinner->stop();
                 $self->loading_box->hide();
                 print "Zoom update completed for $total_children items\n";
-                return 0;
-            }
-        };
-
-        # Start processing first batch
-        Glib::Timeout->add(10, $process_batch);
+            },
+        );
     }
 
     sub _cleanup_background_processes {
         my $self = shift;
 
         # Clear thumbnail cache to free memory
-        $self->thumbnail_cache({});
+        $self->thumbnail_cache->clear();
 
         print "Background processes cleaned up\n";
     }
 
-    sub _manage_thumbnail_cache {
-        my $self = shift;
-
-        my $cache = $self->thumbnail_cache;
-        my $max_cache_items = 500;  # Limit memory usage
-
-        if (keys %$cache > $max_cache_items) {
-            # Remove oldest entries (simple FIFO, could be improved with LRU)
-            my @keys = keys %$cache;
-            my $to_remove = @keys - $max_cache_items;
-
-            # Only run loop if there are actually items to remove
-            if ($to_remove > 0) {
-                for my $i (0..$to_remove-1) {
-                    delete $cache->{$keys[$i]};
-                }
-
-                print "Trimmed thumbnail cache: removed $to_remove items\n";
-            }
-        }
-    }
-
     sub _add_wallpaper_directory {
         my $self = shift;
 
@@ -1162,7 +1231,7 @@ package DesktopBackgroundsManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -1174,7 +1243,7 @@ package DesktopBackgroundsManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -1224,11 +1293,11 @@ package DesktopBackgroundsManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -1271,125 +1340,65 @@ package DesktopBackgroundsManager {
         return $ENV{HOME} . '/.local/share/cinnamon-backgrounds-manager/config/settings.json';
     }
 
-    sub _load_config {
+    sub _build_config_store {
         my $self = shift;
 
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            thumbnail_size => 200,
-            custom_directories => [],
-            last_selected_directory => undef,
-        };
-
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-
-                    # Validate thumbnail_size range
-                    if ($config->{thumbnail_size} < 200 || $config->{thumbnail_size} > 400) {
-                        print "Invalid thumbnail size in config, using default\n";
-                        $config->{thumbnail_size} = 200;
-                    }
-
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                thumbnail_size => 200,
+                custom_directories => [],
+                last_selected_directory => undef,
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
 
-                    print "Loaded configuration from $config_file\n";
-                    print "  Thumbnail size: " . $config->{thumbnail_size} . "\n";
-                    print "  Custom directories: " . @{$config->{custom_directories}} . "\n";
-                    print "  Last directory: " . ($config->{last_selected_directory} || 'none') . "\n";
-                } else {
-                    print "Config file is empty, using defaults\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration\n";
-            }
-        } else {
-            print "Config file not found, using defaults\n";
-        }
+    sub _load_config {
+        my $self = shift;
 
-        return $config;
+        return $self->config_store->load();
     }
 
-    sub _save_config {
+    sub _validate_config {
         my ($self, $config) = @_;
 
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
-
-        print "DEBUG: Attempting to save config to: $config_file\n";
-        print "DEBUG: Saving thumbnail_size: " . ($config->{thumbnail_size} || 'undef') . "\n";
-        print "DEBUG: Saving custom_directories count: " . (@{$config->{custom_directories} || []}) . "\n";
-        print "DEBUG: Saving last_selected_directory: " . ($config->{last_selected_directory} || 'undef') . "\n";
-
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-                print "DEBUG: Created config directory: $config_dir\n";
-            }
-
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
-
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
-
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
-
-            # Verify the final file exists and has content
-            unless (-f $config_file && -s $config_file) {
-                die "Final config file was not created or is empty";
-            }
+        # Validate thumbnail_size range
+        if (!$config->{thumbnail_size} || $config->{thumbnail_size} < 200 || $config->{thumbnail_size} > 400) {
+            print "Invalid thumbnail size in config, using default\n";
+            $config->{thumbnail_size} = 200;
+        }
 
-            print "DEBUG: Successfully saved configuration to $config_file\n";
-            print "DEBUG: File size: " . (-s $config_file) . " bytes\n";
-            print "  Thumbnail size: " . $config->{thumbnail_size} . "\n";
-            print "  Custom directories: " . @{$config->{custom_directories}} . "\n";
-            print "  Last directory: " . ($config->{last_selected_directory} || 'none') . "\n";
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
+    }
 
-            # Verify by reading back the file
-            open my $verify_fh, '<:encoding(UTF-8)', $config_file or die "Cannot read back config file for verification: $!";
-            my $verify_content = do { local $/; <$verify_fh> };
-            close $verify_fh;
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
 
-            if ($verify_content && length($verify_content) > 0) {
-                print "DEBUG: Config file verification successful\n";
-            } else {
-                die "Config file verification failed - file is empty";
-            }
+        return unless $self->wallpaper_grid;
 
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
+        if (grep { $_ eq 'thumbnail_size' } @$keys) {
+            $self->zoom_level($self->config->{thumbnail_size});
+            $self->_update_wallpaper_zoom_async();
         }
     }
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-backgrounds-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Desktop Backgrounds Manager started\n";
         Gtk3::main();
     }
@@ -1397,6 +1406,12 @@ package DesktopBackgroundsManager {
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit DesktopBackgroundsManager->new(prewarm => 1)->prewarm_caches(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = DesktopBackgroundsManager->new();
     $app->run();
 }
@@ -7,13 +7,27 @@ use utf8;
 # A dedicated cursor theme management application for Linux Mint Cinnamon
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use File::Basename qw(basename dirname);
 use JSON qw(encode_json decode_json);
 use Data::Dumper;
-use Digest::MD5 qw(md5_hex);
+use Cairo;
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::Session;
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::BudgetCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
+use CinnamonSettings::SystemCache;
+use CinnamonSettings::PreviewCache;
+use CinnamonSettings::PreviewClient;
+use CinnamonSettings::ArchivePreviewDialog;
+use CinnamonSettings::Prewarm;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -24,6 +38,12 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CursorThemesManager {
     use Moo;
+    use Cwd qw(realpath);
+    use File::Path qw(remove_tree);
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
+
+    # Left in a ~/.icons theme by _optimize_cursor_theme
+    use constant OPTIMIZED_MARKER => '.csm-optimized';
 
     has 'window' => (is => 'rw');
     has 'directory_list' => (is => 'rw');
@@ -32,17 +52,45 @@ package CursorThemesManager {
     has 'cursor_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
     has 'zoom_level' => (is => 'rw', default => sub { 200 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_paths' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
     has 'loading_box' => (is => 'rw');
     has 'current_directory' => (is => 'rw');
-    has 'cached_theme_lists' => (is => 'rw', default => sub { {} });
+    has 'cached_theme_lists' => (is => 'ro', default => sub {
+        CinnamonSettings::BudgetCache->new(name => 'theme lists', budget_bytes => 16 * 1024 * 1024)
+    });
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
-    has 'cursor_cache' => (is => 'rw', default => sub { {} });
+    has 'cursor_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::PreviewCache->new(
+            name => 'cursor previews',
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-cursor-theme-manager/thumbnails',
+            memory_budget => 32 * 1024 * 1024,
+            shared => CinnamonSettings::SystemCache->new(section => 'cursors'),
+        )
+    });
     has 'cursor_preview_size' => (is => 'rw', default => sub { 40 });
+    has 'session' => (is => 'ro', default => sub {
+        CinnamonSettings::Session->new(app_name => 'cinnamon-cursor-themes-manager')
+    });
+    has 'preview_service' => (is => 'ro', default => sub { CinnamonSettings::PreviewClient->new() });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-cursor-themes-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-cursor-theme-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
+    # Cursor decodes for the archive preview dialog
+    has 'archive_token' => (is => 'rw');
+    # Headless --prewarm run: configuration only, no windows
+    has 'prewarm' => (is => 'ro', default => sub { 0 });
 
     # Cursor types for preview extraction
     has 'cursor_types' => (is => 'ro', default => sub { [
@@ -66,9 +114,16 @@ package CursorThemesManager {
         { name => 'fd_double_arrow', desc => 'Resize Anti-Diagonal', aliases => ['size_fdiag', 'nwse-resize'] }
     ] });
 
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Frame address lookups into the current directory's view
+    sub theme_paths { $_[0]->view->paths }
+
     sub BUILD {
         my $self = shift;
         $self->_initialize_configuration();
+        return if $self->prewarm;
         $self->_setup_ui();
         $self->_populate_cursor_directories();
         $self->_restore_last_selected_directory();
@@ -146,18 +201,22 @@ package CursorThemesManager {
         return $ENV{HOME} . '/.local/share/cinnamon-cursor-theme-manager/config/settings.json';
     }
 
-    sub _get_cache_filename {
-        my ($self, $theme_name, $cursor_type) = @_;
-
-        # Use the dynamic cursor preview size
-        my $target_size = $self->cursor_preview_size;
+    # Key of a cursor file's frame at the current preview size; the same
+    # naming as the system cache built at install time
+    sub _cursor_key {
+        my ($self, $cursor_file) = @_;
+        return CinnamonSettings::PreviewCache->file_key($cursor_file, '_' . $self->cursor_preview_size . '.argb32');
+    }
 
-        # Create hash of the theme name, cursor type, and size for unique identification
-        my $cache_key = "${theme_name}_${cursor_type}_${target_size}";
-        my $cache_hash = Digest::MD5::md5_hex($cache_key);
-        my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-cursor-theme-manager/thumbnails';
+    # Cached frame from memory, the system cache or the disk cache
+    sub _load_cached_frame {
+        my ($self, $cache_key) = @_;
+        return $self->cursor_cache->load($cache_key, sub { $self->_load_cursor_frame(shift) }, \&_frame_bytes);
+    }
 
-        return "$cache_dir/${cache_hash}_${target_size}.png";
+    sub _frame_bytes {
+        my $frame = shift;
+        return $frame->{width} * $frame->{height} * 4 + 64;
     }
 
     sub _setup_ui {
@@ -204,10 +263,12 @@ package CursorThemesManager {
         $control_container->set_margin_top(6);
         $control_container->set_margin_bottom(6);
 
-        my ($add_dir_button, $remove_dir_button) = $self->_create_directory_buttons();
+        my ($add_dir_button, $remove_dir_button, $build_theme_button, $archive_button) = $self->_create_directory_buttons();
 
         $control_container->pack_start($add_dir_button, 1, 1, 0);
         $control_container->pack_start($remove_dir_button, 1, 1, 0);
+        $control_container->pack_start($build_theme_button, 1, 1, 0);
+        $control_container->pack_start($archive_button, 1, 1, 0);
 
         $left_container->pack_start($control_container, 0, 0, 0);
 
@@ -328,13 +389,13 @@ package CursorThemesManager {
         $self->loading_box($loading_box);
 
         # Connect signals
-        $self->_connect_signals($add_dir_button, $remove_dir_button, $zoom_in, $zoom_out);
+        $self->_connect_signals($add_dir_button, $remove_dir_button, $build_theme_button, $archive_button, $zoom_in, $zoom_out);
 
         print "UI setup completed\n";
     }
 
     sub _connect_signals {
-        my ($self, $add_dir_button, $remove_dir_button, $zoom_in, $zoom_out) = @_;
+        my ($self, $add_dir_button, $remove_dir_button, $build_theme_button, $archive_button, $zoom_in, $zoom_out) = @_;
 
         # Connect signals for mode buttons
         $self->_connect_mode_button_signals($self->cursor_mode, $self->settings_mode, $self->content_switcher);
@@ -347,7 +408,7 @@ package CursorThemesManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_cursor_themes_from_directory($row);
@@ -361,6 +422,14 @@ package CursorThemesManager {
             $self->_remove_cursor_directory();
         });
 
+        $build_theme_button->signal_connect('clicked' => sub {
+            $self->_build_cursor_theme();
+        });
+
+        $archive_button->signal_connect('clicked' => sub {
+            $self->_preview_cursor_archive();
+        });
+
         # Updated zoom button functionality - DON'T force refresh, use cache
         $zoom_in->signal_connect('clicked' => sub {
             my $current_size = $self->cursor_preview_size;
@@ -371,10 +440,10 @@ package CursorThemesManager {
 
             # Save cursor preview size to config
             $self->config->{cursor_preview_size} = $new_size;
-            $self->_save_config($self->config);
+            $self->config_store->save();
 
             # Clear cursor cache since size changed, then refresh current directory
-            $self->cursor_cache({});  # Clear memory cache
+            $self->cursor_cache->clear();  # Clear memory cache
             my $selected_row = $self->directory_list->get_selected_row();
             if ($selected_row) {
                 $self->_load_cursor_themes_from_directory($selected_row, 1); # Force refresh due to size change
@@ -392,10 +461,10 @@ package CursorThemesManager {
 
             # Save cursor preview size to config
             $self->config->{cursor_preview_size} = $new_size;
-            $self->_save_config($self->config);
+            $self->config_store->save();
 
             # Clear cursor cache since size changed, then refresh current directory
-            $self->cursor_cache({});  # Clear memory cache
+            $self->cursor_cache->clear();  # Clear memory cache
             my $selected_row = $self->directory_list->get_selected_row();
             if ($selected_row) {
                 $self->_load_cursor_themes_from_directory($selected_row, 1); # Force refresh due to size change
@@ -420,8 +489,13 @@ package CursorThemesManager {
         });
 
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
+            $self->session->report_stats();
+            $self->cursor_cache->report_stats();
+            $self->preview_service->report_stats();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -559,6 +633,13 @@ package CursorThemesManager {
 
         $info_box->pack_start($reset_button, 0, 0, 0);
 
+        # Rewrite the current theme into ~/.icons so it loads faster
+        my $optimize_button = Gtk3::Button->new_with_label('Optimize Current Theme');
+        $optimize_button->set_halign('start');
+        $optimize_button->set_tooltip_text('Install a smaller copy of the theme in ~/.icons: duplicate cursors become symlinks and repeated frames are merged');
+
+        $info_box->pack_start($optimize_button, 0, 0, 0);
+
         $info_frame->add($info_box);
         $settings_box->pack_start($info_frame, 0, 0, 0);
 
@@ -632,6 +713,10 @@ package CursorThemesManager {
             }
         });
 
+        $optimize_button->signal_connect('clicked' => sub {
+            $self->_optimize_cursor_theme($self->_get_current_cursor_theme(), $optimize_button);
+        });
+
         $settings_box->pack_start($apply_button, 0, 0, 12);
 
         # Load current settings
@@ -665,7 +750,23 @@ package CursorThemesManager {
         my $remove_icon = Gtk3::Image->new_from_icon_name('list-remove-symbolic', 1);
         $remove_button->add($remove_icon);
 
-        return ($add_button, $remove_button);
+        my $build_button = Gtk3::Button->new();
+        $build_button->set_relief('none');
+        $build_button->set_size_request(32, 32);
+        $build_button->set_tooltip_text('Build cursor theme from PNG sources');
+
+        my $build_icon = Gtk3::Image->new_from_icon_name('document-new-symbolic', 1);
+        $build_button->add($build_icon);
+
+        my $archive_button = Gtk3::Button->new();
+        $archive_button->set_relief('none');
+        $archive_button->set_size_request(32, 32);
+        $archive_button->set_tooltip_text('Preview and install a cursor theme archive');
+
+        my $archive_icon = Gtk3::Image->new_from_icon_name('package-x-generic-symbolic', 1);
+        $archive_button->add($archive_icon);
+
+        return ($add_button, $remove_button, $build_button, $archive_button);
     }
 
     sub _create_custom_zoom_buttons {
@@ -947,43 +1048,33 @@ package CursorThemesManager {
         foreach my $child ($self->directory_list->get_children()) {
             $self->directory_list->remove($child);
         }
-        $self->directory_paths({});  # Clear path mappings
+        $self->directory_view->release();
+        $self->directory_view(CinnamonSettings::ViewState->new());
+
+        foreach my $dir_info ($self->_cursor_directories()) {
+            my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
+            $self->directory_view->track($row, $dir_info->{path});
+            $self->directory_list->add($row);
+        }
+
+        print "Populated cursor directories without duplicates\n";
+    }
+
+    # Default cursor directories followed by custom ones from the config,
+    # each existing path once
+    sub _cursor_directories {
+        my $self = shift;
 
         # Default cursor directories - ONLY the ones that actually work for cursor themes
-        my @default_dirs = (
+        my @dirs = (
             { name => 'User Cursors', path => $ENV{HOME} . '/.icons' },
             { name => 'System Cursors', path => '/usr/share/icons' },
             { name => 'Local System Cursors', path => '/usr/local/share/icons' },
+            @{$self->config->{custom_directories} || []},
         );
 
-        # Track added paths to prevent duplicates
         my %added_paths;
-
-        # Add default directories
-        foreach my $dir_info (@default_dirs) {
-            next unless -d $dir_info->{path};
-            next if $added_paths{$dir_info->{path}};  # Skip if already added
-
-            my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
-            $self->directory_list->add($row);
-            $added_paths{$dir_info->{path}} = 1;
-        }
-
-        # Add custom directories from config
-        if ($self->config->{custom_directories}) {
-            foreach my $custom_dir (@{$self->config->{custom_directories}}) {
-                next unless -d $custom_dir->{path};
-                next if $added_paths{$custom_dir->{path}};  # Skip if already added
-
-                my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
-                $self->directory_list->add($row);
-                $added_paths{$custom_dir->{path}} = 1;
-            }
-        }
-
-        print "Populated cursor directories without duplicates\n";
+        return grep { -d $_->{path} && !$added_paths{$_->{path}}++ } @dirs;
     }
 
     sub _create_directory_row {
@@ -1069,6 +1160,14 @@ package CursorThemesManager {
 
         print "DEBUG: Loading cursor themes from directory: $dir_path\n";
 
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Drop whatever is still queued for the previously selected directory
+        $self->scheduler->cancel($self->load_token);
+        $self->preview_service->cancel_token($self->load_token);
+        my $token = $self->scheduler->new_token();
+        $self->load_token($token);
+
         # Show loading indicator
         $self->loading_label->set_text('Scanning directory...');
         $self->loading_box->show_all();
@@ -1082,59 +1181,63 @@ package CursorThemesManager {
         }
 
         # Clear the theme references completely
-        $self->theme_paths({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
 
         # Store current directory for reference
         $self->current_directory($dir_path);
 
-        # Process UI updates immediately
-        while (Gtk3::events_pending()) {
-            Gtk3::main_iteration();
+        # Check if we have cached theme list for this directory (unless force refresh)
+        if (!$force_refresh && $self->cached_theme_lists->contains($dir_path)) {
+            my $themes = $self->cached_theme_lists->get($dir_path);
+            print "Using cached theme list for $dir_path (" . @$themes . " themes)\n";
+            $self->loading_label->set_text('Loading cached themes...');
+            $self->_populate_cursor_grid($dir_path, $themes, $token);
+            return;
         }
 
-        # Use timeout to allow UI to update before scanning
-        Glib::Timeout->add(50, sub {
-            # Double-check we're still loading the same directory
-            return 0 if !$self->current_directory || $self->current_directory ne $dir_path;
+        # Show scanning progress
+        $self->loading_label->set_text('Scanning for cursor themes...');
 
-            # Check if we have cached theme list for this directory (unless force refresh)
-            my @themes;
-            if (!$force_refresh && exists $self->cached_theme_lists->{$dir_path}) {
-                @themes = @{$self->cached_theme_lists->{$dir_path}};
-                print "Using cached theme list for $dir_path (" . @themes . " themes)\n";
-                $self->loading_label->set_text('Loading cached themes...');
-            } else {
-                # Show scanning progress
-                $self->loading_label->set_text('Scanning for cursor themes...');
-                while (Gtk3::events_pending()) {
-                    Gtk3::main_iteration();
-                }
+        # Scan directory for cursor themes
+        $self->_scan_cursor_themes_with_progress($dir_path, $token, sub {
+            my $themes = shift;
+            $self->cached_theme_lists->set($dir_path, $themes);
+            print "Scanned $dir_path: " . @$themes . " cursor themes found\n";
+            $self->_populate_cursor_grid($dir_path, $themes, $token);
+        });
+    }
 
-                # Scan directory for cursor themes
-                @themes = $self->_scan_cursor_themes_with_progress($dir_path);
-                $self->cached_theme_lists->{$dir_path} = \@themes;
-                print "Scanned $dir_path: " . @themes . " cursor themes found\n";
-            }
+    # Create one preview widget per scheduler step so extraction of an
+    # uncached theme never holds up input or redraws for long
+    sub _populate_cursor_grid {
+        my ($self, $dir_path, $themes, $token) = @_;
+
+        my $flowbox = $self->cursor_grid;
+        my $loaded_count = 0;
+        my $total_themes = @$themes;
 
-            # Quick load - just create the widgets without processing cursors again
-            my $loaded_count = 0;
-            my $total_themes = @themes;
+        # Track loaded theme names to prevent duplicates within this directory
+        my %loaded_themes;
 
-            # Track loaded theme names to prevent duplicates within this directory
-            my %loaded_themes;
+        $self->scheduler->foreach_item(
+            label => 'cursor: create theme widgets',
+            token => $token,
+            items => $themes,
+            each => sub {
+                my $theme_info = shift;
 
-            foreach my $theme_info (@themes) {
                 # Skip if we've already loaded this theme name
                 if ($loaded_themes{$theme_info->{name}}) {
                     print "Skipping duplicate theme: " . $theme_info->{name} . "\n";
-                    next;
-                }
-
-                # Quick widget creation - check if all cursors are already cached
-                my $theme_widget = $self->_create_cursor_preview_widget_cached($theme_info);
-                if ($theme_widget) {
-                    $flowbox->add($theme_widget);
-                    $loaded_themes{$theme_info->{name}} = 1;  # Mark as loaded
+                } else {
+                    # Quick widget creation - check if all cursors are already cached
+                    my $theme_widget = $self->_create_cursor_preview_widget_cached($theme_info);
+                    if ($theme_widget) {
+                        $flowbox->add($theme_widget);
+                        $theme_widget->show_all();
+                        $loaded_themes{$theme_info->{name}} = 1;  # Mark as loaded
+                    }
                 }
 
                 $loaded_count++;
@@ -1143,32 +1246,23 @@ package CursorThemesManager {
                 if ($loaded_count % 5 == 0 || $loaded_count == $total_themes) {
                     my $progress = $total_themes > 0 ? int(($loaded_count / $total_themes) * 100) : 100;
                     $self->loading_label->set_text("Loading themes... ${progress}% (${loaded_count}/${total_themes})");
-
-                    # Process UI updates
-                    while (Gtk3::events_pending()) {
-                        Gtk3::main_iteration();
-                    }
                 }
-            }
-
-            # Show all widgets at once
-            $flowbox->show_all();
-
-            # Loading complete - manage cache only ONCE at the end
-            $self->_manage_cursor_cache();
-
-            $self->loading_spinner->stop();
-            $self->loading_box->hide();
-            my $unique_count = keys %loaded_themes;
-            print "Finished loading $unique_count unique cursor themes from $dir_path\n";
-
-            return 0; # Don't repeat this timeout
-        });
+            },
+            on_done => sub {
+                $self->loading_spinner->stop();
+                $self->loading_box->hide();
+                my $unique_count = keys %loaded_themes;
+                print "Finished loading $unique_count unique cursor themes from $dir_path\n";
+                delete $self->{load_span};
+            },
+        );
     }
 
     sub _create_cursor_preview_widget_cached {
         my ($self, $theme_info) = @_;
 
+        my $span = TRACING && trace_span('create cursor theme widget', theme => $theme_info->{name});
+
         # Check if we already have a widget for this theme path to prevent duplicates
         foreach my $existing_key (keys %{$self->theme_paths}) {
             my $existing_info = $self->theme_paths->{$existing_key};
@@ -1189,25 +1283,13 @@ package CursorThemesManager {
         foreach my $cursor_type (@{$self->cursor_types}) {
             my $cursor_file = $self->_find_cursor_file($cursors_path, $cursor_type);
             if ($cursor_file) {
-                my $cache_file = $self->_get_cache_filename($theme_info->{name}, $cursor_type->{name});
-                if (-f $cache_file && (stat($cache_file))[9] > (stat($cursor_file))[9]) {
-                    # Cache exists and is newer than source
-                    eval {
-                        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($cache_file);
-                        if ($pixbuf) {
-                            push @cached_cursors, {
-                                pixbuf => $pixbuf,
-                                name => $cursor_type->{desc}
-                            };
-                        } else {
-                            $all_cached = 0;
-                            last;
-                        }
+                # Keys include the source's mtime, so a hit is current
+                my $frame = eval { $self->_load_cached_frame($self->_cursor_key($cursor_file)) };
+                if ($frame) {
+                    push @cached_cursors, {
+                        frame => $frame,
+                        name => $cursor_type->{desc}
                     };
-                    if ($@) {
-                        $all_cached = 0;
-                        last;
-                    }
                 } else {
                     $all_cached = 0;
                     last;
@@ -1218,7 +1300,7 @@ package CursorThemesManager {
         # If all cursors are cached, create widget quickly
         if ($all_cached && @cached_cursors > 0) {
             print "All cursors cached for theme: " . $theme_info->{display_name} . " - quick load\n";
-            return $self->_create_cursor_widget_from_cached_pixbufs($theme_info, \@cached_cursors);
+            return $self->_create_cursor_widget_from_cached_frames($theme_info, \@cached_cursors);
         } else {
             # Fall back to full processing (this will happen on first run or cache miss)
             print "Cache miss for theme: " . $theme_info->{display_name} . " - full processing\n";
@@ -1226,7 +1308,7 @@ package CursorThemesManager {
         }
     }
 
-    sub _create_cursor_widget_from_cached_pixbufs {
+    sub _create_cursor_widget_from_cached_frames {
         my ($self, $theme_info, $cached_cursors) = @_;
 
         # Create main container with proper alignment
@@ -1293,77 +1375,81 @@ package CursorThemesManager {
         $container->pack_start($dark_panel, 0, 0, 0);
         $container->pack_start($label, 0, 0, 0);
 
-        # Store theme info for later retrieval - use unique key
-        my $widget_key = $container + 0;
-        $self->theme_paths->{$widget_key} = $theme_info;
+        # Store theme info for later retrieval
+        $self->view->track($container, $theme_info);
 
         return $container;
     }
 
     sub _scan_cursor_themes_with_progress {
-        my ($self, $dir_path) = @_;
+        my ($self, $dir_path, $token, $on_done) = @_;
 
         my @themes;
         my %seen_themes;  # Track themes by name to prevent duplicates
 
         # Open directory
-        opendir(my $dh, $dir_path) or return @themes;
-        my @entries = readdir($dh);
-        closedir($dh);
+        my @entries;
+        if (opendir(my $dh, $dir_path)) {
+            @entries = grep { !/^\.\.?$/ } readdir($dh);  # Skip . and ..
+            closedir($dh);
+        }
 
         my $total_entries = @entries;
         my $processed = 0;
 
-        foreach my $entry (@entries) {
-            next if $entry =~ /^\.\.?$/; # Skip . and ..
+        $self->scheduler->foreach_item(
+            label => 'cursor: scan theme directory',
+            token => $token,
+            items => \@entries,
+            each => sub {
+                my $entry = shift;
 
-            $processed++;
+                $processed++;
 
-            # Update progress every few entries
-            if ($processed % 10 == 0 || $processed == $total_entries) {
-                my $progress = int(($processed / $total_entries) * 100);
-                $self->loading_label->set_text("Scanning... ${progress}% (${processed}/${total_entries})");
-                while (Gtk3::events_pending()) {
-                    Gtk3::main_iteration();
+                # Update progress every few entries
+                if ($processed % 10 == 0 || $processed == $total_entries) {
+                    my $progress = int(($processed / $total_entries) * 100);
+                    $self->loading_label->set_text("Scanning... ${progress}% (${processed}/${total_entries})");
                 }
-            }
 
-            my $theme_path = "$dir_path/$entry";
-            next unless -d $theme_path; # Only directories
+                my $theme_path = "$dir_path/$entry";
+                return unless -d $theme_path; # Only directories
 
-            # Skip if we've already seen this theme name
-            next if $seen_themes{$entry};
+                # Skip if we've already seen this theme name
+                return if $seen_themes{$entry};
 
-            # Check if this is a cursor theme directory
-            my $cursor_dir = "$theme_path/cursors";
-
-            # Must have cursors directory with actual cursor files
-            next unless -d $cursor_dir;
+                # Check if this is a cursor theme directory
+                my $cursor_dir = "$theme_path/cursors";
 
-            # Verify the cursors directory contains actual cursor files
-            opendir(my $cdh, $cursor_dir) or next;
-            my @cursor_files = grep { -f "$cursor_dir/$_" && $_ !~ /^\./ } readdir($cdh);
-            closedir($cdh);
+                # Must have cursors directory with actual cursor files
+                return unless -d $cursor_dir;
 
-            # Skip if no cursor files found
-            next unless @cursor_files > 0;
+                # Verify the cursors directory contains actual cursor files
+                opendir(my $cdh, $cursor_dir) or return;
+                my @cursor_files = grep { -f "$cursor_dir/$_" && $_ !~ /^\./ } readdir($cdh);
+                closedir($cdh);
 
-            # Create theme info
-            my $theme_info = {
-                name => $entry,
-                path => $theme_path,
-                display_name => $self->_get_cursor_theme_display_name($theme_path, $entry)
-            };
+                # Skip if no cursor files found
+                return unless @cursor_files > 0;
 
-            push @themes, $theme_info;
-            $seen_themes{$entry} = 1;  # Mark as seen
-        }
+                # Create theme info
+                my $theme_info = {
+                    name => $entry,
+                    path => $theme_path,
+                    display_name => $self->_get_cursor_theme_display_name($theme_path, $entry)
+                };
 
-        # Sort themes by display name
-        @themes = sort { $a->{display_name} cmp $b->{display_name} } @themes;
+                push @themes, $theme_info;
+                $seen_themes{$entry} = 1;  # Mark as seen
+            },
+            on_done => sub {
+                # Sort themes by display name
+                @themes = sort { $a->{display_name} cmp $b->{display_name} } @themes;
 
-        print "Scanned $dir_path: found " . @themes . " unique cursor themes\n";
-        return @themes;
+                print "Scanned $dir_path: found " . @themes . " unique cursor themes\n";
+                $on_done->(\@themes);
+            },
+        );
     }
 
 
@@ -1452,12 +1538,14 @@ package CursorThemesManager {
         $container->set_halign('center');  # Center the container horizontally
         $container->set_valign('start');   # Align to top vertically
 
-        # Load cursor pixbufs for this theme
-        my @cursor_pixbufs = $self->_load_cursor_pixbufs_for_theme($theme_info);
+        # Load cursor frames for this theme; frames that are still being
+        # extracted are drawn once they arrive
+        my @panels;
+        my @cursor_frames = $self->_load_cursor_frames_for_theme($theme_info, sub { $_->queue_draw() foreach @panels });
 
         # Only create the widget if we have cursors to display
-        if (@cursor_pixbufs == 0) {
-            print "Warning: No cursor pixbufs loaded for theme: " . $theme_info->{display_name} . "\n";
+        if (@cursor_frames == 0) {
+            print "Warning: No cursor frames loaded for theme: " . $theme_info->{display_name} . "\n";
             return undef;
         }
 
@@ -1470,6 +1558,7 @@ package CursorThemesManager {
         my $dark_panel = Gtk3::DrawingArea->new();
         $dark_panel->set_size_request(300, 200);
         $dark_panel->set_halign('center');   # Center the drawing area
+        @panels = ($light_panel, $dark_panel);
 
         # Light panel draw handler
         $light_panel->signal_connect('draw' => sub {
@@ -1484,7 +1573,7 @@ package CursorThemesManager {
             $cr->stroke();
 
             # Draw cursors in grid
-            $self->_draw_cursor_grid($cr, \@cursor_pixbufs, 300, 200);
+            $self->_draw_cursor_grid($cr, \@cursor_frames, 300, 200);
 
             return 0;
         });
@@ -1502,7 +1591,7 @@ package CursorThemesManager {
             $cr->stroke();
 
             # Draw cursors in grid
-            $self->_draw_cursor_grid($cr, \@cursor_pixbufs, 300, 200);
+            $self->_draw_cursor_grid($cr, \@cursor_frames, 300, 200);
 
             return 0;
         });
@@ -1519,309 +1608,335 @@ package CursorThemesManager {
         $container->pack_start($dark_panel, 0, 0, 0);
         $container->pack_start($label, 0, 0, 0);
 
-        # Store theme info for later retrieval - use unique key
-        my $widget_key = $container + 0;
-        $self->theme_paths->{$widget_key} = $theme_info;
+        # Store theme info for later retrieval
+        $self->view->track($container, $theme_info);
 
-        print "Created preview widget for theme: " . $theme_info->{display_name} . " with " . @cursor_pixbufs . " cursors\n";
+        print "Created preview widget for theme: " . $theme_info->{display_name} . " with " . @cursor_frames . " cursors\n";
 
         return $container;
     }
 
-    sub _load_cursor_pixbufs_for_theme {
-        my ($self, $theme_info) = @_;
+    sub _load_cursor_frames_for_theme {
+        my ($self, $theme_info, $redraw) = @_;
 
-        my @cursor_pixbufs;
+        my @cursor_frames;
         my $cursors_path = "$theme_info->{path}/cursors";
 
-        return @cursor_pixbufs unless -d $cursors_path;
+        return @cursor_frames unless -d $cursors_path;
 
-        print "DEBUG: Loading cursor pixbufs for theme: " . $theme_info->{display_name} . "\n";
+        print "DEBUG: Loading cursor frames for theme: " . $theme_info->{display_name} . "\n";
 
         foreach my $cursor_type (@{$self->cursor_types}) {
             my $cursor_file = $self->_find_cursor_file($cursors_path, $cursor_type);
             if ($cursor_file) {
                 print "DEBUG: Found cursor file: $cursor_file for type: " . $cursor_type->{name} . "\n";
-                my $pixbuf = $self->_extract_cursor_pixbuf_cached($cursor_file, $theme_info->{name}, $cursor_type->{name});
-                if ($pixbuf) {
-                    print "DEBUG: Successfully extracted pixbuf for: " . $cursor_type->{name} . "\n";
-                    push @cursor_pixbufs, {
-                        pixbuf => $pixbuf,
-                        name => $cursor_type->{desc}
-                    };
-                } else {
-                    print "DEBUG: Failed to extract pixbuf for: " . $cursor_type->{name} . "\n";
-                }
+                my $entry = { frame => undef, name => $cursor_type->{desc} };
+                $entry->{frame} = $self->_extract_cursor_frame_cached($cursor_file, $theme_info->{name}, $cursor_type->{name}, sub {
+                    $entry->{frame} = shift;
+                    $redraw->() if $redraw;
+                });
+                push @cursor_frames, $entry;
             } else {
                 print "DEBUG: No cursor file found for type: " . $cursor_type->{name} . "\n";
             }
         }
 
-        print "DEBUG: Loaded " . @cursor_pixbufs . " cursor pixbufs for theme: " . $theme_info->{display_name} . "\n";
+        print "DEBUG: Loaded " . @cursor_frames . " cursor frames for theme: " . $theme_info->{display_name} . "\n";
 
-        return @cursor_pixbufs;
+        return @cursor_frames;
     }
 
 
-    sub _extract_cursor_pixbuf_cached {
-        my ($self, $cursor_file, $theme_name, $cursor_type) = @_;
+    # Frame of $cursor_file if it is cached; otherwise undef, and $on_frame
+    # gets the frame once the daemon or the scheduler has extracted it
+    sub _extract_cursor_frame_cached {
+        my ($self, $cursor_file, $theme_name, $cursor_type, $on_frame) = @_;
+
+        my $span = TRACING && trace_span('extract cursor', theme => $theme_name, cursor => $cursor_type);
 
         # Use dynamic cursor preview size for cache key
         my $target_size = $self->cursor_preview_size;
+        my $cache_key = $self->_cursor_key($cursor_file);
 
-        # Generate cache key without file path to allow size-based caching
-        my $cache_key = "${theme_name}_${cursor_type}_${target_size}";
-
-        # Check memory cache first
-        if (exists $self->cursor_cache->{$cache_key}) {
-            print "DEBUG: Found cursor in memory cache: $cache_key\n";
-            return $self->cursor_cache->{$cache_key};
+        # Memory first, then frames of system themes extracted at install
+        # time, then the disk cache; unreadable entries are dropped
+        if (my $frame = $self->_load_cached_frame($cache_key)) {
+            return $frame;
         }
 
-        # Check disk cache
-        my $cache_file = $self->_get_cache_filename($theme_name, $cursor_type);
+        # The session's preview daemon extracts it into the disk cache and
+        # keeps it hot for the next manager or theme list
+        my $id = $self->preview_service->request(
+            kind => 'cursor',
+            source => $cursor_file,
+            width => $target_size,
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $self->load_token,
+            cache_dir => $self->cursor_cache->cache_dir,
+            section => 'cursors',
+            on_done => sub {
+                my $data = shift;
+                my $frame = defined $data ? $self->_frame_from_argb32($data) : undef;
+                # The daemon failed; extract in-process
+                return $self->_extract_cursor_frame_async($cursor_file, $cache_key, $on_frame) unless $frame;
+
+                $self->cursor_cache->put($cache_key, $frame, _frame_bytes($frame));
+                $on_frame->($frame);
+            },
+        );
+        $self->_extract_cursor_frame_async($cursor_file, $cache_key, $on_frame) unless defined $id;
 
-        if (-f $cache_file && (stat($cache_file))[9] > (stat($cursor_file))[9]) {
-            print "DEBUG: Loading cursor from disk cache: $cache_file\n";
-            eval {
-                my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($cache_file);
-                if ($pixbuf) {
-                    # Verify the cached pixbuf matches the current target size
-                    my $cached_width = $pixbuf->get_width();
-                    my $cached_height = $pixbuf->get_height();
-                    my $cached_size = $cached_width > $cached_height ? $cached_width : $cached_height;
-
-                    # If cached size doesn't match current target size, regenerate
-                    if (abs($cached_size - $target_size) > 2) {  # Allow 2px tolerance
-                        print "DEBUG: Cached size ($cached_size) doesn't match target ($target_size), regenerating\n";
-                        unlink $cache_file;  # Remove outdated cache
-                    } else {
-                        $self->cursor_cache->{$cache_key} = $pixbuf;
-                        return $pixbuf;
-                    }
-                }
-            };
-            if ($@) {
-                print "Error loading cached cursor: $@\n";
-                # Delete corrupted cache file
-                unlink $cache_file;
-            } else {
-                return $self->cursor_cache->{$cache_key} if $self->cursor_cache->{$cache_key};
-            }
+        return undef;
+    }
+
+    # Extract a frame from the scheduler, so a directory of uncached themes
+    # never runs the extractor from inside a widget's creation
+    sub _extract_cursor_frame_async {
+        my ($self, $cursor_file, $cache_key, $on_frame) = @_;
+
+        $self->scheduler->defer(
+            label => 'cursor: extract frame',
+            token => $self->load_token,
+            run => sub {
+                my $frame = $self->_extract_cursor_frame($cursor_file, $cache_key);
+                $on_frame->($frame) if $frame;
+            },
+        );
+    }
+
+    sub _extract_cursor_frame {
+        my ($self, $cursor_file, $cache_key) = @_;
+
+        # Without xcursor_extractor the gdk-pixbuf Xcursor loader, if it is
+        # installed, decodes the frame; those frames are only kept in memory
+        if (!$self->_find_helper_binary('xcursor_extractor') && $self->_have_xcursor_loader()) {
+            my $frame = $self->_load_cursor_with_pixbuf_loader($cursor_file, $self->cursor_preview_size);
+            $self->cursor_cache->put($cache_key, $frame, _frame_bytes($frame)) if $frame;
+            return $frame;
         }
 
-        print "DEBUG: Creating new cursor thumbnail for $cursor_type from $cursor_file (size: $target_size)\n";
+        print "DEBUG: Creating new cursor thumbnail from $cursor_file (size: " . $self->cursor_preview_size . ")\n";
         # Create new cursor thumbnail
-        my $pixbuf = $self->_create_cursor_thumbnail($cursor_file);
+        my $data = $self->_try_c_extractor_argb32($cursor_file);
+        my $frame = defined $data ? $self->_frame_from_argb32($data) : undef;
 
-        if ($pixbuf) {
+        if ($frame) {
             print "DEBUG: Successfully created cursor thumbnail\n";
             # Cache in memory
-            $self->cursor_cache->{$cache_key} = $pixbuf;
+            $self->cursor_cache->put($cache_key, $frame, _frame_bytes($frame));
 
-            # Save to disk cache
-            eval {
-                # Ensure cache directory exists
-                my $cache_dir = $cache_file;
-                $cache_dir =~ s/\/[^\/]+$//;
-                unless (-d $cache_dir) {
-                    system("mkdir -p '$cache_dir'");
-                }
-
-                $pixbuf->savev($cache_file, 'png', [], []);
-                print "DEBUG: Saved cursor to cache: $cache_file\n";
-            };
-            if ($@) {
-                print "Warning: Could not save cursor to cache: $@\n";
-            }
+            $self->_store_cursor_frame($cache_key, $data);
         } else {
             print "DEBUG: Failed to create cursor thumbnail for $cursor_file\n";
         }
 
-        return $pixbuf;
+        return $frame;
     }
 
-    sub _create_cursor_thumbnail {
-        my ($self, $cursor_file) = @_;
+    # Save the extractor output as is, so loading it back is a read
+    sub _store_cursor_frame {
+        my ($self, $cache_key, $data) = @_;
+
+        my $cache_file = $self->cursor_cache->store_data($cache_key, $data);
+        unless ($cache_file) {
+            print "Warning: Could not save cursor to cache\n";
+            return 0;
+        }
 
-        return $self->_try_c_extractor_pixbuf($cursor_file);
+        $self->session->note_file_created();
+        print "DEBUG: Saved cursor to cache: $cache_file\n";
+        return 1;
     }
 
-    sub _find_cursor_file {
-        my ($self, $cursors_path, $cursor_type) = @_;
+    # Headless --prewarm: extract every preview cursor of every theme at
+    # the configured preview size into the disk cache
+    sub prewarm_caches {
+        my ($self, @dirs) = @_;
 
-        my $primary_file = "$cursors_path/" . $cursor_type->{name};
-        return $primary_file if -f $primary_file;
+        my $prewarm = CinnamonSettings::Prewarm->new(app_name => 'cinnamon-cursor-themes-manager');
+        $prewarm->lower_priority();
+        @dirs = map { $_->{path} } $self->_cursor_directories() unless @dirs;
 
-        foreach my $alias (@{$cursor_type->{aliases}}) {
-            my $alias_file = "$cursors_path/$alias";
-            return $alias_file if -f $alias_file;
+        foreach my $dir_path (grep { -d } @dirs) {
+            my @themes = $self->_scan_cursor_themes($dir_path);
+            $prewarm->note("$dir_path: " . @themes . " cursor themes");
+
+            foreach my $theme_info (@themes) {
+                my $cursors_path = "$theme_info->{path}/cursors";
+                foreach my $cursor_type (@{$self->cursor_types}) {
+                    my $cursor_file = $self->_find_cursor_file($cursors_path, $cursor_type) or next;
+                    $prewarm->add("$theme_info->{name}/$cursor_type->{name}", sub {
+                        $self->_prewarm_cursor_frame($cursor_file);
+                    });
+                }
+            }
         }
 
-        return undef;
+        return $prewarm->run();
     }
 
-    sub _extract_cursor_pixbuf {
+    sub _prewarm_cursor_frame {
         my ($self, $cursor_file) = @_;
 
-        # This method is now just a wrapper for the cached version
-        # Extract theme name and cursor type from the file path for caching
-        my $theme_name = 'unknown';
-        my $cursor_type = 'unknown';
+        # The lookups _extract_cursor_frame_cached makes before extracting
+        my $cache_key = $self->_cursor_key($cursor_file) or return 'failed';
+        return 'current' if $self->cursor_cache->lookup($cache_key);
 
-        if ($cursor_file =~ m{/([^/]+)/cursors/([^/]+)$}) {
-            $theme_name = $1;
-            $cursor_type = $2;
-        }
-
-        return $self->_extract_cursor_pixbuf_cached($cursor_file, $theme_name, $cursor_type);
+        my $data = $self->_try_c_extractor_argb32($cursor_file);
+        return defined $data && $self->_store_cursor_frame($cache_key, $data) ? 'created' : 'failed';
     }
 
-    sub _manage_cursor_cache {
-        my $self = shift;
+    sub _load_cursor_frame {
+        my ($self, $cache_file) = @_;
 
-        my $cache = $self->cursor_cache;
-        my $max_cache_items = 500;  # Increased from 200 to 500 to be less aggressive
+        open my $fh, '<:raw', $cache_file or return undef;
+        my $data = do { local $/; <$fh> };
+        close $fh;
 
-        my $current_cache_size = keys %$cache;
+        return defined $data ? $self->_frame_from_argb32($data) : undef;
+    }
 
-        if ($current_cache_size > $max_cache_items) {
-            # Remove oldest entries (simple FIFO, could be improved with LRU)
-            my @keys = keys %$cache;
-            my $excess_items = $current_cache_size - $max_cache_items;
-            my $to_remove = int($excess_items / 4);  # Remove only 1/4 of excess, not all
+    # Wrap xcursor_extractor --argb32 output ("ARGB32 <width> <height>
+    # <stride>" and premultiplied native-endian pixels, which is Cairo's
+    # own ARGB32 layout) in an image surface without touching the pixels
+    sub _frame_from_argb32 {
+        my ($self, $data) = @_;
 
-            # Ensure we remove at least 1 item if there's excess
-            $to_remove = 1 if $to_remove < 1 && $excess_items > 0;
+        return undef unless $data =~ /\AARGB32 (\d+) (\d+) (\d+)\n/;
+        my ($width, $height, $stride) = ($1, $2, $3);
+        my $pixels = substr($data, $+[0]);
 
-            # Only run loop if there are actually items to remove
-            if ($to_remove > 0) {
-                for my $i (0..$to_remove-1) {
-                    delete $cache->{$keys[$i]};
-                }
+        return undef unless $width && $height && $stride >= $width * 4
+            && length($pixels) == $stride * $height;
 
-                my $new_cache_size = keys %$cache;
-                print "Trimmed cursor cache: removed $to_remove items (cache size: $new_cache_size)\n";
-            }
-        }
+        my $surface = Cairo::ImageSurface->create_for_data($pixels, 'argb32', $width, $height, $stride);
+
+        # The surface reads straight from $pixels, so the frame keeps both
+        return {
+            surface => $surface,
+            pixels => \$pixels,
+            width => $width,
+            height => $height,
+        };
     }
 
-    sub _read_xcursor_pixbuf {
-        my ($self, $cursor_file) = @_;
+    sub _have_xcursor_loader {
+        my $self = shift;
 
-        return $self->_try_c_extractor_pixbuf($cursor_file);
+        return $self->{xcursor_loader} if exists $self->{xcursor_loader};
+
+        my $found = eval {
+            grep { $_->get_name() eq 'xcursor' } Gtk3::Gdk::Pixbuf::get_formats();
+        } ? 1 : 0;
+
+        $self->{xcursor_loader} = $found;
+        return $found;
     }
 
-    sub _try_c_extractor_pixbuf {
-        my ($self, $cursor_file) = @_;
+    sub _load_cursor_with_pixbuf_loader {
+        my ($self, $cursor_file, $size) = @_;
 
-        my $extractor_path;
-        if (-x "./xcursor_extractor") {
-            $extractor_path = "./xcursor_extractor";
-        } elsif (system("which xcursor_extractor ") == 0) {
-            $extractor_path = "xcursor_extractor";
-        } else {
-            print "Warning: xcursor_extractor not found. Using fallback icon.\n";
+        my $span = TRACING && trace_span('xcursor loader', file => $cursor_file);
+
+        # With a requested size the loader decodes the nominal size nearest
+        # to it, rather than the largest one, and scales only the rest
+        my $pixbuf = eval { Gtk3::Gdk::Pixbuf->new_from_file_at_scale($cursor_file, $size, $size, 1) };
+        unless ($pixbuf) {
+            print "Error loading cursor with gdk-pixbuf: $cursor_file\n";
             return undef;
         }
 
-        my $pid = $$;
-        my $timestamp = time();
-        my $random = int(rand(10000));
-        my $temp_dir = "/tmp/xcursor_extract_${pid}_${timestamp}_${random}";
-        mkdir($temp_dir) or return undef;
+        return $self->_frame_from_pixbuf($pixbuf, $size);
+    }
 
-        my $pixbuf_result;
+    # Like the extractor, scale a decoded cursor down to the preview size
+    # but never up
+    sub _frame_from_pixbuf {
+        my ($self, $pixbuf, $size) = @_;
 
-        eval {
-            my $result = system("$extractor_path '$cursor_file' '$temp_dir' >/dev/null 2>&1");
+        my ($native_width, $native_height) = ($pixbuf->get_width(), $pixbuf->get_height());
+        my $largest = $native_width > $native_height ? $native_width : $native_height;
+        if ($largest > $size) {
+            my $scale = $size / $largest;
+            $pixbuf = $pixbuf->scale_simple(int($native_width * $scale + 0.5) || 1, int($native_height * $scale + 0.5) || 1, 'bilinear');
+        }
 
-            if ($result == 0) {
-                opendir(my $dh, $temp_dir) or die "Cannot read temp dir: $!";
-                my @png_files = grep { /^frame_\d+\.png$/ } readdir($dh);
-                closedir($dh);
-
-                if (@png_files > 0) {
-                    @png_files = sort {
-                        my ($a_num) = $a =~ /frame_(\d+)\.png/;
-                        my ($b_num) = $b =~ /frame_(\d+)\.png/;
-                        $a_num <=> $b_num;
-                    } @png_files;
-
-                    # Find the largest frame by checking actual image dimensions
-                    my $best_frame;
-                    my $largest_size = 0;
-
-                    foreach my $png_file (@png_files) {
-                        my $frame_path = "$temp_dir/$png_file";
-                        if (-f $frame_path) {
-                            eval {
-                                my $test_pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($frame_path);
-                                if ($test_pixbuf) {
-                                    my $frame_width = $test_pixbuf->get_width();
-                                    my $frame_height = $test_pixbuf->get_height();
-                                    my $frame_size = $frame_width > $frame_height ? $frame_width : $frame_height;
-
-                                    if ($frame_size > $largest_size) {
-                                        $largest_size = $frame_size;
-                                        $best_frame = $frame_path;
-                                    }
-                                }
-                            };
-                        }
-                    }
+        my ($width, $height) = ($pixbuf->get_width(), $pixbuf->get_height());
+        my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
+        my $cr = Cairo::Context->create($surface);
+        Gtk3::Gdk::cairo_set_source_pixbuf($cr, $pixbuf, 0, 0);
+        $cr->paint();
+
+        return {
+            surface => $surface,
+            width => $width,
+            height => $height,
+        };
+    }
+
+    sub _find_cursor_file {
+        my ($self, $cursors_path, $cursor_type) = @_;
 
-                    # Use the largest frame found, or fall back to first frame
-                    my $selected_frame = $best_frame || "$temp_dir/" . $png_files[0];
+        my $primary_file = "$cursors_path/" . $cursor_type->{name};
+        return $primary_file if -f $primary_file;
 
-                    if (-f $selected_frame) {
-                        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($selected_frame);
+        foreach my $alias (@{$cursor_type->{aliases}}) {
+            my $alias_file = "$cursors_path/$alias";
+            return $alias_file if -f $alias_file;
+        }
 
-                        if ($pixbuf) {
-                            my $original_width = $pixbuf->get_width();
-                            my $original_height = $pixbuf->get_height();
+        return undef;
+    }
 
-                            # Use the dynamic cursor preview size
-                            my $target_size = $self->cursor_preview_size;
+    sub _try_c_extractor_argb32 {
+        my ($self, $cursor_file) = @_;
 
-                            # Only scale down if larger than target, never scale up
-                            if ($original_width > $target_size || $original_height > $target_size) {
-                                my $scale_factor = $target_size / ($original_width > $original_height ? $original_width : $original_height);
-                                my $new_width = int($original_width * $scale_factor);
-                                my $new_height = int($original_height * $scale_factor);
+        my $span = TRACING && trace_span('xcursor_extractor', file => $cursor_file);
 
-                                # Use hyper interpolation for high-quality downscaling
-                                $pixbuf_result = $pixbuf->scale_simple($new_width, $new_height, 'hyper');
-                            } else {
-                                # Use original size if already small enough
-                                $pixbuf_result = $pixbuf;
-                            }
-                        }
-                    }
-                }
-            }
-        };
+        my $extractor_path = $self->_find_helper_binary('xcursor_extractor');
+        unless ($extractor_path) {
+            print "Warning: xcursor_extractor not found. Using fallback icon.\n" unless $self->{extractor_warned}++;
+            return undef;
+        }
 
-        if ($@) {
-            print "Error extracting cursor: $@\n";
+        # The extractor picks the closest frame, scales it to the preview
+        # size and streams it over a pipe
+        my ($result, $data) = $self->session->capture($extractor_path, '--argb32', $cursor_file, $self->cursor_preview_size);
+
+        if ($result != 0 || !length($data)) {
+            print "Error extracting cursor: $cursor_file\n";
+            return undef;
         }
 
-        if (-d $temp_dir) {
-            system("rm -rf '$temp_dir'");
+        return $data;
+    }
+
+    sub _find_helper_binary {
+        my ($self, $name) = @_;
+
+        # Looked up once per session instead of once per cursor
+        return $self->{helper_binaries}{$name} if exists $self->{helper_binaries}{$name};
+
+        my $path;
+        if (-x "./$name") {
+            $path = "./$name";
+        } elsif (system("which $name >/dev/null 2>&1") == 0) {
+            $path = $name;
         }
 
-        return $pixbuf_result;
+        $self->{helper_binaries}{$name} = $path;
+        return $path;
     }
 
 
     sub _draw_cursor_grid {
-        my ($self, $cr, $cursor_pixbufs, $panel_width, $panel_height) = @_;
+        my ($self, $cr, $cursor_frames, $panel_width, $panel_height) = @_;
 
-        return unless @$cursor_pixbufs > 0;
+        return unless @$cursor_frames > 0;
 
         # Grid configuration - 6 columns to match the original design
         my $cols = 6;
-        my $rows = int((scalar(@$cursor_pixbufs) + $cols - 1) / $cols); # Calculate needed rows
+        my $rows = int((scalar(@$cursor_frames) + $cols - 1) / $cols); # Calculate needed rows
 
         my $cell_width = int($panel_width / $cols);
         my $cell_height = int($panel_height / $rows);
@@ -1830,12 +1945,12 @@ package CursorThemesManager {
 
         for my $row (0 .. $rows - 1) {
             for my $col (0 .. $cols - 1) {
-                last if $cursor_index >= @$cursor_pixbufs;
+                last if $cursor_index >= @$cursor_frames;
 
-                my $cursor_data = $cursor_pixbufs->[$cursor_index];
-                my $pixbuf = $cursor_data->{pixbuf};
+                my $cursor_data = $cursor_frames->[$cursor_index];
+                my $frame = $cursor_data->{frame};
 
-                if ($pixbuf) {
+                if ($frame) {
                     # Calculate cell center
                     my $cell_x = $col * $cell_width;
                     my $cell_y = $row * $cell_height;
@@ -1843,13 +1958,13 @@ package CursorThemesManager {
                     my $center_y = $cell_y + int($cell_height / 2);
 
                     # Draw cursor centered in cell
-                    my $cursor_width = $pixbuf->get_width();
-                    my $cursor_height = $pixbuf->get_height();
+                    my $cursor_width = $frame->{width};
+                    my $cursor_height = $frame->{height};
                     my $draw_x = $center_x - int($cursor_width / 2);
                     my $draw_y = $center_y - int($cursor_height / 2);
 
                     $cr->set_antialias('none');
-                    Gtk3::Gdk::cairo_set_source_pixbuf($cr, $pixbuf, $draw_x, $draw_y);
+                    $cr->set_source_surface($frame->{surface}, $draw_x, $draw_y);
                     $cr->paint();
                 }
 
@@ -1911,7 +2026,7 @@ package CursorThemesManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -1923,7 +2038,7 @@ package CursorThemesManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -1947,6 +2062,383 @@ package CursorThemesManager {
         $dialog->destroy();
     }
 
+    # Compile a folder of xcursorgen configs and PNG frames into a theme
+    # under ~/.icons with xcursor_compiler, which runs one worker per CPU
+    sub _build_cursor_theme {
+        my $self = shift;
+
+        my $compiler = $self->_find_helper_binary('xcursor_compiler');
+        unless ($compiler) {
+            $self->_show_message('error', 'xcursor_compiler was not found. Run "make install" to build it.');
+            return;
+        }
+
+        my $dialog = Gtk3::FileChooserDialog->new(
+            'Select Cursor Theme Source Directory',
+            $self->window,
+            'select-folder',
+            'gtk-cancel' => 'cancel',
+            'gtk-open' => 'accept'
+        );
+        my $source = $dialog->run() eq 'accept' ? $dialog->get_filename() : undef;
+        $dialog->destroy();
+        return unless $source;
+
+        my $name = $source;
+        $name =~ s/.*\///;
+        my $icons_dir = $ENV{HOME} . '/.icons';
+        mkdir $icons_dir unless -d $icons_dir;
+        my $output = "$icons_dir/$name";
+        if ((-e $output || -l $output)
+            && !$self->_confirm("~/.icons/$name already exists.\n\nReplace it with the theme built from $source?")) {
+            return;
+        }
+
+        # Built next to the target and swapped in once complete, so a failed
+        # build leaves an installed theme as it was
+        my $staging = "$icons_dir/.$name.csm-build";
+        remove_tree($staging) if -e $staging;
+
+        print "Building cursor theme '$name' from $source\n";
+        $self->loading_label->set_text("Building cursor theme $name...");
+        $self->loading_box->show_all();
+        $self->loading_spinner->start();
+
+        my $started = $self->session->spawn_command(
+            command => [$compiler, $source, $staging],
+            label => "build $name",
+            on_exit => sub {
+                my ($exit_code, $output_text) = @_;
+
+                $self->loading_spinner->stop();
+                $self->loading_box->hide();
+                print $output_text;
+
+                if ($exit_code != 0) {
+                    remove_tree($staging);
+                    $self->_show_message('error', "Building cursor theme '$name' failed:\n\n$output_text");
+                    return;
+                }
+                unless ($self->_swap_in_theme($staging, $output)) {
+                    my $error = $!;
+                    remove_tree($staging);
+                    $self->_show_message('error', "Cannot install cursor theme '$name' to $output: $error");
+                    return;
+                }
+
+                # Show the new theme if ~/.icons is the directory on screen
+                $self->cached_theme_lists->remove($icons_dir);
+                my $row = $self->directory_list->get_selected_row();
+                if ($row && ($self->directory_paths->{$row + 0} // '') eq $icons_dir) {
+                    $self->_load_cursor_themes_from_directory($row, 1);
+                }
+            },
+        );
+
+        unless ($started) {
+            $self->loading_spinner->stop();
+            $self->loading_box->hide();
+            $self->_show_message('error', 'Could not start xcursor_compiler.');
+        }
+    }
+
+    # Preview a downloaded cursor theme archive from the cursor files the
+    # preview grid shows, read into memory, and install it into ~/.icons
+    # once confirmed
+    sub _preview_cursor_archive {
+        my $self = shift;
+
+        my $icons_dir = $ENV{HOME} . '/.icons';
+        my @names = map { ($_->{name}, @{$_->{aliases}}) } @{$self->cursor_types};
+
+        CinnamonSettings::ArchivePreviewDialog->new(
+            parent => $self->window,
+            session => $self->session,
+            kind => 'cursor',
+            names => \@names,
+            install_dir => $icons_dir,
+            render => sub { $self->_render_archive_cursors(@_) },
+            on_installed => sub {
+                $self->cached_theme_lists->remove($icons_dir);
+                my $row = $self->directory_list->get_selected_row();
+                if ($row && ($self->directory_paths->{$row + 0} // '') eq $icons_dir) {
+                    $self->_load_cursor_themes_from_directory($row, 1);
+                }
+            },
+        )->run();
+    }
+
+    # The grid is returned right away; each cursor is decoded in its own
+    # scheduler step and fills in its cell
+    sub _render_archive_cursors {
+        my ($self, $archive, $theme) = @_;
+
+        # Switching themes drops the decodes still queued for the last one
+        $self->scheduler->cancel($self->archive_token);
+        my $token = $self->scheduler->new_token();
+        $self->archive_token($token);
+
+        my $size = $self->cursor_preview_size;
+        my (@cells, @pending);
+        foreach my $cursor_type (@{$self->cursor_types}) {
+            my $data;
+            foreach my $name ($cursor_type->{name}, @{$cursor_type->{aliases}}) {
+                $data = $archive->theme_member($theme, "cursors/$name");
+                last if defined $data;
+            }
+            next unless defined $data;
+
+            my $image = Gtk3::Image->new();
+            $image->set_size_request($size, $size);
+            push @cells, [$image, $cursor_type->{desc}];
+            push @pending, [$image, $data];
+        }
+
+        $self->scheduler->foreach_item(
+            label => 'cursor: archive preview',
+            token => $token,
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            items => \@pending,
+            each => sub {
+                my ($image, $data) = @{$_[0]};
+
+                my $frame = $self->_load_cursor_from_data($data);
+                unless ($frame) {
+                    $image->set_from_icon_name('image-missing', 'dialog');
+                    return;
+                }
+                $image->set_from_surface($frame->{surface});
+                # The surface may read straight from the frame's pixel buffer
+                $image->{csm_frame} = $frame;
+            },
+        );
+
+        return CinnamonSettings::ArchivePreviewDialog->preview_grid(@cells);
+    }
+
+    # Decode an in-memory cursor file by piping it to xcursor_extractor
+    # --argb32 -, or through the gdk-pixbuf loader when the extractor is not
+    # installed
+    sub _load_cursor_from_data {
+        my ($self, $data) = @_;
+
+        my $size = $self->cursor_preview_size;
+
+        if (my $extractor_path = $self->_find_helper_binary('xcursor_extractor')) {
+            my ($result, $output) = $self->session->capture_input($data, $extractor_path, '--argb32', '-', $size);
+            return $result == 0 ? $self->_frame_from_argb32($output) : undef;
+        }
+
+        return undef unless $self->_have_xcursor_loader();
+        my $pixbuf = eval {
+            my $loader = Gtk3::Gdk::PixbufLoader->new_with_type('xcursor');
+            $loader->write($data);
+            $loader->close();
+            $loader->get_pixbuf();
+        };
+        return $pixbuf ? $self->_frame_from_pixbuf($pixbuf, $size) : undef;
+    }
+
+    # Run xcursor_extractor --optimize on a theme and install the result as
+    # ~/.icons/<theme>, which libXcursor searches before the system
+    # directories. Nominal sizes are only dropped when the config lists the
+    # ones to keep in optimize_cursor_sizes. Only the cursors are replaced;
+    # a theme's icons and other files stay where they are.
+    sub _optimize_cursor_theme {
+        my ($self, $theme_name, $button) = @_;
+
+        my $extractor = $self->_find_helper_binary('xcursor_extractor');
+        unless ($extractor) {
+            $self->_show_message('error', 'xcursor_extractor was not found. Run "make install" to build it.');
+            return;
+        }
+
+        my ($source) = grep { -d "$_/cursors" }
+            map { "$_/$theme_name" } ($ENV{HOME} . '/.icons', '/usr/share/icons', '/usr/local/share/icons');
+        unless ($source) {
+            $self->_show_message('error', "Cursor theme '$theme_name' was not found.");
+            return;
+        }
+
+        my $icons_dir = $ENV{HOME} . '/.icons';
+        mkdir $icons_dir unless -d $icons_dir;
+        my $target = "$icons_dir/$theme_name";
+
+        # Anything in ~/.icons that an earlier run did not install is the
+        # user's own; it is only changed once confirmed
+        my $own = -l $target || (-e $target && !-e "$target/" . OPTIMIZED_MARKER);
+        if ($own) {
+            my $what = -l $target ? "a link to " . readlink($target) : "a theme you installed";
+            my $question = "~/.icons/$theme_name is $what.\n\n"
+                . (-l $target
+                    ? "The link will be replaced by a folder with the optimized cursors; everything else in the theme stays where it is."
+                    : "Its cursors folder will be replaced by the optimized cursors and the original kept as cursors.orig inside it.")
+                . "\n\nContinue?";
+            return unless $self->_confirm($question);
+        }
+
+        my $staging = "$icons_dir/.$theme_name.optimized";
+        remove_tree($staging) if -e $staging;
+
+        my @command = ($extractor, '--optimize', $source, $staging);
+        my $sizes = join(',', @{$self->config->{optimize_cursor_sizes} || []});
+        push @command, $sizes if length $sizes;
+
+        print "Optimizing cursor theme '$theme_name' from $source\n";
+        $button->set_sensitive(0);
+        $button->set_label('Optimizing...');
+
+        my $started = $self->session->spawn_command(
+            command => \@command,
+            label => "optimize $theme_name",
+            on_exit => sub {
+                my ($exit_code, $output) = @_;
+
+                $button->set_sensitive(1);
+                $button->set_label('Optimize Current Theme');
+                print $output;
+
+                if ($exit_code != 0) {
+                    remove_tree($staging);
+                    $self->_show_message('error', "Optimizing cursor theme '$theme_name' failed:\n\n$output");
+                    return;
+                }
+
+                my $installed = (-d $target && !-l $target)
+                    ? $self->_install_optimized_cursors($staging, $target, $own)
+                    : $self->_install_optimized_theme($source, $staging, $target);
+                unless ($installed) {
+                    my $error = $!;
+                    remove_tree($staging);
+                    $self->_show_message('error', "Could not install the optimized theme to $target: $error");
+                    return;
+                }
+
+                $self->cached_theme_lists->remove($icons_dir);
+                $self->_show_message('info', "Installed optimized '$theme_name' to $target\n\n$output");
+            },
+        );
+
+        unless ($started) {
+            $button->set_sensitive(1);
+            $button->set_label('Optimize Current Theme');
+            $self->_show_message('error', 'Could not start xcursor_extractor.');
+        }
+    }
+
+    # Swap the cursors folder of a theme directory in ~/.icons for the
+    # optimized one; $keep_original keeps the user's own cursors
+    sub _install_optimized_cursors {
+        my ($self, $staging, $target, $keep_original) = @_;
+
+        my $old = "$target/.cursors.old";
+        remove_tree($old) if -e $old || -l $old;
+        if (-e "$target/cursors" || -l "$target/cursors") {
+            rename("$target/cursors", $old) or return 0;
+        }
+        unless (rename("$staging/cursors", "$target/cursors")) {
+            rename($old, "$target/cursors");
+            return 0;
+        }
+
+        # index.theme and the like, unless the theme has its own
+        if (opendir(my $dh, $staging)) {
+            foreach my $entry (grep { !/^\./ && -f "$staging/$_" } readdir($dh)) {
+                rename("$staging/$entry", "$target/$entry") unless -e "$target/$entry";
+            }
+            closedir($dh);
+        }
+        remove_tree($staging);
+
+        if (-e $old) {
+            if ($keep_original && !-e "$target/cursors.orig") {
+                rename($old, "$target/cursors.orig");
+            } else {
+                remove_tree($old);
+            }
+        }
+        return $self->_mark_optimized($target);
+    }
+
+    # Install the staged theme where ~/.icons had nothing or a link; the
+    # source's other folders (icons, gtk-3.0, ...) are linked in, so a
+    # combined theme keeps working
+    sub _install_optimized_theme {
+        my ($self, $source, $staging, $target) = @_;
+
+        my $real_source = realpath($source) or return 0;
+        if (opendir(my $dh, $real_source)) {
+            foreach my $entry (grep { !/^\.\.?$/ && $_ ne 'cursors' } readdir($dh)) {
+                next if -e "$staging/$entry" || -l "$staging/$entry";
+                symlink("$real_source/$entry", "$staging/$entry") or return 0;
+            }
+            closedir($dh);
+        }
+
+        unlink($target) if -l $target;
+        rename($staging, $target) or return 0;
+        return $self->_mark_optimized($target);
+    }
+
+    # Rename a finished theme over $target; an existing one is set aside
+    # first and only deleted once the new one is in place
+    sub _swap_in_theme {
+        my ($self, $staging, $target) = @_;
+
+        my $old = "$staging.old";
+        remove_tree($old) if -e $old;
+        my $replacing = -e $target || -l $target;
+        return 0 if $replacing && !rename($target, $old);
+
+        unless (rename($staging, $target)) {
+            my $error = $!;
+            rename($old, $target) if $replacing;
+            $! = $error;
+            return 0;
+        }
+        if ($replacing) {
+            -l $old ? unlink($old) : remove_tree($old);
+        }
+        return 1;
+    }
+
+    sub _mark_optimized {
+        my ($self, $target) = @_;
+
+        open(my $fh, '>', "$target/" . OPTIMIZED_MARKER) or return 0;
+        print $fh "Cursors optimized by cinnamon-cursor-themes-manager\n";
+        return close($fh);
+    }
+
+    sub _confirm {
+        my ($self, $text) = @_;
+
+        my $dialog = Gtk3::MessageDialog->new(
+            $self->window,
+            'modal',
+            'question',
+            'yes-no',
+            $text
+        );
+        my $response = $dialog->run();
+        $dialog->destroy();
+        return $response eq 'yes';
+    }
+
+    sub _show_message {
+        my ($self, $type, $text) = @_;
+
+        my $msg_dialog = Gtk3::MessageDialog->new(
+            $self->window,
+            'modal',
+            $type,
+            'ok',
+            $text
+        );
+        $msg_dialog->run();
+        $msg_dialog->destroy();
+    }
+
     sub _remove_cursor_directory {
         my $self = shift;
 
@@ -1983,11 +2475,11 @@ package CursorThemesManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -2227,133 +2719,79 @@ package CursorThemesManager {
         return 0; # Failure
     }
 
-    sub _load_config {
+    sub _build_config_store {
         my $self = shift;
 
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            thumbnail_size => 200,
-            cursor_preview_size => 40,  # Add default cursor preview size
-            custom_directories => [],
-            last_selected_directory => undef,
-        };
-
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-
-                    # Validate thumbnail_size range
-                    if ($config->{thumbnail_size} < 200 || $config->{thumbnail_size} > 400) {
-                        print "Invalid thumbnail size in config, using default\n";
-                        $config->{thumbnail_size} = 200;
-                    }
-
-                    # Validate cursor_preview_size range
-                    if (!$config->{cursor_preview_size} || $config->{cursor_preview_size} < 24 || $config->{cursor_preview_size} > 64) {
-                        print "Invalid cursor preview size in config, using default\n";
-                        $config->{cursor_preview_size} = 40;
-                    }
-
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
-
-                    print "Loaded configuration from $config_file\n";
-                    print "  Thumbnail size: " . $config->{thumbnail_size} . "\n";
-                    print "  Cursor preview size: " . $config->{cursor_preview_size} . "\n";
-                    print "  Custom directories: " . @{$config->{custom_directories}} . "\n";
-                    print "  Last directory: " . ($config->{last_selected_directory} || 'none') . "\n";
-                } else {
-                    print "Config file is empty, using defaults\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration\n";
-            }
-        } else {
-            print "Config file not found, using defaults\n";
-        }
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                thumbnail_size => 200,
+                cursor_preview_size => 40,
+                custom_directories => [],
+                last_selected_directory => undef,
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
 
-        return $config;
+    sub _load_config {
+        my $self = shift;
+        return $self->config_store->load();
     }
 
-    sub _save_config {
+    sub _validate_config {
         my ($self, $config) = @_;
 
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
-
-        print "DEBUG: Attempting to save config to: $config_file\n";
-        print "DEBUG: Saving thumbnail_size: " . ($config->{thumbnail_size} || 'undef') . "\n";
-        print "DEBUG: Saving custom_directories count: " . (@{$config->{custom_directories} || []}) . "\n";
-        print "DEBUG: Saving last_selected_directory: " . ($config->{last_selected_directory} || 'undef') . "\n";
-
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-                print "DEBUG: Created config directory: $config_dir\n";
-            }
-
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
+        # Validate thumbnail_size range
+        if (!$config->{thumbnail_size} || $config->{thumbnail_size} < 200 || $config->{thumbnail_size} > 400) {
+            print "Invalid thumbnail size in config, using default\n";
+            $config->{thumbnail_size} = 200;
+        }
 
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
+        # Validate cursor_preview_size range
+        if (!$config->{cursor_preview_size} || $config->{cursor_preview_size} < 24 || $config->{cursor_preview_size} > 64) {
+            print "Invalid cursor preview size in config, using default\n";
+            $config->{cursor_preview_size} = 40;
+        }
 
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
+    }
 
-            # Verify the final file exists and has content
-            unless (-f $config_file && -s $config_file) {
-                die "Final config file was not created or is empty";
-            }
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
 
-            print "DEBUG: Successfully saved configuration to $config_file\n";
-            print "DEBUG: File size: " . (-s $config_file) . " bytes\n";
-            print "  Thumbnail size: " . $config->{thumbnail_size} . "\n";
-            print "  Custom directories: " . @{$config->{custom_directories}} . "\n";
-            print "  Last directory: " . ($config->{last_selected_directory} || 'none') . "\n";
+        return unless $self->cursor_grid;
 
-            # Verify by reading back the file
-            open my $verify_fh, '<:encoding(UTF-8)', $config_file or die "Cannot read back config file for verification: $!";
-            my $verify_content = do { local $/; <$verify_fh> };
-            close $verify_fh;
+        if (grep { $_ eq 'cursor_preview_size' } @$keys) {
+            my $new_size = $self->config->{cursor_preview_size};
+            $self->cursor_preview_size($new_size);
+            $self->{size_label}->set_text($new_size . 'px') if $self->{size_label};
 
-            if ($verify_content && length($verify_content) > 0) {
-                print "DEBUG: Config file verification successful\n";
-            } else {
-                die "Config file verification failed - file is empty";
+            # Frames of the old size are useless now
+            $self->cursor_cache->clear();
+            my $selected_row = $self->directory_list->get_selected_row();
+            if ($selected_row) {
+                $self->_load_cursor_themes_from_directory($selected_row, 1);
             }
-
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
         }
     }
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-cursor-themes-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Cursor Themes Manager started\n";
         Gtk3::main();
     }
@@ -2361,6 +2799,12 @@ package CursorThemesManager {
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit CursorThemesManager->new(prewarm => 1)->prewarm_caches(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = CursorThemesManager->new();
     $app->run();
 }
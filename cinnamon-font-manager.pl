@@ -14,6 +14,14 @@ use JSON qw(encode_json decode_json);
 use Data::Dumper;
 use Digest::MD5 qw(md5_hex);
 use File::Find qw(find);
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::PreviewCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -24,6 +32,7 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CinnamonFontManager {
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
 
     has 'window' => (is => 'rw');
     has 'directory_list' => (is => 'rw');
@@ -31,10 +40,15 @@ package CinnamonFontManager {
     has 'search_entry' => (is => 'rw');
     has 'preview_text_view' => (is => 'rw');
     has 'preview_size' => (is => 'rw', default => sub { 24 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'font_info_cache' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    # Memory tier only: fc-query results are cheap to recompute
+    has 'font_file_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::PreviewCache->new(name => 'font files', memory_budget => 8 * 1024 * 1024)
+    });
     has 'current_directory' => (is => 'rw');
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
@@ -42,18 +56,30 @@ package CinnamonFontManager {
     has 'content_switcher' => (is => 'rw');
     has 'fonts_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-font-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-font-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
     has 'sample_text' => (is => 'rw', default => sub { "The quick brown fox jumps over the lazy dog\nTHE QUICK BROWN FOX JUMPS OVER THE LAZY DOG\nABCDEF GHIJKL MNOPQR STUVWX YZ\nabcdef ghijkl mnopqr stuvwx yz\n0123456789\n! @ # \$ % ^ & * ( ) _ + - = [ ] { } | ; ' : \" , . / < > ?" });
 
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Row address lookups into the current directory's view
+    sub font_info_cache { $_[0]->view->paths }
+
     sub BUILD {
         my $self = shift;
 
         # FIXED: Ensure UTF-8 support is enabled
         binmode(STDOUT, ":utf8");
         binmode(STDERR, ":utf8");
-
-        # Initialize font file cache
-        $self->{font_file_cache} = {};
-
         $self->_initialize_configuration();
         $self->_setup_ui();
         $self->_populate_font_directories();
@@ -323,6 +349,7 @@ package CinnamonFontManager {
         my ($size_decrease, $size_increase) = $self->_create_size_buttons();
         my $size_label = Gtk3::Label->new();
         $size_label->set_markup("<b>" . $self->preview_size . "pt</b>");
+        $self->{size_label} = $size_label;
 
         $preview_controls->pack_start($size_decrease, 0, 0, 0);
         $preview_controls->pack_start($size_label, 0, 0, 0);
@@ -644,7 +671,7 @@ package CinnamonFontManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_fonts_from_directory_async($row);
@@ -669,8 +696,11 @@ package CinnamonFontManager {
         });
 
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
+            $self->font_file_cache->report_stats();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -718,7 +748,7 @@ package CinnamonFontManager {
             $self->_update_preview_font_size();
             # Save size to config
             $self->config->{preview_size} = $self->preview_size;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $size_decrease->signal_connect('clicked' => sub {
@@ -729,7 +759,7 @@ package CinnamonFontManager {
             $self->_update_preview_font_size();
             # Save size to config
             $self->config->{preview_size} = $self->preview_size;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
     }
 
@@ -1382,7 +1412,7 @@ package CinnamonFontManager {
             next unless -d $dir_info->{path};
 
             my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
+            $self->directory_view->track($row, $dir_info->{path});
             $self->directory_list->add($row);
         }
 
@@ -1392,7 +1422,7 @@ package CinnamonFontManager {
                 next unless -d $custom_dir->{path};
 
                 my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
+                $self->directory_view->track($row, $custom_dir->{path});
                 $self->directory_list->add($row);
             }
         }
@@ -1496,21 +1526,26 @@ package CinnamonFontManager {
         # Clear existing font list and duplicates tracker
         my $listbox = $self->font_list;
         foreach my $child ($listbox->get_children()) {
-            # Clean up font info cache for removed rows
-            my $row_key = $child + 0;
-            delete $self->font_info_cache->{$row_key};
             $listbox->remove($child);
+            $child->destroy();
         }
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
 
         # Store current directory
         $self->current_directory($dir_path);
 
-        # Use Glib::Timeout to process fonts in chunks to avoid blocking the UI
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Rows still queued for the previous directory are no longer wanted
+        $self->scheduler->cancel($self->load_token);
+        my $token = $self->scheduler->new_token();
+        $self->load_token($token);
+
+        # Process fonts through the scheduler to avoid blocking the UI
         my @font_files = ();
         my %seen_families = ();
         my @processed_fonts = ();
-        my $font_index = 0;
-        my $chunk_size = 20; # Process 20 fonts at a time
         my $first_font_row = undef;
 
         # First, quickly scan for font files without processing them
@@ -1534,56 +1569,48 @@ package CinnamonFontManager {
 
         return unless $total_files > 0;
 
-        # Process fonts in chunks using a timer
-        my $process_chunk; # Forward declaration
-        $process_chunk = sub {
-            my $chunk_end = $font_index + $chunk_size - 1;
-            $chunk_end = $total_files - 1 if $chunk_end >= $total_files;
-
-            # Update progress
-            my $progress = int(($font_index / $total_files) * 100);
-            $self->loading_label->set_text("Processing fonts... $progress% ($font_index/$total_files)");
+        # One font per step; fc-query is slow enough that the frame budget
+        # rather than a fixed chunk size decides how many fit in a frame
+        my $processed = 0;
+        $self->scheduler->foreach_item(
+            label => 'fonts: create font rows',
+            token => $token,
+            items => \@font_files,
+            each => sub {
+                my $font_file = shift;
+
+                # Update progress
+                if ($processed % 20 == 0) {
+                    my $progress = int(($processed / $total_files) * 100);
+                    $self->loading_label->set_text("Processing fonts... $progress% ($processed/$total_files)");
+                }
+                $processed++;
 
-            # Process this chunk of fonts
-            for my $i ($font_index..$chunk_end) {
-                my $font_file = $font_files[$i];
                 my $font_info = $self->_get_font_info_fast($font_file);
+                return unless $font_info;
 
-                if ($font_info) {
-                    # Create unique key for family + style combination
-                    my $unique_key = lc($font_info->{family}) . '|' . lc($font_info->{style});
+                # Create unique key for family + style combination
+                my $unique_key = lc($font_info->{family}) . '|' . lc($font_info->{style});
 
-                    # Only add if we haven't seen this family+style combination
-                    if (!exists $seen_families{$unique_key}) {
-                        $seen_families{$unique_key} = 1;
-                        push @processed_fonts, $font_info;
+                # Only add if we haven't seen this family+style combination
+                return if exists $seen_families{$unique_key};
+                $seen_families{$unique_key} = 1;
+                push @processed_fonts, $font_info;
 
-                        # Create and add the font row immediately
-                        my $font_row = $self->_create_font_row($font_info);
-                        $listbox->add($font_row);
-                        $font_row->show_all();
+                # Create and add the font row immediately
+                my $font_row = $self->_create_font_row($font_info);
+                $listbox->add($font_row);
+                $font_row->show_all();
 
-                        # Track the first font row for auto-selection
-                        if (!$first_font_row) {
-                            $first_font_row = $font_row;
-                        }
-                    }
+                # Track the first font row for auto-selection
+                if (!$first_font_row) {
+                    $first_font_row = $font_row;
                 }
-            }
-
-            # Force UI update
-            $listbox->queue_draw();
-            Gtk3::main_iteration() while Gtk3::events_pending();
-
-            $font_index = $chunk_end + 1;
-
-            # Continue processing if there are more fonts
-            if ($font_index < $total_files) {
-                # Schedule next chunk
-                return 1; # Continue timer
-            } else {
+            },
+            on_done => sub {
                 # Finished processing all fonts
                 print "Finished processing " . @processed_fonts . " unique fonts from $dir_path\n";
+                delete $self->{load_span};
 
                 # Hide loading indicator
                 $self->loading_spinner->stop();
@@ -1592,28 +1619,29 @@ package CinnamonFontManager {
                 # Auto-select and preview the first font
                 if ($first_font_row) {
                     print "Auto-selecting first font\n";
-                    Glib::Timeout->add(50, sub {
-                        $listbox->select_row($first_font_row);
-                        $self->_update_font_preview($first_font_row);
-                        return 0; # Don't repeat
-                    });
+                    $self->scheduler->defer(
+                        label => 'fonts: select first font',
+                        token => $token,
+                        run => sub {
+                            $listbox->select_row($first_font_row);
+                            $self->_update_font_preview($first_font_row);
+                        },
+                    );
                 }
-
-                return 0; # Stop timer
-            }
-        };
-
-        # Start processing with a very short delay (10ms)
-        Glib::Timeout->add(10, $process_chunk);
+            },
+        );
     }
 
     sub _get_font_info_fast {
         my ($self, $font_file) = @_;
 
-        # Cache font info to avoid re-processing the same files
-        my $file_key = $font_file;
-        if (exists $self->{font_file_cache}->{$file_key}) {
-            return $self->{font_file_cache}->{$file_key};
+        my $span = TRACING && trace_span('font info', file => $font_file);
+
+        # Cache font info to avoid re-processing the same files; the key
+        # changes when a font is replaced in place
+        my $file_key = CinnamonSettings::PreviewCache->file_key($font_file, '.info');
+        if (my $cached = $self->font_file_cache->get($file_key)) {
+            return $cached;
         }
 
         my ($family, $style) = ('Unknown Font', 'Regular');
@@ -1684,7 +1712,7 @@ package CinnamonFontManager {
         };
 
         # Cache the result
-        $self->{font_file_cache}->{$file_key} = $result;
+        $self->font_file_cache->set($file_key, $result);
 
         return $result;
     }
@@ -1840,8 +1868,7 @@ package CinnamonFontManager {
         $row->show_all();
 
         # Store font info using the row's memory address as key
-        my $row_key = $row + 0;
-        $self->font_info_cache->{$row_key} = $font_info;
+        $self->view->track($row, $font_info);
 
         return $row;
     }
@@ -2090,7 +2117,7 @@ package CinnamonFontManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -2102,7 +2129,7 @@ package CinnamonFontManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -2152,11 +2179,11 @@ package CinnamonFontManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -2185,104 +2212,66 @@ package CinnamonFontManager {
         return $ENV{HOME} . '/.local/share/cinnamon-font-manager/config/settings.json';
     }
 
-    sub _load_config {
+    sub _build_config_store {
         my $self = shift;
 
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            preview_size => 24,
-            custom_directories => [],
-            last_selected_directory => undef,
-        };
-
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-
-                    # Validate preview_size range
-                    if ($config->{preview_size} < 8 || $config->{preview_size} > 72) {
-                        print "Invalid preview size in config, using default\n";
-                        $config->{preview_size} = 24;
-                    }
-
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
-
-                    print "Loaded configuration from $config_file\n";
-                    print "  Preview size: " . $config->{preview_size} . "\n";
-                    print "  Custom directories: " . @{$config->{custom_directories}} . "\n";
-                    print "  Last directory: " . ($config->{last_selected_directory} || 'none') . "\n";
-                } else {
-                    print "Config file is empty, using defaults\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration\n";
-            }
-        } else {
-            print "Config file not found, using defaults\n";
-        }
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                preview_size => 24,
+                custom_directories => [],
+                last_selected_directory => undef,
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
 
-        return $config;
+    sub _load_config {
+        my $self = shift;
+        return $self->config_store->load();
     }
 
-    sub _save_config {
+    sub _validate_config {
         my ($self, $config) = @_;
 
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
-
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-            }
-
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
-
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
+        # Validate preview_size range
+        if (!$config->{preview_size} || $config->{preview_size} < 8 || $config->{preview_size} > 72) {
+            print "Invalid preview size in config, using default\n";
+            $config->{preview_size} = 24;
+        }
 
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
+    }
 
-            # Verify the final file exists and has content
-            unless (-f $config_file && -s $config_file) {
-                die "Final config file was not created or is empty";
-            }
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
 
-            print "Successfully saved configuration to $config_file\n";
+        return unless $self->{size_label};
 
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
+        if (grep { $_ eq 'preview_size' } @$keys) {
+            my $new_size = $self->config->{preview_size};
+            $self->preview_size($new_size);
+            $self->{size_label}->set_markup("<b>${new_size}pt</b>");
+            $self->_update_preview_font_size();
         }
     }
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-font-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Cinnamon Font Manager started\n";
         Gtk3::main();
     }
@@ -7,7 +7,7 @@ use utf8;
 # A dedicated icon theme management application for Linux Mint Cinnamon
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use File::Basename qw(basename dirname);
@@ -15,6 +15,18 @@ use JSON qw(encode_json decode_json);
 use Data::Dumper;
 use Digest::MD5 qw(md5_hex);
 use Cairo;
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::Session;
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::BudgetCache;
+use CinnamonSettings::PreviewCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
+use CinnamonSettings::ArchivePreviewDialog;
+use CinnamonSettings::Prewarm;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -25,6 +37,7 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CinnamonIconsThemeManager {
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
     use File::Basename qw(basename dirname);
 
     has 'window' => (is => 'rw');
@@ -34,18 +47,41 @@ package CinnamonIconsThemeManager {
     has 'icons_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
     has 'zoom_level' => (is => 'rw', default => sub { 400 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_widgets' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
     has 'loading_box' => (is => 'rw');
     has 'current_directory' => (is => 'rw');
-    has 'cached_theme_lists' => (is => 'rw', default => sub { {} });
+    has 'cached_theme_lists' => (is => 'ro', default => sub {
+        CinnamonSettings::BudgetCache->new(name => 'theme lists', budget_bytes => 16 * 1024 * 1024)
+    });
+    has 'preview_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::PreviewCache->new(
+            name => 'icon previews',
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/thumbnails',
+        )
+    });
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
-    has 'icon_cache' => (is => 'rw', default => sub { {} });
     has 'current_theme' => (is => 'rw');
+    has 'session' => (is => 'ro', default => sub {
+        CinnamonSettings::Session->new(app_name => 'cinnamon-icon-themes-manager')
+    });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-icon-themes-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
+    has 'preview_token' => (is => 'rw');
+    # Headless --prewarm run: configuration only, no windows
+    has 'prewarm' => (is => 'ro', default => sub { 0 });
 
     has 'icon_types' => (is => 'ro', default => sub { [
         # Row 1: Places icons
@@ -166,9 +202,17 @@ package CinnamonIconsThemeManager {
         }
     ] });
 
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Frame address lookups into the current directory's view
+    sub theme_paths { $_[0]->view->paths }
+    sub theme_widgets { $_[0]->view->widgets }
+
     sub BUILD {
         my $self = shift;
         $self->_initialize_configuration();
+        return if $self->prewarm;
         $self->_setup_ui();
         $self->_populate_icon_directories();
         $self->_restore_last_selected_directory();
@@ -841,6 +885,7 @@ package CinnamonIconsThemeManager {
     sub _generate_icon_preview {
         my ($self, $theme_info, $output_file, $width, $height) = @_;
 
+        my $span = TRACING && trace_span('generate icon preview', theme => $theme_info->{name}, size => "${width}x${height}");
 
         # Check if already exists for this specific size
         if (-f $output_file && -s $output_file > 1000) {
@@ -865,7 +910,7 @@ package CinnamonIconsThemeManager {
         my $cr = Cairo::Context->create($surface);
         
         $self->_draw_icon_grid($cr, \@icon_pixbufs, $width, $height);
-        $surface->write_to_png($output_file);
+        $self->_store_preview($output_file, $surface);
         
         if (-f $output_file && -s $output_file > 1000) {
             print "Generated preview: $output_file\n";
@@ -920,23 +965,35 @@ package CinnamonIconsThemeManager {
         print "Directory structure initialized for Icons Theme Manager\n";
     }
 
+    # Cache file of a theme's preview at $size. The key covers the theme
+    # directory and its index.theme, so an updated theme maps to a new file.
+    sub _preview_cache_file {
+        my ($self, $theme_info, $size) = @_;
+
+        my $theme_path = $theme_info->{path};
+        my @index = stat("$theme_path/index.theme");
+        my @dir = stat($theme_path);
+        my $fingerprint = join("\0", $index[9] // 0, $index[7] // 0, $dir[9] // 0);
+
+        return $self->preview_cache->path_for(
+            CinnamonSettings::PreviewCache->key($theme_path, $fingerprint, "-preview-${size}.png")
+        );
+    }
+
     sub _is_valid_cached_preview {
         my ($self, $cache_file) = @_;
-        
-        # Check if file exists
-        return 0 unless -f $cache_file;
-        
-        # Check if file has reasonable size (at least 1KB)
-        my $file_size = -s $cache_file;
-        return 0 unless $file_size > 1000;
-        
-        # Check if file is recent enough (optional: skip very old cache files)
-        my $file_age = time() - (stat($cache_file))[9];
-        if ($file_age > (30 * 24 * 60 * 60)) {  # 30 days old
-  
-            return 0;
-        }
-        
+
+        # Any entry is current since the key changes with the theme; a hit
+        # also marks the entry as recently used
+        return $self->preview_cache->lookup(basename($cache_file)) ? 1 : 0;
+    }
+
+    # Write a rendered preview under its .part name and rename it into place
+    sub _store_preview {
+        my ($self, $cache_file, $surface) = @_;
+
+        $self->preview_cache->store_surface(basename($cache_file), $surface) or return 0;
+        $self->session->note_file_created();
         return 1;
     }
 
@@ -984,7 +1041,7 @@ package CinnamonIconsThemeManager {
                                     $box->show_all();
                                     
                                     # Update reference
-                                    $self->theme_widgets->{$frame + 0} = $new_image;
+                                    $self->view->set_widget($frame, $new_image);
                            
                                 }
                             }
@@ -1422,34 +1479,28 @@ package CinnamonIconsThemeManager {
     sub _populate_icon_directories {
         my $self = shift;
 
-        # Default icon theme directories
-        my @default_dirs = (
-            { name => 'User Icons', path => $ENV{HOME} . '/.local/share/icons' },
-            { name => 'User Icons (Legacy)', path => $ENV{HOME} . '/.icons' },
-            { name => 'System Icons', path => '/usr/share/icons' },
-        );
-
-        # Add default directories
-        foreach my $dir_info (@default_dirs) {
-            next unless -d $dir_info->{path};
-
+        foreach my $dir_info ($self->_icon_directories()) {
             my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
+            $self->directory_view->track($row, $dir_info->{path});
             $self->directory_list->add($row);
         }
 
-        # Add custom directories from config
-        if ($self->config->{custom_directories}) {
-            foreach my $custom_dir (@{$self->config->{custom_directories}}) {
-                next unless -d $custom_dir->{path};
+        print "Populated icon directories\n";
+    }
 
-                my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
-                $self->directory_list->add($row);
-            }
-        }
+    # Default icon theme directories followed by custom ones from the
+    # config, as far as they exist
+    sub _icon_directories {
+        my $self = shift;
 
-        print "Populated icon directories\n";
+        my @dirs = (
+            { name => 'User Icons', path => $ENV{HOME} . '/.local/share/icons' },
+            { name => 'User Icons (Legacy)', path => $ENV{HOME} . '/.icons' },
+            { name => 'System Icons', path => '/usr/share/icons' },
+            @{$self->config->{custom_directories} || []},
+        );
+
+        return grep { -d $_->{path} } @dirs;
     }
 
     sub _quick_theme_validation {
@@ -1531,42 +1582,6 @@ package CinnamonIconsThemeManager {
         return $is_valid;
     }
 
-    sub _save_config {
-        my ($self, $config) = @_;
-
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
-
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-            }
-
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
-
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
-
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
-
-            print "Successfully saved configuration\n";
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
-        }
-    }
-
     sub _scan_theme_directories_optimized {
         my ($self, $theme_path) = @_;
         
@@ -1825,8 +1840,7 @@ package CinnamonIconsThemeManager {
         my ($self, $theme_info) = @_;
         
         my $theme_name = $theme_info->{name};
-        my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/thumbnails';
-        my $cache_file = "$cache_dir/${theme_name}-preview-" . $self->zoom_level . ".png";
+        my $cache_file = $self->_preview_cache_file($theme_info, $self->zoom_level);
         
         # Find the widget for this theme
         my $flowbox = $self->icons_grid;
@@ -1892,7 +1906,7 @@ package CinnamonIconsThemeManager {
                                 $box->show_all();
                                 
                                 # Update reference
-                                $self->theme_widgets->{$frame + 0} = $image;
+                                $self->view->set_widget($frame, $image);
              
                             }
                         }
@@ -1944,7 +1958,7 @@ package CinnamonIconsThemeManager {
                                 $box->show_all();
                                 
                                 # Update reference
-                                $self->theme_widgets->{$frame + 0} = $image;
+                                $self->view->set_widget($frame, $image);
                                 print "Updated widget with cached preview for: $theme_name at ${zoom_level}px\n";
                             }
                         }
@@ -2099,7 +2113,7 @@ package CinnamonIconsThemeManager {
     }
 
     sub _connect_signals {
-        my ($self, $add_dir_button, $remove_dir_button, $zoom_in, $zoom_out) = @_;
+        my ($self, $add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out) = @_;
 
         # Connect signals for mode buttons
         $self->_connect_mode_button_signals($self->icons_mode, $self->settings_mode, $self->content_switcher);
@@ -2112,7 +2126,7 @@ package CinnamonIconsThemeManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_icons_from_directory ($row);
@@ -2126,6 +2140,10 @@ package CinnamonIconsThemeManager {
             $self->_remove_icon_directory();
         });
 
+        $archive_button->signal_connect('clicked' => sub {
+            $self->_preview_icon_archive();
+        });
+
         #  Zoom In Button - ensure we read current zoom level correctly
         $zoom_in->signal_connect('clicked' => sub {
             my $current_zoom = $self->zoom_level;
@@ -2148,7 +2166,7 @@ package CinnamonIconsThemeManager {
             
             # Save config
             $self->config->{preview_size} = $new_zoom;
-            $self->_save_config($self->config);
+            $self->config_store->save();
 
         });
 
@@ -2175,7 +2193,7 @@ package CinnamonIconsThemeManager {
             
             # Save config
             $self->config->{preview_size} = $new_zoom;
-            $self->_save_config($self->config);
+            $self->config_store->save();
             
         });
 
@@ -2195,10 +2213,14 @@ package CinnamonIconsThemeManager {
         });
 
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
             # Clean up any running background processes
             $self->_cleanup_background_processes();
+            $self->session->report_stats();
+            $self->preview_cache->report_stats();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -2497,24 +2519,34 @@ package CinnamonIconsThemeManager {
         my $flowbox = $self->icons_grid;
         foreach my $child ($flowbox->get_children()) {
             $flowbox->remove($child);
+            $child->destroy();
         }
         $flowbox->show_all();
 
         # Clear references immediately
-        $self->theme_paths({});
-        $self->theme_widgets({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
         $self->current_directory($dir_path);
 
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Drop widget and preview work still queued for the previous directory
+        $self->scheduler->cancel($self->load_token);
+        $self->scheduler->cancel($self->preview_token);
+        $self->load_token($self->scheduler->new_token());
+
         # Check cache first - this should be instant
-        if (exists $self->cached_theme_lists->{$dir_path}) {
-            my $themes_ref = $self->cached_theme_lists->{$dir_path};
+        if ($self->cached_theme_lists->contains($dir_path)) {
+            my $themes_ref = $self->cached_theme_lists->get($dir_path);
             print "Using cached theme list for $dir_path (" . @$themes_ref . " themes)\n";
             
-            # Use very short timeout to prevent blocking
-            Glib::Timeout->add(10, sub {
-                $self->_display_themes_immediately($themes_ref, $dir_path);
-                return 0;
-            });
+            # Let the cleared grid draw before widgets are created
+            $self->scheduler->defer(
+                label => 'icons: display cached themes',
+                priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+                token => $self->load_token,
+                run => sub { $self->_display_themes_immediately($themes_ref, $dir_path) },
+            );
         } else {
             # Start background scanning with very small time slices
             print "Starting background scan of $dir_path\n";
@@ -2529,45 +2561,43 @@ package CinnamonIconsThemeManager {
 
         $self->{preview_generation_active} = 1;
 
-        my $item = shift @{$self->{preview_generation_queue}};
-        my $theme_name = $item->{theme_info}->{name} || '';
+        # One preview per step, behind anything the user is waiting for
+        $self->scheduler->add_task(
+            label => 'icons: generate queued previews',
+            priority => CinnamonSettings::Scheduler::PRIORITY_LOW,
+            step => sub {
+                my $item = shift @{$self->{preview_generation_queue}} or return 0;
+                my $theme_name = $item->{theme_info}->{name} || '';
 
-        # Mark as currently being generated
-        $self->{currently_generating_preview} = $theme_name;
+                # Mark as currently being generated
+                $self->{currently_generating_preview} = $theme_name;
 
-        print "Processing preview generation for: $theme_name\n";
+                print "Processing preview generation for: $theme_name\n";
 
-        # Generate preview in background
-        Glib::Timeout->add(50, sub {
-            my $success = $self->_generate_icon_preview(
-                $item->{theme_info},
-                $item->{cache_file},
-                $item->{width},
-                $item->{height}
-            );
+                my $success = $self->_generate_icon_preview(
+                    $item->{theme_info},
+                    $item->{cache_file},
+                    $item->{width},
+                    $item->{height}
+                );
 
-            if ($success) {
-                print "Generated preview for $theme_name\n";
-                # Trigger a refresh of this specific theme widget
-                $self->_refresh_theme_widget_if_visible($theme_name);
-            }
+                if ($success) {
+                    print "Generated preview for $theme_name\n";
+                    # Trigger a refresh of this specific theme widget
+                    $self->_refresh_theme_widget_if_visible($theme_name);
+                }
 
-            # Clear currently generating flag
-            $self->{currently_generating_preview} = undef;
+                # Clear currently generating flag
+                $self->{currently_generating_preview} = undef;
 
-            # Continue with next item in queue
-            if (@{$self->{preview_generation_queue}}) {
-                Glib::Timeout->add(100, sub {
-                    $self->_process_preview_generation_queue();
-                    return 0;
-                });
-            } else {
+                # Continue with next item in queue
+                return scalar @{$self->{preview_generation_queue}};
+            },
+            on_done => sub {
                 $self->{preview_generation_active} = 0;
                 print "Preview generation queue completed\n";
-            }
-
-            return 0;
-        });
+            },
+        );
     }
 
     sub _set_icon_theme {
@@ -2592,7 +2622,7 @@ package CinnamonIconsThemeManager {
                 path => $theme_info->{path},
                 timestamp => time()
             };
-            $self->_save_config($self->config);
+            $self->config_store->save();
             
             print "Applied icon theme: $theme_name\n";
             return 0;
@@ -2624,24 +2654,18 @@ package CinnamonIconsThemeManager {
         
         print "Found $total_dirs subdirectories to scan\n";
         
-        # Process directories in very small batches
+        # Validate one candidate directory per scheduler step
         my $processed = 0;
         my @found_themes = ();
-        
-        my $process_batch;
-        $process_batch = sub {
-            return 0 if $self->current_directory ne $dir_path;
-            
-            my $batch_size = 3; # Very small batches
-            my $end_idx = ($processed + $batch_size - 1 < $total_dirs - 1) 
-                         ? $processed + $batch_size - 1 
-                         : $total_dirs - 1;
-            
-            # Process this small batch
-            for my $i ($processed..$end_idx) {
-                my $subdir = $all_subdirs[$i];
+
+        $self->scheduler->foreach_item(
+            label => 'icons: scan theme directory',
+            token => $self->load_token,
+            items => \@all_subdirs,
+            each => sub {
+                my $subdir = shift;
                 my $theme_path = "$dir_path/$subdir";
-                
+
                 # Quick validation
                 my $index_file = "$theme_path/index.theme";
                 if (-f $index_file && $self->_quick_theme_validation($theme_path)) {
@@ -2649,35 +2673,26 @@ package CinnamonIconsThemeManager {
                     push @found_themes, $theme_info;
                     print "Found valid theme: $subdir\n";
                 }
-            }
-            
-            $processed = $end_idx + 1;
-            my $progress = int(($processed / $total_dirs) * 100);
-            $self->_update_loading_progress("Scanning themes...", $progress);
-            
-            if ($processed < $total_dirs) {
-                # Continue with next batch - very short delay
-                Glib::Timeout->add(5, $process_batch);
-                return 0;
-            } else {
+
+                $processed++;
+                my $progress = int(($processed / $total_dirs) * 100);
+                $self->_update_loading_progress("Scanning themes...", $progress);
+            },
+            on_done => sub {
                 # Scanning complete
                 @found_themes = sort { lc($a->{name}) cmp lc($b->{name}) } @found_themes;
-                $self->cached_theme_lists->{$dir_path} = \@found_themes;
-                
+                $self->cached_theme_lists->set($dir_path, \@found_themes);
+
                 print "Scan complete: " . @found_themes . " themes found\n";
-                
+
                 if (@found_themes > 0) {
                     $self->_display_themes_immediately(\@found_themes, $dir_path);
                 } else {
                     $self->_show_no_themes_message();
                 }
-                return 0;
-            }
-        };
-        
-        # Start processing
-        Glib::Timeout->add(10, $process_batch);
-    }   
+            },
+        );
+    }
 
     sub _start_lazy_preview_loading {
         my ($self, $themes_ref, $dir_path) = @_;
@@ -2706,7 +2721,7 @@ package CinnamonIconsThemeManager {
             print "Processing preview " . $current_index . "/" . @$themes_to_process . ": $theme_name\n";
             
             # Check if preview already exists
-            my $cache_file = $ENV{HOME} . "/.local/share/cinnamon-icons-theme-manager/thumbnails/${theme_name}-preview-400.png";
+            my $cache_file = $self->_preview_cache_file($theme_info, 400);
             
             if (-f $cache_file && -s $cache_file > 1000) {
                 # Load existing preview
@@ -2757,75 +2772,52 @@ package CinnamonIconsThemeManager {
         
         print "Starting lazy preview loading for " . @$themes_ref . " themes at ${zoom_level}px\n";
         
-        # Cancel any existing preview loading
-        if ($self->{preview_loading_timeout}) {
-            Glib::Source->remove($self->{preview_loading_timeout});
-            $self->{preview_loading_timeout} = undef;
-        }
+        # Cancel any existing preview loading, e.g. for the previous zoom level
+        $self->scheduler->cancel($self->preview_token);
+        my $token = $self->scheduler->new_token();
+        $self->preview_token($token);
         
-        my $themes_to_process = [@$themes_ref]; # Copy array
+        my $total = @$themes_ref;
         my $current_index = 0;
         
-        my $process_next;
-        $process_next = sub {
-            # Stop if directory changed or zoom level changed
-            return 0 if ($self->current_directory ne $dir_path || $self->zoom_level != $zoom_level);
-            return 0 if $current_index >= @$themes_to_process;
-            
-            my $theme_info = $themes_to_process->[$current_index];
-            my $theme_name = $theme_info->{name};
-            $current_index++;
-            
-            print "Processing preview " . $current_index . "/" . @$themes_to_process . ": $theme_name at ${zoom_level}px\n";
-            
-            # CHECK CACHE FIRST
-            my $cache_file = $ENV{HOME} . "/.local/share/cinnamon-icons-theme-manager/thumbnails/${theme_name}-preview-${zoom_level}.png";
-            
-            if ($self->_is_valid_cached_preview($cache_file)) {
-                # Use existing cached preview
-                $self->_update_widget_with_cached_preview_at_zoom($theme_info, $cache_file, $zoom_level);
+        $self->scheduler->foreach_item(
+            label => 'icons: load theme previews',
+            token => $token,
+            items => $themes_ref,
+            each => sub {
+                my $theme_info = shift;
+                my $theme_name = $theme_info->{name};
+                $current_index++;
                 
-                # Continue immediately to next theme
-                if ($current_index < @$themes_to_process) {
-                    $self->{preview_loading_timeout} = Glib::Timeout->add(10, $process_next);
-                } else {
-                    print "All preview loading completed\n";
-                    $self->{preview_loading_timeout} = undef;
+                print "Processing preview " . $current_index . "/" . $total . ": $theme_name at ${zoom_level}px\n";
+                
+                # CHECK CACHE FIRST
+                my $cache_file = $self->_preview_cache_file($theme_info, $zoom_level);
+                
+                if ($self->_is_valid_cached_preview($cache_file)) {
+                    # Use existing cached preview
+                    $self->_update_widget_with_cached_preview_at_zoom($theme_info, $cache_file, $zoom_level);
+                    return;
                 }
-            } else {
+                
                 # Generate new preview
-                Glib::Idle->add(sub {
-                    return 0 if ($self->current_directory ne $dir_path || $self->zoom_level != $zoom_level);
-                    
-                    my $success = 0;
-                    eval {
-                        $success = $self->_generate_simple_preview($theme_info, $cache_file);
-                    };
-                    if ($@) {
-                        print "Error generating preview for $theme_name: $@\n";
-                    }
-                    
-                    if ($success && $self->_is_valid_cached_preview($cache_file)) {
-                        $self->_update_widget_with_cached_preview_at_zoom($theme_info, $cache_file, $zoom_level);
-                    }
-                    
-                    # Continue to next theme
-                    if ($current_index < @$themes_to_process && $self->zoom_level == $zoom_level) {
-                        $self->{preview_loading_timeout} = Glib::Timeout->add(200, $process_next);
-                    } else {
-                        print "All preview loading completed\n";
-                        $self->{preview_loading_timeout} = undef;
-                    }
-                    
-                    return 0;
-                });
-            }
-            
-            return 0;
-        };
-        
-        # Start processing
-        $self->{preview_loading_timeout} = Glib::Timeout->add(10, $process_next);
+                my $success = 0;
+                eval {
+                    $success = $self->_generate_simple_preview($theme_info, $cache_file);
+                };
+                if ($@) {
+                    print "Error generating preview for $theme_name: $@\n";
+                }
+                
+                if ($success && $self->_is_valid_cached_preview($cache_file)) {
+                    $self->_update_widget_with_cached_preview_at_zoom($theme_info, $cache_file, $zoom_level);
+                }
+            },
+            on_done => sub {
+                print "All preview loading completed\n";
+                delete $self->{load_span};
+            },
+        );
     }
 
     sub _start_non_blocking_preview_generation {
@@ -2856,8 +2848,7 @@ package CinnamonIconsThemeManager {
             # Generate preview in idle callback to prevent UI blocking
             Glib::Idle->add(sub {
                 # Check if we already have preview at current zoom level
-                my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/thumbnails';
-                my $cache_file = "$cache_dir/${theme_name}-preview-${current_zoom}.png";
+                my $cache_file = $self->_preview_cache_file($theme_info, $current_zoom);
                 
                 # Only generate if not cached for this specific size
                 if (!(-f $cache_file && -s $cache_file > 1000)) {
@@ -2990,8 +2981,7 @@ package CinnamonIconsThemeManager {
                 my $theme_name = $theme_info->{name};
                 
                 #  Always check cache first for zoom changes
-                my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/thumbnails';
-                my $cache_file = "$cache_dir/${theme_name}-preview-${width}.png";
+                my $cache_file = $self->_preview_cache_file($theme_info, $width);
                 
                 if ($self->_is_valid_cached_preview($cache_file)) {
                     # Load existing high-quality preview immediately
@@ -3076,7 +3066,7 @@ package CinnamonIconsThemeManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -3088,7 +3078,7 @@ package CinnamonIconsThemeManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -3121,7 +3111,77 @@ package CinnamonIconsThemeManager {
         my $remove_icon = Gtk3::Image->new_from_icon_name('list-remove-symbolic', 1);
         $remove_button->add($remove_icon);
 
-        return ($add_button, $remove_button);
+        my $archive_button = Gtk3::Button->new();
+        $archive_button->set_relief('none');
+        $archive_button->set_size_request(32, 32);
+        $archive_button->set_tooltip_text('Preview and install an icon theme archive');
+
+        my $archive_icon = Gtk3::Image->new_from_icon_name('package-x-generic-symbolic', 1);
+        $archive_button->add($archive_icon);
+
+        return ($add_button, $remove_button, $archive_button);
+    }
+
+    # Preview a downloaded icon theme archive from the preview icons alone,
+    # read into memory, and install it into ~/.local/share/icons once
+    # confirmed
+    sub _preview_icon_archive {
+        my $self = shift;
+
+        my $icons_dir = $ENV{HOME} . '/.local/share/icons';
+        my @names = map { ($_->{name}, @{$_->{alternatives}}, @{$_->{fallback_names}}) } @{$self->icon_types};
+
+        CinnamonSettings::ArchivePreviewDialog->new(
+            parent => $self->window,
+            session => $self->session,
+            kind => 'icon',
+            names => \@names,
+            install_dir => $icons_dir,
+            render => sub { $self->_render_archive_icons(@_) },
+            on_installed => sub {
+                $self->cached_theme_lists->remove($icons_dir);
+                my $row = $self->directory_list->get_selected_row();
+                if ($row && ($self->directory_paths->{$row + 0} // '') eq $icons_dir) {
+                    $self->current_directory(undef);
+                    $self->_load_icons_from_directory($row);
+                }
+            },
+        )->run();
+    }
+
+    sub _render_archive_icons {
+        my ($self, $archive, $theme) = @_;
+
+        # Candidate files per icon name; scalable first, then the largest
+        my %candidates;
+        foreach my $path (keys %{$archive->theme_members($theme)}) {
+            next unless $path =~ m{([^/]+)\.(png|svg)$};
+            my ($icon_name, $ext) = ($1, $2);
+            my $score = $ext eq 'svg' || $path =~ /scalable/ ? 1000 : $path =~ m{(?:^|/)(\d+)(?:x\d+)?(?:@\d+x?)?/} ? $1 : 0;
+            push @{$candidates{$icon_name}}, [$score, $path];
+        }
+
+        my @cells;
+        foreach my $icon_type (@{$self->icon_types}) {
+            foreach my $icon_name ($icon_type->{name}, @{$icon_type->{alternatives}}, @{$icon_type->{fallback_names}}) {
+                my ($best) = sort { $b->[0] <=> $a->[0] } @{$candidates{$icon_name} || []};
+                next unless $best;
+
+                my $pixbuf = eval {
+                    my $loader = Gtk3::Gdk::PixbufLoader->new();
+                    $loader->set_size(48, 48);
+                    $loader->write($archive->member($best->[1]));
+                    $loader->close();
+                    $loader->get_pixbuf();
+                };
+                next unless $pixbuf;
+
+                push @cells, [Gtk3::Image->new_from_pixbuf($pixbuf), $icon_type->{desc}];
+                last;
+            }
+        }
+
+        return CinnamonSettings::ArchivePreviewDialog->preview_grid(@cells);
     }
 
     sub _create_instant_theme_widget {
@@ -3169,8 +3229,7 @@ package CinnamonIconsThemeManager {
         $frame->add($box);
         
         # Store references
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $placeholder;
+        $self->view->track($frame, $theme_info, $placeholder);
         
         return $frame;
     }
@@ -3221,8 +3280,7 @@ package CinnamonIconsThemeManager {
         $frame->add($box);
         
         # Store references
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $placeholder;
+        $self->view->track($frame, $theme_info, $placeholder);
         
         return $frame;
     }
@@ -3258,13 +3316,8 @@ package CinnamonIconsThemeManager {
         $cr->move_to($x, $y);
         $cr->show_text($text);
 
-        # Convert to pixbuf using a unique temporary file
-        my $temp_file = "/tmp/placeholder_$$.png";
-        $surface->write_to_png($temp_file);
-        my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($temp_file);
-        unlink($temp_file);
-
-        return $pixbuf;
+        # Convert to pixbuf directly from the surface
+        return Gtk3::Gdk::pixbuf_get_from_surface($surface, 0, 0, $width, $height);
     }
 
     sub _initialize_configuration {
@@ -3287,7 +3340,7 @@ package CinnamonIconsThemeManager {
         if ($zoom_level != 400 && $zoom_level != 500 && $zoom_level != 600) {
             $zoom_level = 400;
             $config->{preview_size} = 400;
-            $self->_save_config($config);
+            $self->config_store->save();
         }
         
         #  Set zoom level properly in object
@@ -3300,62 +3353,59 @@ package CinnamonIconsThemeManager {
         print "  Last directory: " . ($self->last_selected_directory_path || 'none') . "\n";
     }
 
+    sub _build_config_store {
+        my $self = shift;
+
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                preview_size => 400,  # Always default to 400px
+                custom_directories => [],
+                last_selected_directory => undef,
+                theme_backups => [],
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
+
     sub _load_config {
         my $self = shift;
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            preview_size => 400,  # Always default to 400px
-            custom_directories => [],
-            last_selected_directory => undef,
-            theme_backups => [],
-        };
-        
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-                
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-                    
-                    #  Validate and correct preview_size
-                    my $preview_size = $config->{preview_size};
-                    if (!$preview_size || ($preview_size != 400 && $preview_size != 500 && $preview_size != 600)) {
-                        print "Invalid preview size in config ($preview_size), using default 400px\n";
-                        $config->{preview_size} = 400;
-                    } else {
-                        print "Loaded preview size from config: ${preview_size}px\n";
-                    }
-                    
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
-                    
-                    # Ensure theme_backups is an array ref
-                    if (!ref($config->{theme_backups}) || ref($config->{theme_backups}) ne 'ARRAY') {
-                        $config->{theme_backups} = [];
-                    }
-                    
-                    print "Loaded configuration from $config_file\n";
-                } else {
-                    print "Config file is empty, using defaults (400px)\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration (400px)\n";
-            }
-        } else {
-            print "Config file not found, using defaults (400px)\n";
+        return $self->config_store->load();
+    }
+
+    sub _validate_config {
+        my ($self, $config) = @_;
+
+        #  Validate and correct preview_size
+        my $preview_size = $config->{preview_size};
+        if (!$preview_size || ($preview_size != 400 && $preview_size != 500 && $preview_size != 600)) {
+            print "Invalid preview size in config (" . ($preview_size // 'none') . "), using default 400px\n";
+            $config->{preview_size} = 400;
+        }
+
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
+
+        # Ensure theme_backups is an array ref
+        if (!ref($config->{theme_backups}) || ref($config->{theme_backups}) ne 'ARRAY') {
+            $config->{theme_backups} = [];
+        }
+    }
+
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
+
+        return unless $self->icons_grid;
+
+        if (grep { $_ eq 'preview_size' } @$keys) {
+            $self->zoom_level($self->config->{preview_size});
+            $self->_update_icon_zoom_non_blocking();
+            $self->_adjust_grid_columns();
         }
-        
-        return $config;
     }
 
     sub _remove_icon_directory {
@@ -3394,11 +3444,11 @@ package CinnamonIconsThemeManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -3491,10 +3541,11 @@ package CinnamonIconsThemeManager {
         $control_container->set_margin_top(6);
         $control_container->set_margin_bottom(6);
 
-        my ($add_dir_button, $remove_dir_button) = $self->_create_directory_buttons();
+        my ($add_dir_button, $remove_dir_button, $archive_button) = $self->_create_directory_buttons();
 
         $control_container->pack_start($add_dir_button, 1, 1, 0);
         $control_container->pack_start($remove_dir_button, 1, 1, 0);
+        $control_container->pack_start($archive_button, 1, 1, 0);
 
         $left_container->pack_start($control_container, 0, 0, 0);
 
@@ -3598,7 +3649,7 @@ package CinnamonIconsThemeManager {
         $self->loading_box($loading_box);
 
         # Connect signals
-        $self->_connect_signals($add_dir_button, $remove_dir_button, $zoom_in, $zoom_out);
+        $self->_connect_signals($add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out);
 
         print "UI setup completed\n";
     }
@@ -3607,10 +3658,7 @@ package CinnamonIconsThemeManager {
         my $self = shift;
 
         # Clear cached theme lists to free memory
-        $self->cached_theme_lists({});
-
-        # Clear icon cache
-        $self->icon_cache({});
+        $self->cached_theme_lists->clear();
 
         print "Background processes cleaned up\n";
     }
@@ -3626,10 +3674,7 @@ package CinnamonIconsThemeManager {
         my $height = int($size * 0.75);
 
         # Check cache first
-        my $cache_dir = $ENV{HOME} . '/.local/share/cinnamon-icons-theme-manager/thumbnails';
-        system("mkdir -p '$cache_dir'") unless -d $cache_dir;
-
-        my $preview_path = "$cache_dir/${theme_name}-preview-${size}.png";
+        my $preview_path = $self->_preview_cache_file($theme_info, $size);
 
         #  Better cache validation and create preview at requested size
         my $preview_widget;
@@ -3661,8 +3706,38 @@ package CinnamonIconsThemeManager {
         return $preview_widget;
     }
 
+    # Headless --prewarm: render the icon grid preview of every theme at
+    # the configured preview size
+    sub prewarm_caches {
+        my ($self, @dirs) = @_;
+
+        my $prewarm = CinnamonSettings::Prewarm->new(app_name => 'cinnamon-icon-themes-manager');
+        $prewarm->lower_priority();
+        @dirs = map { $_->{path} } $self->_icon_directories() unless @dirs;
+
+        my $zoom_level = $self->zoom_level;
+        foreach my $dir_path (grep { -d } @dirs) {
+            my @themes = $self->_scan_icon_themes($dir_path);
+            $prewarm->note("$dir_path: " . @themes . " icon themes");
+
+            foreach my $theme_info (@themes) {
+                # The cache file _start_lazy_preview_loading_at_zoom looks for
+                my $cache_file = $self->_preview_cache_file($theme_info, $zoom_level);
+                $prewarm->add($theme_info->{name}, sub {
+                    return 'current' if $self->_is_valid_cached_preview($cache_file);
+                    # Themes with too few of the grid's icons get no preview
+                    return $self->_generate_simple_preview($theme_info, $cache_file) ? 'created' : 'skipped';
+                });
+            }
+        }
+
+        return $prewarm->run();
+    }
+
     sub _generate_simple_preview {
         my ($self, $theme_info, $cache_file) = @_;
+
+        my $span = TRACING && trace_span('generate icon preview', theme => $theme_info->{name});
         
         my $theme_path = $theme_info->{path};
         my $theme_name = $theme_info->{name};
@@ -3823,7 +3898,7 @@ package CinnamonIconsThemeManager {
             #  Use high-quality icon grid drawing method
             $self->_draw_high_quality_icon_grid($cr, \@found_pixbufs, $target_width, $target_height);
             
-            $surface->write_to_png($cache_file);
+            return 0 unless $self->_store_preview($cache_file, $surface);
             print "Generated HIGH-RESOLUTION preview with $real_icons_count real icons: $cache_file\n";
             return 1;
         } else {
@@ -3859,17 +3934,18 @@ package CinnamonIconsThemeManager {
         my $flowbox = $self->icons_grid;
         foreach my $child ($flowbox->get_children()) {
             $flowbox->remove($child);
+            $child->destroy();
         }
 
         # Clear references
-        $self->theme_paths({});
-        $self->theme_widgets({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
         $self->current_directory($dir_path);
 
         # Check cache first - this is fast and non-blocking
         my $themes_ref;
-        if (exists $self->cached_theme_lists->{$dir_path}) {
-            $themes_ref = $self->cached_theme_lists->{$dir_path};
+        if ($self->cached_theme_lists->contains($dir_path)) {
+            $themes_ref = $self->cached_theme_lists->get($dir_path);
             print "Using cached theme list for $dir_path (" . @$themes_ref . " themes)\n";
             $self->_display_themes_non_blocking($themes_ref, $dir_path);
         } else {
@@ -3883,7 +3959,7 @@ package CinnamonIconsThemeManager {
                 my @themes = $self->_scan_icon_themes($dir_path);
                 @themes = sort { lc($a->{name}) cmp lc($b->{name}) } @themes;
                 $themes_ref = \@themes;
-                $self->cached_theme_lists->{$dir_path} = $themes_ref;
+                $self->cached_theme_lists->set($dir_path, $themes_ref);
                 
                 print "Scanned $dir_path: " . @themes . " icon themes found\n";
                 
@@ -3919,7 +3995,7 @@ package CinnamonIconsThemeManager {
                     print "Refreshing widget for $theme_name\n";
 
                     # Replace the placeholder with the new preview
-                    my $cache_file = $ENV{HOME} . "/.local/share/cinnamon-icons-theme-manager/thumbnails/${theme_name}-preview-" . $self->zoom_level . ".png";
+                    my $cache_file = $self->_preview_cache_file($theme_info, $self->zoom_level);
                     if (-f $cache_file && -s $cache_file) {
                         my $new_preview = eval {
                             my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale(
@@ -3948,7 +4024,7 @@ package CinnamonIconsThemeManager {
                                         $box->show_all();
 
                                         # Update widget reference
-                                        $self->theme_widgets->{$container + 0} = $new_preview;
+                                        $self->view->set_widget($container, $new_preview);
                                     }
                                 }
                             }
@@ -4306,7 +4382,7 @@ sub _scan_icon_themes {
             shift @{$self->config->{theme_backups}};
         }
 
-        $self->_save_config($self->config);
+        $self->config_store->save();
 
         my $dialog = Gtk3::MessageDialog->new(
             $self->window,
@@ -4374,8 +4450,7 @@ sub _scan_icon_themes {
         $frame->add($box);
 
         # Store references
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $preview_widget;
+        $self->view->track($frame, $theme_info, $preview_widget);
 
         return $frame;
     }
@@ -4421,8 +4496,7 @@ sub _scan_icon_themes {
         $frame->add($box);
 
         # Store references
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $placeholder;
+        $self->view->track($frame, $theme_info, $placeholder);
 
         return $frame;
     }
@@ -4474,17 +4548,24 @@ sub _scan_icon_themes {
         #  Use current zoom level from object
         my $current_zoom = $self->zoom_level;
         
-        # Create ALL widgets immediately with simple placeholders at current zoom level
-        foreach my $theme_info (@$themes_ref) {
-            my $widget = $self->_create_instant_theme_widget_at_zoom($theme_info, $current_zoom);
-            $self->icons_grid->add($widget);
-        }
-        
-        $self->icons_grid->show_all();
-        $self->_hide_loading_indicator();
-        
-        # Start lazy preview loading in background at current zoom level
-        $self->_start_lazy_preview_loading_at_zoom($themes_ref, $dir_path, $current_zoom);
+        # Create widgets with simple placeholders at current zoom level
+        $self->scheduler->foreach_item(
+            label => 'icons: create theme widgets',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $self->load_token,
+            items => $themes_ref,
+            each => sub {
+                my $widget = $self->_create_instant_theme_widget_at_zoom(shift, $current_zoom);
+                $self->icons_grid->add($widget);
+                $widget->show_all();
+            },
+            on_done => sub {
+                $self->_hide_loading_indicator();
+
+                # Start lazy preview loading in background at current zoom level
+                $self->_start_lazy_preview_loading_at_zoom($themes_ref, $dir_path, $current_zoom);
+            },
+        );
     }
 
     sub _draw_high_quality_icon_grid {
@@ -4874,7 +4955,15 @@ sub _scan_icon_themes {
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-icon-themes-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Cinnamon Icons Theme Manager started\n";
         Gtk3::main();
     }
@@ -4882,6 +4971,12 @@ sub _scan_icon_themes {
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit CinnamonIconsThemeManager->new(prewarm => 1)->prewarm_caches(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = CinnamonIconsThemeManager->new();
     $app->run();
 }
@@ -0,0 +1,298 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - system preview cache builder
+# Generates, without a display, the previews every user would otherwise
+# build on first login for the themes and wallpapers installed under
+# /usr/share: cursor frames, Cinnamon theme thumbnails, GTK color tables
+# and wallpaper thumbnails. They go to the read-only system cache that the
+# managers check before their per-user caches. Run by "make install-caches"
+# and after package updates; entries that are still current are kept and
+# entries for changed or removed sources are deleted.
+
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+
+package SystemCacheBuilder {
+    use Moo;
+    use Gtk3;
+    use Cwd qw(realpath);
+    use File::Find qw(find);
+    use File::Path qw(make_path);
+    use File::Basename qw(basename);
+    use Getopt::Long qw(GetOptionsFromArray);
+    use CinnamonSettings::SystemCache;
+    use CinnamonSettings::Session;
+    use CinnamonSettings::ThumbnailCache;
+    use CinnamonSettings::CssColorTable;
+    use CinnamonSettings::CinnamonStyle;
+    use CinnamonSettings::CinnamonThemeIndex;
+
+    has 'root' => (is => 'rw', default => sub { CinnamonSettings::SystemCache::DEFAULT_ROOT });
+    has 'icon_dirs' => (is => 'rw', default => sub { ['/usr/share/icons'] });
+    has 'theme_dirs' => (is => 'rw', default => sub { ['/usr/share/themes'] });
+    has 'background_dirs' => (is => 'rw', default => sub { ['/usr/share/backgrounds'] });
+    # The sizes each manager's zoom buttons can reach from its default
+    has 'cursor_sizes' => (is => 'rw', default => sub { [24, 32, 40, 48, 56, 64] });
+    has 'theme_widths' => (is => 'rw', default => sub { [400] });
+    has 'background_sizes' => (is => 'rw', default => sub { [200, 300, 400] });
+    has 'extractor' => (is => 'rw');
+    has 'session' => (is => 'ro', default => sub {
+        CinnamonSettings::Session->new(app_name => 'cinnamon-settings-cache-builder')
+    });
+    # Entry names produced by this run, per section; everything else is stale
+    has 'wanted' => (is => 'ro', default => sub { {} });
+    has 'stats' => (is => 'ro', default => sub { {} });
+
+    sub run {
+        my ($self, @argv) = @_;
+
+        my $usage = "Usage: $0 [--output DIR] [--icons DIR]... [--themes DIR]... [--backgrounds DIR]...\n"
+                  . "       [--cursor-sizes 24,32,...] [--theme-widths 400,...] [--background-sizes 200,...]\n"
+                  . "       [--extractor PATH]\n";
+        my (@icons, @themes, @backgrounds, $help);
+        GetOptionsFromArray(\@argv,
+            'output=s'           => sub { $self->root($_[1]) },
+            'icons=s'            => \@icons,
+            'themes=s'           => \@themes,
+            'backgrounds=s'      => \@backgrounds,
+            'cursor-sizes=s'     => sub { $self->cursor_sizes(_size_list($_[1])) },
+            'theme-widths=s'     => sub { $self->theme_widths(_size_list($_[1])) },
+            'background-sizes=s' => sub { $self->background_sizes(_size_list($_[1])) },
+            'extractor=s'        => sub { $self->extractor($_[1]) },
+            'help'               => \$help,
+        ) or die $usage;
+
+        if ($help) {
+            print $usage;
+            return 0;
+        }
+
+        $self->icon_dirs(\@icons) if @icons;
+        $self->theme_dirs(\@themes) if @themes;
+        $self->background_dirs(\@backgrounds) if @backgrounds;
+        $self->extractor($self->extractor || _find_extractor());
+
+        # Every user reads these files
+        umask 022;
+        make_path($self->root);
+        print "Building system preview cache in " . $self->root . "\n";
+
+        $self->_build_cursors();
+        $self->_build_cinnamon_themes();
+        $self->_build_color_tables();
+        $self->_build_backgrounds();
+        $self->_prune();
+
+        foreach my $section (sort keys %{$self->stats}) {
+            my $stats = $self->stats->{$section};
+            printf "  %-16s %5d created, %5d current, %4d failed, %4d removed\n", $section,
+                map { $stats->{$_} || 0 } qw(created current failed removed);
+        }
+        return 0;
+    }
+
+    sub _build_cursors {
+        my $self = shift;
+
+        my $cache = $self->_section('cursors');
+        unless ($self->extractor) {
+            print "  xcursor_extractor not found; cursor previews skipped\n";
+            return;
+        }
+
+        foreach my $theme_dir ($self->_theme_dirs($self->icon_dirs)) {
+            my $cursors_dir = "$theme_dir/cursors";
+            next unless -d $cursors_dir;
+            print "  Cursors: $theme_dir\n";
+
+            # Alias names share one set of frames through symlinks
+            my %entries;
+            opendir(my $dh, $cursors_dir) or next;
+            foreach my $name (sort grep { !/^\./ } readdir($dh)) {
+                my $cursor_file = "$cursors_dir/$name";
+                next unless -f $cursor_file;
+                my $real = realpath($cursor_file) // $cursor_file;
+
+                foreach my $size (@{$self->cursor_sizes}) {
+                    my $target = $cache->path_for($cursor_file, "_${size}.argb32") or next;
+                    my $shared = $entries{"$real\0$size"};
+                    $entries{"$real\0$size"} //= $target;
+
+                    $self->_produce($cache, $target, sub {
+                        return symlink(basename($shared), "$target.part") && rename("$target.part", $target)
+                            if $shared && -s $shared;
+
+                        my ($result, $data) = $self->session->capture($self->extractor, '--argb32', $cursor_file, $size);
+                        return $result == 0 && length($data) && _write_file($target, $data);
+                    });
+                }
+            }
+            closedir($dh);
+        }
+    }
+
+    # Thumbnails, or previews synthesized from cinnamon.css, at the sizes
+    # the Cinnamon themes manager asks its ThumbnailCache for
+    sub _build_cinnamon_themes {
+        my $self = shift;
+
+        my $cache = $self->_section('cinnamon-themes');
+        my $thumbnails = CinnamonSettings::ThumbnailCache->new(cache_dir => $cache->dir, disk_budget => 0);
+        my $styles = CinnamonSettings::CinnamonStyle->new();
+        my $index = CinnamonSettings::CinnamonThemeIndex->new(index_file => '/dev/null');
+
+        foreach my $theme_dir ($self->_theme_dirs($self->theme_dirs)) {
+            my $entry = $index->parse_theme($theme_dir, basename($theme_dir));
+            next unless $entry->{is_theme};
+            print "  Cinnamon theme: $theme_dir\n";
+
+            my $css_file = "$entry->{cinnamon_path}/cinnamon.css";
+            foreach my $width (@{$self->theme_widths}) {
+                my $height = int($width * 0.75);
+
+                if (my $thumbnail = $entry->{thumbnail_path}) {
+                    my $target = $thumbnails->path_for($thumbnail, $width, $height) or next;
+                    $self->_produce($cache, $target, sub {
+                        CinnamonSettings::ThumbnailCache->scale_file($thumbnail, $target, $width, $height);
+                    });
+                } else {
+                    my $target = $thumbnails->path_for($css_file, $width, $height) or next;
+                    $self->_produce($cache, $target, sub {
+                        my $style = $styles->style_for($css_file) or return 0;
+                        my $surface = $styles->render_preview($style, $width, $height);
+                        return $thumbnails->store_surface($css_file, $width, $height, $surface);
+                    });
+                }
+            }
+        }
+    }
+
+    sub _build_color_tables {
+        my $self = shift;
+
+        my $cache = $self->_section('colors');
+        my $colors = CinnamonSettings::CssColorTable->new(cache_dir => $cache->dir);
+
+        foreach my $theme_dir ($self->_theme_dirs($self->theme_dirs)) {
+            my $css_file = "$theme_dir/gtk-3.0/gtk.css";
+            next unless -f $css_file;
+
+            # color_table() keeps a current table and rebuilds a stale one
+            my $target = $colors->cache_file_for($css_file);
+            my $before = (stat($target))[9];
+            $self->wanted->{$cache->section}{basename($target)} = 1;
+            my $table = eval { $colors->color_table($css_file) };
+            my $after = (stat($target))[9];
+            $self->_count($cache, !$table || !$after ? 'failed' : defined $before && $before == $after ? 'current' : 'created');
+        }
+    }
+
+    sub _build_backgrounds {
+        my $self = shift;
+
+        my $cache = $self->_section('backgrounds');
+        my $thumbnails = CinnamonSettings::ThumbnailCache->new(cache_dir => $cache->dir, disk_budget => 0);
+
+        my @images;
+        foreach my $dir (grep { -d } @{$self->background_dirs}) {
+            find({ wanted => sub {
+                push @images, $File::Find::name if /\.(jpg|jpeg|png|bmp|gif|webp|tiff|tif)$/i && -f $_;
+            } }, $dir);
+        }
+        print "  Wallpapers: " . @images . " images\n";
+
+        foreach my $image (sort @images) {
+            foreach my $size (@{$self->background_sizes}) {
+                my $target = $thumbnails->path_for($image, $size, $size) or next;
+                $self->_produce($cache, $target, sub {
+                    CinnamonSettings::ThumbnailCache->scale_file($image, $target, $size, $size);
+                });
+            }
+        }
+    }
+
+    # Delete entries no source maps to any more (changed or removed themes)
+    sub _prune {
+        my $self = shift;
+
+        foreach my $section (keys %{$self->wanted}) {
+            my $dir = $self->root . "/$section";
+            opendir(my $dh, $dir) or next;
+            foreach my $name (grep { !/^\./ } readdir($dh)) {
+                next if $self->wanted->{$section}{$name};
+                unlink("$dir/$name") and $self->stats->{$section}{removed}++;
+            }
+            closedir($dh);
+        }
+    }
+
+    sub _section {
+        my ($self, $section) = @_;
+
+        my $cache = CinnamonSettings::SystemCache->new(section => $section, root => $self->root);
+        make_path($cache->dir);
+        $self->wanted->{$section} ||= {};
+        $self->stats->{$section} ||= {};
+        return $cache;
+    }
+
+    # Run $generate unless the entry already exists
+    sub _produce {
+        my ($self, $cache, $target, $generate) = @_;
+
+        $self->wanted->{$cache->section}{basename($target)} = 1;
+        return $self->_count($cache, 'current') if -s $target;
+
+        my $ok = eval { $generate->() };
+        unlink("$target.part") unless $ok;
+        $self->_count($cache, $ok ? 'created' : 'failed');
+    }
+
+    sub _count {
+        my ($self, $cache, $what) = @_;
+        $self->stats->{$cache->section}{$what}++;
+    }
+
+    sub _theme_dirs {
+        my ($self, $bases) = @_;
+
+        my @dirs;
+        foreach my $base (grep { -d } @$bases) {
+            opendir(my $dh, $base) or next;
+            push @dirs, map { "$base/$_" } sort grep { !/^\./ && -d "$base/$_" } readdir($dh);
+            closedir($dh);
+        }
+        return @dirs;
+    }
+
+    sub _write_file {
+        my ($target, $data) = @_;
+
+        open my $fh, '>:raw', "$target.part" or return 0;
+        print $fh $data;
+        close $fh or return 0;
+        return rename("$target.part", $target);
+    }
+
+    sub _size_list {
+        my $list = shift;
+        return [grep { $_ > 0 } map { int } split /,/, $list];
+    }
+
+    sub _find_extractor {
+        foreach my $candidate ("$FindBin::RealBin/xcursor_extractor", "$ENV{HOME}/.local/bin/xcursor_extractor") {
+            return $candidate if -x $candidate;
+        }
+        return system('which xcursor_extractor >/dev/null 2>&1') == 0 ? 'xcursor_extractor' : undef;
+    }
+}
+
+# Main execution
+if (!caller) {
+    exit SystemCacheBuilder->new()->run(@ARGV);
+}
+
+1;
@@ -7,12 +7,16 @@ use utf8;
 # A modern settings application for Linux Mint Cinnamon
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use JSON qw(encode_json decode_json);
 use Data::Dumper;
 use Digest::MD5 qw(md5_hex);
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -23,6 +27,7 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CinnamonSettingsManager;
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_milestone);
 
     has 'window' => (is => 'rw');
     has 'sidebar' => (is => 'rw');
@@ -35,6 +40,16 @@ package CinnamonSettingsManager;
     has 'current_category' => (is => 'rw');
     has 'settings_widgets' => (is => 'rw', default => sub { {} });
     has 'row_to_category' => (is => 'rw', default => sub { {} });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-settings-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-settings-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'category_token' => (is => 'rw');
 
     sub BUILD {
         my $self = shift;
@@ -49,7 +64,9 @@ package CinnamonSettingsManager;
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
         Gtk3::main();
     }
 
@@ -357,7 +374,10 @@ package CinnamonSettingsManager;
             }
         });
 
-        $window->signal_connect('destroy' => sub { Gtk3::main_quit() });
+        $window->signal_connect('destroy' => sub {
+            $self->stall_detector->report();
+            Gtk3::main_quit();
+        });
         
         # Store references
         $self->window($window);
@@ -512,6 +532,10 @@ package CinnamonSettingsManager;
         
         $self->current_category($category);
         
+        # Module rows still queued for the previous category are not needed
+        $self->scheduler->cancel($self->category_token);
+        $self->category_token($self->scheduler->new_token());
+        
         # Clear content area
         my $content_area = $self->content_area;
         foreach my $child ($content_area->get_children()) {
@@ -577,10 +601,19 @@ package CinnamonSettingsManager;
         
         my $modules_box = Gtk3::Box->new('vertical', 6);
         
-        foreach my $module (@$modules) {
-            my $module_widget = $self->_create_module_widget($module);
-            $modules_box->pack_start($module_widget, 0, 0, 0);
-        }
+        # Custom module icons are SVG files, so rows are added through the
+        # scheduler and the header shows before they are all decoded
+        $self->scheduler->foreach_item(
+            label => 'settings: create module rows',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $self->category_token,
+            items => $modules,
+            each => sub {
+                my $module_widget = $self->_create_module_widget(shift);
+                $modules_box->pack_start($module_widget, 0, 0, 0);
+                $module_widget->show_all();
+            },
+        );
         
         return $modules_box;
     }
@@ -859,30 +892,47 @@ package CinnamonSettingsManager;
         }
     }
 
-    sub _launch_custom_module {
-        my ($self, $module_name) = @_;
+    # ~/.local/bin first, then PATH, then the current directory
+    sub _find_module {
+        my ($class, $module_name) = @_;
 
-        # First try to launch from ~/.local/bin
-        my $home = $ENV{HOME};
-        my $local_path = "$home/.local/bin/$module_name";
+        my $local_path = "$ENV{HOME}/.local/bin/$module_name";
+        return $local_path if -f $local_path && -x $local_path;
+        return $module_name if system("which $module_name >/dev/null 2>&1") == 0;
+        return "./$module_name" if -f "./$module_name" && -x "./$module_name";
+        return undef;
+    }
 
-        if (-f $local_path && -x $local_path) {
-            print "Launching custom module from ~/.local/bin: $module_name\n";
-            system("$local_path &");
-            return;
-        }
+    # --prewarm for every manager with disk caches, one after the other;
+    # each one already spreads its own work over all cores
+    sub prewarm_modules {
+        my ($class, @dirs) = @_;
 
-        # Try to find it in PATH
-        if (system("which $module_name >/dev/null 2>&1") == 0) {
-            print "Launching custom module from PATH: $module_name\n";
-            system("$module_name &");
-            return;
+        my $status = 0;
+        foreach my $module_name (qw(
+            cinnamon-themes-manager.pl
+            cinnamon-application-themes-manager.pl
+            cinnamon-icon-themes-manager.pl
+            cinnamon-cursor-themes-manager.pl
+            cinnamon-backgrounds-manager.pl
+        )) {
+            my $module_path = $class->_find_module($module_name);
+            unless ($module_path) {
+                print "Skipping $module_name: not installed\n";
+                next;
+            }
+            system($module_path, '--prewarm', @dirs) == 0 or $status = 1;
         }
 
-        # Try current directory as fallback
-        if (-f "./$module_name" && -x "./$module_name") {
-            print "Launching custom module from current directory: $module_name\n";
-            system("./$module_name &");
+        return $status;
+    }
+
+    sub _launch_custom_module {
+        my ($self, $module_name) = @_;
+
+        if (my $module_path = $self->_find_module($module_name)) {
+            print "Launching custom module: $module_path\n";
+            system("$module_path &");
             return;
         }
 
@@ -1138,6 +1188,12 @@ package CinnamonSettingsManager;
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit CinnamonSettingsManager->prewarm_modules(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = CinnamonSettingsManager->new();
     $app->run();
 }
@@ -7,7 +7,7 @@ use utf8;
 # A dedicated Cinnamon theme management application for Linux Mint
 # Written in Perl with GTK3
 
-use Gtk3 -init;
+use Gtk3;
 use Glib 'TRUE', 'FALSE';
 use File::Spec;
 use JSON qw(encode_json decode_json);
@@ -16,6 +16,22 @@ use Digest::MD5 qw(md5_hex);
 use File::Basename;
 use File::HomeDir;
 use Cairo;
+use FindBin;
+use lib "$FindBin::RealBin/lib", "$ENV{HOME}/.local/share/cinnamon-settings-manager/lib";
+use CinnamonSettings::Session;
+use CinnamonSettings::ThumbnailCache;
+use CinnamonSettings::PreviewClient;
+use CinnamonSettings::SystemCache;
+use CinnamonSettings::CinnamonThemeIndex;
+use CinnamonSettings::CinnamonStyle;
+use CinnamonSettings::ConfigStore;
+use CinnamonSettings::Scheduler;
+use CinnamonSettings::StallDetector;
+use CinnamonSettings::BudgetCache;
+use CinnamonSettings::ViewState;
+use CinnamonSettings::Soak;
+use CinnamonSettings::ArchivePreviewDialog;
+use CinnamonSettings::Prewarm;
 
 $SIG{__WARN__} = sub {
     my $warning = shift;
@@ -26,7 +42,10 @@ $SIG{__WARN__} = sub {
 # Main application class
 package CinnamonThemeManager {
     use Moo;
+    use CinnamonSettings::Trace qw(TRACING trace_span trace_milestone);
     use File::HomeDir;
+    use File::Basename qw(basename);
+    use JSON qw(decode_json);
 
     has 'window' => (is => 'rw');
     has 'directory_list' => (is => 'rw');
@@ -35,21 +54,61 @@ package CinnamonThemeManager {
     has 'themes_mode' => (is => 'rw');
     has 'settings_mode' => (is => 'rw');
     has 'zoom_level' => (is => 'rw', default => sub { 400 });
-    has 'directory_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_paths' => (is => 'rw', default => sub { {} });
-    has 'theme_widgets' => (is => 'rw', default => sub { {} });
+    has 'directory_view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'view' => (is => 'rw', default => sub { CinnamonSettings::ViewState->new() });
+    has 'themes_view' => (is => 'rw');
     has 'loading_spinner' => (is => 'rw');
     has 'loading_label' => (is => 'rw');
     has 'loading_box' => (is => 'rw');
     has 'current_directory' => (is => 'rw');
-    has 'cached_theme_lists' => (is => 'rw', default => sub { {} });
+    has 'cached_theme_lists' => (is => 'ro', default => sub {
+        CinnamonSettings::BudgetCache->new(name => 'theme lists', budget_bytes => 16 * 1024 * 1024)
+    });
     has 'config' => (is => 'rw');
+    has 'config_store' => (is => 'ro', lazy => 1, builder => '_build_config_store');
     has 'last_selected_directory_path' => (is => 'rw');
     has 'current_theme' => (is => 'rw');
+    has 'session' => (is => 'ro', default => sub {
+        CinnamonSettings::Session->new(app_name => 'cinnamon-themes-manager')
+    });
+    has 'preview_service' => (is => 'ro', default => sub { CinnamonSettings::PreviewClient->new() });
+    has 'scheduler' => (is => 'ro', default => sub { CinnamonSettings::Scheduler->new() });
+    has 'stall_detector' => (is => 'ro', lazy => 1, default => sub {
+        my $self = shift;
+        CinnamonSettings::StallDetector->new(
+            app_name => 'cinnamon-themes-manager',
+            config_dir => $ENV{HOME} . '/.local/share/cinnamon-theme-manager/config',
+            scheduler => $self->scheduler,
+        )
+    });
+    has 'load_token' => (is => 'rw');
+    has 'zoom_token' => (is => 'rw');
+    has 'thumbnail_cache' => (is => 'ro', default => sub {
+        CinnamonSettings::ThumbnailCache->new(
+            cache_dir => $ENV{HOME} . '/.local/share/cinnamon-theme-manager/previews',
+            shared => CinnamonSettings::SystemCache->new(section => 'cinnamon-themes'),
+        )
+    });
+    has 'theme_index' => (is => 'ro', default => sub {
+        CinnamonSettings::CinnamonThemeIndex->new(
+            index_file => $ENV{HOME} . '/.local/share/cinnamon-theme-manager/theme-index.json'
+        )
+    });
+    has 'cinnamon_style' => (is => 'ro', default => sub { CinnamonSettings::CinnamonStyle->new() });
+    # Headless --prewarm run: configuration only, no windows
+    has 'prewarm' => (is => 'ro', default => sub { 0 });
+
+    # Sidebar row address lookups
+    sub directory_paths { $_[0]->directory_view->paths }
+
+    # Frame address lookups into the current directory's view
+    sub theme_paths { $_[0]->view->paths }
+    sub theme_widgets { $_[0]->view->widgets }
 
     sub BUILD {
         my $self = shift;
         $self->_initialize_configuration();
+        return if $self->prewarm;
         $self->_setup_ui();
         $self->_populate_theme_directories();
         $self->_restore_last_selected_directory();
@@ -151,10 +210,11 @@ package CinnamonThemeManager {
         $control_container->set_margin_top(6);
         $control_container->set_margin_bottom(6);
 
-        my ($add_dir_button, $remove_dir_button) = $self->_create_directory_buttons();
+        my ($add_dir_button, $remove_dir_button, $archive_button) = $self->_create_directory_buttons();
 
         $control_container->pack_start($add_dir_button, 1, 1, 0);
         $control_container->pack_start($remove_dir_button, 1, 1, 0);
+        $control_container->pack_start($archive_button, 1, 1, 0);
 
         $left_container->pack_start($control_container, 0, 0, 0);
 
@@ -204,6 +264,7 @@ package CinnamonThemeManager {
 
         $themes_view->add($themes_grid);
         $content_switcher->add_named($themes_view, 'themes');
+        $self->themes_view($themes_view);
 
         # Settings content
         my $settings_view = Gtk3::ScrolledWindow->new();
@@ -258,13 +319,13 @@ package CinnamonThemeManager {
         $self->loading_box($loading_box);
 
         # Connect signals
-        $self->_connect_signals($add_dir_button, $remove_dir_button, $zoom_in, $zoom_out);
+        $self->_connect_signals($add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out);
 
         print "UI setup completed\n";
     }
 
     sub _connect_signals {
-        my ($self, $add_dir_button, $remove_dir_button, $zoom_in, $zoom_out) = @_;
+        my ($self, $add_dir_button, $remove_dir_button, $archive_button, $zoom_in, $zoom_out) = @_;
 
         # Connect signals for mode buttons
         $self->_connect_mode_button_signals($self->themes_mode, $self->settings_mode, $self->content_switcher);
@@ -277,7 +338,7 @@ package CinnamonThemeManager {
             my $dir_path = $self->directory_paths->{$row + 0};
             if ($dir_path) {
                 $self->config->{last_selected_directory} = $dir_path;
-                $self->_save_config($self->config);
+                $self->config_store->save();
             }
 
             $self->_load_themes_from_directory_async($row);
@@ -291,13 +352,17 @@ package CinnamonThemeManager {
             $self->_remove_theme_directory();
         });
 
+        $archive_button->signal_connect('clicked' => sub {
+            $self->_preview_theme_archive();
+        });
+
         $zoom_in->signal_connect('clicked' => sub {
             my $new_zoom = ($self->zoom_level < 600) ? $self->zoom_level + 50 : 600;
             $self->zoom_level($new_zoom);
             $self->_update_theme_zoom_async();
             # Save zoom level to config
             $self->config->{preview_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $zoom_out->signal_connect('clicked' => sub {
@@ -306,7 +371,7 @@ package CinnamonThemeManager {
             $self->_update_theme_zoom_async();
             # Save zoom level to config
             $self->config->{preview_size} = $self->zoom_level;
-            $self->_save_config($self->config);
+            $self->config_store->save();
         });
 
         $self->themes_grid->signal_connect('child-activated' => sub {
@@ -315,10 +380,15 @@ package CinnamonThemeManager {
         });
 
         $self->window->signal_connect('destroy' => sub {
-            # Save configuration before closing
-            $self->_save_config($self->config);
+            # Write pending configuration changes before closing
+            $self->config_store->flush();
+            $self->config_store->report_stats();
             # Clean up any running background processes
             $self->_cleanup_background_processes();
+            $self->session->report_stats();
+            $self->thumbnail_cache->report_stats();
+            $self->preview_service->report_stats();
+            $self->stall_detector->report();
             Gtk3::main_quit();
         });
 
@@ -456,7 +526,54 @@ package CinnamonThemeManager {
         my $remove_icon = Gtk3::Image->new_from_icon_name('list-remove-symbolic', 1);
         $remove_button->add($remove_icon);
 
-        return ($add_button, $remove_button);
+        my $archive_button = Gtk3::Button->new();
+        $archive_button->set_relief('none');
+        $archive_button->set_size_request(32, 32);
+        $archive_button->set_tooltip_text('Preview and install a Cinnamon theme archive');
+
+        my $archive_icon = Gtk3::Image->new_from_icon_name('package-x-generic-symbolic', 1);
+        $archive_button->add($archive_icon);
+
+        return ($add_button, $remove_button, $archive_button);
+    }
+
+    # Preview a downloaded Cinnamon theme archive from its thumbnail, read
+    # into memory, and install it into ~/.themes once confirmed
+    sub _preview_theme_archive {
+        my $self = shift;
+
+        my $themes_dir = File::HomeDir->my_home . '/.themes';
+
+        CinnamonSettings::ArchivePreviewDialog->new(
+            parent => $self->window,
+            session => $self->session,
+            kind => 'cinnamon',
+            install_dir => $themes_dir,
+            render => sub { $self->_render_archive_theme(@_) },
+            on_installed => sub {
+                $self->cached_theme_lists->remove($themes_dir);
+                my $row = $self->directory_list->get_selected_row();
+                if ($row && ($self->directory_paths->{$row + 0} // '') eq $themes_dir) {
+                    $self->{last_loaded_directory} = undef;
+                    $self->_load_themes_from_directory_async($row);
+                }
+            },
+        )->run();
+    }
+
+    sub _render_archive_theme {
+        my ($self, $archive, $theme) = @_;
+
+        my $data = $archive->theme_member($theme, 'cinnamon/thumbnail.png');
+        return undef unless defined $data;
+
+        my $pixbuf = eval {
+            my $loader = Gtk3::Gdk::PixbufLoader->new();
+            $loader->write($data);
+            $loader->close();
+            $loader->get_pixbuf();
+        };
+        return $pixbuf ? Gtk3::Image->new_from_pixbuf($pixbuf) : undef;
     }
 
     sub _create_zoom_buttons {
@@ -518,36 +635,29 @@ package CinnamonThemeManager {
     sub _populate_theme_directories {
         my $self = shift;
 
-        my $home = File::HomeDir->my_home;
-
-        # Default Cinnamon theme directories
-        my @default_dirs = (
-            { name => 'System Themes', path => '/usr/share/themes' },
-            { name => 'User Themes',   path => "$home/.themes" },
-            { name => 'Local Themes',  path => "$home/.local/share/themes" },
-        );
-
-        # Add default directories
-        foreach my $dir_info (@default_dirs) {
-            next unless -d $dir_info->{path};
-
+        foreach my $dir_info ($self->_theme_directories()) {
             my $row = $self->_create_directory_row($dir_info->{name}, $dir_info->{path});
-            $self->directory_paths->{$row + 0} = $dir_info->{path};
+            $self->directory_view->track($row, $dir_info->{path});
             $self->directory_list->add($row);
         }
 
-        # Add custom directories from config
-        if ($self->config->{custom_directories}) {
-            foreach my $custom_dir (@{$self->config->{custom_directories}}) {
-                next unless -d $custom_dir->{path};
+        print "Populated theme directories\n";
+    }
 
-                my $row = $self->_create_directory_row($custom_dir->{name}, $custom_dir->{path});
-                $self->directory_paths->{$row + 0} = $custom_dir->{path};
-                $self->directory_list->add($row);
-            }
-        }
+    # Default Cinnamon theme directories followed by custom ones from the
+    # config, as far as they exist
+    sub _theme_directories {
+        my $self = shift;
 
-        print "Populated theme directories\n";
+        my $home = File::HomeDir->my_home;
+        my @dirs = (
+            { name => 'System Themes', path => '/usr/share/themes' },
+            { name => 'User Themes',   path => "$home/.themes" },
+            { name => 'Local Themes',  path => "$home/.local/share/themes" },
+            @{$self->config->{custom_directories} || []},
+        );
+
+        return grep { -d $_->{path} } @dirs;
     }
 
     sub _create_directory_row {
@@ -653,26 +763,46 @@ package CinnamonThemeManager {
         my $flowbox = $self->themes_grid;
         foreach my $child ($flowbox->get_children()) {
             $flowbox->remove($child);
+            $child->destroy();
         }
 
         # Clear references
-        $self->theme_paths({});
-        $self->theme_widgets({});
+        $self->view->release();
+        $self->view(CinnamonSettings::ViewState->new(path => $dir_path));
         $self->current_directory($dir_path);
 
+        $self->{load_span} = TRACING && trace_span('load directory', path => $dir_path);
+
+        # Pending widgets and thumbnail jobs belong to the previous directory
+        $self->scheduler->cancel($self->load_token);
+        $self->scheduler->cancel($self->zoom_token);
+        $self->load_token($self->scheduler->new_token());
+        $self->{thumbnail_jobs} = [];
+        $self->{thumbnail_waiters} = {};
+        $self->{synthesis_queue} = [];
+
         # Get or scan themes
-        my $themes_ref;
-        if (exists $self->cached_theme_lists->{$dir_path}) {
-            $themes_ref = $self->cached_theme_lists->{$dir_path};
+        if ($self->cached_theme_lists->contains($dir_path)) {
+            my $themes_ref = $self->cached_theme_lists->get($dir_path);
             print "Using cached theme list for $dir_path (" . @$themes_ref . " themes)\n";
-        } else {
-            my @themes = $self->_scan_cinnamon_themes($dir_path);
-            @themes = sort { lc($a->{name}) cmp lc($b->{name}) } @themes;
-            $themes_ref = \@themes;
-            $self->cached_theme_lists->{$dir_path} = $themes_ref;
-            print "Scanned $dir_path: " . @themes . " Cinnamon themes found\n";
+            $self->_show_theme_list($themes_ref, $dir_path);
+            return;
         }
 
+        $self->_scan_cinnamon_themes($dir_path, sub {
+            my @themes = sort { lc($a->{name}) cmp lc($b->{name}) } @_;
+            $self->cached_theme_lists->set($dir_path, \@themes);
+            print "Scanned $dir_path: " . @themes . " Cinnamon themes found\n";
+
+            # The user may have moved on while helpers were parsing
+            return unless $self->current_directory && $self->current_directory eq $dir_path;
+            $self->_show_theme_list(\@themes, $dir_path);
+        });
+    }
+
+    sub _show_theme_list {
+        my ($self, $themes_ref, $dir_path) = @_;
+
         if (@$themes_ref == 0) {
             $self->_hide_loading_indicator();
             print "No Cinnamon themes found in $dir_path\n";
@@ -684,106 +814,159 @@ package CinnamonThemeManager {
     }
 
     sub _scan_cinnamon_themes {
-        my ($self, $base_dir) = @_;
+        my ($self, $base_dir, $on_done) = @_;
 
-        my @themes = ();
+        my $index = $self->theme_index;
 
-        opendir(my $dh, $base_dir) or return @themes;
-        my @subdirs = grep { -d "$base_dir/$_" && $_ !~ /^\./ } readdir($dh);
-        closedir($dh);
+        # Warm entries cost one stat each; only changed directories are parsed
+        my $scan = $index->scan_directory($base_dir);
+        my @cold = @{$scan->{cold}};
+        print "Theme index for $base_dir: " . @{$scan->{entries}} . " cached, " . @cold . " to parse\n";
 
-        foreach my $subdir (@subdirs) {
-            my $theme_path = "$base_dir/$subdir";
-            my $cinnamon_dir = "$theme_path/cinnamon";
+        my $finish = sub {
+            my @parsed = @_;
 
-            # Check if this directory contains a Cinnamon theme
-            if (-d $cinnamon_dir) {
-                my $cinnamon_css = "$cinnamon_dir/cinnamon.css";
+            $index->update_entries($base_dir, \@parsed);
+            $index->save();
 
-                if (-f $cinnamon_css) {
-                    # Parse theme information
-                    my $theme_info = $self->_parse_cinnamon_theme_info($theme_path, $subdir);
+            # Themes without a screenshot get a synthesized preview
+            my @themes = grep { $_->{is_theme} } (@{$scan->{entries}}, @parsed);
 
-                    # Only include themes that have thumbnails/previews
-                    if ($theme_info->{thumbnail_path}) {
-                        push @themes, $theme_info;
-                        print "DEBUG: Including Cinnamon theme '$subdir' with thumbnail: " . $theme_info->{thumbnail_path} . "\n";
-                    } else {
-                        print "DEBUG: Skipping Cinnamon theme '$subdir' - no thumbnail found\n";
-                    }
-                }
-            }
+            $on_done->(@themes);
+            $self->_schedule_index_revalidation($base_dir, $scan->{entries});
+        };
+
+        # Small batches are not worth a helper process
+        if (@cold < 16) {
+            $finish->(map { $index->parse_theme(@$_) } @cold);
+            return;
         }
 
-        return @themes;
+        # Cold scan: split JSON parsing and stat work across helper processes
+        my $workers = @cold >= 64 ? 4 : 2;
+        my @chunks;
+        push @{$chunks[$_ % $workers]}, $cold[$_] for 0 .. $#cold;
+
+        my @parsed;
+        my $pending = @chunks;
+
+        foreach my $chunk (@chunks) {
+            my $collect = sub {
+                my ($exit_code, $output) = @_;
+
+                my %seen;
+                foreach my $line (split /\n/, $output || '') {
+                    next unless $line =~ /^\{/;
+                    my $entry = eval { decode_json($line) } or next;
+                    $seen{$entry->{name}} = 1;
+                    push @parsed, $entry;
+                }
+
+                # Anything the helper did not report is parsed here instead
+                push @parsed, map { $index->parse_theme(@$_) } grep { !$seen{$_->[1]} } @$chunk;
+
+                $finish->(@parsed) if --$pending == 0;
+            };
+
+            my $pid = $self->session->spawn_perl(
+                label => 'theme index parse',
+                script => $index->parse_script($chunk),
+                timeout => 60,
+                on_exit => $collect,
+            );
+            $collect->(-1, '') unless $pid;
+        }
     }
 
-    sub _parse_cinnamon_theme_info {
-        my ($self, $theme_path, $theme_name) = @_;
+    # Headless --prewarm: bring the theme index up to date and write the
+    # thumbnail or synthesized preview of every theme at the configured size
+    sub prewarm_caches {
+        my ($self, @dirs) = @_;
 
-        my $theme_info = {
-            name          => $theme_name,
-            path          => $theme_path,
-            display_name  => $theme_name,
-            cinnamon_path => "$theme_path/cinnamon",
-        };
+        my $prewarm = CinnamonSettings::Prewarm->new(app_name => 'cinnamon-themes-manager');
+        $prewarm->lower_priority();
+        @dirs = map { $_->{path} } $self->_theme_directories() unless @dirs;
 
-        # Look for thumbnail files in priority order
-        my @thumbnail_candidates = (
-            "$theme_path/cinnamon/thumbnail.png",
-            "$theme_path/thumbnail.png",
-            "$theme_path/cinnamon/preview.png",
-            "$theme_path/preview.png",
-            "$theme_path/cinnamon/screenshot.png",
-            "$theme_path/screenshot.png",
-        );
+        my $index = $self->theme_index;
+        my $width = $self->zoom_level;
+        my $height = int($self->zoom_level * 0.75);
 
-        foreach my $thumbnail_path (@thumbnail_candidates) {
-            if (-f $thumbnail_path && -s $thumbnail_path > 1000) {  # File exists and is not empty
-                $theme_info->{thumbnail_path} = $thumbnail_path;
-                print "Found thumbnail for $theme_name: $thumbnail_path\n";
-                last;
+        foreach my $dir_path (grep { -d } @dirs) {
+            my $scan = $index->scan_directory($dir_path);
+            my @parsed = map { $index->parse_theme(@$_) } @{$scan->{cold}};
+            $index->update_entries($dir_path, \@parsed);
+
+            # What _schedule_index_revalidation would catch up on later
+            my $indexed = @parsed;
+            foreach my $entry (@{$scan->{entries}}) {
+                next if $index->entry_is_current($entry);
+                %$entry = %{$index->parse_theme($entry->{path}, $entry->{name})};
+                $index->dirty(1);
+                $indexed++;
             }
-        }
+            $prewarm->count('indexed', $indexed);
 
-        # Try to read metadata from theme.json
-        my $theme_json = "$theme_path/cinnamon/theme.json";
-        if (-f $theme_json) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $theme_json;
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text) {
-                    my $metadata = JSON->new->decode($json_text);
-                    $theme_info->{display_name} = $metadata->{name} || $theme_name;
-                    $theme_info->{description} = $metadata->{description};
-                    $theme_info->{author} = $metadata->{author};
-                    $theme_info->{version} = $metadata->{version};
-                }
-            };
-            if ($@) {
-                print "Warning: Could not parse theme.json for $theme_name: $@\n";
+            my @themes = grep { $_->{is_theme} } (@{$scan->{entries}}, @parsed);
+            $prewarm->note("$dir_path: " . @themes . " Cinnamon themes, $indexed indexed");
+
+            foreach my $theme_info (@themes) {
+                $prewarm->add($theme_info->{name}, sub { $self->_prewarm_theme_preview($theme_info, $width, $height) });
             }
         }
+        $index->save();
 
-        # Fallback: try to get name from metadata.json
-        my $metadata_json = "$theme_path/metadata.json";
-        if (-f $metadata_json && !$theme_info->{description}) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $metadata_json;
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text) {
-                    my $metadata = JSON->new->decode($json_text);
-                    $theme_info->{display_name} = $metadata->{name} || $theme_info->{display_name};
-                    $theme_info->{description} = $metadata->{description};
-                }
-            };
+        return $prewarm->run();
+    }
+
+    sub _prewarm_theme_preview {
+        my ($self, $theme_info, $width, $height) = @_;
+
+        # Same cache entries _load_theme_thumbnail and _load_synthesized_preview use
+        my $source = $theme_info->{thumbnail_path} || "$theme_info->{cinnamon_path}/cinnamon.css";
+        return 'current' if $self->thumbnail_cache->lookup($source, $width, $height);
+
+        if ($theme_info->{thumbnail_path}) {
+            my $target = $self->thumbnail_cache->path_for($source, $width, $height) or return 'failed';
+            return CinnamonSettings::ThumbnailCache->scale_file($source, $target, $width, $height) ? 'created' : 'failed';
         }
 
-        return $theme_info;
+        my $style = $self->cinnamon_style->style_for($source) or return 'failed';
+        my $surface = $self->cinnamon_style->render_preview($style, $width, $height);
+        return $self->thumbnail_cache->store_surface($source, $width, $height, $surface) ? 'created' : 'failed';
+    }
+
+    sub _schedule_index_revalidation {
+        my ($self, $base_dir, $entries) = @_;
+
+        my @queue = @$entries;
+        return unless @queue;
+
+        my $changed = 0;
+
+        # Check the remaining recorded mtimes once nothing else is queued
+        $self->scheduler->foreach_item(
+            label => 'cinnamon themes: revalidate index',
+            priority => CinnamonSettings::Scheduler::PRIORITY_LOW,
+            items => \@queue,
+            each => sub {
+                my $entry = shift;
+                return if $self->theme_index->entry_is_current($entry);
+
+                print "Theme index: $entry->{name} changed, re-reading metadata\n";
+                my $fresh = $self->theme_index->parse_theme($entry->{path}, $entry->{name});
+                %$entry = %$fresh;
+                $changed = 1;
+            },
+            on_done => sub {
+                return unless $changed;
+
+                $self->theme_index->dirty(1);
+                $self->theme_index->save();
+
+                # Rebuild the list (e.g. a thumbnail went away) on next visit
+                $self->cached_theme_lists->remove($base_dir);
+            },
+        );
     }
 
     sub _start_progressive_loading {
@@ -802,115 +985,62 @@ package CinnamonThemeManager {
             dir_path => $dir_path
         };
 
-        # Phase 1: Quickly create all theme widgets with placeholders
-        $self->_update_loading_progress("Creating theme widgets...", 0);
-
-        my $create_widgets;
-        $create_widgets = sub {
-            return 0 if $self->current_directory ne $dir_path;  # Directory changed
+        $self->_update_loading_progress("Loading themes...", 0);
 
-            my $batch_size = 8;
-            my $batch_end = ($loaded_widgets + $batch_size - 1 < $total_themes - 1)
-                        ? $loaded_widgets + $batch_size - 1
-                        : $total_themes - 1;
-
-            # Create widgets for this batch
-            for my $i ($loaded_widgets..$batch_end) {
-                my $theme_info = $themes_ref->[$i];
+        # Each widget requests its thumbnail as soon as it is created, so
+        # decoding in the worker pool overlaps widget creation
+        $self->scheduler->foreach_item(
+            label => 'cinnamon themes: create theme widgets',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $self->load_token,
+            items => $themes_ref,
+            each => sub {
+                my $theme_info = shift;
 
                 # Create widget with placeholder preview
                 my $theme_widget = $self->_create_theme_widget_with_placeholder($theme_info);
                 $self->themes_grid->add($theme_widget);
-            }
+                $theme_widget->show_all();
 
-            $loaded_widgets = $batch_end + 1;
-            $self->{preview_progress}->{loaded_widgets} = $loaded_widgets;
+                $self->_load_theme_thumbnail($theme_info, $theme_widget);
 
-            # Update progress
-            my $widget_progress = int(($loaded_widgets / $total_themes) * 30);  # 30% for widget creation
-            $self->_update_loading_progress("Creating theme widgets...", $widget_progress);
-
-            $self->themes_grid->show_all();
-
-            if ($loaded_widgets < $total_themes) {
-                # Continue with next batch
-                Glib::Timeout->add(10, $create_widgets);
-                return 0;
-            } else {
-                # Widget creation complete, start thumbnail loading
-                print "All widgets created, starting thumbnail loading\n";
-                $self->_start_thumbnail_loading($themes_ref);
-                return 0;
-            }
-        };
-
-        # Start widget creation
-        Glib::Timeout->add(10, $create_widgets);
+                $loaded_widgets++;
+                $self->{preview_progress}->{loaded_widgets} = $loaded_widgets;
+                $self->_update_thumbnail_progress();
+            },
+            on_done => sub {
+                print "All widgets created\n";
+            },
+        );
     }
 
-    sub _start_thumbnail_loading {
-        my ($self, $themes_ref) = @_;
-
-        my $progress = $self->{preview_progress};
-        return unless $progress;
-
-        print "Starting sequential thumbnail loading\n";
-
-        my $current_index = 0;
-        my $total_themes = @$themes_ref;
-
-        my $load_next;
-        $load_next = sub {
-            return 0 if $self->current_directory ne $progress->{dir_path};
-
-            if ($current_index >= $total_themes) {
-                print "All thumbnail loading completed!\n";
-                $self->_hide_loading_indicator();
-                delete $self->{preview_progress};
-                return 0;  # Stop loading
-            }
-
-            my $theme_info = $themes_ref->[$current_index];
-            print "Loading thumbnail for: " . $theme_info->{name} . " ($current_index/$total_themes)\n";
-
-            # Find the corresponding widget
-            my $widget = $self->_find_theme_widget($theme_info->{name});
-            if ($widget) {
-                $self->_load_theme_thumbnail($theme_info, $widget);
-            }
-
-            $current_index++;
-
-            # Update progress
-            my $thumbnail_progress = 30 + int(($current_index / $total_themes) * 70);
-            $self->_update_loading_progress(
-                "Loading thumbnails... ($current_index/$total_themes)",
-                $thumbnail_progress
-            );
-
-            # Schedule next thumbnail loading
-            Glib::Timeout->add(50, $load_next);
-            return 0;
-        };
+    sub _note_thumbnail_settled {
+        my $self = shift;
 
-        # Start first thumbnail loading
-        Glib::Timeout->add(50, $load_next);
+        # Counts loaded and failed thumbnails alike so progress can finish
+        return unless $self->{preview_progress};
+        $self->{preview_progress}{completed_previews}++;
+        $self->_update_thumbnail_progress();
     }
 
-    sub _find_theme_widget {
-        my ($self, $theme_name) = @_;
+    sub _update_thumbnail_progress {
+        my $self = shift;
 
-        my $flowbox = $self->themes_grid;
-        foreach my $child ($flowbox->get_children()) {
-            my $frame = $child->get_child();  # FlowBoxChild -> Frame
-            my $theme_info = $self->theme_paths->{$frame + 0};
+        my $progress = $self->{preview_progress} or return;
+        my $total = $progress->{total} || 1;
+        my $done = $progress->{completed_previews};
+        $done = $total if $done > $total;
 
-            if ($theme_info && $theme_info->{name} eq $theme_name) {
-                return $frame;
-            }
+        if ($progress->{loaded_widgets} >= $progress->{total} && $done >= $total) {
+            print "All thumbnail loading completed!\n";
+            delete $self->{load_span};
+            $self->_hide_loading_indicator();
+            delete $self->{preview_progress};
+            return;
         }
 
-        return undef;
+        my $percentage = int((($progress->{loaded_widgets} + $done) / (2 * $total)) * 100);
+        $self->_update_loading_progress("Loading thumbnails... ($done/$total)", $percentage);
     }
 
     sub _create_theme_widget_with_placeholder {
@@ -945,8 +1075,7 @@ package CinnamonThemeManager {
         $frame->add($box);
 
         # Store references
-        $self->theme_paths->{$frame + 0} = $theme_info;
-        $self->theme_widgets->{$frame + 0} = $placeholder;
+        $self->view->track($frame, $theme_info, $placeholder);
 
         return $frame;
     }
@@ -1028,49 +1157,278 @@ package CinnamonThemeManager {
     sub _load_theme_thumbnail {
         my ($self, $theme_info, $widget_container) = @_;
 
-        # Since we filtered themes, all themes should have thumbnails
         my $thumbnail_path = $theme_info->{thumbnail_path};
+        return $self->_load_synthesized_preview($theme_info, $widget_container) unless $thumbnail_path;
 
         # Double-check thumbnail file exists and is not empty
         unless (-f $thumbnail_path && -s $thumbnail_path > 1000) {
             print "ERROR: Thumbnail file is missing or corrupted for " . $theme_info->{name} . "\n";
+            $self->_note_thumbnail_settled();
             return 0;
         }
 
-        print "Loading thumbnail from: $thumbnail_path\n";
+        my $target_width = $self->zoom_level;
+        my $target_height = int($self->zoom_level * 0.75);
+
+        # Only small pre-scaled copies are decoded on the main thread
+        my $cached_path = $self->thumbnail_cache->lookup($thumbnail_path, $target_width, $target_height);
+        if ($cached_path) {
+            return $self->_apply_cached_thumbnail($theme_info, $widget_container, $cached_path);
+        }
+
+        $self->_queue_thumbnail_job($theme_info, $widget_container, $target_width, $target_height);
+        return 0;
+    }
+
+    sub _load_synthesized_preview {
+        my ($self, $theme_info, $widget_container) = @_;
+
+        my $css_file = "$theme_info->{cinnamon_path}/cinnamon.css";
+        my $width = $self->zoom_level;
+        my $height = int($self->zoom_level * 0.75);
+
+        # Cached like real thumbnails, keyed by the stylesheet instead
+        my $cached_path = $self->thumbnail_cache->lookup($css_file, $width, $height);
+        if ($cached_path) {
+            return $self->_apply_cached_thumbnail($theme_info, $widget_container, $cached_path);
+        }
+
+        # Rendering takes a few milliseconds, so do one per scheduler step
+        push @{$self->{synthesis_queue} ||= []}, [$theme_info, $widget_container, $css_file];
+        $self->{synthesis_task} ||= $self->scheduler->add_task(
+            label => 'cinnamon themes: synthesize previews',
+            step => sub {
+                my $job = shift @{$self->{synthesis_queue}} or return 0;
+                $self->_render_synthesized_preview(@$job);
+                return scalar @{$self->{synthesis_queue}};
+            },
+            on_done => sub { delete $self->{synthesis_task} },
+        );
+
+        return 0;
+    }
+
+    sub _render_synthesized_preview {
+        my ($self, $theme_info, $widget_container, $css_file) = @_;
+
+        my $span = TRACING && trace_span('synthesize preview', theme => $theme_info->{name});
+
+        # Skip widgets from a directory that is no longer shown
+        my $current = $self->theme_paths->{$widget_container + 0};
+        return unless $current && $current == $theme_info;
+
+        my $width = $self->zoom_level;
+        my $height = int($self->zoom_level * 0.75);
+
+        my $cached_path = eval {
+            my $style = $self->cinnamon_style->style_for($css_file) or die "Cannot read $css_file\n";
+            my $surface = $self->cinnamon_style->render_preview($style, $width, $height);
+            $self->thumbnail_cache->store_surface($css_file, $width, $height, $surface);
+        };
+
+        if ($@ || !$cached_path) {
+            print "ERROR: Could not synthesize a preview for " . $theme_info->{name} . ": $@\n";
+            $self->_note_thumbnail_settled();
+            return;
+        }
+
+        print "Synthesized preview for $theme_info->{name} from cinnamon.css\n";
+        $self->session->note_file_created();
+        $self->_apply_cached_thumbnail($theme_info, $widget_container, $cached_path);
+    }
+
+    sub _apply_cached_thumbnail {
+        my ($self, $theme_info, $widget_container, $cached_path) = @_;
 
-        # Load and scale the thumbnail
         my $thumbnail_image = eval {
-            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($thumbnail_path);
+            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file($cached_path);
+            $pixbuf ? Gtk3::Image->new_from_pixbuf($pixbuf) : undef;
+        };
 
-            if ($pixbuf) {
-                # Scale to fit the current zoom level while maintaining aspect ratio
-                my $orig_width = $pixbuf->get_width();
-                my $orig_height = $pixbuf->get_height();
-                my $target_width = $self->zoom_level;
-                my $target_height = int($self->zoom_level * 0.75);
+        if ($@ || !$thumbnail_image) {
+            print "ERROR: Failed to load cached thumbnail for " . $theme_info->{name} . ": $@\n";
+            unlink $cached_path;
+            return $self->_load_thumbnail_direct($theme_info, $widget_container);
+        }
 
-                # Calculate scaling to fit within target dimensions
-                my $scale_x = $target_width / $orig_width;
-                my $scale_y = $target_height / $orig_height;
-                my $scale = ($scale_x < $scale_y) ? $scale_x : $scale_y;
+        # Update the widget with the thumbnail
+        $self->_update_widget_preview($widget_container, $thumbnail_image);
+        return 1;
+    }
 
-                my $new_width = int($orig_width * $scale);
-                my $new_height = int($orig_height * $scale);
+    sub _queue_thumbnail_job {
+        my ($self, $theme_info, $widget_container, $width, $height) = @_;
 
-                my $scaled_pixbuf = $pixbuf->scale_simple($new_width, $new_height, 'bilinear');
+        my $target = $self->thumbnail_cache->path_for($theme_info->{thumbnail_path}, $width, $height);
+        my $job = {
+            source => $theme_info->{thumbnail_path},
+            target => $target,
+            width => $width,
+            height => $height,
+        };
 
-                return Gtk3::Image->new_from_pixbuf($scaled_pixbuf);
+        my $line = $target ? $self->thumbnail_cache->job_line($job) : undef;
+        unless (defined $line) {
+            return $self->_load_thumbnail_direct($theme_info, $widget_container);
+        }
+        $job->{line} = $line;
+
+        $self->{thumbnail_jobs} ||= [];
+        $self->{thumbnail_waiters} ||= {};
+
+        # Several widgets may wait on the same cache file
+        my $queued = $self->{thumbnail_waiters}{$target};
+        push @{$self->{thumbnail_waiters}{$target}}, [$theme_info, $widget_container];
+        return if $queued;
+
+        # The session's preview daemon writes the same cache file using the
+        # worker pool it shares with the other managers
+        my $id = $self->preview_service->request(
+            kind => 'thumbnail',
+            source => $job->{source},
+            width => $width,
+            height => $height,
+            priority => CinnamonSettings::ViewState->frame_visible($widget_container, $self->themes_view)
+                ? CinnamonSettings::Scheduler::PRIORITY_HIGH : CinnamonSettings::Scheduler::PRIORITY_NORMAL,
+            cache_dir => $self->thumbnail_cache->cache_dir,
+            section => 'cinnamon-themes',
+            on_done => sub { $self->_finish_thumbnail_job($target, defined shift) },
+        );
+        return if defined $id;
+
+        push @{$self->{thumbnail_jobs}}, $job;
+        $self->_dispatch_thumbnail_jobs();
+    }
+
+    sub _dispatch_thumbnail_jobs {
+        my $self = shift;
+
+        my $pool = $self->{thumbnail_workers} ||= [];
+        my $max_workers = 3;
+
+        while (@{$self->{thumbnail_jobs} || []}) {
+            my ($slot) = grep { !$_->{busy} } @$pool;
+
+            if (!$slot && @$pool < $max_workers) {
+                $slot = $self->_start_thumbnail_worker() or last;
+            }
+            last unless $slot;
+
+            my $job = $self->_take_thumbnail_job() or last;
+            $slot->{busy} = $job->{target};
+            $slot->{span} = TRACING && trace_span('thumbnail job', target => $job->{target});
+            $self->session->send_line($slot->{worker}, $job->{line});
+        }
+
+        $self->_schedule_thumbnail_worker_reap() unless @{$self->{thumbnail_jobs} || []};
+    }
+
+    sub _take_thumbnail_job {
+        my $self = shift;
+
+        my $jobs = $self->{thumbnail_jobs};
+
+        # Cards in the viewport first, then the rest in grid order
+        for my $i (0 .. $#$jobs) {
+            my $waiters = $self->{thumbnail_waiters}{$jobs->[$i]{target}} || [];
+            if (grep { CinnamonSettings::ViewState->frame_visible($_->[1], $self->themes_view) } @$waiters) {
+                return splice(@$jobs, $i, 1);
             }
-            return undef;
+        }
+
+        return shift @$jobs;
+    }
+
+    sub _start_thumbnail_worker {
+        my $self = shift;
+
+        my $slot = { busy => undef };
+        $slot->{worker} = $self->session->start_worker(
+            script => $self->thumbnail_cache->worker_script(),
+            on_line => sub {
+                my ($status, $target) = split /\t/, shift, 2;
+                return unless $status && $target;
+
+                $slot->{busy} = undef;
+                delete $slot->{span};
+                $self->_finish_thumbnail_job($target, $status eq 'done');
+                $self->_dispatch_thumbnail_jobs();
+            },
+            on_exit => sub {
+                $self->{thumbnail_workers} = [grep { $_ != $slot } @{$self->{thumbnail_workers} || []}];
+
+                # A worker that died mid-job leaves that card to a direct load
+                if (my $target = $slot->{busy}) {
+                    $slot->{busy} = undef;
+                    $self->_finish_thumbnail_job($target, 0);
+                }
+                $self->_dispatch_thumbnail_jobs();
+            },
+        ) or return undef;
+
+        push @{$self->{thumbnail_workers}}, $slot;
+        print "Started thumbnail worker " . scalar(@{$self->{thumbnail_workers}}) . "\n";
+        return $slot;
+    }
+
+    sub _schedule_thumbnail_worker_reap {
+        my $self = shift;
+
+        return if $self->{thumbnail_reap};
+
+        # Keep workers warm briefly for scrolling and zoom changes
+        $self->{thumbnail_reap} = Glib::Timeout->add(3000, sub {
+            delete $self->{thumbnail_reap};
+            return 0 if @{$self->{thumbnail_jobs} || []};
+
+            foreach my $slot (@{$self->{thumbnail_workers} || []}) {
+                $self->session->stop_worker($slot->{worker}) unless $slot->{busy};
+            }
+            return 0;
+        });
+    }
+
+    sub _finish_thumbnail_job {
+        my ($self, $target, $success) = @_;
+
+        my $waiters = delete $self->{thumbnail_waiters}{$target} or return;
+        if ($success) {
+            $self->thumbnail_cache->adopt($target);
+            $self->session->note_file_created();
+        }
+
+        foreach my $waiter (@$waiters) {
+            my ($theme_info, $widget_container) = @$waiter;
+
+            # Skip widgets from a directory that is no longer shown
+            my $current = $self->theme_paths->{$widget_container + 0};
+            next unless $current && $current == $theme_info;
+
+            if ($success && -s $target) {
+                $self->_apply_cached_thumbnail($theme_info, $widget_container, $target);
+            } else {
+                $self->_load_thumbnail_direct($theme_info, $widget_container);
+            }
+        }
+    }
+
+    sub _load_thumbnail_direct {
+        my ($self, $theme_info, $widget_container) = @_;
+
+        # Last resort when the helper could not produce a cached copy
+        my $thumbnail_image = eval {
+            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale(
+                $theme_info->{thumbnail_path}, $self->zoom_level, int($self->zoom_level * 0.75), 1
+            );
+            $pixbuf ? Gtk3::Image->new_from_pixbuf($pixbuf) : undef;
         };
 
         if ($@ || !$thumbnail_image) {
             print "ERROR: Failed to load thumbnail for " . $theme_info->{name} . ": $@\n";
+            $self->_note_thumbnail_settled();
             return 0;
         }
 
-        # Update the widget with the thumbnail
         $self->_update_widget_preview($widget_container, $thumbnail_image);
         return 1;
     }
@@ -1100,7 +1458,9 @@ package CinnamonThemeManager {
         $box->show_all();
 
         # Update reference
-        $self->theme_widgets->{$widget_container + 0} = $new_preview;
+        $self->view->set_widget($widget_container, $new_preview);
+
+        $self->_note_thumbnail_settled();
 
         print "Updated theme preview with thumbnail\n";
     }
@@ -1140,23 +1500,24 @@ package CinnamonThemeManager {
         $self->loading_spinner->start();
         $self->loading_label->set_text('Updating zoom level...');
 
-        # Get all children and process in batches
+        # A newer zoom request supersedes whatever is still queued
+        $self->scheduler->cancel($self->zoom_token);
+        my $token = $self->scheduler->new_token();
+        $self->zoom_token($token);
+
         my @children = $flowbox->get_children();
         my $total_children = @children;
         my $processed = 0;
-        my $batch_size = 6;
 
         return unless $total_children > 0;
 
-        my $process_batch;
-        $process_batch = sub {
-            my $batch_start = $processed;
-            my $batch_end = ($processed + $batch_size - 1 < $total_children - 1)
-                        ? $processed + $batch_size - 1
-                        : $total_children - 1;
-
-            for my $i ($batch_start..$batch_end) {
-                my $child = $children[$i];
+        $self->scheduler->foreach_item(
+            label => 'cinnamon themes: update zoom',
+            priority => CinnamonSettings::Scheduler::PRIORITY_HIGH,
+            token => $token,
+            items => \@children,
+            each => sub {
+                my $child = shift;
                 my $frame = $child->get_child();  # FlowBoxChild -> Frame
 
                 my $image_widget = $self->theme_widgets->{$frame + 0};
@@ -1166,34 +1527,23 @@ package CinnamonThemeManager {
                     # Update image size request immediately for responsive UI
                     $image_widget->set_size_request($size, int($size * 0.75));
 
-                    # Reload thumbnail with new size if available
-                    if ($theme_info->{thumbnail_path}) {
-                        $self->_load_theme_thumbnail($theme_info, $frame);
-                    }
+                    # Reload thumbnail (or synthesized preview) at the new size
+                    $self->_load_theme_thumbnail($theme_info, $frame);
                 }
-            }
-
-            $processed = $batch_end + 1;
 
-            # Update progress
-            my $progress = int(($processed / $total_children) * 100);
-            $self->loading_label->set_text("Updating zoom... ${progress}%");
+                $processed++;
 
-            if ($processed < $total_children) {
-                # Schedule next batch
-                Glib::Timeout->add(50, $process_batch);
-                return 0;
-            } else {
+                # Update progress
+                my $progress = int(($processed / $total_children) * 100);
+                $self->loading_label->set_text("Updating zoom... ${progress}%");
+            },
+            on_done => sub {
                 # Zoom update complete
                 $self->loading_spinner->stop();
                 $self->loading_box->hide();
                 print "Zoom update completed for $total_children theme previews\n";
-                return 0;
-            }
-        };
-
-        # Start processing first batch
-        Glib::Timeout->add(10, $process_batch);
+            },
+        );
     }
 
     sub _regenerate_all_previews {
@@ -1212,7 +1562,10 @@ package CinnamonThemeManager {
         my $self = shift;
 
         # Clear cached theme lists to free memory
-        $self->cached_theme_lists({});
+        $self->cached_theme_lists->clear();
+
+        # Stop the thumbnail helper if it is still scaling
+        $self->session->terminate_children();
 
         print "Background processes cleaned up\n";
     }
@@ -1245,7 +1598,7 @@ package CinnamonThemeManager {
 
             if (!$already_exists) {
                 my $row = $self->_create_directory_row($name, $folder);
-                $self->directory_paths->{$row + 0} = $folder;
+                $self->directory_view->track($row, $folder);
                 $self->directory_list->add($row);
                 $self->directory_list->show_all();
 
@@ -1257,7 +1610,7 @@ package CinnamonThemeManager {
                     name => $name,
                     path => $folder
                 };
-                $self->_save_config($self->config);
+                $self->config_store->save();
 
                 print "Added custom directory: $name ($folder)\n";
 
@@ -1307,11 +1660,11 @@ package CinnamonThemeManager {
                 $self->config->{last_selected_directory} = undef;
             }
 
-            $self->_save_config($self->config);
+            $self->config_store->save();
         }
 
         # Remove the directory
-        delete $self->directory_paths->{$selected_row + 0};
+        $self->directory_view->forget($selected_row + 0);
         $self->directory_list->remove($selected_row);
 
         # Select the first directory after removal
@@ -1363,7 +1716,7 @@ package CinnamonThemeManager {
             path => $theme_info->{path},
             timestamp => time()
         };
-        $self->_save_config($self->config);
+        $self->config_store->save();
     }
 
     sub _detect_current_theme {
@@ -1395,94 +1748,64 @@ package CinnamonThemeManager {
         return $ENV{HOME} . '/.local/share/cinnamon-theme-manager/config/settings.json';
     }
 
-    sub _load_config {
+    sub _build_config_store {
         my $self = shift;
 
-        my $config_file = $self->_get_config_file_path();
-        my $config = {
-            preview_size => 400,
-            custom_directories => [],
-            last_selected_directory => undef,
-        };
-
-        if (-f $config_file) {
-            eval {
-                open my $fh, '<:encoding(UTF-8)', $config_file or die "Cannot open config file: $!";
-                my $json_text = do { local $/; <$fh> };
-                close $fh;
-
-                if ($json_text && length($json_text) > 0) {
-                    my $loaded_config = JSON->new->decode($json_text);
-                    # Merge loaded config with defaults
-                    foreach my $key (keys %$loaded_config) {
-                        $config->{$key} = $loaded_config->{$key};
-                    }
-
-                    # Validate preview_size range
-                    if ($config->{preview_size} < 200 || $config->{preview_size} > 600) {
-                        print "Invalid preview size in config, using default\n";
-                        $config->{preview_size} = 400;
-                    }
-
-                    # Ensure custom_directories is an array ref
-                    if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
-                        $config->{custom_directories} = [];
-                    }
-
-                } else {
-                    print "Config file is empty, using defaults\n";
-                }
-            };
-            if ($@) {
-                print "Error loading config: $@\n";
-                print "Using default configuration\n";
-            }
-        } else {
-            print "Config file not found, using defaults\n";
-        }
+        return CinnamonSettings::ConfigStore->new(
+            file => $self->_get_config_file_path(),
+            defaults => {
+                preview_size => 400,
+                custom_directories => [],
+                last_selected_directory => undef,
+            },
+            validate => sub { $self->_validate_config(shift) },
+            on_change => sub { $self->_on_config_changed(shift) },
+        );
+    }
 
-        return $config;
+    sub _load_config {
+        my $self = shift;
+        return $self->config_store->load();
     }
 
-    sub _save_config {
+    sub _validate_config {
         my ($self, $config) = @_;
 
-        my $config_file = $self->_get_config_file_path();
-        my $temp_file = "$config_file.tmp";
-
-        eval {
-            # Ensure config directory exists
-            my $config_dir = $config_file;
-            $config_dir =~ s/\/[^\/]+$//;
-            unless (-d $config_dir) {
-                system("mkdir -p '$config_dir'");
-            }
+        # Validate preview_size range
+        if (!$config->{preview_size} || $config->{preview_size} < 200 || $config->{preview_size} > 600) {
+            print "Invalid preview size in config, using default\n";
+            $config->{preview_size} = 400;
+        }
 
-            # Write to temporary file first (atomic operation)
-            open my $fh, '>:encoding(UTF-8)', $temp_file or die "Cannot write temp config file: $!";
-            print $fh JSON->new->pretty->encode($config);
-            close $fh;
+        # Ensure custom_directories is an array ref
+        if (!ref($config->{custom_directories}) || ref($config->{custom_directories}) ne 'ARRAY') {
+            $config->{custom_directories} = [];
+        }
+    }
 
-            # Verify the temp file was written and has content
-            unless (-f $temp_file && -s $temp_file) {
-                die "Temporary config file was not created or is empty";
-            }
+    # Another running instance saved its settings
+    sub _on_config_changed {
+        my ($self, $keys) = @_;
 
-            # Move temporary file to final location
-            rename($temp_file, $config_file) or die "Cannot move temp file to final location: $!";
+        return unless $self->themes_grid;
 
-            print "Successfully saved configuration\n";
-        };
-        if ($@) {
-            print "ERROR: Failed to save config: $@\n";
-            # Clean up temp file if it exists
-            unlink($temp_file) if -f $temp_file;
+        if (grep { $_ eq 'preview_size' } @$keys) {
+            $self->zoom_level($self->config->{preview_size});
+            $self->_update_theme_zoom_async();
         }
     }
 
     sub run {
         my $self = shift;
+        $self->window->signal_connect(draw => sub { trace_milestone('window drawn'); return 0 }) if TRACING;
         $self->window->show_all();
+        $self->stall_detector->start();
+        CinnamonSettings::Soak->new(
+            app_name => 'cinnamon-themes-manager',
+            window => $self->window,
+            list => $self->directory_list,
+            scheduler => $self->scheduler,
+        )->start() if $ENV{CSM_SOAK_SWITCHES};
         print "Cinnamon Theme Manager started\n";
         Gtk3::main();
     }
@@ -1490,6 +1813,12 @@ package CinnamonThemeManager {
 
 # Main execution
 if (!caller) {
+    if (@ARGV && $ARGV[0] eq '--prewarm') {
+        shift @ARGV;
+        exit CinnamonThemeManager->new(prewarm => 1)->prewarm_caches(@ARGV);
+    }
+
+    Gtk3::init();
     my $app = CinnamonThemeManager->new();
     $app->run();
 }
@@ -105,6 +105,14 @@ check_system() {
         echo "  CPAN: cpan Moo"
     }
 
+    perl -e "use Glib::IO;" 2>/dev/null || {
+        print_warning "Glib::IO Perl module not found. Install with:"
+        echo "  Ubuntu/Debian: sudo apt install libglib-io-perl"
+        echo "  Fedora: sudo dnf install perl-Glib-IO"
+        echo "  Arch: Available in AUR: perl-glib-io"
+        echo "  CPAN: cpan Glib::IO"
+    }
+
     print_success "System compatibility check completed"
 }
 
@@ -125,7 +133,7 @@ compile_xcursor_extractor() {
     print_info "Using LIBS: $LIBS"
 
     # Compile with optimization and warnings
-    gcc -O2 -Wall -Wextra $CFLAGS -o xcursor_extractor xcursor_extractor.c $LIBS
+    gcc -O2 -Wall -Wextra $CFLAGS -o xcursor_extractor xcursor_extractor.c xcursor_common.c $LIBS
 
     if [ $? -eq 0 ]; then
         print_success "xcursor_extractor compiled successfully"
@@ -133,6 +141,15 @@ compile_xcursor_extractor() {
         print_error "Failed to compile xcursor_extractor"
         exit 1
     fi
+
+    # The theme compiler is optional; the managers work without it
+    gcc -O2 -Wall -Wextra -pthread $(pkg-config --cflags libpng) -o xcursor_compiler xcursor_compiler.c $(pkg-config --libs libpng)
+
+    if [ $? -eq 0 ]; then
+        print_success "xcursor_compiler compiled successfully"
+    else
+        print_warning "Failed to compile xcursor_compiler, building cursor themes will be unavailable"
+    fi
 }
 
 # Create directory structure
@@ -191,6 +208,12 @@ install_files() {
         exit 1
     fi
 
+    if [ -f "xcursor_compiler" ]; then
+        cp xcursor_compiler "$INSTALL_DIR/"
+        chmod +x "$INSTALL_DIR/xcursor_compiler"
+        print_success "xcursor_compiler installed to $INSTALL_DIR/"
+    fi
+
     # Install main application
     if [ -f "cinnamon-settings-manager.pl" ]; then
         cp cinnamon-settings-manager.pl "$INSTALL_DIR/"
@@ -206,6 +229,7 @@ install_files() {
         "cinnamon-cursor-themes-manager.pl"
         "cinnamon-backgrounds-manager.pl"
         "cinnamon-font-manager.pl"
+        "cinnamon-settings-cache-builder.pl"
     )
 
     for module in "${modules[@]}"; do
@@ -218,6 +242,16 @@ install_files() {
         fi
     done
 
+    # Install shared Perl modules used by the managers
+    if [ -d "lib/CinnamonSettings" ]; then
+        mkdir -p "$DATA_DIR/lib/CinnamonSettings"
+        cp lib/CinnamonSettings/*.pm "$DATA_DIR/lib/CinnamonSettings/"
+        print_success "Shared Perl modules installed to $DATA_DIR/lib/"
+    else
+        print_error "lib/CinnamonSettings not found in current directory"
+        exit 1
+    fi
+
     # Copy custom icons if they exist
     if [ -d "icons" ]; then
         print_info "Installing custom icons..."
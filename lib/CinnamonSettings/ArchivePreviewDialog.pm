@@ -0,0 +1,276 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - theme archive preview dialog
+# Lets the user pick a downloaded theme archive, shows a preview built from
+# the few members the manager asks for while the archive is read once in
+# the background, and installs the theme only when Install is pressed.
+# Managers supply the member names they preview and a render callback
+# that turns the in-memory members into a widget.
+
+package CinnamonSettings::ArchivePreviewDialog {
+    use Moo;
+    use Glib 'TRUE', 'FALSE';
+    use File::Basename qw(basename);
+    use CinnamonSettings::ThemeArchive;
+
+    has 'parent' => (is => 'ro');
+    has 'session' => (is => 'ro', required => 1);
+    # 'cursor', 'icon', 'gtk' or 'cinnamon'; see ThemeArchive->selector
+    has 'kind' => (is => 'ro', required => 1);
+    has 'names' => (is => 'ro', default => sub { [] });
+    has 'install_dir' => (is => 'ro', required => 1);
+    # $render->($archive, $theme) returns the preview widget
+    has 'render' => (is => 'ro', required => 1);
+    # $on_installed->($theme_name, $path) after a successful install
+    has 'on_installed' => (is => 'ro');
+
+    has 'archive' => (is => 'rw');
+    has 'dialog' => (is => 'rw');
+    has 'status_label' => (is => 'rw');
+    has 'spinner' => (is => 'rw');
+    has 'theme_combo' => (is => 'rw');
+    has 'preview_area' => (is => 'rw');
+    has 'install_button' => (is => 'rw');
+    has 'themes' => (is => 'rw', default => sub { [] });
+
+    # Ask for an archive and open the preview window for it
+    sub run {
+        my $self = shift;
+
+        my $chooser = Gtk3::FileChooserDialog->new(
+            'Select Theme Archive',
+            $self->parent,
+            'open',
+            'gtk-cancel' => 'cancel',
+            'gtk-open' => 'accept'
+        );
+        my $filter = Gtk3::FileFilter->new();
+        $filter->set_name('Theme archives');
+        $filter->add_pattern($_) for qw(*.tar.gz *.tgz *.tar.xz *.txz *.tar.bz2 *.tbz2 *.tar.zst *.tar *.zip);
+        $chooser->add_filter($filter);
+
+        my $path = $chooser->run() eq 'accept' ? $chooser->get_filename() : undef;
+        $chooser->destroy();
+        return unless $path;
+
+        unless (CinnamonSettings::ThemeArchive->is_supported($path)) {
+            $self->_show_message('error', basename($path) . ' is not a supported theme archive.');
+            return;
+        }
+
+        $self->archive(CinnamonSettings::ThemeArchive->new(path => $path, session => $self->session));
+        $self->_create_dialog(basename($path));
+
+        $self->archive->scan(
+            want => CinnamonSettings::ThemeArchive->selector(kind => $self->kind, names => $self->names),
+            on_done => sub { $self->_scan_finished(@_) },
+        );
+    }
+
+    sub _create_dialog {
+        my ($self, $title) = @_;
+
+        my $dialog = Gtk3::Dialog->new();
+        $dialog->set_title("Preview $title");
+        $dialog->set_transient_for($self->parent) if $self->parent;
+        $dialog->set_default_size(640, 480);
+        $dialog->add_button('gtk-cancel', 'cancel');
+        my $install_button = $dialog->add_button('Install', 'accept');
+        $install_button->set_sensitive(FALSE);
+
+        my $content = $dialog->get_content_area();
+        $content->set_spacing(8);
+        $content->set_border_width(12);
+
+        my $header = Gtk3::Box->new('horizontal', 8);
+        my $spinner = Gtk3::Spinner->new();
+        my $status_label = Gtk3::Label->new("Reading $title...");
+        $status_label->set_halign('start');
+        $status_label->set_ellipsize('end');
+        my $theme_combo = Gtk3::ComboBoxText->new();
+        $theme_combo->set_no_show_all(TRUE);
+        $header->pack_start($spinner, FALSE, FALSE, 0);
+        $header->pack_start($status_label, TRUE, TRUE, 0);
+        $header->pack_end($theme_combo, FALSE, FALSE, 0);
+        $content->pack_start($header, FALSE, FALSE, 0);
+
+        my $preview_area = Gtk3::ScrolledWindow->new();
+        $preview_area->set_policy('automatic', 'automatic');
+        $content->pack_start($preview_area, TRUE, TRUE, 0);
+
+        $theme_combo->signal_connect(changed => sub { $self->_show_theme() });
+        $dialog->signal_connect(response => sub {
+            my (undef, $response) = @_;
+            if ($response eq 'accept') {
+                $self->_install();
+            } else {
+                $dialog->destroy();
+            }
+        });
+        $dialog->signal_connect(destroy => sub {
+            $self->archive->cancel() if $self->archive;
+            $self->dialog(undef);
+        });
+
+        $self->dialog($dialog);
+        $self->status_label($status_label);
+        $self->spinner($spinner);
+        $self->theme_combo($theme_combo);
+        $self->preview_area($preview_area);
+        $self->install_button($install_button);
+
+        $dialog->show_all();
+        $spinner->start();
+    }
+
+    sub _scan_finished {
+        my ($self, $ok, $error) = @_;
+
+        # Closed while reading
+        return unless $self->dialog;
+
+        $self->spinner->stop();
+        $self->spinner->hide();
+
+        unless ($ok) {
+            $self->status_label->set_text($error);
+            return;
+        }
+
+        my $kind = $self->kind;
+        my @themes = grep { $_->{kinds}{$kind} } @{$self->archive->themes};
+        $self->themes(\@themes);
+
+        unless (@themes) {
+            $self->status_label->set_text('No ' . _kind_label($kind) . ' found in ' . basename($self->archive->path));
+            return;
+        }
+
+        $self->theme_combo->append_text($_->{display_name}) for @themes;
+        $self->theme_combo->set_visible(@themes > 1);
+        $self->theme_combo->set_active(0);
+        $self->install_button->set_sensitive(TRUE);
+
+        printf "Archive %s: %d entries, %d members read (%.1f KiB) for the preview\n",
+            basename($self->archive->path), scalar(keys %{$self->archive->entries}),
+            scalar(keys %{$self->archive->members}), $self->archive->kept_bytes / 1024;
+    }
+
+    sub _show_theme {
+        my $self = shift;
+
+        my $theme = $self->themes->[$self->theme_combo->get_active()] or return;
+        $self->status_label->set_text("$theme->{display_name} — installs to $self->{install_dir}/$theme->{name}");
+
+        my $area = $self->preview_area;
+        $area->remove($_) for $area->get_children();
+
+        my $widget = $self->render->($self->archive, $theme)
+            || Gtk3::Label->new('This theme has nothing to preview.');
+        $area->add($widget);
+        $area->show_all();
+    }
+
+    sub _install {
+        my $self = shift;
+
+        my $theme = $self->themes->[$self->theme_combo->get_active()] or return;
+        my $target = $self->install_dir . '/' . $theme->{name};
+        if (-e $target || -l $target) {
+            my $confirm = Gtk3::MessageDialog->new(
+                $self->dialog,
+                'modal',
+                'question',
+                'yes-no',
+                "$target already exists. Replace it?"
+            );
+            my $response = $confirm->run();
+            $confirm->destroy();
+            return unless $response eq 'yes';
+        }
+
+        $self->install_button->set_sensitive(FALSE);
+        $self->status_label->set_text("Installing $theme->{display_name}...");
+        $self->spinner->show();
+        $self->spinner->start();
+
+        $self->archive->install(
+            theme => $theme,
+            dest_dir => $self->install_dir,
+            on_done => sub {
+                my ($ok, $result) = @_;
+
+                unless ($ok) {
+                    if ($self->dialog) {
+                        $self->spinner->stop();
+                        $self->spinner->hide();
+                        $self->status_label->set_text('Installation failed');
+                        $self->install_button->set_sensitive(TRUE);
+                    }
+                    $self->_show_message('error', "Installing $theme->{display_name} failed:\n\n$result");
+                    return;
+                }
+
+                print "Installed $theme->{name} to $result\n";
+                $self->dialog->destroy() if $self->dialog;
+                $self->on_installed->($theme->{name}, $result) if $self->on_installed;
+            },
+        );
+    }
+
+    # Grid of [widget, caption] cells, for render callbacks
+    sub preview_grid {
+        my ($class, @cells) = @_;
+
+        return undef unless @cells;
+
+        my $grid = Gtk3::FlowBox->new();
+        $grid->set_valign('start');
+        $grid->set_max_children_per_line(8);
+        $grid->set_selection_mode('none');
+        $grid->set_homogeneous(TRUE);
+
+        foreach my $cell (@cells) {
+            my ($widget, $caption) = @$cell;
+            my $box = Gtk3::Box->new('vertical', 4);
+            $box->set_margin_top(6);
+            $box->set_margin_bottom(6);
+            $box->pack_start($widget, FALSE, FALSE, 0);
+            my $label = Gtk3::Label->new($caption);
+            $label->set_ellipsize('end');
+            $label->set_max_width_chars(14);
+            $box->pack_start($label, FALSE, FALSE, 0);
+            $grid->add($box);
+        }
+
+        return $grid;
+    }
+
+    sub _kind_label {
+        my $kind = shift;
+        return {
+            cursor => 'cursor theme',
+            icon => 'icon theme',
+            gtk => 'GTK 3 theme',
+            cinnamon => 'Cinnamon theme',
+        }->{$kind} || 'theme';
+    }
+
+    sub _show_message {
+        my ($self, $type, $text) = @_;
+
+        my $msg_dialog = Gtk3::MessageDialog->new(
+            $self->dialog || $self->parent,
+            'modal',
+            $type,
+            'ok',
+            $text
+        );
+        $msg_dialog->run();
+        $msg_dialog->destroy();
+    }
+}
+
+1;
@@ -0,0 +1,150 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - byte-budgeted LRU cache
+# In-memory caches (scanned directory lists, decoded pixbufs, parsed font
+# files) are charged for the bytes they hold instead of an entry count, so
+# a handful of huge wallpapers and thousands of tiny cursor frames are held
+# to the same limit. The least recently used entries are dropped once the
+# budget is exceeded; the entry just stored is always kept.
+
+package CinnamonSettings::BudgetCache {
+    use Moo;
+    use Scalar::Util qw(blessed reftype refaddr);
+    use CinnamonSettings::Trace qw(TRACING trace_instant);
+
+    has 'name' => (is => 'ro', default => sub { 'cache' });
+    has 'budget_bytes' => (is => 'ro', required => 1);
+    has 'bytes' => (is => 'rw', default => sub { 0 });
+    has 'evictions' => (is => 'rw', default => sub { 0 });
+    # Called with ($key, $value) for entries dropped to stay in budget,
+    # e.g. to delete the file an entry stands for
+    has 'on_evict' => (is => 'ro');
+
+    # key => node; nodes form a list from most (head) to least (tail)
+    # recently used
+    has 'nodes' => (is => 'rw', default => sub { {} });
+    has 'head' => (is => 'rw');
+    has 'tail' => (is => 'rw');
+
+    sub count {
+        return scalar keys %{$_[0]->nodes};
+    }
+
+    sub contains {
+        my ($self, $key) = @_;
+        return exists $self->nodes->{$key};
+    }
+
+    sub get {
+        my ($self, $key) = @_;
+
+        my $node = $self->nodes->{$key} or return undef;
+        $self->_unlink($node);
+        $self->_push_front($node);
+        return $node->{value};
+    }
+
+    # Store $value under $key; $bytes defaults to an estimate of its size
+    sub set {
+        my ($self, $key, $value, $bytes) = @_;
+
+        $bytes = estimate_bytes($value) unless defined $bytes;
+        $self->remove($key);
+
+        my $node = { key => $key, value => $value, bytes => $bytes };
+        $self->nodes->{$key} = $node;
+        $self->_push_front($node);
+        $self->bytes($self->bytes + $bytes);
+
+        $self->_trim();
+        return $value;
+    }
+
+    sub remove {
+        my ($self, $key) = @_;
+
+        my $node = delete $self->nodes->{$key} or return;
+        $self->_unlink($node);
+        $self->bytes($self->bytes - $node->{bytes});
+    }
+
+    sub clear {
+        my $self = shift;
+
+        # Break the list links so the nodes go away with the hash
+        $_->{prev} = $_->{next} = undef for values %{$self->nodes};
+        $self->nodes({});
+        $self->head(undef);
+        $self->tail(undef);
+        $self->bytes(0);
+    }
+
+    sub _trim {
+        my $self = shift;
+
+        my $dropped = 0;
+        while ($self->bytes > $self->budget_bytes && $self->tail && $self->tail != $self->head) {
+            my $node = $self->tail;
+            $self->remove($node->{key});
+            $self->on_evict->($node->{key}, $node->{value}) if $self->on_evict;
+            $dropped++;
+        }
+        return unless $dropped;
+
+        $self->evictions($self->evictions + $dropped);
+        trace_instant('cache evict', cache => $self->name, entries => $dropped, bytes => $self->bytes) if TRACING;
+    }
+
+    sub _push_front {
+        my ($self, $node) = @_;
+
+        $node->{prev} = undef;
+        $node->{next} = $self->head;
+        $self->head->{prev} = $node if $self->head;
+        $self->head($node);
+        $self->tail($node) unless $self->tail;
+    }
+
+    sub _unlink {
+        my ($self, $node) = @_;
+
+        if ($node->{prev}) { $node->{prev}{next} = $node->{next} } else { $self->head($node->{next}) }
+        if ($node->{next}) { $node->{next}{prev} = $node->{prev} } else { $self->tail($node->{prev}) }
+        $node->{prev} = $node->{next} = undef;
+    }
+
+    # Pixel storage of a Gdk::Pixbuf plus a small allowance for the object
+    sub pixbuf_bytes {
+        my $pixbuf = shift;
+        return 64 unless $pixbuf;
+        return $pixbuf->get_rowstride() * $pixbuf->get_height() + 64;
+    }
+
+    # Rough footprint of a Perl data structure: strings by length, a fixed
+    # overhead per scalar and container, pixbufs by their pixel storage
+    sub estimate_bytes {
+        my ($value, $seen) = @_;
+        $seen ||= {};
+
+        return 24 unless defined $value;
+        return 24 + length($value) unless ref $value;
+        return 0 if $seen->{refaddr $value}++;
+
+        return pixbuf_bytes($value) if blessed($value) && $value->isa('Gtk3::Gdk::Pixbuf');
+
+        my $type = reftype($value) || '';
+        my $bytes = 64;
+        if ($type eq 'ARRAY') {
+            $bytes += estimate_bytes($_, $seen) for @$value;
+        } elsif ($type eq 'HASH') {
+            $bytes += length($_) + estimate_bytes($value->{$_}, $seen) for keys %$value;
+        } elsif ($type eq 'SCALAR' || $type eq 'REF') {
+            $bytes += estimate_bytes($$value, $seen);
+        }
+        return $bytes;
+    }
+}
+
+1;
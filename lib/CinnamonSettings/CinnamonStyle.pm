@@ -0,0 +1,380 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - Cinnamon shell stylesheet reader
+# Pulls the panel, menu and accent colors plus a few metrics (panel height,
+# menu corner radius, font size) out of cinnamon/cinnamon.css in a single
+# tokenizing pass, and renders a mock panel and menu from them with Cairo.
+# Used for themes that ship no screenshot, so they can still be previewed
+# without restyling the running shell.
+
+package CinnamonSettings::CinnamonStyle {
+    use Moo;
+    use Cairo;
+    use CinnamonSettings::CssColorTable;
+
+    has 'styles' => (is => 'rw', default => sub { {} });
+
+    # Selectors the preview cares about, mapped to style keys
+    my %KEY_SELECTORS = (
+        'stage'                                 => 'stage',
+        '#panel'                                => 'panel',
+        '.panel-top'                            => 'panel',
+        '.panel-bottom'                         => 'panel',
+        '.panel-button'                         => 'panel_button',
+        '.applet-box'                           => 'panel_button',
+        '.window-list-item-box:active'          => 'task_active',
+        '.window-list-item-box:checked'         => 'task_active',
+        '.window-list-item-box:focus'           => 'task_active',
+        '.grouped-window-list-item-box:active'  => 'task_active',
+        '.grouped-window-list-item-box:focus'   => 'task_active',
+        '.window-list-item-box'                 => 'task',
+        '.grouped-window-list-item-box'         => 'task',
+        '.menu'                                 => 'menu',
+        '.popup-menu'                           => 'menu',
+        '.popup-menu-boxpointer'                => 'menu',
+        '.popup-menu-content'                   => 'menu',
+        '.popup-menu-item:active'               => 'menu_item_active',
+        '.popup-menu-item:hover'                => 'menu_item_active',
+        '.menu-application-button-selected'     => 'menu_item_active',
+        '.menu-category-button-selected'        => 'menu_category_active',
+        '.menu-favorites-box'                   => 'menu_sidebar',
+        '#menu-search-entry'                    => 'menu_entry',
+        '.menu-search-entry'                    => 'menu_entry',
+    );
+
+    # Properties folded into one slot each; the first match in the file wins
+    my %PROPERTY_SLOTS = (
+        'background-color'          => 'background',
+        'background'                => 'background',
+        '-arrow-background-color'   => 'background',
+        'background-gradient-start' => 'background',
+        'color'                     => 'color',
+        'border-color'              => 'border',
+        'border'                    => 'border',
+        'border-top'                => 'border',
+        '-arrow-border-color'       => 'border',
+        'border-radius'             => 'radius',
+        '-arrow-border-radius'      => 'radius',
+        'border-width'              => 'border_width',
+        '-arrow-border-width'       => 'border_width',
+        'height'                    => 'height',
+        'min-height'                => 'height',
+        'font-size'                 => 'font_size',
+    );
+
+    # Resolved style for a cinnamon.css file, parsed once per mtime
+    sub style_for {
+        my ($self, $css_file) = @_;
+
+        my $mtime = (stat($css_file))[9] or return undef;
+        my $memo = $self->styles->{$css_file};
+        return $memo->{style} if $memo && $memo->{mtime} == $mtime;
+
+        open my $fh, '<', $css_file or return undef;
+        my $css = do { local $/; <$fh> };
+        close $fh;
+
+        my $style = $self->resolve_style($self->scan_css($css));
+        $self->styles->{$css_file} = { mtime => $mtime, style => $style };
+        return $style;
+    }
+
+    # One pass over the stylesheet collecting raw values per key and slot
+    sub scan_css {
+        my ($self, $css) = @_;
+
+        my %raw;
+        my @selector_keys;
+        my $in_rule = 0;
+
+        $css =~ s{/\*.*?\*/}{}gs;
+
+        pos($css) = 0;
+        while (pos($css) < length($css)) {
+            if ($css =~ /\G\s+/gc) {
+                next;
+            }
+
+            if ($in_rule) {
+                if ($css =~ /\G([^;}]*)([;}])/gc) {
+                    my ($decl, $end) = ($1, $2);
+                    if (@selector_keys && $decl =~ /^\s*([\w-]+)\s*:\s*(.*?)\s*$/s) {
+                        my $slot = $PROPERTY_SLOTS{lc $1};
+                        if ($slot && length $2) {
+                            $raw{$_}{$slot} //= $2 for @selector_keys;
+                        }
+                    }
+                    $in_rule = 0 if $end eq '}';
+                } else {
+                    last;
+                }
+                next;
+            }
+
+            if ($css =~ /\G\@[\w-]+[^{;]*;/gc) {
+                next;
+            }
+
+            if ($css =~ /\G\@[\w-]+[^{;]*\{/gc) {
+                # Skip nested at-rule blocks such as @keyframes
+                my $level = 1;
+                while ($level > 0 && $css =~ /\G[^{}]*([{}])/gc) {
+                    $level += $1 eq '{' ? 1 : -1;
+                }
+                last if $level > 0;
+                next;
+            }
+
+            if ($css =~ /\G([^{}]+)\{/gc) {
+                @selector_keys = ();
+                foreach my $selector (split /,/, $1) {
+                    $selector =~ s/^\s+|\s+$//g;
+                    $selector =~ s/\s+/ /g;
+
+                    # ".menu .popup-menu-item:active" counts as its last part
+                    my $key = $KEY_SELECTORS{$selector};
+                    $key //= $KEY_SELECTORS{(split / /, $selector)[-1]} if $selector =~ / /;
+                    push @selector_keys, $key if $key;
+                }
+                $in_rule = 1;
+                next;
+            }
+
+            $css =~ /\G./gcs;
+        }
+
+        return \%raw;
+    }
+
+    # Turn raw values into the colors and metrics the renderer uses,
+    # falling back to a neutral dark shell style
+    sub resolve_style {
+        my ($self, $raw) = @_;
+
+        my $color = sub {
+            my ($key, $slot) = @_;
+            my $value = $raw->{$key} && $raw->{$key}{$slot};
+            return undef unless defined $value;
+            my $rgba = CinnamonSettings::CssColorTable->parse_color($value);
+            return ($rgba && $rgba->[3] > 0.05) ? $rgba : undef;
+        };
+        my $metric = sub {
+            my ($key, $slot) = @_;
+            my $value = $raw->{$key} && $raw->{$key}{$slot};
+            return undef unless defined $value && $value =~ /([\d.]+)\s*(px|pt|em)?/;
+            my ($number, $unit) = ($1, $2 || 'px');
+            return $unit eq 'pt' ? $number * 4 / 3 : $unit eq 'em' ? $number * 16 : $number;
+        };
+
+        my $panel_bg = $color->('panel', 'background') || [0.16, 0.17, 0.19, 0.95];
+        my $menu_bg = $color->('menu', 'background') || $panel_bg;
+        my $accent = $color->('menu_item_active', 'background')
+            || $color->('menu_category_active', 'background')
+            || $color->('task_active', 'background')
+            || $color->('task_active', 'border')
+            || [0.21, 0.52, 0.89, 1];
+
+        my %style = (
+            panel_bg        => $panel_bg,
+            panel_fg        => $color->('panel_button', 'color') || $color->('panel', 'color')
+                               || _contrast($panel_bg),
+            panel_border    => $color->('panel', 'border'),
+            panel_height    => $metric->('panel', 'height') || 32,
+            task_bg         => $color->('task', 'background'),
+            task_active_bg  => $color->('task_active', 'background') || [@$accent[0 .. 2], 0.35],
+            menu_bg         => $menu_bg,
+            menu_fg         => $color->('menu', 'color') || $color->('stage', 'color') || _contrast($menu_bg),
+            menu_border     => $color->('menu', 'border'),
+            menu_radius     => $metric->('menu', 'radius') // 6,
+            menu_sidebar_bg => $color->('menu_sidebar', 'background'),
+            entry_bg        => $color->('menu_entry', 'background'),
+            entry_fg        => $color->('menu_entry', 'color'),
+            accent          => $accent,
+            accent_fg       => $color->('menu_item_active', 'color') || _contrast($accent),
+            font_size       => $metric->('stage', 'font_size') || 12,
+        );
+
+        return \%style;
+    }
+
+    # Mock desktop with a bottom panel and an open application menu
+    sub render_preview {
+        my ($self, $style, $width, $height) = @_;
+
+        my $surface = Cairo::ImageSurface->create('argb32', $width, $height);
+        my $cr = Cairo::Context->create($surface);
+        my $s = $width / 400;
+
+        # Desktop backdrop tinted towards the accent
+        my @accent = @{$style->{accent}}[0 .. 2];
+        my $backdrop = Cairo::LinearGradient->create(0, 0, $width, $height);
+        $backdrop->add_color_stop_rgb(0, map { 0.18 + $_ * 0.25 } @accent);
+        $backdrop->add_color_stop_rgb(1, map { 0.06 + $_ * 0.12 } @accent);
+        $cr->set_source($backdrop);
+        $cr->paint();
+
+        # Panel
+        my $panel_h = int(_clamp($style->{panel_height}, 20, 56) * 0.8 * $s);
+        my $panel_y = $height - $panel_h;
+        _set_rgba($cr, $style->{panel_bg});
+        $cr->rectangle(0, $panel_y, $width, $panel_h);
+        $cr->fill();
+        if ($style->{panel_border}) {
+            _set_rgba($cr, $style->{panel_border});
+            $cr->rectangle(0, $panel_y, $width, 1);
+            $cr->fill();
+        }
+
+        # Menu button, window list and tray
+        my $pad = int(4 * $s);
+        my $button = $panel_h - 2 * $pad;
+        _set_rgba($cr, $style->{accent});
+        $cr->arc($pad + $button / 2, $panel_y + $panel_h / 2, $button * 0.35, 0, 2 * 3.14159);
+        $cr->fill();
+
+        my $task_w = int(60 * $s);
+        for my $i (0 .. 2) {
+            my $x = $pad * 3 + $button + $i * ($task_w + $pad);
+            my $bg = $i == 1 ? $style->{task_active_bg} : $style->{task_bg};
+            if ($bg) {
+                _set_rgba($cr, $bg);
+                _rounded_rectangle($cr, $x, $panel_y + $pad, $task_w, $button, 3 * $s);
+                $cr->fill();
+            }
+            if ($i == 1) {
+                _set_rgba($cr, $style->{accent});
+                $cr->rectangle($x, $panel_y + $panel_h - 2 * $s, $task_w, 2 * $s);
+                $cr->fill();
+            }
+            _set_rgba($cr, $style->{panel_fg}, 0.7);
+            _rounded_rectangle($cr, $x + 6 * $s, $panel_y + $panel_h / 2 - 2 * $s, $task_w - 12 * $s, 4 * $s, 2 * $s);
+            $cr->fill();
+        }
+
+        _set_rgba($cr, $style->{panel_fg});
+        $cr->select_font_face('Sans', 'normal', 'normal');
+        $cr->set_font_size(_clamp($style->{font_size}, 9, 16) * $s);
+        my $clock = '12:30';
+        my $extents = $cr->text_extents($clock);
+        $cr->move_to($width - $extents->{width} - 3 * $pad, $panel_y + ($panel_h + $extents->{height}) / 2);
+        $cr->show_text($clock);
+        for my $i (0 .. 2) {
+            $cr->arc($width - $extents->{width} - 6 * $pad - $i * 10 * $s, $panel_y + $panel_h / 2, 2.5 * $s, 0, 2 * 3.14159);
+            $cr->fill();
+        }
+
+        # Application menu
+        my $menu_w = int($width * 0.58);
+        my $menu_h = int(($panel_y - 8 * $s) * 0.9);
+        my $menu_x = $pad;
+        my $menu_y = $panel_y - $menu_h - 2 * $s;
+        my $radius = _clamp($style->{menu_radius}, 0, 14) * $s;
+
+        _set_rgba($cr, $style->{menu_bg});
+        _rounded_rectangle($cr, $menu_x, $menu_y, $menu_w, $menu_h, $radius);
+        $cr->fill_preserve();
+        _set_rgba($cr, $style->{menu_border} || [@{$style->{menu_fg}}[0 .. 2], 0.15]);
+        $cr->set_line_width(1);
+        $cr->stroke();
+
+        my $inner = 8 * $s;
+        my $sidebar_w = int(34 * $s);
+        if ($style->{menu_sidebar_bg}) {
+            _set_rgba($cr, $style->{menu_sidebar_bg});
+            _rounded_rectangle($cr, $menu_x + $inner, $menu_y + $inner, $sidebar_w, $menu_h - 2 * $inner, $radius / 2);
+            $cr->fill();
+        }
+        for my $i (0 .. 4) {
+            _set_rgba($cr, $i == 0 ? $style->{accent} : $style->{menu_fg}, $i == 0 ? 1 : 0.35);
+            $cr->arc($menu_x + $inner + $sidebar_w / 2, $menu_y + $inner + (14 + $i * 26) * $s, 8 * $s, 0, 2 * 3.14159);
+            $cr->fill();
+        }
+
+        # Search entry
+        my $content_x = $menu_x + $inner * 2 + $sidebar_w;
+        my $content_w = $menu_w - ($content_x - $menu_x) - $inner;
+        my $entry_h = 18 * $s;
+        _set_rgba($cr, $style->{entry_bg} || [@{$style->{menu_fg}}[0 .. 2], 0.08]);
+        _rounded_rectangle($cr, $content_x, $menu_y + $inner, $content_w, $entry_h, 3 * $s);
+        $cr->fill();
+        _set_rgba($cr, $style->{entry_fg} || $style->{menu_fg}, 0.55);
+        $cr->set_font_size(9 * $s);
+        $cr->move_to($content_x + 6 * $s, $menu_y + $inner + $entry_h * 0.7);
+        $cr->show_text('Search');
+
+        # Categories on the left, applications on the right
+        my $rows_y = $menu_y + $inner * 2 + $entry_h;
+        my $row_h = 17 * $s;
+        my $column_w = int($content_w * 0.42);
+        my $rows = int(($menu_y + $menu_h - $inner - $rows_y) / $row_h);
+
+        for my $i (0 .. $rows - 1) {
+            my $y = $rows_y + $i * $row_h;
+
+            if ($i == 1) {
+                _set_rgba($cr, $style->{accent}, 0.45);
+                _rounded_rectangle($cr, $content_x, $y, $column_w, $row_h - 2 * $s, 3 * $s);
+                $cr->fill();
+            }
+            _set_rgba($cr, $style->{menu_fg}, 0.6);
+            _rounded_rectangle($cr, $content_x + 5 * $s, $y + $row_h / 2 - 3 * $s, $column_w * (0.45 + 0.08 * ($i % 4)), 4 * $s, 2 * $s);
+            $cr->fill();
+
+            my $app_x = $content_x + $column_w + $inner;
+            my $app_w = $content_w - $column_w - $inner;
+            if ($i == 2) {
+                _set_rgba($cr, $style->{accent});
+                _rounded_rectangle($cr, $app_x, $y, $app_w, $row_h - 2 * $s, 3 * $s);
+                $cr->fill();
+            }
+            _set_rgba($cr, $i == 2 ? $style->{accent_fg} : $style->{menu_fg}, $i == 2 ? 0.9 : 0.35);
+            _rounded_rectangle($cr, $app_x + 4 * $s, $y + 2.5 * $s, 10 * $s, 10 * $s, 2 * $s);
+            $cr->fill();
+            _set_rgba($cr, $i == 2 ? $style->{accent_fg} : $style->{menu_fg}, 0.7);
+            _rounded_rectangle($cr, $app_x + 18 * $s, $y + $row_h / 2 - 3 * $s, $app_w * (0.4 + 0.07 * ($i % 5)), 4 * $s, 2 * $s);
+            $cr->fill();
+        }
+
+        return $surface;
+    }
+
+    sub _set_rgba {
+        my ($cr, $rgba, $alpha_scale) = @_;
+        my $alpha = defined $rgba->[3] ? $rgba->[3] : 1;
+        $alpha *= $alpha_scale if defined $alpha_scale;
+        $cr->set_source_rgba(@$rgba[0 .. 2], $alpha);
+    }
+
+    sub _rounded_rectangle {
+        my ($cr, $x, $y, $w, $h, $r) = @_;
+
+        $r = $h / 2 if $r > $h / 2;
+        $r = $w / 2 if $r > $w / 2;
+        if ($r <= 0) {
+            $cr->rectangle($x, $y, $w, $h);
+            return;
+        }
+
+        $cr->new_sub_path();
+        $cr->arc($x + $w - $r, $y + $r, $r, -3.14159 / 2, 0);
+        $cr->arc($x + $w - $r, $y + $h - $r, $r, 0, 3.14159 / 2);
+        $cr->arc($x + $r, $y + $h - $r, $r, 3.14159 / 2, 3.14159);
+        $cr->arc($x + $r, $y + $r, $r, 3.14159, 3 * 3.14159 / 2);
+        $cr->close_path();
+    }
+
+    sub _contrast {
+        my ($rgba) = @_;
+        my $luma = 0.299 * $rgba->[0] + 0.587 * $rgba->[1] + 0.114 * $rgba->[2];
+        return $luma > 0.5 ? [0.1, 0.1, 0.1, 1] : [0.95, 0.95, 0.95, 1];
+    }
+
+    sub _clamp {
+        my ($value, $min, $max) = @_;
+        return $value < $min ? $min : $value > $max ? $max : $value;
+    }
+}
+
+1;
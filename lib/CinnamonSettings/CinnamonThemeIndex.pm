@@ -0,0 +1,227 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - persisted Cinnamon theme index
+# Remembers, per theme directory, the resolved thumbnail path and display
+# metadata together with the mtimes they were derived from. A warm scan is
+# one readdir of the base directory plus one stat per theme; only themes
+# whose directory mtime changed are parsed again. The other recorded mtimes
+# are checked later by entry_is_current(), off the critical path.
+
+package CinnamonSettings::CinnamonThemeIndex {
+    use Moo;
+    use JSON qw(encode_json decode_json);
+    use File::Basename qw(dirname);
+    use File::Path qw(make_path);
+    use Data::Dumper;
+
+    # Bump when the entry layout or parse_theme changes
+    use constant INDEX_FORMAT => 1;
+
+    # Thumbnail files in priority order, relative to the theme directory
+    my @THUMBNAIL_CANDIDATES = (
+        'cinnamon/thumbnail.png',
+        'thumbnail.png',
+        'cinnamon/preview.png',
+        'preview.png',
+        'cinnamon/screenshot.png',
+        'screenshot.png',
+    );
+
+    has 'index_file' => (is => 'ro', required => 1);
+    has 'index' => (is => 'rw', lazy => 1, builder => '_build_index');
+    has 'dirty' => (is => 'rw', default => sub { 0 });
+
+    sub _build_index {
+        my $self = shift;
+
+        my $index = eval {
+            open my $fh, '<', $self->index_file or die "Cannot read index: $!";
+            my $json = do { local $/; <$fh> };
+            close $fh;
+            decode_json($json);
+        };
+
+        return $index if ref $index eq 'HASH' && ($index->{format} || 0) == INDEX_FORMAT;
+        return { format => INDEX_FORMAT, directories => {} };
+    }
+
+    # Split the subdirectories of $base_dir into entries that can be reused
+    # as-is and [path, name] pairs that must be parsed
+    sub scan_directory {
+        my ($self, $base_dir) = @_;
+
+        my $result = { entries => [], cold => [] };
+
+        opendir(my $dh, $base_dir) or return $result;
+        my @names = grep { !/^\./ } readdir($dh);
+        closedir($dh);
+
+        my $known = $self->index->{directories}{$base_dir} ||= {};
+        my %present;
+
+        foreach my $name (@names) {
+            my $theme_path = "$base_dir/$name";
+            my @st = stat($theme_path);
+            next unless @st && -d _;
+
+            $present{$name} = 1;
+            my $entry = $known->{$name};
+
+            if ($entry && $entry->{dir_mtime} == $st[9]) {
+                push @{$result->{entries}}, $entry;
+            } else {
+                push @{$result->{cold}}, [$theme_path, $name];
+            }
+        }
+
+        # Forget themes that were removed
+        foreach my $name (keys %$known) {
+            next if $present{$name};
+            delete $known->{$name};
+            $self->dirty(1);
+        }
+
+        return $result;
+    }
+
+    # Read everything the theme grid needs from one theme directory. Entries
+    # for directories that are not Cinnamon themes are kept too (is_theme 0),
+    # so they are not parsed again on the next scan.
+    sub parse_theme {
+        my ($self, $theme_path, $theme_name) = @_;
+
+        my $cinnamon_dir = "$theme_path/cinnamon";
+        my $entry = {
+            name          => $theme_name,
+            path          => $theme_path,
+            display_name  => $theme_name,
+            cinnamon_path => $cinnamon_dir,
+            dir_mtime     => (stat($theme_path))[9] || 0,
+            files         => {},
+            is_theme      => (-f "$cinnamon_dir/cinnamon.css") ? 1 : 0,
+        };
+
+        return $entry unless $entry->{is_theme};
+
+        $entry->{files}{$cinnamon_dir} = (stat($cinnamon_dir))[9] || 0;
+
+        foreach my $candidate (@THUMBNAIL_CANDIDATES) {
+            my $thumbnail_path = "$theme_path/$candidate";
+            my @st = stat($thumbnail_path);
+            if (@st && -f _ && $st[7] > 1000) {  # File exists and is not empty
+                $entry->{thumbnail_path} = $thumbnail_path;
+                $entry->{files}{$thumbnail_path} = $st[9];
+                last;
+            }
+        }
+
+        # Metadata from theme.json, then metadata.json as a fallback
+        my $theme_json = "$cinnamon_dir/theme.json";
+        $entry->{files}{$theme_json} = (stat($theme_json))[9] || 0;
+        if (my $metadata = _read_json($theme_json)) {
+            $entry->{display_name} = $metadata->{name} || $theme_name;
+            $entry->{description} = $metadata->{description};
+            $entry->{author} = $metadata->{author};
+            $entry->{version} = $metadata->{version};
+        }
+
+        my $metadata_json = "$theme_path/metadata.json";
+        $entry->{files}{$metadata_json} = (stat($metadata_json))[9] || 0;
+        if (!$entry->{description} && (my $metadata = _read_json($metadata_json))) {
+            $entry->{display_name} = $metadata->{name} || $entry->{display_name};
+            $entry->{description} = $metadata->{description};
+        }
+
+        return $entry;
+    }
+
+    # True while every file the entry was derived from keeps its mtime
+    sub entry_is_current {
+        my ($self, $entry) = @_;
+
+        foreach my $file (keys %{$entry->{files} || {}}) {
+            my $mtime = (stat($file))[9] || 0;
+            return 0 if $mtime != $entry->{files}{$file};
+        }
+        return 1;
+    }
+
+    sub update_entries {
+        my ($self, $base_dir, $entries) = @_;
+
+        my $known = $self->index->{directories}{$base_dir} ||= {};
+        $known->{$_->{name}} = $_ for @$entries;
+        $self->dirty(1) if @$entries;
+    }
+
+    sub save {
+        my $self = shift;
+
+        return unless $self->dirty;
+
+        my $index_dir = dirname($self->index_file);
+        make_path($index_dir) unless -d $index_dir;
+
+        eval {
+            my $temp_file = $self->index_file . ".tmp.$$";
+            open my $fh, '>', $temp_file or die "Cannot write $temp_file: $!";
+            print $fh encode_json($self->index);
+            close $fh;
+            rename $temp_file, $self->index_file or die "Cannot rename $temp_file: $!";
+            $self->dirty(0);
+        };
+        if ($@) {
+            print "Warning: Could not save theme index: $@\n";
+        }
+    }
+
+    # Script for a helper process that parses [path, name] pairs and prints
+    # one JSON entry per line
+    sub parse_script {
+        my ($self, $jobs) = @_;
+
+        my $lib_dir = dirname(dirname($INC{'CinnamonSettings/CinnamonThemeIndex.pm'}));
+        my $job_list = Data::Dumper->new([$jobs])->Terse(1)->Indent(0)->Useqq(1)->Dump();
+        my $lib_literal = Data::Dumper->new([$lib_dir])->Terse(1)->Useqq(1)->Dump();
+        chomp $lib_literal;
+
+        return <<"SCRIPT";
+use strict;
+use warnings;
+use lib $lib_literal;
+use JSON qw(encode_json);
+use CinnamonSettings::CinnamonThemeIndex;
+use CinnamonSettings::Trace qw(TRACING trace_span);
+
+\$| = 1;
+
+for my \$job (\@{ $job_list }) {
+    my \$span = TRACING && trace_span('theme index parse', theme => \$job->[1]);
+    my \$entry = CinnamonSettings::CinnamonThemeIndex->parse_theme(\@\$job);
+    print encode_json(\$entry), "\\n";
+}
+SCRIPT
+    }
+
+    sub _read_json {
+        my $file = shift;
+
+        return undef unless -f $file;
+
+        my $data = eval {
+            open my $fh, '<:encoding(UTF-8)', $file or die "Cannot read $file: $!";
+            my $json_text = do { local $/; <$fh> };
+            close $fh;
+            $json_text ? JSON->new->decode($json_text) : undef;
+        };
+        if ($@) {
+            print "Warning: Could not parse $file: $@\n";
+        }
+
+        return ref $data eq 'HASH' ? $data : undef;
+    }
+}
+
+1;
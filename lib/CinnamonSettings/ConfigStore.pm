@@ -0,0 +1,420 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - shared configuration store
+# A manager keeps its settings in the hash returned by load() and calls
+# save() after changing it. Saves only mark the store dirty: the file is
+# written once the changes settle (a burst of zoom clicks is one write),
+# and flush() writes pending changes right away, e.g. on window close.
+# Writes go to a temporary file that is synced before it is renamed over
+# settings.json, so a crash leaves either the old or the new settings.
+# Delayed writes run in a forked writer, so the sync never stalls the main
+# loop; flush() waits for it and writes in this process.
+#
+# The file is monitored, so another running instance writing it is merged
+# into the live hash: keys this instance has not changed since its last
+# load or write take the other instance's values, and on_change is called
+# with the names of the keys that changed. A write only replaces the file
+# if it is still the one last read or written; otherwise the other
+# instance's changes are merged first and the write is retried.
+
+package CinnamonSettings::ConfigStore {
+    use Moo;
+    use Fcntl qw(O_RDONLY);
+    use File::Basename qw(dirname);
+    use File::Path qw(make_path);
+    use IO::Handle;
+    use JSON;
+    use POSIX qw(_exit);
+    use Time::HiRes qw(time);
+    use Glib 'TRUE', 'FALSE';
+    use Glib::IO;
+
+    has 'file' => (is => 'ro', required => 1);
+    has 'defaults' => (is => 'ro', default => sub { {} });
+    # Called with the config hash after every load, to repair bad values
+    has 'validate' => (is => 'ro');
+    # Called with an array ref of key names after another instance's write
+    has 'on_change' => (is => 'rw');
+    has 'delay_ms' => (is => 'ro', default => sub { 500 });
+    # A steady stream of saves is still written this often
+    has 'max_delay_ms' => (is => 'ro', default => sub { 3000 });
+    has 'data' => (is => 'ro', default => sub { {} });
+    has 'dirty_since' => (is => 'rw');
+    has 'timeout_id' => (is => 'rw');
+    # { pid, from, watch, started, snapshot } of the delayed write in progress
+    has 'write_job' => (is => 'rw');
+    has 'monitor' => (is => 'rw');
+    has 'check_id' => (is => 'rw');
+    # Encoded value of every key as last read from or written to the file
+    has 'snapshot' => (is => 'rw', default => sub { {} });
+    # Identity of the file as last read or written, to skip our own writes
+    has 'signature' => (is => 'rw', default => sub { '' });
+    has 'stats' => (is => 'ro', default => sub { {
+        saves => 0,
+        writes => 0,
+        reloads => 0,
+    } });
+
+    # Read the file over the defaults and start watching it; returns the
+    # live config hash
+    sub load {
+        my $self = shift;
+
+        my $data = $self->data;
+        %$data = %{$self->_with_defaults({})};
+
+        my $file = $self->file;
+        if (-f $file) {
+            my $loaded = eval { $self->_read() };
+            if ($@) {
+                print "Error loading config: $@\n";
+                print "Using default configuration\n";
+            } elsif ($loaded) {
+                %$data = %{$self->_with_defaults($loaded)};
+                print "Loaded configuration from $file\n";
+            } else {
+                print "Config file is empty, using defaults\n";
+            }
+        } else {
+            print "Config file not found, using defaults\n";
+        }
+
+        $self->snapshot($self->_encode_all($data));
+        $self->signature($self->_file_signature());
+        $self->validate->($data) if $self->validate;
+        $self->_watch();
+
+        return $data;
+    }
+
+    # Schedule a write of the live hash
+    sub save {
+        my $self = shift;
+
+        $self->stats->{saves}++;
+        my $now = time();
+        $self->dirty_since($now) unless defined $self->dirty_since;
+
+        # Restart the delay on every save, up to max_delay_ms after the
+        # first unsaved change
+        if ($self->timeout_id) {
+            return if ($now - $self->dirty_since) * 1000 >= $self->max_delay_ms - $self->delay_ms;
+            Glib::Source->remove($self->timeout_id);
+        }
+        $self->_schedule_write();
+    }
+
+    # Write pending changes now, after any delayed write still running;
+    # returns false if the write failed, in which case the changes stay
+    # pending for the next save
+    sub flush {
+        my $self = shift;
+
+        if ($self->timeout_id) {
+            Glib::Source->remove($self->timeout_id);
+            $self->timeout_id(undef);
+        }
+        if (my $job = $self->write_job) {
+            # The window is closing, so the writer is waited for here
+            # rather than from the main loop
+            Glib::Source->remove($job->{watch});
+            $self->_reap_write($job);
+        }
+        return 1 unless defined $self->dirty_since;
+
+        my ($status, $detail) = ('changed');
+        for (1 .. 3) {
+            # Merge another instance's write first, so it is not lost
+            $self->_check();
+            my $snapshot = $self->_encode_all($self->data);
+            ($status, $detail) = $self->_write_file($self->_encode_file(), $self->signature);
+            next if $status eq 'changed';
+
+            last unless $status eq 'ok';
+            $self->dirty_since(undef);
+            $self->_written($snapshot, $detail);
+            return 1;
+        }
+
+        print "ERROR: Failed to save config: ", $status eq 'changed' ? "the file keeps changing\n" : $detail;
+        return 0;
+    }
+
+    sub _schedule_write {
+        my $self = shift;
+
+        $self->timeout_id(Glib::Timeout->add($self->delay_ms, sub {
+            $self->timeout_id(undef);
+            $self->_write_async();
+            return FALSE;
+        }));
+    }
+
+    # Hand the encoded settings to a forked writer that writes and syncs
+    # them; only the bookkeeping is left for the main loop. The writer is
+    # reaped here when it closes its pipe, not through a GLib child watch,
+    # so flush() can wait for it too.
+    sub _write_async {
+        my $self = shift;
+
+        # The running write reschedules once it is done
+        return if $self->write_job;
+        return unless defined $self->dirty_since;
+
+        my $json = $self->_encode_file();
+        my $expected = $self->signature;
+        my $job = {
+            started => $self->dirty_since,
+            snapshot => $self->_encode_all($self->data),
+        };
+
+        pipe(my $from_child, my $to_parent) or return $self->flush();
+        my $pid = fork();
+        unless (defined $pid) {
+            close $from_child;
+            close $to_parent;
+            return $self->flush();
+        }
+        if ($pid == 0) {
+            close $from_child;
+            my ($status, $detail) = $self->_write_file($json, $expected);
+            print $to_parent "$status\t$detail";
+            close $to_parent;
+            _exit(0);
+        }
+        close $to_parent;
+
+        @{$job}{qw(pid from)} = ($pid, $from_child);
+        $job->{watch} = Glib::IO->add_watch(fileno($from_child), ['in', 'hup', 'err'], sub {
+            my $status = $self->_reap_write($job);
+            $self->_schedule_write()
+                if $status ne 'error' && defined $self->dirty_since && !$self->timeout_id;
+            return FALSE;
+        });
+        $self->write_job($job);
+        # Saves from now on are changes the writer does not write
+        $self->dirty_since(undef);
+    }
+
+    # Collect the writer's result; returns its status
+    sub _reap_write {
+        my ($self, $job) = @_;
+
+        my $from_child = $job->{from};
+        my $result = do { local $/; <$from_child> };
+        close $from_child;
+        waitpid($job->{pid}, 0);
+        $self->write_job(undef);
+
+        my ($status, $detail) = split /\t/, $result // '', 2;
+        ($status, $detail) = ('error', "Config writer exited without a result\n") unless $status;
+        $self->_finish_write($job, $status, $detail);
+        return $status;
+    }
+
+    sub _finish_write {
+        my ($self, $job, $status, $detail) = @_;
+
+        if ($status eq 'ok') {
+            $self->_written($job->{snapshot}, $detail);
+            # Another instance's write that arrived while ours ran
+            $self->_check();
+            return;
+        }
+
+        # Pending again, from the oldest change the writer had
+        $self->dirty_since($job->{started});
+        if ($status eq 'changed') {
+            # Merged now; the caller writes the result again
+            $self->_check();
+        } else {
+            print "ERROR: Failed to save config: $detail";
+        }
+    }
+
+    sub _written {
+        my ($self, $snapshot, $signature) = @_;
+
+        $self->snapshot($snapshot);
+        $self->signature($signature);
+        $self->stats->{writes}++;
+        print "Successfully saved configuration\n";
+    }
+
+    # Write $json over the file unless it no longer has the signature
+    # $expected. Returns ('ok', $new_signature), ('changed', '') or
+    # ('error', $message).
+    sub _write_file {
+        my ($self, $json, $expected) = @_;
+
+        my $file = $self->file;
+        my $temp_file = "$file.tmp.$$";
+        my $config_dir = dirname($file);
+
+        my $status = eval {
+            make_path($config_dir) unless -d $config_dir;
+
+            open my $fh, '>:raw', $temp_file or die "Cannot write temp config file: $!\n";
+            print $fh $json;
+            $fh->flush() && $fh->sync() or die "Cannot sync temp config file: $!\n";
+            close $fh or die "Cannot write temp config file: $!\n";
+
+            if ($self->_file_signature() ne $expected) {
+                unlink($temp_file);
+                return 'changed';
+            }
+            rename($temp_file, $file) or die "Cannot move temp file to final location: $!\n";
+
+            # Make the rename itself durable
+            if (sysopen(my $dir_fh, $config_dir, O_RDONLY)) {
+                $dir_fh->sync();
+                close $dir_fh;
+            }
+            'ok';
+        };
+        unless ($status) {
+            unlink($temp_file);
+            return ('error', $@);
+        }
+        return $status eq 'ok' ? ('ok', $self->_file_signature()) : ('changed', '');
+    }
+
+    sub report_stats {
+        my $self = shift;
+        return unless $ENV{CSM_DEBUG};
+
+        my $stats = $self->stats;
+        printf STDERR "[config] %d saves in %d writes, %d reloads\n", @{$stats}{qw(saves writes reloads)};
+    }
+
+    sub _watch {
+        my $self = shift;
+        return if $self->monitor;
+
+        my $monitor = eval { Glib::IO::File::new_for_path($self->file)->monitor_file([], undef) };
+        unless ($monitor) {
+            print "Config file monitoring unavailable: changes made by other windows are not followed\n";
+            return;
+        }
+
+        $monitor->signal_connect('changed' => sub {
+            my ($monitor, $file, $other_file, $event) = @_;
+            return if $event eq 'deleted' || $event eq 'attribute-changed';
+
+            # One check for the burst of events a single write produces
+            $self->check_id(Glib::Timeout->add(100, sub {
+                $self->check_id(undef);
+                $self->_check();
+                return FALSE;
+            })) unless $self->check_id;
+        });
+        $self->monitor($monitor);
+    }
+
+    # Merge a write by another instance into the live hash
+    sub _check {
+        my $self = shift;
+
+        # Our own write in progress; its signature is taken once it is done
+        return if $self->write_job;
+
+        my $signature = $self->_file_signature();
+        return if $signature eq '' || $signature eq $self->signature;
+
+        # An empty or broken file has nothing to merge; our next write
+        # replaces it
+        my $theirs = eval { $self->_read() };
+        unless ($theirs) {
+            $self->signature($signature);
+            return;
+        }
+        $theirs = $self->_with_defaults($theirs);
+
+        my $data = $self->data;
+        my $snapshot = $self->snapshot;
+        my $their_snapshot = $self->_encode_all($theirs);
+        my %keys = map { $_ => 1 } keys %$data, keys %$theirs;
+        my @changed;
+
+        foreach my $key (sort keys %keys) {
+            my $mine = $self->_encode($data->{$key});
+            # Our own unsaved changes win
+            next if $mine ne ($snapshot->{$key} // $self->_encode(undef));
+
+            my $their = $their_snapshot->{$key} // $self->_encode(undef);
+            next if $their eq $mine;
+
+            if (exists $theirs->{$key}) {
+                $data->{$key} = $theirs->{$key};
+            } else {
+                delete $data->{$key};
+            }
+            push @changed, $key;
+        }
+
+        $self->snapshot($their_snapshot);
+        $self->signature($signature);
+        $self->stats->{reloads}++;
+        return unless @changed;
+
+        $self->validate->($data) if $self->validate;
+        print "Configuration changed by another instance: @changed\n";
+        $self->on_change->(\@changed) if $self->on_change;
+    }
+
+    # Decoded file, or undef if it is empty
+    sub _read {
+        my $self = shift;
+
+        open my $fh, '<:encoding(UTF-8)', $self->file or die "Cannot open config file: $!\n";
+        my $json_text = do { local $/; <$fh> };
+        close $fh;
+
+        return undef unless defined $json_text && $json_text =~ /\S/;
+        my $config = JSON->new->decode($json_text);
+        die "Config file does not hold an object\n" unless ref($config) eq 'HASH';
+        return $config;
+    }
+
+    sub _with_defaults {
+        my ($self, $config) = @_;
+
+        my $defaults = $self->defaults;
+        # Fresh copies, so defaults are never changed through the live hash
+        my %merged = map { $_ => $self->_copy($defaults->{$_}) } keys %$defaults;
+        $merged{$_} = $config->{$_} for keys %$config;
+        return \%merged;
+    }
+
+    sub _copy {
+        my ($self, $value) = @_;
+        return ref($value) ? JSON->new->allow_nonref->decode(JSON->new->allow_nonref->encode($value)) : $value;
+    }
+
+    # File contents for the live hash, as UTF-8 bytes
+    sub _encode_file {
+        my $self = shift;
+        return JSON->new->utf8->pretty->canonical->encode($self->data);
+    }
+
+    sub _encode {
+        my ($self, $value) = @_;
+        return JSON->new->canonical->allow_nonref->encode($value);
+    }
+
+    sub _encode_all {
+        my ($self, $config) = @_;
+        return { map { $_ => $self->_encode($config->{$_}) } keys %$config };
+    }
+
+    sub _file_signature {
+        my $self = shift;
+
+        my @st = stat($self->file) or return '';
+        return join(':', @st[0, 1, 7, 9]);
+    }
+}
+
+1;
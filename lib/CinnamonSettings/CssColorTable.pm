@@ -0,0 +1,590 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - Theme CSS color table
+# Reads a GTK theme stylesheet (and its file and resource:// @imports) in a
+# single tokenizing pass and produces one table of resolved colors per theme.
+# Tables are stored on disk and reused until the mtime or size of any source
+# stylesheet or gresource bundle changes. Tables for system themes are read
+# from the install-time system cache when it has a current one.
+
+package CinnamonSettings::CssColorTable {
+    use Moo;
+    use JSON qw(encode_json decode_json);
+    use Digest::MD5 qw(md5_hex);
+    use File::Basename qw(dirname basename);
+    use File::Path qw(make_path);
+    use CinnamonSettings::GResource;
+
+    # Bump when the table layout or the parser changes
+    use constant TABLE_FORMAT => 2;
+
+    has 'cache_dir' => (is => 'ro', required => 1);
+    # CinnamonSettings::SystemCache holding tables for system themes
+    has 'shared' => (is => 'ro');
+    has 'tables' => (is => 'rw', default => sub { {} });
+
+    # Selectors whose colors the previews care about, mapped to table keys
+    my %KEY_SELECTORS = (
+        'window'                    => 'window',
+        'window.background'         => 'window',
+        '.background'               => 'window',
+        'button'                    => 'button',
+        '.button'                   => 'button',
+        'entry'                     => 'entry',
+        '.entry'                    => 'entry',
+        'headerbar'                 => 'headerbar',
+        '.titlebar'                 => 'headerbar',
+        '.sidebar'                  => 'sidebar',
+        'button.suggested-action'   => 'suggested_action',
+        '.suggested-action'         => 'suggested_action',
+        'selection'                 => 'selection',
+        '*:selected'                => 'selection',
+        ':selected'                 => 'selection',
+    );
+
+    my %NAMED_COLORS = (
+        white => [1, 1, 1, 1],
+        black => [0, 0, 0, 1],
+        transparent => [0, 0, 0, 0],
+        red => [1, 0, 0, 1],
+        green => [0, 0.5, 0, 1],
+        blue => [0, 0, 1, 1],
+        gray => [0.5, 0.5, 0.5, 1],
+        grey => [0.5, 0.5, 0.5, 1],
+        silver => [0.75, 0.75, 0.75, 1],
+        orange => [1, 0.65, 0, 1],
+        yellow => [1, 1, 0, 1],
+    );
+
+    # Return the color table for a stylesheet, computing it at most once per
+    # change of the stylesheet (memory first, then the on-disk table)
+    sub color_table {
+        my ($self, $css_file) = @_;
+
+        return undef unless $css_file && -f $css_file;
+
+        my $memo = $self->tables->{$css_file};
+        return $memo if $memo && $self->_sources_unchanged($memo);
+
+        my $cache_file = $self->cache_file_for($css_file);
+        my $table;
+
+        # The system cache uses the same file names; the recorded sources
+        # tell whether its table still matches the installed theme
+        if ($self->shared && $self->shared->covers($css_file)) {
+            $table = $self->_load_table($self->shared->dir . '/' . basename($cache_file));
+            $table = undef unless $self->_table_is_current($table, $css_file);
+        }
+
+        $table ||= $self->_load_table($cache_file);
+        unless ($self->_table_is_current($table, $css_file)) {
+            $table = $self->build_table($css_file);
+            $self->_store_table($cache_file, $table);
+        }
+
+        $self->tables->{$css_file} = $table;
+        return $table;
+    }
+
+    # Tokenize the stylesheet and its file imports once and resolve every
+    # color the table exposes. With $files (path => contents), stylesheets
+    # are read from memory instead, as for a theme still inside an archive.
+    sub build_table {
+        my ($self, $css_file, $files) = @_;
+
+        my $state = {
+            defines => {},
+            selectors => {},
+            first => {},
+            flat => 0,
+            mentions_dark => 0,
+            resource_imports => [],
+            resources_read => {},
+            bundles => undef,
+            theme_css_dir => dirname($css_file),
+            sources => {},
+            files => $files,
+        };
+
+        $self->_scan_file($css_file, $state, 0);
+
+        # Resolve all @define-color expressions now that every file has been read
+        my %resolved;
+        my $resolve;
+        $resolve = sub {
+            my ($name, $seen) = @_;
+            return $resolved{$name} if exists $resolved{$name};
+            my $expr = $state->{defines}{$name};
+            return undef if !defined $expr || $seen->{$name};
+            local $seen->{$name} = 1;
+            my $rgba = $self->_eval_color($expr, sub { $resolve->($_[0], $seen) });
+            $resolved{$name} = $rgba;
+            return $rgba;
+        };
+        $resolve->($_, {}) for keys %{$state->{defines}};
+        my $lookup = sub { $resolved{$_[0]} };
+
+        my %colors;
+        foreach my $name (keys %resolved) {
+            my $rgb = _visible_rgb($resolved{$name});
+            $colors{$name} = $rgb if $rgb;
+        }
+
+        my %selectors;
+        foreach my $key (keys %{$state->{selectors}}) {
+            foreach my $prop (keys %{$state->{selectors}{$key}}) {
+                my $rgb = _visible_rgb($self->_eval_color($state->{selectors}{$key}{$prop}, $lookup));
+                $selectors{$key}{$prop} = $rgb if $rgb;
+            }
+        }
+
+        my %first;
+        foreach my $prop (keys %{$state->{first}}) {
+            my $rgb = _visible_rgb($self->_eval_color($state->{first}{$prop}, $lookup));
+            $first{$prop} = $rgb if $rgb;
+        }
+
+        return {
+            format => TABLE_FORMAT,
+            css_file => $css_file,
+            sources => $state->{sources},
+            colors => \%colors,
+            selectors => \%selectors,
+            first => \%first,
+            flat => $state->{flat},
+            mentions_dark => $state->{mentions_dark},
+            resource_imports => $state->{resource_imports},
+            resource_bundle => $state->{resource_bundle},
+        };
+    }
+
+    # Look up the first resolved color among several @define-color names
+    sub define_color {
+        my ($self, $table, @names) = @_;
+
+        return undef unless $table;
+        foreach my $name (@names) {
+            return $table->{colors}{$name} if $table->{colors}{$name};
+        }
+        return undef;
+    }
+
+    # Look up a resolved property ('background', 'color', 'border') of a key selector
+    sub selector_color {
+        my ($self, $table, $key, $prop) = @_;
+
+        return undef unless $table && $table->{selectors}{$key};
+        return $table->{selectors}{$key}{$prop};
+    }
+
+    # Resolve a plain CSS color value (hex, rgb/rgba, GTK color functions,
+    # named colors, or a shorthand containing one) to [r, g, b, a]
+    sub parse_color {
+        my ($self, $value) = @_;
+
+        my $expr = $self->_first_color_expression($value);
+        return undef unless defined $expr;
+        return $self->_eval_color($expr, sub { undef });
+    }
+
+    sub _scan_file {
+        my ($self, $css_file, $state, $depth) = @_;
+
+        return if $depth > 8 || exists $state->{sources}{$css_file};
+
+        if ($state->{files}) {
+            1 while $css_file =~ s{(^|/)(?!\.\./)[^/]+/\.\./}{$1};
+            my $css = $state->{files}{$css_file};
+            return unless defined $css;
+            $state->{sources}{$css_file} = [0, length $css];
+            $self->_scan_css($css, dirname($css_file), $state, $depth);
+            return;
+        }
+
+        my @st = stat($css_file);
+        return unless @st;
+        $state->{sources}{$css_file} = [$st[9], $st[7]];
+
+        open my $fh, '<', $css_file or return;
+        my $css = do { local $/; <$fh> };
+        close $fh;
+
+        $self->_scan_css($css, dirname($css_file), $state, $depth);
+    }
+
+    # Resolve a resource:// stylesheet through the theme's compiled bundles
+    sub _scan_resource {
+        my ($self, $uri, $state, $depth) = @_;
+
+        return if $depth > 8 || $state->{resources_read}{$uri}++;
+
+        unless ($state->{bundles}) {
+            my @bundles;
+            foreach my $bundle_file (sort glob("$state->{theme_css_dir}/*.gresource")) {
+                my $bundle = CinnamonSettings::GResource->new(file => $bundle_file);
+                push @bundles, $bundle if $bundle->is_valid;
+            }
+            $state->{bundles} = \@bundles;
+        }
+
+        foreach my $bundle (@{$state->{bundles}}) {
+            my $css = $bundle->lookup($uri);
+            next unless defined $css;
+
+            my @st = stat($bundle->file);
+            $state->{sources}{$bundle->file} = [$st[9], $st[7]] if @st;
+            $state->{resource_bundle} //= $bundle->file;
+
+            $self->_scan_css($css, dirname($uri), $state, $depth);
+            return;
+        }
+    }
+
+    sub _scan_css {
+        my ($self, $css, $base_dir, $state, $depth) = @_;
+
+        $css =~ s{/\*.*?\*/}{}gs;
+        $state->{mentions_dark} = 1 if $css =~ /dark/i;
+
+        my @selector_keys;
+        my $in_rule = 0;
+
+        pos($css) = 0;
+        while (pos($css) < length($css)) {
+            if ($css =~ /\G\s+/gc) {
+                next;
+            }
+
+            if ($in_rule) {
+                # One declaration per step; a closing brace ends the rule
+                if ($css =~ /\G([^;}]*)([;}])/gc) {
+                    my ($decl, $end) = ($1, $2);
+                    $self->_record_declaration($decl, \@selector_keys, $state)
+                        if $decl =~ /:/;
+                    $in_rule = 0 if $end eq '}';
+                } else {
+                    last;
+                }
+                next;
+            }
+
+            if ($css =~ /\G\@define-color\s+([\w-]+)\s+([^;]+);/gc) {
+                # Later definitions win, as they do in GTK
+                $state->{defines}{$1} = $2;
+                next;
+            }
+
+            if ($css =~ /\G\@import\s+(?:url\(\s*)?["']?([^"')\s;]+)["']?\s*\)?[^;]*;/gc) {
+                my $target = $1;
+                if ($target =~ m{^resource://}) {
+                    push @{$state->{resource_imports}}, $target;
+                    $self->_scan_resource($target, $state, $depth + 1);
+                } elsif ($base_dir =~ m{^resource://}) {
+                    # Relative import inside a stylesheet read from a bundle
+                    $self->_scan_resource("$base_dir/$target", $state, $depth + 1);
+                } else {
+                    $target =~ s{^file://}{};
+                    $target = "$base_dir/$target" unless $target =~ m{^/};
+                    $self->_scan_file($target, $state, $depth + 1);
+                }
+                next;
+            }
+
+            if ($css =~ /\G\@[\w-]+[^{;]*;/gc) {
+                next;
+            }
+
+            if ($css =~ /\G\@[\w-]+[^{;]*\{/gc) {
+                # Skip nested at-rule blocks such as @keyframes
+                my $level = 1;
+                while ($level > 0 && $css =~ /\G[^{}]*([{}])/gc) {
+                    $level += $1 eq '{' ? 1 : -1;
+                }
+                last if $level > 0;
+                next;
+            }
+
+            if ($css =~ /\G([^{}]+)\{/gc) {
+                my $selector_text = $1;
+                @selector_keys = ();
+                foreach my $selector (split /,/, $selector_text) {
+                    $selector =~ s/^\s+|\s+$//g;
+                    $selector =~ s/\s+/ /g;
+                    my $key = $KEY_SELECTORS{$selector};
+                    push @selector_keys, $key if $key;
+                }
+                $in_rule = 1;
+                next;
+            }
+
+            # Stray braces or garbage: step over one character
+            $css =~ /\G./gcs;
+        }
+    }
+
+    sub _record_declaration {
+        my ($self, $decl, $selector_keys, $state) = @_;
+
+        my ($prop, $value) = $decl =~ /^\s*([\w-]+)\s*:\s*(.*?)\s*$/s;
+        return unless defined $prop && length $value;
+        $prop = lc $prop;
+
+        # Flat design hints
+        if ($prop eq 'border-radius' && $value =~ /^[01]px\b/) {
+            $state->{flat} = 1;
+        } elsif ($prop eq 'box-shadow' && $value =~ /^none\b/i) {
+            $state->{flat} = 1;
+        } elsif ($value =~ /gradient.*none/i) {
+            $state->{flat} = 1;
+        }
+
+        my $slot;
+        if ($prop eq 'background-color' || $prop eq 'background') {
+            $slot = 'background';
+        } elsif ($prop eq 'color') {
+            $slot = 'color';
+        } elsif ($prop eq 'border-color' || $prop eq 'border') {
+            $slot = 'border';
+        }
+        return unless $slot;
+
+        my $color_expr = $self->_first_color_expression($value);
+        return unless defined $color_expr;
+
+        $state->{first}{$slot} //= $color_expr if $prop ne 'background' && $prop ne 'border';
+
+        foreach my $key (@$selector_keys) {
+            $state->{selectors}{$key}{$slot} //= $color_expr;
+        }
+    }
+
+    # Pick the color part out of a shorthand value such as "1px solid @borders"
+    sub _first_color_expression {
+        my ($self, $value) = @_;
+
+        if ($value =~ /(?:shade|mix|alpha|lighter|darker|rgba?)\s*\(/i) {
+            my $call = _balanced_call($value, $-[0]);
+            return $call if defined $call;
+        }
+        return $1 if $value =~ /(\@[\w-]+)/;
+        return $1 if $value =~ /(#[0-9a-fA-F]{3,8})\b/;
+        return lc $1 if $value =~ /^\s*(\w+)\s*$/ && $NAMED_COLORS{lc $1};
+        return undef;
+    }
+
+    sub _balanced_call {
+        my ($text, $start) = @_;
+
+        my $open = index($text, '(', $start);
+        return undef if $open < 0;
+        my $level = 0;
+        for my $i ($open .. length($text) - 1) {
+            my $ch = substr($text, $i, 1);
+            $level++ if $ch eq '(';
+            $level-- if $ch eq ')';
+            return substr($text, $start, $i - $start + 1) if $level == 0;
+        }
+        return undef;
+    }
+
+    # Evaluate a GTK color expression to [r, g, b, a]; $lookup resolves @names
+    sub _eval_color {
+        my ($self, $expr, $lookup) = @_;
+
+        return undef unless defined $expr;
+        $expr =~ s/^\s+|\s+$//g;
+        $expr =~ s/\s*!important$//i;
+
+        if ($expr =~ /^\@([\w-]+)$/) {
+            my $rgba = $lookup->($1);
+            return $rgba ? [@$rgba] : undef;
+        }
+
+        if ($expr =~ /^#([0-9a-fA-F]+)$/) {
+            my $hex = $1;
+            $hex = join('', map { $_ x 2 } split //, $hex) if length($hex) == 3 || length($hex) == 4;
+            return undef unless length($hex) == 6 || length($hex) == 8;
+            my @c = map { hex(substr($hex, $_ * 2, 2)) / 255.0 } 0 .. (length($hex) / 2 - 1);
+            push @c, 1.0 if @c == 3;
+            return \@c;
+        }
+
+        if ($expr =~ /^(\w[\w-]*)\s*\((.*)\)$/s) {
+            my ($func, $body) = (lc $1, $2);
+            my @args = _split_args($body);
+
+            if ($func eq 'rgb' || $func eq 'rgba') {
+                return undef unless @args >= 3;
+                my @c = map {
+                    /^([\d.]+)%$/ ? $1 / 100 : ($_ =~ /^[\d.]+$/ ? $_ / 255.0 : 0)
+                } @args[0 .. 2];
+                my $alpha = defined $args[3] && $args[3] =~ /^[\d.]+$/ ? $args[3] : 1.0;
+                return [@c, $alpha];
+            }
+
+            if ($func eq 'shade' || $func eq 'lighter' || $func eq 'darker') {
+                my $base = $self->_eval_color($args[0], $lookup) or return undef;
+                my $factor = $func eq 'lighter' ? 1.3 : $func eq 'darker' ? 0.7 : ($args[1] // 1);
+                return undef unless $factor =~ /^[\d.]+$/;
+                return _shade($base, $factor);
+            }
+
+            if ($func eq 'alpha') {
+                my $base = $self->_eval_color($args[0], $lookup) or return undef;
+                my $factor = $args[1] // 1;
+                return undef unless $factor =~ /^[\d.]+$/;
+                my $a = $base->[3] * $factor;
+                $a = 1.0 if $a > 1.0;
+                return [@$base[0 .. 2], $a];
+            }
+
+            if ($func eq 'mix') {
+                return undef unless @args >= 3 && $args[2] =~ /^[\d.]+$/;
+                my $c1 = $self->_eval_color($args[0], $lookup) or return undef;
+                my $c2 = $self->_eval_color($args[1], $lookup) or return undef;
+                my $f = $args[2];
+                return [map { $c1->[$_] + ($c2->[$_] - $c1->[$_]) * $f } 0 .. 3];
+            }
+
+            return undef;
+        }
+
+        my $named = $NAMED_COLORS{lc $expr};
+        return $named ? [@$named] : undef;
+    }
+
+    sub _split_args {
+        my ($body) = @_;
+
+        my @args;
+        my ($level, $current) = (0, '');
+        foreach my $ch (split //, $body) {
+            if ($ch eq ',' && $level == 0) {
+                push @args, $current;
+                $current = '';
+                next;
+            }
+            $level++ if $ch eq '(';
+            $level-- if $ch eq ')';
+            $current .= $ch;
+        }
+        push @args, $current if length $current;
+        s/^\s+|\s+$//g for @args;
+        return @args;
+    }
+
+    # GTK's shade(): scale lightness and saturation in HLS space
+    sub _shade {
+        my ($rgba, $factor) = @_;
+
+        my ($red, $green, $blue, $alpha) = @$rgba;
+        my ($max, $min) = (sort { $b <=> $a } ($red, $green, $blue))[0, 2];
+        my $l = ($max + $min) / 2;
+        my ($h, $s) = (0, 0);
+
+        if ($max != $min) {
+            my $delta = $max - $min;
+            $s = $l <= 0.5 ? $delta / ($max + $min) : $delta / (2 - $max - $min);
+            if ($red == $max) {
+                $h = ($green - $blue) / $delta;
+            } elsif ($green == $max) {
+                $h = 2 + ($blue - $red) / $delta;
+            } else {
+                $h = 4 + ($red - $green) / $delta;
+            }
+            $h *= 60;
+            $h += 360 if $h < 0;
+        }
+
+        $l *= $factor;
+        $l = 1.0 if $l > 1.0;
+        $s *= $factor;
+        $s = 1.0 if $s > 1.0;
+
+        return [$l, $l, $l, $alpha] if $s == 0;
+
+        my $m2 = $l <= 0.5 ? $l * (1 + $s) : $l + $s - $l * $s;
+        my $m1 = 2 * $l - $m2;
+        my $channel = sub {
+            my $hue = shift;
+            $hue -= 360 while $hue > 360;
+            $hue += 360 while $hue < 0;
+            return $m1 + ($m2 - $m1) * $hue / 60 if $hue < 60;
+            return $m2 if $hue < 180;
+            return $m1 + ($m2 - $m1) * (240 - $hue) / 60 if $hue < 240;
+            return $m1;
+        };
+
+        return [$channel->($h + 120), $channel->($h), $channel->($h - 120), $alpha];
+    }
+
+    # Previews paint opaque colors; drop fully transparent results
+    sub _visible_rgb {
+        my ($rgba) = @_;
+
+        return undef unless $rgba && $rgba->[3] > 0.05;
+        return [map { my $v = $_ < 0 ? 0 : $_ > 1 ? 1 : $_; 0 + sprintf('%.4f', $v) } @$rgba[0 .. 2]];
+    }
+
+    sub _sources_unchanged {
+        my ($self, $table) = @_;
+
+        return 0 unless $table->{sources} && %{$table->{sources}};
+        foreach my $file (keys %{$table->{sources}}) {
+            my @st = stat($file);
+            return 0 unless @st;
+            my ($mtime, $size) = @{$table->{sources}{$file}};
+            return 0 unless $st[9] == $mtime && $st[7] == $size;
+        }
+        return 1;
+    }
+
+    sub _table_is_current {
+        my ($self, $table, $css_file) = @_;
+
+        return $table && ($table->{format} // 0) == TABLE_FORMAT
+            && $table->{css_file} eq $css_file
+            && $self->_sources_unchanged($table);
+    }
+
+    sub cache_file_for {
+        my ($self, $css_file) = @_;
+        return $self->cache_dir . '/' . md5_hex($css_file) . '.json';
+    }
+
+    sub _load_table {
+        my ($self, $cache_file) = @_;
+
+        return undef unless -f $cache_file;
+
+        my $table = eval {
+            open my $fh, '<', $cache_file or die "Cannot read $cache_file: $!";
+            my $json = do { local $/; <$fh> };
+            close $fh;
+            decode_json($json);
+        };
+        return ref $table eq 'HASH' ? $table : undef;
+    }
+
+    sub _store_table {
+        my ($self, $cache_file, $table) = @_;
+
+        my $cache_dir = $self->cache_dir;
+        make_path($cache_dir) unless -d $cache_dir;
+
+        eval {
+            my $temp_file = "$cache_file.tmp.$$";
+            open my $fh, '>', $temp_file or die "Cannot write $temp_file: $!";
+            print $fh encode_json($table);
+            close $fh;
+            rename $temp_file, $cache_file or die "Cannot rename $temp_file: $!";
+        };
+        if ($@) {
+            print "Warning: Could not save color table: $@\n";
+        }
+    }
+}
+
+1;
@@ -0,0 +1,154 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - GResource bundle reader
+# Reads compiled .gresource bundles (GVDB hash tables holding (uuay) file
+# variants) directly, so stylesheets shipped inside gtk.gresource can be
+# parsed without starting GTK or spawning glib-compile-resources tools.
+# Only the hash table, the entry names and the files looked up are read;
+# the images that make up most of a bundle are never touched.
+
+package CinnamonSettings::GResource {
+    use Moo;
+    use Compress::Zlib qw(uncompress);
+
+    # G_RESOURCE_FLAGS_COMPRESSED
+    use constant FLAG_COMPRESSED => 1;
+
+    has 'file' => (is => 'ro', required => 1);
+    has 'handle' => (is => 'rw');
+    has 'size' => (is => 'rw', default => sub { 0 });
+    has 'entries' => (is => 'rw', default => sub { {} });
+    has 'big_endian' => (is => 'rw', default => sub { 0 });
+
+    sub BUILD {
+        my $self = shift;
+        $self->_load();
+    }
+
+    # True when the bundle's hash table could be read
+    sub is_valid {
+        my $self = shift;
+        return defined $self->handle && %{$self->entries} ? 1 : 0;
+    }
+
+    # Return the contents of a resource path such as /org/gnome/theme/gtk.css
+    sub lookup {
+        my ($self, $path) = @_;
+
+        $path =~ s{^resource://}{};
+        my $entry = $self->entries->{$path};
+        return undef unless $entry && $entry->{type} eq 'v';
+
+        my ($start, $end) = @{$entry}{qw(start end)};
+        return undef if $end > $self->size || $end - $start < 8;
+
+        # The value is a 'v' variant: (uuay) body, NUL, then the type string
+        my $variant = $self->_read_at($start, $end - $start);
+        return undef unless defined $variant;
+        $variant =~ s/\0\(uuay\)\z// or return undef;
+
+        my ($size, $flags) = unpack($self->big_endian ? 'NN' : 'VV', $variant);
+        my $payload = substr($variant, 8);
+
+        if ($flags & FLAG_COMPRESSED) {
+            my $contents = uncompress($payload);
+            return defined $contents ? $contents : undef;
+        }
+
+        # Uncompressed payloads carry a trailing NUL after $size bytes
+        return substr($payload, 0, $size);
+    }
+
+    # All file paths stored in the bundle
+    sub list {
+        my $self = shift;
+        return sort grep { $self->entries->{$_}{type} eq 'v' } keys %{$self->entries};
+    }
+
+    sub _load {
+        my $self = shift;
+
+        open my $fh, '<:raw', $self->file or return;
+        $self->handle($fh);
+        $self->size(-s $fh);
+
+        my $header = $self->_read_at(0, 24);
+        return unless defined $header;
+
+        my $signature = substr($header, 0, 8);
+        if ($signature eq 'GVariant') {
+            $self->big_endian(0);
+        } elsif ($signature eq 'raVGtnai') {
+            $self->big_endian(1);
+        } else {
+            return;
+        }
+
+        my $u32 = $self->big_endian ? 'N' : 'V';
+        my $u16 = $self->big_endian ? 'n' : 'v';
+
+        my ($root_start, $root_end) = unpack("x16 ${u32}2", $header);
+        return if $root_end > $self->size || $root_end < $root_start + 8;
+
+        # The hash table: bloom filter, buckets, then 24-byte items
+        my $table = $self->_read_at($root_start, $root_end - $root_start);
+        return unless defined $table;
+
+        my ($n_bloom_words, $n_buckets) = unpack("${u32}2", $table);
+        $n_bloom_words &= (1 << 27) - 1;
+
+        my $items_start = 8 + 4 * $n_bloom_words + 4 * $n_buckets;
+        return if $items_start > length $table;
+        my $n_items = int((length($table) - $items_start) / 24);
+
+        my @items;
+        for my $i (0 .. $n_items - 1) {
+            my ($hash, $parent, $key_start, $key_size, $type, undef, $value_start, $value_end) =
+                unpack("x" . ($items_start + $i * 24) . " ${u32}3 ${u16} a a ${u32}2", $table);
+            my $key = $self->_read_at($key_start, $key_size);
+            return unless defined $key;
+            push @items, {
+                parent => $parent,
+                key => $key,
+                type => $type,
+                start => $value_start,
+                end => $value_end,
+            };
+        }
+
+        # Keys are stored relative to their parent directory entry
+        my %entries;
+        for my $i (0 .. $#items) {
+            my $name = '';
+            my ($index, $guard) = ($i, 0);
+            while ($index != 0xffffffff && $index < @items && $guard++ < 64) {
+                $name = $items[$index]{key} . $name;
+                $index = $items[$index]{parent};
+            }
+            $entries{$name} = $items[$i];
+        }
+
+        $self->entries(\%entries);
+    }
+
+    # $length bytes at $offset, or undef if the file is shorter
+    sub _read_at {
+        my ($self, $offset, $length) = @_;
+
+        return '' unless $length;
+        return undef if $offset + $length > $self->size;
+
+        my $fh = $self->handle;
+        sysseek($fh, $offset, 0) or return undef;
+        my $data = '';
+        while (length $data < $length) {
+            my $read = sysread($fh, $data, $length - length $data, length $data);
+            return undef unless $read;
+        }
+        return $data;
+    }
+}
+
+1;
@@ -0,0 +1,291 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - unified preview cache
+# Every manager keeps its previews (thumbnails, rendered theme cards,
+# extracted cursor frames) here. An entry key is built from the source's
+# identity (usually its path), a fingerprint of its content (mtime and size
+# by default) and the variant (preview size and format):
+#
+#     md5_hex("<identity>\0<fingerprint>") . "<variant>"
+#
+# so a changed source simply maps to a new key and entries never need to
+# be validated. This is also the naming of the read-only system cache
+# built at install time, which is consulted before the per-user directory.
+#
+# Decoded values live in a byte-budgeted memory tier (BudgetCache); files
+# live in a disk tier that is trimmed back to its own byte budget, least
+# recently used first (hits refresh an entry's mtime). Files are written
+# under a .part name and renamed into place, so readers never see a
+# partial entry. Hits and misses per tier are printed by report_stats()
+# when CSM_DEBUG is set.
+
+package CinnamonSettings::PreviewCache {
+    use Moo;
+    use Digest::MD5 qw(md5_hex);
+    use File::Path qw(make_path);
+    use CinnamonSettings::BudgetCache;
+    use CinnamonSettings::Trace qw(TRACING trace_instant);
+
+    has 'name' => (is => 'ro', default => sub { 'previews' });
+    # Disk tier; without one only the memory tier is used
+    has 'cache_dir' => (is => 'ro');
+    has 'memory_budget' => (is => 'ro', default => sub { 32 * 1024 * 1024 });
+    # 0 leaves the disk tier unbounded
+    has 'disk_budget' => (is => 'ro', default => sub { 256 * 1024 * 1024 });
+    # CinnamonSettings::SystemCache section checked before cache_dir
+    has 'shared' => (is => 'ro');
+    has 'memory' => (is => 'ro', lazy => 1, builder => '_build_memory');
+    # Bytes in cache_dir, counted on the first store
+    has 'disk_bytes' => (is => 'rw');
+    has 'stats' => (is => 'ro', default => sub { {
+        memory_hits => 0,
+        shared_hits => 0,
+        disk_hits => 0,
+        misses => 0,
+        stores => 0,
+        disk_evictions => 0,
+    } });
+
+    sub _build_memory {
+        my $self = shift;
+        return CinnamonSettings::BudgetCache->new(name => $self->name, budget_bytes => $self->memory_budget);
+    }
+
+    sub BUILD {
+        my $self = shift;
+        make_path($self->cache_dir) if $self->cache_dir && !-d $self->cache_dir;
+    }
+
+    # Key for a source identity, a fingerprint of its content and a variant
+    # suffix such as "-400x300.png"
+    sub key {
+        my ($class, $identity, $fingerprint, $variant) = @_;
+        return md5_hex(join("\0", $identity, $fingerprint)) . $variant;
+    }
+
+    # Key for a file fingerprinted by its mtime and size, or undef if it
+    # cannot be stat'ed
+    sub file_key {
+        my ($class, $source, $variant) = @_;
+
+        my @st = stat($source) or return undef;
+        return $class->key($source, "$st[9]\0$st[7]", $variant);
+    }
+
+    # Decoded value from the memory tier
+    sub get {
+        my ($self, $key) = @_;
+
+        unless (defined $key && $self->memory->contains($key)) {
+            # With a disk tier, lookup() counts the miss
+            $self->stats->{misses}++ unless $self->cache_dir;
+            return undef;
+        }
+        $self->stats->{memory_hits}++;
+        return $self->memory->get($key);
+    }
+
+    # Keep a decoded value in the memory tier; $bytes defaults to an estimate
+    sub put {
+        my ($self, $key, $value, $bytes) = @_;
+
+        return unless defined $key;
+        return $self->memory->set($key, $value, $bytes);
+    }
+
+    # File of an entry in the system cache or the disk tier, or undef
+    sub lookup {
+        my ($self, $key) = @_;
+
+        return undef unless defined $key;
+
+        if ($self->shared) {
+            my $shared = $self->shared->dir . "/$key";
+            if (-s $shared) {
+                $self->stats->{shared_hits}++;
+                return $shared;
+            }
+        }
+
+        my $path = $self->path_for($key);
+        if ($path && -s $path) {
+            $self->stats->{disk_hits}++;
+            utime(undef, undef, $path);
+            return $path;
+        }
+
+        $self->stats->{misses}++;
+        return undef;
+    }
+
+    # Decoded value from memory, else $loader->($file) on the cached file,
+    # kept in memory; undef on a miss
+    sub load {
+        my ($self, $key, $loader, $bytes_of) = @_;
+
+        my $value = $self->get($key);
+        return $value if defined $value;
+
+        my $path = $self->lookup($key) or return undef;
+        $value = eval { $loader->($path) };
+        unless (defined $value) {
+            # An unreadable entry is regenerated next time
+            $self->remove($key) if $path eq ($self->path_for($key) // '');
+            return undef;
+        }
+
+        $self->put($key, $value, $bytes_of ? $bytes_of->($value) : undef);
+        return $value;
+    }
+
+    # File an entry of the disk tier is (to be) stored in
+    sub path_for {
+        my ($self, $key) = @_;
+        return ($self->cache_dir && defined $key) ? $self->cache_dir . "/$key" : undef;
+    }
+
+    # Name to write an entry under before commit() renames it into place,
+    # e.g. for a helper process that writes the file itself
+    sub part_path {
+        my ($self, $key) = @_;
+        my $path = $self->path_for($key);
+        return defined $path ? "$path.part" : undef;
+    }
+
+    sub commit {
+        my ($self, $key) = @_;
+
+        my $path = $self->path_for($key) or return undef;
+        unless (-s "$path.part" && rename("$path.part", $path)) {
+            unlink("$path.part");
+            return undef;
+        }
+
+        $self->stats->{stores}++;
+        $self->_charge(-s $path);
+        return $path;
+    }
+
+    # Account for an entry a helper process has already renamed into place
+    sub adopt {
+        my ($self, $key) = @_;
+
+        my $path = $self->path_for($key) or return undef;
+        return undef unless -s $path;
+
+        $self->stats->{stores}++;
+        $self->_charge(-s $path);
+        return $path;
+    }
+
+    # Write an entry through $write->($part_path); returns the cache file
+    sub store {
+        my ($self, $key, $write) = @_;
+
+        my $part = $self->part_path($key) or return undef;
+        my $ok = eval { $write->($part) };
+        unless ($ok) {
+            unlink($part);
+            return undef;
+        }
+        return $self->commit($key);
+    }
+
+    sub store_data {
+        my ($self, $key, $data) = @_;
+
+        return $self->store($key, sub {
+            my $part = shift;
+            open my $fh, '>:raw', $part or return 0;
+            print $fh $data;
+            return close($fh);
+        });
+    }
+
+    sub store_surface {
+        my ($self, $key, $surface) = @_;
+        return $self->store($key, sub { $surface->write_to_png(shift); 1 });
+    }
+
+    sub store_pixbuf {
+        my ($self, $key, $pixbuf) = @_;
+        return $self->store($key, sub { $pixbuf->savev(shift, 'png', [], []) });
+    }
+
+    sub remove {
+        my ($self, $key) = @_;
+
+        $self->memory->remove($key);
+        my $path = $self->path_for($key);
+        unlink($path) if $path;
+    }
+
+    # Drop the memory tier, e.g. when a zoom change makes it useless
+    sub clear {
+        my $self = shift;
+        $self->memory->clear();
+    }
+
+    sub report_stats {
+        my $self = shift;
+        return unless $ENV{CSM_DEBUG};
+
+        my $stats = $self->stats;
+        my $lookups = $stats->{memory_hits} + $stats->{shared_hits} + $stats->{disk_hits} + $stats->{misses};
+        printf STDERR "[%s] %d lookups: %d memory, %d system, %d disk hits, %d misses; %d stored, %d evicted (memory %d, disk %d)\n",
+            $self->name, $lookups, @{$stats}{qw(memory_hits shared_hits disk_hits misses stores)},
+            $self->memory->evictions + $stats->{disk_evictions}, $self->memory->evictions, $stats->{disk_evictions};
+    }
+
+    sub _charge {
+        my ($self, $bytes) = @_;
+        return unless $self->disk_budget;
+
+        $self->disk_bytes($self->_scan_disk_bytes()) unless defined $self->disk_bytes;
+        $self->disk_bytes($self->disk_bytes + ($bytes || 0));
+        $self->_trim_disk() if $self->disk_bytes > $self->disk_budget;
+    }
+
+    sub _scan_disk_bytes {
+        my $self = shift;
+
+        my $dir = $self->cache_dir;
+        my $bytes = 0;
+        opendir(my $dh, $dir) or return 0;
+        $bytes += (-s "$dir/$_") || 0 for grep { !/^\./ } readdir($dh);
+        closedir($dh);
+        return $bytes;
+    }
+
+    # Delete least recently used files down to 90% of the budget, so a
+    # full cache is not trimmed again on every store
+    sub _trim_disk {
+        my $self = shift;
+
+        my $dir = $self->cache_dir;
+        opendir(my $dh, $dir) or return;
+        my @entries = map { my @st = stat("$dir/$_"); @st ? [$_, $st[9], $st[7]] : () }
+            grep { !/^\./ && !/\.part$/ } readdir($dh);
+        closedir($dh);
+
+        my $bytes = 0;
+        $bytes += $_->[2] for @entries;
+        my $target = int($self->disk_budget * 0.9);
+        my $dropped = 0;
+
+        foreach my $entry (sort { $a->[1] <=> $b->[1] } @entries) {
+            last if $bytes <= $target;
+            unlink("$dir/$entry->[0]") or next;
+            $bytes -= $entry->[2];
+            $dropped++;
+        }
+
+        $self->disk_bytes($bytes);
+        $self->stats->{disk_evictions} += $dropped;
+        trace_instant('cache evict', cache => $self->name, entries => $dropped, bytes => $bytes) if TRACING && $dropped;
+    }
+}
+
+1;
@@ -0,0 +1,282 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - preview daemon client
+# Managers hand thumbnail and cursor frame requests to the session's
+# CinnamonSettings::PreviewDaemon, starting it on first use. Replies arrive
+# on the GTK main loop and carry an ARGB32 buffer from the daemon's hot
+# cache. request() returns undef when no daemon can be reached (no
+# XDG_RUNTIME_DIR, CSM_PREVIEW_DAEMON=0, it is still starting or it failed
+# to start), and a request the daemon could not serve completes with undef,
+# so callers always keep their in-process path as the fallback.
+
+package CinnamonSettings::PreviewClient {
+    use Moo;
+    use IO::Socket::UNIX;
+    use Socket qw(SOCK_STREAM);
+    use POSIX qw(_exit setsid EAGAIN);
+    use Time::HiRes qw(time);
+    use File::Basename qw(dirname);
+    use Glib 'TRUE', 'FALSE';
+    use CinnamonSettings::Scheduler;
+    use CinnamonSettings::PreviewDaemon;
+
+    has 'socket' => (is => 'rw');
+    has 'watch_id' => (is => 'rw');
+    has 'input' => (is => 'rw', default => sub { '' });
+    # Request lines the daemon has not taken yet, sent from an 'out' watch
+    has 'output' => (is => 'rw', default => sub { '' });
+    has 'write_id' => (is => 'rw');
+    has 'next_id' => (is => 'rw', default => sub { 1 });
+    # id => { on_done, token }
+    has 'requests' => (is => 'ro', default => sub { {} });
+    has 'disabled' => (is => 'ro', default => sub {
+        defined $ENV{CSM_PREVIEW_DAEMON} && !$ENV{CSM_PREVIEW_DAEMON}
+    });
+    # While a started daemon comes up, requests fall back to the callers'
+    # in-process paths instead of waiting for it
+    has 'starting_until' => (is => 'rw', default => sub { 0 });
+    # After a failed start the daemon is not tried again for a while
+    has 'retry_after' => (is => 'rw', default => sub { 0 });
+    has 'stats' => (is => 'ro', default => sub { {
+        requests => 0,
+        done => 0,
+        failed => 0,
+    } });
+
+    # Submit a job; on_done->($argb32_data) runs from the main loop, with
+    # undef if the daemon failed. Requests whose Scheduler token has been
+    # cancelled complete silently. Returns the request id, or undef if the
+    # daemon is unavailable and on_done will never be called.
+    sub request {
+        my ($self, %args) = @_;
+
+        my @fields = (
+            $args{priority} // CinnamonSettings::Scheduler::PRIORITY_NORMAL,
+            $args{kind},
+            $args{source},
+            $args{width},
+            $args{height} // $args{width},
+            $args{cache_dir} // '',
+            $args{section} // '',
+        );
+        return undef if grep { !defined $_ || /[\t\n]/ } @fields;
+
+        $self->_connect() or return undef;
+
+        my $id = $self->next_id;
+        $self->next_id($id + 1);
+        $self->_send(join("\t", $id, @fields) . "\n") or return undef;
+
+        $self->requests->{$id} = { on_done => $args{on_done}, token => $args{token} };
+        $self->stats->{requests}++;
+        return $id;
+    }
+
+    sub cancel {
+        my ($self, $id) = @_;
+
+        delete $self->requests->{$id} or return;
+        $self->_send("cancel\t$id\n");
+    }
+
+    # Cancel every outstanding request made with a Scheduler token
+    sub cancel_token {
+        my ($self, $token) = @_;
+        return unless $token;
+
+        foreach my $id (keys %{$self->requests}) {
+            my $token_of = $self->requests->{$id}{token};
+            $self->cancel($id) if $token_of && $token_of == $token;
+        }
+    }
+
+    # Read a reply buffer; it may have been evicted since the reply
+    sub read_buffer {
+        my ($class, $buffer) = @_;
+
+        open(my $fh, '<:raw', $buffer) or return undef;
+        my $data = do { local $/; <$fh> };
+        close($fh);
+        return $data;
+    }
+
+    # Pixbuf of an ARGB32 buffer, e.g. for a Gtk3::Image
+    sub pixbuf_from_argb32 {
+        my ($class, $data) = @_;
+
+        return undef unless defined $data && $data =~ /\AARGB32 (\d+) (\d+) (\d+)\n/;
+        my ($width, $height, $stride) = ($1, $2, $3);
+        my $pixels = substr($data, $+[0]);
+        return undef unless $width && $height && length($pixels) == $stride * $height;
+
+        my $surface = Cairo::ImageSurface->create_for_data($pixels, 'argb32', $width, $height, $stride);
+        return Gtk3::Gdk::pixbuf_get_from_surface($surface, 0, 0, $width, $height);
+    }
+
+    sub report_stats {
+        my $self = shift;
+        return unless $ENV{CSM_DEBUG};
+
+        my $stats = $self->stats;
+        printf STDERR "[preview daemon] %d requests: %d done, %d failed\n", @{$stats}{qw(requests done failed)};
+    }
+
+    sub _connect {
+        my $self = shift;
+
+        return $self->socket if $self->socket;
+        return undef if $self->disabled || time() < $self->retry_after;
+
+        # Connecting to a listening socket never blocks, so this costs one
+        # failed connect() per request while the daemon is starting
+        my $path = CinnamonSettings::PreviewDaemon->socket_path() or return undef;
+        my $socket = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $path);
+
+        unless ($socket) {
+            if (!$self->starting_until) {
+                $self->_start_daemon();
+                $self->starting_until(time() + 5);
+            } elsif (time() > $self->starting_until) {
+                print "Preview daemon unavailable; generating previews in-process\n";
+                $self->starting_until(0);
+                $self->retry_after(time() + 30);
+            }
+            return undef;
+        }
+        $self->starting_until(0);
+
+        # Non-blocking, so a spurious watch wakeup cannot stall the main loop
+        $socket->blocking(0);
+        $self->socket($socket);
+        $self->input('');
+        $self->output('');
+        $self->watch_id(Glib::IO->add_watch(fileno($socket), ['in', 'hup', 'err'], sub {
+            # A disconnect from inside the watch ends it by returning FALSE
+            my $watch_id = $self->watch_id;
+            $self->watch_id(undef);
+            $self->_read();
+            return FALSE unless $self->socket;
+            $self->watch_id($watch_id);
+            return TRUE;
+        }));
+        return $socket;
+    }
+
+    sub _start_daemon {
+        my $self = shift;
+
+        my $lib_dir = dirname(dirname($INC{'CinnamonSettings/PreviewClient.pm'}));
+        my $pid = fork();
+        return 0 unless defined $pid;
+
+        if ($pid == 0) {
+            # Detach twice so the daemon outlives this manager and is never
+            # left as its zombie
+            setsid();
+            my $daemon = fork();
+            _exit(1) unless defined $daemon;
+            _exit(0) if $daemon;
+
+            chdir('/');
+            open(STDIN, '<', '/dev/null');
+            unless ($ENV{CSM_DEBUG}) {
+                open(STDOUT, '>', '/dev/null');
+                open(STDERR, '>', '/dev/null');
+            }
+            { exec($^X, "-I$lib_dir", '-MCinnamonSettings::PreviewDaemon', '-e',
+                'exit CinnamonSettings::PreviewDaemon->new()->run()') }
+            _exit(1);
+        }
+
+        waitpid($pid, 0);
+        return 1;
+    }
+
+    # Queue a line for the daemon; returns false if the daemon has gone
+    sub _send {
+        my ($self, $line) = @_;
+
+        $self->socket or return 0;
+        $self->output($self->output . $line);
+        return $self->_flush();
+    }
+
+    # Write as much queued output as the socket takes. A full socket only
+    # means the daemon has not read yet, so the rest waits for an 'out'
+    # watch, as in the daemon's own _flush.
+    sub _flush {
+        my $self = shift;
+
+        my $socket = $self->socket or return 0;
+        my $output = $self->output;
+
+        local $SIG{PIPE} = 'IGNORE';
+        while (length $output) {
+            my $written = syswrite($socket, $output);
+            unless (defined $written) {
+                last if $! == EAGAIN;
+                $self->_disconnect();
+                return 0;
+            }
+            substr($output, 0, $written, '');
+        }
+        $self->output($output);
+
+        if (length $output && !$self->write_id) {
+            $self->write_id(Glib::IO->add_watch(fileno($socket), ['out', 'hup', 'err'], sub {
+                $self->write_id(undef);
+                $self->_flush();
+                # _flush adds a new watch while output is left
+                return FALSE;
+            }));
+        }
+        return 1;
+    }
+
+    sub _read {
+        my $self = shift;
+
+        my $socket = $self->socket or return;
+        my $input = $self->input;
+        my $read = sysread($socket, $input, 65536, length $input);
+        return if !defined $read && $! == EAGAIN;
+        return $self->_disconnect() unless $read;
+
+        while ($input =~ s/\A([^\n]*)\n//) {
+            my ($id, $status, $detail) = split /\t/, $1, 3;
+            my $data = $status eq 'done' ? $self->read_buffer($detail) : undef;
+            $self->_complete($id, $data);
+        }
+        $self->input($input);
+    }
+
+    sub _complete {
+        my ($self, $id, $data) = @_;
+
+        my $request = delete $self->requests->{$id} or return;
+        $self->stats->{defined $data ? 'done' : 'failed'}++;
+        return if $request->{token} && $request->{token}->cancelled;
+        $request->{on_done}->($data) if $request->{on_done};
+    }
+
+    # The daemon went away (idle exit racing a request, crash): outstanding
+    # requests fail over to the callers' in-process paths and the next
+    # request starts a new daemon
+    sub _disconnect {
+        my $self = shift;
+
+        Glib::Source->remove($self->watch_id) if $self->watch_id;
+        Glib::Source->remove($self->write_id) if $self->write_id;
+        close($self->socket) if $self->socket;
+        $self->socket(undef);
+        $self->watch_id(undef);
+        $self->write_id(undef);
+        $self->output('');
+
+        $self->_complete($_, undef) for sort { $a <=> $b } keys %{$self->requests};
+    }
+}
+
+1;
@@ -0,0 +1,521 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - per-session preview daemon
+# One daemon per login session scales wallpaper and theme thumbnails and
+# extracts cursor frames for every manager, so a manager opened right after
+# another starts warm and two open managers share one worker pool instead of
+# competing for cores. It listens on
+# $XDG_RUNTIME_DIR/cinnamon-settings-manager/previews.sock, is started by the
+# first CinnamonSettings::PreviewClient that finds nothing listening, and
+# exits once it has had no clients and no work for idle_timeout seconds.
+#
+# Requests carry a Scheduler priority and are merged by PreviewCache key
+# across clients. Results are ARGB32 buffers (the xcursor_extractor --argb32
+# layout) in the runtime directory, which is memory backed: only the buffer's
+# path crosses the socket, and clients read the file in one go and wrap the
+# pixels in a Cairo surface without decoding a PNG. These buffers are the
+# hot cache, held to hot_budget bytes, least recently used first. Workers
+# read and fill the disk tier of the client's own PreviewCache directory,
+# so entries outlive the daemon.
+#
+# Protocol, one tab separated line per message:
+#   client: <id> <priority> <kind> <source> <width> <height> <cache_dir> <section>
+#           cancel <id>
+#   daemon: <id> done <buffer file>
+#           <id> failed <reason>
+
+package CinnamonSettings::PreviewDaemon {
+    use Moo;
+    use Fcntl qw(:flock);
+    use File::Path qw(make_path remove_tree);
+    use IO::Select;
+    use IO::Socket::UNIX;
+    use Socket qw(SOCK_STREAM);
+    use POSIX qw(_exit EAGAIN);
+    use Time::HiRes qw(time);
+    use Gtk3;
+    use Cairo;
+    use CinnamonSettings::BudgetCache;
+    use CinnamonSettings::PreviewCache;
+    use CinnamonSettings::SystemCache;
+    use CinnamonSettings::Prewarm;
+    use CinnamonSettings::Trace qw(TRACING trace_span);
+
+    has 'runtime_dir' => (is => 'ro', default => sub { session_dir() });
+    has 'idle_timeout' => (is => 'ro', default => sub { $ENV{CSM_PREVIEW_DAEMON_IDLE} || 60 });
+    has 'worker_count' => (is => 'ro', default => sub { CinnamonSettings::Prewarm::cpu_count() });
+    has 'hot_budget' => (is => 'ro', default => sub { 128 * 1024 * 1024 });
+    has 'hot' => (is => 'ro', lazy => 1, builder => '_build_hot');
+    has 'listener' => (is => 'rw');
+    has 'readers' => (is => 'ro', default => sub { IO::Select->new() });
+    has 'writers' => (is => 'ro', default => sub { IO::Select->new() });
+    # fileno => { socket, input, output, requests => { id => key } }
+    has 'clients' => (is => 'ro', default => sub { {} });
+    # fileno of the result pipe => { pid, to, from, input, job }
+    has 'workers' => (is => 'ro', default => sub { {} });
+    # key => { kind, source, width, height, cache_dir, section, priority, waiters, worker }
+    has 'pending' => (is => 'ro', default => sub { {} });
+    has 'queues' => (is => 'ro', default => sub { [[], [], []] });
+    has 'last_active' => (is => 'rw', default => sub { time() });
+    has 'stopping' => (is => 'rw', default => sub { 0 });
+    has 'stats' => (is => 'ro', default => sub { {
+        requests => 0,
+        hot_hits => 0,
+        merged => 0,
+        done => 0,
+        failed => 0,
+    } });
+
+    sub _build_hot {
+        my $self = shift;
+        return CinnamonSettings::BudgetCache->new(
+            name => 'preview buffers',
+            budget_bytes => $self->hot_budget,
+            on_evict => sub { unlink($_[1]) },
+        );
+    }
+
+    # Session runtime directory, or undef without XDG_RUNTIME_DIR (the
+    # managers then do all the work in-process)
+    sub session_dir {
+        return $ENV{XDG_RUNTIME_DIR} ? "$ENV{XDG_RUNTIME_DIR}/cinnamon-settings-manager" : undef;
+    }
+
+    # Also callable as a class method, for clients
+    sub socket_path {
+        my $self = shift;
+
+        my $dir = ref $self ? $self->runtime_dir : session_dir();
+        return defined $dir ? "$dir/previews.sock" : undef;
+    }
+
+    # PreviewCache variant of a request, shared with the managers' own keys
+    sub variant {
+        my ($class, $kind, $width, $height) = @_;
+        return $kind eq 'cursor' ? "_${width}.argb32" : "-${width}x${height}.png";
+    }
+
+    sub buffer_dir {
+        my $self = shift;
+        return $self->runtime_dir . '/buffers';
+    }
+
+    sub run {
+        my $self = shift;
+
+        my $dir = $self->runtime_dir or die "XDG_RUNTIME_DIR is not set\n";
+        make_path($self->buffer_dir, { mode => 0700 });
+        chmod(0700, $dir);
+
+        # Two managers starting at once may both launch a daemon; the one
+        # that does not get the lock leaves quietly. The holder records its
+        # pid there, so it can be stopped from outside its session.
+        open(my $lock, '>>', "$dir/daemon.lock") or die "Cannot open $dir/daemon.lock: $!\n";
+        return 0 unless flock($lock, LOCK_EX | LOCK_NB);
+        truncate($lock, 0);
+        $lock->autoflush(1);
+        print $lock "$$\n";
+
+        unlink($self->socket_path);
+        my $listener = IO::Socket::UNIX->new(Type => SOCK_STREAM, Local => $self->socket_path, Listen => 16)
+            or die "Cannot listen on " . $self->socket_path . ": $!\n";
+        $self->listener($listener);
+        $self->readers->add($listener);
+
+        local $SIG{PIPE} = 'IGNORE';
+        local $SIG{TERM} = local $SIG{INT} = sub { $self->stopping(1) };
+
+        $self->_start_worker() for 1 .. $self->worker_count;
+        $self->_log("listening on " . $self->socket_path . " with " . $self->worker_count . " workers");
+
+        until ($self->stopping) {
+            my ($readable, $writable) = IO::Select->select($self->readers, $self->writers, undef, 1);
+
+            foreach my $fh (@{$writable || []}) {
+                my $client = $self->clients->{fileno($fh)} or next;
+                $self->_flush($client);
+            }
+            foreach my $fh (@{$readable || []}) {
+                if ($fh == $listener) {
+                    $self->_accept();
+                } elsif (my $worker = $self->workers->{fileno($fh)}) {
+                    $self->_read_worker($worker);
+                } elsif (my $client = $self->clients->{fileno($fh)}) {
+                    $self->_read_client($client);
+                }
+            }
+
+            $self->_dispatch();
+            last if $self->_idle_expired();
+        }
+
+        $self->_shutdown();
+        return 0;
+    }
+
+    sub _idle_expired {
+        my $self = shift;
+
+        if (%{$self->clients} || %{$self->pending}) {
+            $self->last_active(time());
+            return 0;
+        }
+        return time() - $self->last_active > $self->idle_timeout;
+    }
+
+    sub _shutdown {
+        my $self = shift;
+
+        # Stop listening first so new clients start a fresh daemon
+        unlink($self->socket_path);
+        close($self->listener);
+
+        $self->_drop_client($_) for values %{$self->clients};
+        foreach my $worker (values %{$self->workers}) {
+            close($worker->{to});
+            close($worker->{from});
+            waitpid($worker->{pid}, 0);
+        }
+        remove_tree($self->buffer_dir);
+
+        my $stats = $self->stats;
+        $self->_log(sprintf "exiting: %d requests, %d hot hits, %d merged, %d done, %d failed, %d evicted",
+            @{$stats}{qw(requests hot_hits merged done failed)}, $self->hot->evictions);
+    }
+
+    sub _log {
+        my ($self, $message) = @_;
+        print STDERR "[cinnamon-preview-daemon] $message\n" if $ENV{CSM_DEBUG};
+    }
+
+    # Clients
+
+    sub _accept {
+        my $self = shift;
+
+        my $socket = $self->listener->accept() or return;
+        $socket->blocking(0);
+        $self->clients->{fileno($socket)} = { socket => $socket, input => '', output => '', requests => {} };
+        $self->readers->add($socket);
+    }
+
+    sub _read_client {
+        my ($self, $client) = @_;
+
+        my $read = sysread($client->{socket}, $client->{input}, 65536, length $client->{input});
+        return if !defined $read && $! == EAGAIN;
+        return $self->_drop_client($client) unless $read;
+
+        while ($client->{input} =~ s/\A([^\n]*)\n//) {
+            $self->_handle_line($client, $1);
+        }
+    }
+
+    sub _handle_line {
+        my ($self, $client, $line) = @_;
+
+        my @fields = split /\t/, $line, -1;
+        return $self->_cancel($client, $fields[1]) if $fields[0] eq 'cancel';
+
+        my ($id, $priority, $kind, $source, $width, $height, $cache_dir, $section) = @fields;
+        return unless defined $section;
+        return $self->_reply($client, $id, 'failed', 'bad request')
+            unless $kind =~ /^(?:thumbnail|cursor)$/ && $priority =~ /^[012]$/
+                && $width =~ /^[1-9]\d*$/ && $height =~ /^[1-9]\d*$/;
+
+        $self->stats->{requests}++;
+        my $key = CinnamonSettings::PreviewCache->file_key($source, $self->variant($kind, $width, $height));
+        return $self->_reply($client, $id, 'failed', 'cannot stat source') unless defined $key;
+
+        my $buffer = $self->hot->get($key);
+        if ($buffer && -e $buffer) {
+            $self->stats->{hot_hits}++;
+            return $self->_reply($client, $id, 'done', $buffer);
+        }
+
+        # A request for something already queued or running waits for it
+        my $job = $self->pending->{$key};
+        if ($job) {
+            $self->stats->{merged}++;
+        } else {
+            $job = $self->pending->{$key} = {
+                kind => $kind,
+                source => $source,
+                width => $width,
+                height => $height,
+                cache_dir => $cache_dir,
+                section => $section,
+                priority => scalar @{$self->queues},
+                waiters => [],
+            };
+        }
+
+        push @{$job->{waiters}}, [$client, $id];
+        $client->{requests}{$id} = $key;
+
+        # Queue entries left at a lower priority are skipped when taken
+        if ($priority < $job->{priority}) {
+            $job->{priority} = $priority;
+            push @{$self->queues->[$priority]}, $key unless $job->{worker};
+        }
+    }
+
+    sub _cancel {
+        my ($self, $client, $id) = @_;
+
+        my $key = delete $client->{requests}{$id} // return;
+        my $job = $self->pending->{$key} or return;
+
+        $job->{waiters} = [grep { $_->[0] != $client || $_->[1] ne $id } @{$job->{waiters}}];
+
+        # A running job still finishes into the hot cache
+        delete $self->pending->{$key} unless @{$job->{waiters}} || $job->{worker};
+    }
+
+    sub _drop_client {
+        my ($self, $client) = @_;
+
+        $self->_cancel($client, $_) for keys %{$client->{requests}};
+        $self->readers->remove($client->{socket});
+        $self->writers->remove($client->{socket});
+        delete $self->clients->{fileno($client->{socket})};
+        close($client->{socket});
+    }
+
+    sub _reply {
+        my ($self, $client, $id, $status, $detail) = @_;
+
+        delete $client->{requests}{$id};
+        $detail =~ s/[\t\n]+/ /g;
+        $client->{output} .= "$id\t$status\t$detail\n";
+        $self->_flush($client);
+    }
+
+    sub _flush {
+        my ($self, $client) = @_;
+
+        while (length $client->{output}) {
+            my $written = syswrite($client->{socket}, $client->{output});
+            unless (defined $written) {
+                last if $! == EAGAIN;
+                return $self->_drop_client($client);
+            }
+            substr($client->{output}, 0, $written, '');
+        }
+
+        # A client that is slow to read gets the rest when it can take it
+        if (length $client->{output}) {
+            $self->writers->add($client->{socket});
+        } else {
+            $self->writers->remove($client->{socket});
+        }
+    }
+
+    # Worker pool
+
+    sub _start_worker {
+        my $self = shift;
+
+        pipe(my $job_reader, my $job_writer) or die "Cannot create pipe: $!\n";
+        pipe(my $result_reader, my $result_writer) or die "Cannot create pipe: $!\n";
+
+        my $pid = fork();
+        die "Cannot fork: $!\n" unless defined $pid;
+        if ($pid == 0) {
+            close($job_writer);
+            close($result_reader);
+            close($self->listener);
+            close($_->{socket}) for values %{$self->clients};
+            close($_->{to}), close($_->{from}) for values %{$self->workers};
+
+            $result_writer->autoflush(1);
+            $self->_worker_loop($job_reader, $result_writer);
+            _exit(0);
+        }
+
+        close($job_reader);
+        close($result_writer);
+        $job_writer->autoflush(1);
+
+        $self->workers->{fileno($result_reader)} = {
+            pid => $pid,
+            to => $job_writer,
+            from => $result_reader,
+            input => '',
+            job => undef,
+        };
+        $self->readers->add($result_reader);
+    }
+
+    sub _dispatch {
+        my $self = shift;
+
+        foreach my $worker (grep { !$_->{job} } values %{$self->workers}) {
+            my ($key, $job) = $self->_next_job() or last;
+
+            $job->{worker} = $worker;
+            $worker->{job} = $key;
+            print {$worker->{to}} join("\t", $key, @{$job}{qw(kind source width height cache_dir section)},
+                $self->buffer_dir . "/$key") . "\n";
+        }
+    }
+
+    sub _next_job {
+        my $self = shift;
+
+        foreach my $level (0 .. $#{$self->queues}) {
+            my $queue = $self->queues->[$level];
+            while (defined(my $key = shift @$queue)) {
+                my $job = $self->pending->{$key} or next;
+                next if $job->{worker} || $job->{priority} != $level;
+                return ($key, $job);
+            }
+        }
+        return;
+    }
+
+    sub _read_worker {
+        my ($self, $worker) = @_;
+
+        my $read = sysread($worker->{from}, $worker->{input}, 4096, length $worker->{input});
+        return $self->_restart_worker($worker) unless $read;
+
+        while ($worker->{input} =~ s/\A([^\n]*)\n//) {
+            my ($key, $status, $detail) = split /\t/, $1, 3;
+            $worker->{job} = undef;
+            $self->_finish_job($key, $status eq 'ok', $detail);
+        }
+    }
+
+    # A worker that crashed fails its job and is replaced
+    sub _restart_worker {
+        my ($self, $worker) = @_;
+
+        $self->readers->remove($worker->{from});
+        delete $self->workers->{fileno($worker->{from})};
+        close($worker->{to});
+        close($worker->{from});
+        waitpid($worker->{pid}, 0);
+
+        $self->_finish_job($worker->{job}, 0, 'worker exited') if $worker->{job};
+        $self->_start_worker() unless $self->stopping;
+    }
+
+    sub _finish_job {
+        my ($self, $key, $success, $detail) = @_;
+
+        my $job = delete $self->pending->{$key} or return;
+        my $buffer = $self->buffer_dir . "/$key";
+
+        if ($success && -s $buffer) {
+            $self->stats->{done}++;
+            $self->hot->set($key, $buffer, -s $buffer);
+        } else {
+            $self->stats->{failed}++;
+            $success = 0;
+        }
+
+        # Clients that went away were already removed from the waiters
+        foreach my $waiter (@{$job->{waiters}}) {
+            my ($client, $id) = @$waiter;
+            $self->_reply($client, $id, $success ? ('done', $buffer) : ('failed', $detail || 'no preview'));
+        }
+    }
+
+    # Runs in a worker process: one job line in, one result line out
+    sub _worker_loop {
+        my ($self, $jobs, $results) = @_;
+
+        my %caches;
+        while (my $line = <$jobs>) {
+            chomp $line;
+            my ($key, $kind, $source, $width, $height, $cache_dir, $section, $buffer) = split /\t/, $line, -1;
+            next unless defined $buffer;
+
+            my $span = TRACING && trace_span('daemon job', kind => $kind, source => $source);
+
+            # The manager's disk tier, behind the system cache
+            my $cache = $caches{"$cache_dir\t$section"} ||= CinnamonSettings::PreviewCache->new(
+                name => 'daemon',
+                cache_dir => length $cache_dir ? $cache_dir : undef,
+                shared => length $section ? CinnamonSettings::SystemCache->new(section => $section) : undef,
+            );
+
+            my $data = eval {
+                $kind eq 'cursor'
+                    ? $self->_cursor_buffer($cache, $key, $source, $width)
+                    : $self->_thumbnail_buffer($cache, $key, $source, $width, $height);
+            };
+            (my $error = $@ || 'no preview') =~ s/\s+/ /g;
+
+            if (defined $data && _write_buffer($buffer, $data)) {
+                print $results "$key\tok\t\n";
+            } else {
+                print $results "$key\tfailed\t$error\n";
+            }
+        }
+    }
+
+    sub _write_buffer {
+        my ($buffer, $data) = @_;
+
+        open(my $fh, '>:raw', "$buffer.part") or return 0;
+        print $fh $data;
+        unless (close($fh) && rename("$buffer.part", $buffer)) {
+            unlink("$buffer.part");
+            return 0;
+        }
+        return 1;
+    }
+
+    sub _thumbnail_buffer {
+        my ($self, $cache, $key, $source, $width, $height) = @_;
+
+        my $cached = $cache->lookup($key);
+        my $pixbuf = $cached && eval { Gtk3::Gdk::Pixbuf->new_from_file($cached) };
+        unless ($pixbuf) {
+            $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale($source, $width, $height, 1);
+            $cache->store_pixbuf($key, $pixbuf) if $cache->cache_dir;
+        }
+
+        my ($w, $h) = ($pixbuf->get_width(), $pixbuf->get_height());
+        my $surface = Cairo::ImageSurface->create('argb32', $w, $h);
+        my $cr = Cairo::Context->create($surface);
+        Gtk3::Gdk::cairo_set_source_pixbuf($cr, $pixbuf, 0, 0);
+        $cr->paint();
+        $surface->flush();
+
+        return "ARGB32 $w $h " . $surface->get_stride() . "\n" . $surface->get_data();
+    }
+
+    sub _cursor_buffer {
+        my ($self, $cache, $key, $source, $size) = @_;
+
+        if (my $cached = $cache->lookup($key)) {
+            open(my $fh, '<:raw', $cached) or die "Cannot read $cached: $!\n";
+            my $data = do { local $/; <$fh> };
+            return $data if defined $data && $data =~ /\AARGB32 /;
+        }
+
+        my $extractor = _find_extractor() or die "xcursor_extractor not found\n";
+        open(my $fh, '-|:raw', $extractor, '--argb32', $source, $size) or die "Cannot run $extractor: $!\n";
+        my $data = do { local $/; <$fh> };
+        close($fh) or die "xcursor_extractor failed on $source\n";
+        die "xcursor_extractor returned no frame\n" unless defined $data && $data =~ /\AARGB32 /;
+
+        $cache->store_data($key, $data) if $cache->cache_dir;
+        return $data;
+    }
+
+    # Installed next to the managers, or anywhere on PATH
+    sub _find_extractor {
+        foreach my $dir ("$ENV{HOME}/.local/bin", split(/:/, $ENV{PATH} || '')) {
+            return "$dir/xcursor_extractor" if length $dir && -x "$dir/xcursor_extractor";
+        }
+        return undef;
+    }
+}
+
+1;
@@ -0,0 +1,112 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - headless cache prewarming
+# "<manager> --prewarm [dirs...]" runs a manager's scan, index and preview
+# pipelines without creating any windows, so the GUI opens with warm disk
+# caches (from a login hook or after theme packages are installed). The
+# manager collects one job per preview; they are spread over one forked
+# worker per CPU at idle CPU and I/O priority, with a progress line per job
+# and a summary at the end.
+
+package CinnamonSettings::Prewarm {
+    use Moo;
+    use POSIX qw(_exit);
+    use Time::HiRes qw(time);
+
+    has 'app_name' => (is => 'ro', required => 1);
+    has 'workers' => (is => 'ro', default => sub { cpu_count() });
+    has 'jobs' => (is => 'ro', default => sub { [] });
+    has 'stats' => (is => 'ro', default => sub { {} });
+    has 'started' => (is => 'ro', default => sub { time() });
+
+    sub cpu_count {
+        my $count = `getconf _NPROCESSORS_ONLN 2>/dev/null`;
+        return ($count && $count =~ /^(\d+)/ && $1 > 0) ? $1 : 1;
+    }
+
+    # Nice 19 and the idle I/O class, so a login hook does not compete
+    # with the desktop starting up; inherited by workers and helpers
+    sub lower_priority {
+        my $self = shift;
+
+        setpriority(0, 0, 19);
+        system("ionice -c 3 -p $$ >/dev/null 2>&1");
+    }
+
+    # Queue $run, which returns 'created', 'current' or 'failed'; it runs
+    # in a worker process, so it must not rely on changing in-memory state
+    sub add {
+        my ($self, $label, $run) = @_;
+        push @{$self->jobs}, { label => $label, run => $run };
+    }
+
+    # Record work done in the main process (e.g. index updates)
+    sub count {
+        my ($self, $what, $amount) = @_;
+        $self->stats->{$what} += $amount // 1;
+    }
+
+    sub note {
+        my ($self, $message) = @_;
+        print "[" . $self->app_name . "] $message\n";
+    }
+
+    # Run the queued jobs and print the summary; returns the exit code,
+    # 1 if any job failed
+    sub run {
+        my $self = shift;
+
+        my @jobs = @{$self->jobs};
+        my $workers = $self->workers < @jobs ? $self->workers : scalar @jobs;
+        $self->note(@jobs . " previews to check with $workers workers") if @jobs;
+
+        # Every worker takes every Nth job and reports one line per job;
+        # lines shorter than PIPE_BUF arrive whole
+        pipe(my $from_workers, my $to_parent) or die "Cannot create pipe: $!\n";
+        my @pids;
+        foreach my $worker (0 .. $workers - 1) {
+            my $pid = fork();
+            die "Cannot fork: $!\n" unless defined $pid;
+            if ($pid == 0) {
+                close $from_workers;
+                $to_parent->autoflush(1);
+                for (my $i = $worker; $i < @jobs; $i += $workers) {
+                    my $result = eval { $jobs[$i]{run}->() } || 'failed';
+                    (my $error = $@) =~ s/\s+/ /g;
+                    $error =~ s/ $//;
+                    print $to_parent "$result\t$i\t$error\n";
+                }
+                close $to_parent;
+                _exit(0);
+            }
+            push @pids, $pid;
+        }
+        close $to_parent;
+
+        my $done = 0;
+        while (my $line = <$from_workers>) {
+            chomp $line;
+            my ($result, $i, $error) = split /\t/, $line, 3;
+            $done++;
+            $self->count($result);
+            printf "[%s] [%d/%d] %s: %s%s\n", $self->app_name, $done, scalar @jobs, $jobs[$i]{label}, $result,
+                length $error ? " ($error)" : '';
+        }
+        close $from_workers;
+        waitpid($_, 0) foreach @pids;
+
+        # Jobs of a crashed worker never reported back
+        $self->count('failed', @jobs - $done) if $done < @jobs;
+
+        my $stats = $self->stats;
+        $self->note(sprintf "done in %.1fs: %s", time() - $self->started,
+            join(', ', map { ($stats->{$_} || 0) . " $_" } 'created', 'current', 'failed',
+                grep { !/^(created|current|failed)$/ } sort keys %$stats));
+
+        return $stats->{failed} ? 1 : 0;
+    }
+}
+
+1;
@@ -0,0 +1,176 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - frame-budgeted cooperative scheduler
+# Long jobs (creating widgets, scanning directories, loading previews) are
+# queued as tasks whose step callback does one small unit of work. A single
+# idle callback runs steps from the highest priority queue until the frame
+# budget, measured on the monotonic clock, is used up and then yields back
+# to GTK so input and redraws are never starved, however fast the machine.
+
+package CinnamonSettings::Scheduler::Token {
+    use Moo;
+
+    has 'cancelled' => (is => 'rw', default => sub { 0 });
+
+    sub cancel { $_[0]->cancelled(1) }
+}
+
+package CinnamonSettings::Scheduler {
+    use Moo;
+    use Time::HiRes qw(clock_gettime CLOCK_MONOTONIC);
+    use Glib 'TRUE', 'FALSE';
+    use CinnamonSettings::Trace qw(TRACING trace_span);
+
+    use constant {
+        PRIORITY_HIGH   => 0,  # Work the user is looking at right now
+        PRIORITY_NORMAL => 1,  # Filling in the current view
+        PRIORITY_LOW    => 2,  # Revalidation, cache housekeeping
+    };
+
+    has 'budget_ms' => (is => 'rw', default => sub { 6 });
+    has 'queues' => (is => 'rw', default => sub { [[], [], []] });
+    has 'idle_id' => (is => 'rw');
+    has 'current_label' => (is => 'rw');
+
+    sub new_token {
+        return CinnamonSettings::Scheduler::Token->new();
+    }
+
+    # Queue a task. step->() does one unit of work and returns true while
+    # there is more to do; on_done->() runs once it returns false. Tasks
+    # whose token has been cancelled are dropped without calling on_done.
+    sub add_task {
+        my ($self, %args) = @_;
+
+        my $priority = defined $args{priority} ? $args{priority} : PRIORITY_NORMAL;
+        my $task = {
+            label   => $args{label} || 'task',
+            step    => $args{step},
+            on_done => $args{on_done},
+            token   => $args{token},
+        };
+
+        push @{$self->queues->[$priority]}, $task;
+        $self->_ensure_running();
+
+        return $task;
+    }
+
+    # Convenience wrapper: call each->($item, $index) for every item, one
+    # item per step
+    sub foreach_item {
+        my ($self, %args) = @_;
+
+        my @items = @{$args{items} || []};
+        my $index = 0;
+
+        return $self->add_task(
+            %args,
+            step => sub {
+                return FALSE if $index >= @items;
+                $args{each}->($items[$index], $index);
+                $index++;
+                return $index < @items;
+            },
+        );
+    }
+
+    # Run a callback once from the scheduler, e.g. after the current view
+    # has been populated
+    sub defer {
+        my ($self, %args) = @_;
+
+        my $callback = $args{run};
+        return $self->add_task(%args, step => sub { $callback->(); return FALSE });
+    }
+
+    # Drop every queued task that carries $token
+    sub cancel {
+        my ($self, $token) = @_;
+        return unless $token;
+
+        $token->cancel();
+        foreach my $queue (@{$self->queues}) {
+            @$queue = grep { !$_->{token} || $_->{token} != $token } @$queue;
+        }
+    }
+
+    sub pending {
+        my $self = shift;
+        my $count = 0;
+        $count += @$_ for @{$self->queues};
+        return $count;
+    }
+
+    sub _now_ms {
+        return clock_gettime(CLOCK_MONOTONIC) * 1000;
+    }
+
+    sub _ensure_running {
+        my $self = shift;
+        return if $self->idle_id;
+
+        # Default idle priority sits below GTK's layout and redraw sources
+        $self->idle_id(Glib::Idle->add(sub { $self->_run_slice() }, undef, Glib::G_PRIORITY_DEFAULT_IDLE));
+    }
+
+    sub _next_task {
+        my $self = shift;
+
+        foreach my $queue (@{$self->queues}) {
+            while (@$queue) {
+                my $task = $queue->[0];
+                return $task unless $task->{token} && $task->{token}->cancelled;
+                shift @$queue;
+            }
+        }
+        return undef;
+    }
+
+    sub _run_slice {
+        my $self = shift;
+
+        my $deadline = _now_ms() + $self->budget_ms;
+        my $slice_span = TRACING && trace_span('scheduler slice');
+
+        while (my $task = $self->_next_task()) {
+            $self->current_label($task->{label});
+            my $step_span = TRACING && trace_span($task->{label});
+            my $more = eval { $task->{step}->() };
+            if ($@) {
+                print "Warning: scheduled task '$task->{label}' failed: $@\n";
+                $more = 0;
+            }
+
+            if (!$more) {
+                $self->_remove_task($task);
+
+                # The step may have cancelled its own token
+                if ($task->{on_done} && !($task->{token} && $task->{token}->cancelled)) {
+                    eval { $task->{on_done}->() };
+                    print "Warning: scheduled task '$task->{label}' failed: $@\n" if $@;
+                }
+            }
+
+            last if _now_ms() >= $deadline;
+        }
+        $self->current_label(undef);
+
+        return TRUE if $self->pending;
+
+        $self->idle_id(undef);
+        return FALSE;
+    }
+
+    sub _remove_task {
+        my ($self, $task) = @_;
+
+        foreach my $queue (@{$self->queues}) {
+            @$queue = grep { $_ != $task } @$queue;
+        }
+    }
+}
+
+1;
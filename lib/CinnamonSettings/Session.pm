@@ -0,0 +1,316 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - per-session helper process plumbing
+# Helper scripts are streamed to "perl -" over an anonymous pipe and their
+# output is collected over another, so preview and extraction jobs never
+# leave scripts, logs or scratch images behind in /tmp. The session also
+# keeps the counters printed by report_stats() when CSM_DEBUG is set.
+
+package CinnamonSettings::Session {
+    use Moo;
+    use POSIX qw(_exit);
+    use Glib 'TRUE', 'FALSE';
+    use CinnamonSettings::Trace qw(TRACING trace_span);
+
+    has 'app_name' => (is => 'ro', default => sub { 'cinnamon-settings-manager' });
+    has 'children' => (is => 'rw', default => sub { {} });
+    has 'stats' => (is => 'rw', default => sub { {
+        spawned => 0,
+        failed => 0,
+        pipe_bytes => 0,
+        files_created => 0,
+    } });
+
+    # Run a Perl script in a child process and return immediately.
+    # $on_exit->($exit_code, $output) is called from the main loop.
+    sub spawn_perl {
+        my ($self, %args) = @_;
+
+        my ($pid, $to_child, $from_child) = $self->_start(1, _perl_command($args{timeout}));
+        return 0 unless $pid;
+
+        $self->_send_script($to_child, $args{script});
+
+        # Ends when the helper has exited
+        my $span = TRACING && trace_span('helper process', pid => $pid, label => $args{label});
+
+        my $output = '';
+        $self->_watch_child($pid, $from_child, sub { $output .= shift }, sub {
+            my $status = shift;
+            undef $span;
+            $self->_finish_child($pid, $status, $output);
+            $args{on_exit}->($status >> 8, $output) if $args{on_exit};
+        });
+
+        return $pid;
+    }
+
+    # Run a command in a child process and return immediately, with
+    # stderr merged into its output. $on_exit->($exit_code, $output) is
+    # called from the main loop. With on_data, output is handed over as it
+    # arrives instead of being collected, and discard_stderr keeps it
+    # binary-clean.
+    sub spawn_command {
+        my ($self, %args) = @_;
+
+        my ($pid, $to_child, $from_child) = $self->_start(!$args{discard_stderr}, @{$args{command}});
+        return 0 unless $pid;
+        close $to_child;
+
+        my $span = TRACING && trace_span('command', pid => $pid, label => $args{label});
+
+        my $output = '';
+        my $streamed = 0;
+        my $on_data = $args{on_data}
+            ? sub { $streamed += length $_[0]; $args{on_data}->($_[0]) }
+            : sub { $output .= shift };
+        $self->_watch_child($pid, $from_child, $on_data, sub {
+            my $status = shift;
+            undef $span;
+            $self->_finish_child($pid, $status, $output);
+            $self->stats->{pipe_bytes} += $streamed;
+            $args{on_exit}->($status >> 8, $output) if $args{on_exit};
+        });
+
+        return $pid;
+    }
+
+    # Start a long-lived Perl helper. The script reads job lines from its
+    # DATA handle; each line it prints is passed to $on_line as it arrives.
+    # Returns a worker handle for send_line() and stop_worker().
+    sub start_worker {
+        my ($self, %args) = @_;
+
+        my ($pid, $to_child, $from_child) = $self->_start(1, $^X, '-');
+        return undef unless $pid;
+
+        # Everything after __END__ stays unread on stdin and becomes DATA
+        $self->_send_script($to_child, "$args{script}\n__END__\n", 1);
+
+        my $worker = { pid => $pid, input => $to_child };
+        my $pending = '';
+        my $transferred = 0;
+
+        $self->_watch_child($pid, $from_child, sub {
+            $pending .= shift;
+            while ($pending =~ s/^([^\n]*)\n//) {
+                $transferred += length($1) + 1;
+                $args{on_line}->($1) if $args{on_line};
+            }
+        }, sub {
+            my $status = shift;
+            close $worker->{input} if $worker->{input};
+            delete $worker->{input};
+            $self->_finish_child($pid, $status, '');
+            $self->stats->{pipe_bytes} += $transferred;
+            $args{on_exit}->($status >> 8) if $args{on_exit};
+        });
+
+        return $worker;
+    }
+
+    sub send_line {
+        my ($self, $worker, $line) = @_;
+        return 0 unless $worker->{input};
+
+        local $SIG{PIPE} = 'IGNORE';
+        print {$worker->{input}} "$line\n" or return 0;
+        $self->stats->{pipe_bytes} += length($line) + 1;
+        return 1;
+    }
+
+    # Closing stdin ends the helper's DATA loop and lets it exit
+    sub stop_worker {
+        my ($self, $worker) = @_;
+
+        close $worker->{input} if $worker->{input};
+        delete $worker->{input};
+    }
+
+    # Run a Perl script and wait for it; returns ($exit_code, $output)
+    sub run_perl {
+        my ($self, %args) = @_;
+
+        my $span = TRACING && trace_span('helper process (blocking)', label => $args{label});
+        my ($pid, $to_child, $from_child) = $self->_start(1, _perl_command($args{timeout}));
+        return (-1, '') unless $pid;
+
+        $self->_send_script($to_child, $args{script});
+        return $self->_collect($pid, $from_child);
+    }
+
+    # Run a command and return ($exit_code, $stdout) with stdout read as
+    # raw bytes; stderr is discarded so binary output stays intact
+    sub capture {
+        my ($self, @command) = @_;
+
+        my $span = TRACING && trace_span('capture', command => join(' ', @command));
+        my ($pid, $to_child, $from_child) = $self->_start(0, @command);
+        return (-1, '') unless $pid;
+
+        close $to_child;
+        binmode $from_child;
+        return $self->_collect($pid, $from_child);
+    }
+
+    # Like capture(), with $input written to the command's stdin first
+    sub capture_input {
+        my ($self, $input, @command) = @_;
+
+        my $span = TRACING && trace_span('capture', command => join(' ', @command));
+        my ($pid, $to_child, $from_child) = $self->_start(0, @command);
+        return (-1, '') unless $pid;
+
+        # The pipe buffer may be smaller than $input, so write from a
+        # child while this process reads
+        my $writer = fork();
+        if (defined $writer && $writer == 0) {
+            close $from_child;
+            local $SIG{PIPE} = 'IGNORE';
+            binmode $to_child;
+            print $to_child $input;
+            close $to_child;
+            _exit(0);
+        }
+        close $to_child;
+        $self->stats->{pipe_bytes} += length $input;
+
+        binmode $from_child;
+        my @result = $self->_collect($pid, $from_child);
+        waitpid($writer, 0) if $writer;
+        return @result;
+    }
+
+    sub _collect {
+        my ($self, $pid, $from_child) = @_;
+
+        my $output = do { local $/; <$from_child> };
+        $output = '' unless defined $output;
+        close $from_child;
+        waitpid($pid, 0);
+        my $status = $?;
+
+        $self->_finish_child($pid, $status, $output);
+        return ($status >> 8, $output);
+    }
+
+    # Count a file written on purpose (cache entries, exported images)
+    sub note_file_created {
+        my ($self, $count) = @_;
+        $self->stats->{files_created} += defined $count ? $count : 1;
+    }
+
+    # Stop helpers that are still running, e.g. when the window closes
+    sub terminate_children {
+        my $self = shift;
+
+        my @pids = keys %{$self->children};
+        kill 'TERM', @pids if @pids;
+        $self->children({});
+    }
+
+    sub report_stats {
+        my $self = shift;
+        return unless $ENV{CSM_DEBUG};
+
+        my $stats = $self->stats;
+        printf STDERR "[%s] session: %d helper processes (%d failed), %.1f KiB over pipes, %d files created\n",
+            $self->app_name, $stats->{spawned}, $stats->{failed}, $stats->{pipe_bytes} / 1024,
+            $stats->{files_created};
+    }
+
+    sub _perl_command {
+        my $timeout = shift || 30;
+        return ('timeout', "${timeout}s", $^X, '-');
+    }
+
+    sub _start {
+        my ($self, $merge_stderr, @command) = @_;
+
+        pipe(my $script_in, my $to_child) or return;
+        pipe(my $from_child, my $output_out) or return;
+
+        my $pid = fork();
+        return unless defined $pid;
+
+        if ($pid == 0) {
+            close $to_child;
+            close $from_child;
+            open STDIN, '<&', $script_in or _exit(127);
+            open STDOUT, '>&', $output_out or _exit(127);
+            if ($merge_stderr) {
+                open STDERR, '>&', $output_out or _exit(127);
+            } else {
+                open STDERR, '>', '/dev/null' or _exit(127);
+            }
+            exec(@command) or _exit(127);
+        }
+
+        close $script_in;
+        close $output_out;
+
+        $self->stats->{spawned}++;
+        $self->children->{$pid} = 1;
+
+        return ($pid, $to_child, $from_child);
+    }
+
+    sub _send_script {
+        my ($self, $to_child, $script, $keep_open) = @_;
+
+        # A helper that fails to start must not take the application down
+        local $SIG{PIPE} = 'IGNORE';
+        print $to_child $script;
+
+        if ($keep_open) {
+            $to_child->autoflush(1);
+            $to_child->flush();
+        } else {
+            close $to_child;
+        }
+
+        $self->stats->{pipe_bytes} += length $script;
+    }
+
+    # Feed output chunks to $on_data as they arrive and call $on_exit with
+    # the wait status once the child has exited and the pipe is drained
+    sub _watch_child {
+        my ($self, $pid, $from_child, $on_data, $on_exit) = @_;
+
+        my $reader;
+        $reader = Glib::IO->add_watch(fileno($from_child), ['in', 'hup', 'err'], sub {
+            my $read = sysread($from_child, my $chunk, 65536);
+            if ($read) {
+                $on_data->($chunk);
+                return TRUE;
+            }
+            undef $reader;
+            return FALSE;
+        });
+
+        Glib::Child->watch_add($pid, sub {
+            my (undef, $status) = @_;
+
+            # The child has exited, so whatever is left in the pipe ends at EOF
+            Glib::Source->remove($reader) if defined $reader;
+            while (sysread($from_child, my $chunk, 65536)) {
+                $on_data->($chunk);
+            }
+            close $from_child;
+
+            $on_exit->($status);
+        });
+    }
+
+    sub _finish_child {
+        my ($self, $pid, $status, $output) = @_;
+
+        delete $self->children->{$pid};
+        $self->stats->{pipe_bytes} += length $output;
+        $self->stats->{failed}++ if $status != 0;
+    }
+}
+
+1;
@@ -0,0 +1,93 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - directory switching soak run
+# With CSM_SOAK_SWITCHES=N a manager selects the rows of its directory
+# list in turn, N times, waiting for each directory to finish loading
+# before moving on, then closes its window. Resident memory is sampled
+# along the way and recorded as trace instants (and on stderr), so a run
+# under `make perf-soak` can check that it levels off instead of growing
+# with every directory visited.
+
+package CinnamonSettings::Soak {
+    use Moo;
+    use Glib 'TRUE', 'FALSE';
+    use CinnamonSettings::Trace qw(TRACING trace_instant);
+
+    has 'app_name' => (is => 'ro', required => 1);
+    has 'window' => (is => 'ro', required => 1);
+    has 'list' => (is => 'ro', required => 1);
+    has 'scheduler' => (is => 'ro');
+    has 'switches' => (is => 'ro', default => sub { $ENV{CSM_SOAK_SWITCHES} || 0 });
+    has 'sample_every' => (is => 'ro', default => sub { 10 });
+    has 'interval_ms' => (is => 'ro', default => sub { 20 });
+    has 'done' => (is => 'rw', default => sub { 0 });
+    has 'samples' => (is => 'rw', default => sub { [] });
+
+    sub start {
+        my $self = shift;
+        return unless $self->switches > 0;
+
+        print STDERR "[" . $self->app_name . "] soak: switching directories " . $self->switches . " times\n";
+        $self->_sample();
+        Glib::Timeout->add($self->interval_ms, sub { $self->_tick() });
+    }
+
+    sub _tick {
+        my $self = shift;
+
+        # Let the previous directory finish populating first
+        return TRUE if $self->scheduler && $self->scheduler->pending;
+
+        if ($self->done >= $self->switches) {
+            $self->_sample();
+            $self->_finish();
+            return FALSE;
+        }
+
+        my @rows = $self->list->get_children();
+        if (@rows < 2) {
+            print STDERR "[" . $self->app_name . "] soak: need at least two directories, stopping\n";
+            $self->_finish();
+            return FALSE;
+        }
+
+        my $selected = $self->list->get_selected_row();
+        my $index = $selected ? $selected->get_index() : -1;
+        $self->list->select_row($rows[($index + 1) % @rows]);
+
+        $self->done($self->done + 1);
+        $self->_sample() if $self->done % $self->sample_every == 0;
+
+        return TRUE;
+    }
+
+    sub _sample {
+        my $self = shift;
+
+        my $rss = _rss_kib();
+        push @{$self->samples}, [$self->done, $rss];
+        trace_instant('soak sample', switch => $self->done, rss_kib => $rss) if TRACING;
+    }
+
+    sub _finish {
+        my $self = shift;
+
+        my @rss = map { $_->[1] } @{$self->samples};
+        printf STDERR "[%s] soak: %d switches, RSS %d kB at start, %d kB peak, %d kB at end\n",
+            $self->app_name, $self->done, $rss[0], (sort { $b <=> $a } @rss)[0], $rss[-1];
+
+        $self->window->destroy();
+    }
+
+    sub _rss_kib {
+        open my $fh, '<', '/proc/self/status' or return 0;
+        while (my $line = <$fh>) {
+            return $1 if $line =~ /^VmRSS:\s+(\d+)/;
+        }
+        return 0;
+    }
+}
+
+1;
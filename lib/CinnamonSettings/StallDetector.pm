@@ -0,0 +1,196 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - main loop stall detector
+# A heartbeat timeout on the GTK main loop records when the loop last got
+# to run; an interval timer signal checks it from outside the loop. Once
+# the heartbeat is late by more than the threshold, the signal handler
+# (which Perl runs at the next op of the blocked code) captures the Perl
+# call stack and the scheduler task that was running. When the heartbeat
+# comes back the stall is recorded with its full length. Enabled by
+# CSM_DEBUG or CSM_STALL_THRESHOLD_MS; the per-session histogram is
+# written to the config directory by report().
+
+package CinnamonSettings::StallDetector {
+    use Moo;
+    use POSIX qw(strftime);
+    use File::Path qw(make_path);
+    use Time::HiRes qw(clock_gettime CLOCK_MONOTONIC setitimer ITIMER_REAL);
+    use JSON;
+    use CinnamonSettings::Trace qw(TRACING trace_instant);
+
+    # Upper bounds (ms) of the histogram buckets; the last one is open
+    my @BUCKETS = (100, 250, 500, 1000, 2500);
+
+    has 'app_name' => (is => 'ro', required => 1);
+    has 'config_dir' => (is => 'ro', required => 1);
+    has 'scheduler' => (is => 'ro');
+    has 'threshold_ms' => (is => 'ro', default => sub { $ENV{CSM_STALL_THRESHOLD_MS} || 50 });
+    has 'heartbeat_ms' => (is => 'ro', default => sub { 10 });
+    has 'enabled' => (is => 'ro', default => sub {
+        ($ENV{CSM_DEBUG} || $ENV{CSM_STALL_THRESHOLD_MS}) ? 1 : 0
+    });
+    has 'culprits' => (is => 'rw', default => sub { {} });
+    has 'stall_count' => (is => 'rw', default => sub { 0 });
+    has 'started_at' => (is => 'rw');
+
+    sub start {
+        my $self = shift;
+        return unless $self->enabled;
+        return if $self->{heartbeat_id};
+
+        $self->started_at(time());
+        $self->{last_beat} = _now_ms();
+
+        $self->{heartbeat_id} = Glib::Timeout->add($self->heartbeat_ms, sub {
+            # A signal delivered here was held back by native code, so
+            # there is no Perl stack worth sampling
+            local $self->{in_heartbeat} = 1;
+            $self->_heartbeat();
+            return 1;
+        });
+
+        # SA_RESTART keeps blocking reads and waits in the managers from
+        # failing with EINTR every time the monitor ticks
+        POSIX::sigaction(POSIX::SIGALRM(),
+            POSIX::SigAction->new(sub { $self->_check() }, POSIX::SigSet->new(), POSIX::SA_RESTART()));
+
+        my $interval = $self->threshold_ms / 2000;
+        setitimer(ITIMER_REAL, $interval, $interval);
+    }
+
+    sub stop {
+        my $self = shift;
+        return unless $self->{heartbeat_id};
+
+        setitimer(ITIMER_REAL, 0);
+        POSIX::sigaction(POSIX::SIGALRM(), POSIX::SigAction->new('DEFAULT'));
+        Glib::Source->remove(delete $self->{heartbeat_id});
+    }
+
+    sub _now_ms {
+        return clock_gettime(CLOCK_MONOTONIC) * 1000;
+    }
+
+    # Runs on the main loop; a late beat ends a stall
+    sub _heartbeat {
+        my $self = shift;
+
+        my $now = _now_ms();
+        my $stalled = $now - $self->{last_beat} - $self->heartbeat_ms;
+        $self->{last_beat} = $now;
+
+        my $sample = delete $self->{sample};
+        $self->_record($stalled, $sample) if $stalled >= $self->threshold_ms;
+    }
+
+    # Runs from the timer signal while the loop may be blocked
+    sub _check {
+        my $self = shift;
+
+        return if $self->{sample} || $self->{in_heartbeat};
+        return if _now_ms() - $self->{last_beat} - $self->heartbeat_ms < $self->threshold_ms;
+
+        # Each frame gives a sub and where it was called from, so the
+        # position inside a sub comes from the frame before it
+        my @stack;
+        my $where = '?';
+        for (my $level = 1; my @frame = caller($level); $level++) {
+            my ($file, $line, $sub) = @frame[1, 2, 3];
+            # Perl wraps the signal dispatch itself in an eval frame
+            my $handler = $sub =~ /^CinnamonSettings::StallDetector::/ || (!@stack && $sub eq '(eval)');
+            push @stack, "$sub ($where)" unless $handler;
+            $file =~ s{.*/}{};
+            $where = "$file:$line";
+            last if @stack >= 16;
+        }
+
+        my $label = $self->scheduler ? $self->scheduler->current_label : undef;
+        $self->{sample} = { stack => \@stack, task => $label };
+    }
+
+    sub _record {
+        my ($self, $stalled, $sample) = @_;
+
+        my $stack = $sample ? $sample->{stack} : [];
+        my $task = ($sample && $sample->{task}) || 'none';
+
+        # The innermost application frame names the culprit; anonymous
+        # subs (scheduler steps, callbacks) keep their location
+        my ($culprit) = grep { !/^(?:CinnamonSettings::Scheduler::|\(eval\))/ } @$stack;
+        if ($culprit) {
+            $culprit =~ s/ \(.*\)$// unless $culprit =~ /::__ANON__ /;
+        } else {
+            $culprit = 'native code in main loop';
+        }
+
+        my $entry = $self->culprits->{$culprit} ||= {
+            count => 0,
+            total_ms => 0,
+            max_ms => 0,
+            buckets => {},
+            tasks => {},
+        };
+
+        my $bucket = (grep { $stalled < $_ } @BUCKETS)[0];
+        $bucket = defined $bucket ? "<$bucket" : ">=$BUCKETS[-1]";
+
+        $entry->{count}++;
+        $entry->{total_ms} += $stalled;
+        $entry->{buckets}{$bucket}++;
+        $entry->{tasks}{$task}++;
+        if ($stalled > $entry->{max_ms}) {
+            $entry->{max_ms} = $stalled;
+            $entry->{worst_stack} = $stack;
+        }
+
+        $self->stall_count($self->stall_count + 1);
+        trace_instant('main loop stall', ms => int($stalled), culprit => $culprit, task => $task) if TRACING;
+        printf STDERR "[%s] stall: %.0f ms in %s (task: %s)\n", $self->app_name, $stalled, $culprit, $task
+            if $ENV{CSM_DEBUG};
+    }
+
+    # Write the histogram for this session; returns the file written
+    sub report {
+        my $self = shift;
+        return undef unless $self->enabled && $self->started_at;
+
+        $self->stop();
+
+        my %culprits = %{$self->culprits};
+        foreach my $entry (values %culprits) {
+            $entry->{total_ms} = int($entry->{total_ms} + 0.5);
+            $entry->{max_ms} = int($entry->{max_ms} + 0.5);
+        }
+
+        my $report = {
+            app => $self->app_name,
+            pid => $$,
+            started => strftime('%Y-%m-%dT%H:%M:%S', localtime($self->started_at)),
+            duration_s => time() - $self->started_at,
+            threshold_ms => $self->threshold_ms,
+            stalls => $self->stall_count,
+            culprits => \%culprits,
+        };
+
+        my $file = $self->config_dir . '/stalls-' . strftime('%Y%m%d-%H%M%S', localtime($self->started_at)) . "-$$.json";
+        my $ok = eval {
+            make_path($self->config_dir) unless -d $self->config_dir;
+            open my $fh, '>', "$file.part" or die "Cannot write $file.part: $!";
+            print $fh JSON->new->pretty->canonical->encode($report);
+            close $fh;
+            rename "$file.part", $file or die "Cannot rename $file.part: $!";
+        };
+        if (!$ok) {
+            print STDERR "Warning: Could not write stall report: $@\n";
+            return undef;
+        }
+
+        printf STDERR "[%s] %d main loop stalls over %d ms, report in %s\n",
+            $self->app_name, $self->stall_count, $self->threshold_ms, $file;
+        return $file;
+    }
+}
+
+1;
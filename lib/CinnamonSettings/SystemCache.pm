@@ -0,0 +1,53 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - read-only system preview cache
+# Previews of themes and wallpapers shipped in /usr/share are the same for
+# every user, so they are generated once at install time (make
+# install-caches) into /var/cache/cinnamon-settings-manager and looked up
+# before the per-user caches. Entries use the key schema of
+# CinnamonSettings::PreviewCache (source path, its mtime and size, and the
+# variant), so an updated theme simply misses and falls through to the
+# per-user cache.
+
+package CinnamonSettings::SystemCache {
+    use Moo;
+    use CinnamonSettings::PreviewCache;
+
+    use constant DEFAULT_ROOT => '/var/cache/cinnamon-settings-manager';
+
+    # One subdirectory per kind of preview: cursors, cinnamon-themes,
+    # colors, backgrounds
+    has 'section' => (is => 'ro', required => 1);
+    has 'root' => (is => 'ro', default => sub { $ENV{CSM_SYSTEM_CACHE_DIR} || DEFAULT_ROOT });
+
+    sub dir {
+        my $self = shift;
+        return $self->root . '/' . $self->section;
+    }
+
+    # Entry name for $source with a variant suffix such as "-400x300.png",
+    # or undef if the source cannot be stat'ed
+    sub entry_name {
+        my ($class, $source, $suffix) = @_;
+        return CinnamonSettings::PreviewCache->file_key($source, $suffix);
+    }
+
+    sub path_for {
+        my ($self, $source, $suffix) = @_;
+
+        my $name = $self->entry_name($source, $suffix);
+        return defined $name ? $self->dir . "/$name" : undef;
+    }
+
+    # Themes in the home directory are never in the shared cache
+    sub covers {
+        my ($self, $source) = @_;
+
+        return 0 if defined $ENV{HOME} && index($source, "$ENV{HOME}/") == 0;
+        return $source =~ m{^/(?:usr|opt)/};
+    }
+}
+
+1;
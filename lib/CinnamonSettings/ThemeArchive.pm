@@ -0,0 +1,596 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - theme archive reader
+# Reads a downloaded .tar.gz/.tar.xz/.tar.bz2/.tar/.zip theme bundle for a
+# preview without unpacking it. Tarballs are decompressed by a child process
+# and parsed as the data arrives, in a single pass: every member name goes
+# into the index, and only the members a selector asks for (a few cursor
+# files, preview icons, stylesheets, thumbnails) are kept, in memory. Zip
+# files are indexed from their central directory and the selected members
+# are read back to back by one more child. Nothing touches the disk until
+# install().
+
+package CinnamonSettings::ThemeArchive {
+    use Moo;
+    use Glib 'TRUE', 'FALSE';
+    use File::Basename qw(basename);
+    use File::Path qw(remove_tree);
+    use CinnamonSettings::Trace qw(TRACING trace_span);
+
+    use constant BLOCK => 512;
+
+    has 'path' => (is => 'ro', required => 1);
+    has 'session' => (is => 'ro', required => 1);
+    # Members larger than this are indexed but never kept
+    has 'max_member_bytes' => (is => 'ro', default => sub { 8 * 1024 * 1024 });
+    has 'entries' => (is => 'rw', default => sub { {} });
+    has 'members' => (is => 'rw', default => sub { {} });
+    has 'kept_bytes' => (is => 'rw', default => sub { 0 });
+    has 'pid' => (is => 'rw');
+
+    my %DECOMPRESSORS = (
+        gz => ['gzip', '-dc'],
+        tgz => ['gzip', '-dc'],
+        xz => ['xz', '-dc'],
+        txz => ['xz', '-dc'],
+        bz2 => ['bzip2', '-dc'],
+        tbz2 => ['bzip2', '-dc'],
+        zst => ['zstd', '-dc'],
+        tar => ['cat'],
+    );
+
+    sub is_supported {
+        my ($class, $path) = @_;
+        return defined _format($path);
+    }
+
+    sub _format {
+        my $path = shift;
+
+        return 'zip' if $path =~ /\.zip$/i;
+        return lc $1 if $path =~ /\.(tgz|txz|tbz2|tar)$/i;
+        return lc $1 if $path =~ /\.tar\.(gz|xz|bz2|zst)$/i;
+        return undef;
+    }
+
+    # Members a preview of the given kind needs, as a selector for scan():
+    # index.theme files plus, per kind, the named cursors or icons, the
+    # GTK 3 stylesheets, or the thumbnails
+    sub selector {
+        my ($class, %args) = @_;
+
+        my %names = map { $_ => 1 } @{$args{names} || []};
+        my $kind = $args{kind};
+
+        return sub {
+            my $name = shift;
+
+            return 1 if $name =~ m{(?:^|/)index\.theme$};
+            if ($kind eq 'cursor') {
+                return $name =~ m{(?:^|/)cursors/([^/]+)$} && $names{$1};
+            }
+            if ($kind eq 'icon') {
+                # Small sizes are never shown in a preview
+                return 0 if $name =~ m{(?:^|/)cursors/} || $name =~ m{/(?:16|22|24|32)(?:x\d+)?(?:@\d+x?)?/};
+                return $name =~ m{([^/]+)\.(?:png|svg)$} && $names{$1};
+            }
+            if ($kind eq 'gtk') {
+                return $name =~ m{(?:^|/)gtk-3\.0/[^/]+\.css$} || $name =~ m{(?:^|/)(?:gtk-3\.0/)?thumbnail\.png$};
+            }
+            if ($kind eq 'cinnamon') {
+                return $name =~ m{(?:^|/)cinnamon/thumbnail\.png$};
+            }
+            return 0;
+        };
+    }
+
+    # Read the archive once, keeping the members $want->($name) accepts;
+    # $on_done->($ok, $error) runs from the main loop when it is finished.
+    # Selected symlinks whose targets were not selected are fetched by a
+    # second pass that keeps only those targets.
+    sub scan {
+        my ($self, %args) = @_;
+
+        my $format = _format($self->path);
+        return $args{on_done}->(0, 'Unsupported archive type') unless $format;
+
+        $self->entries({});
+        $self->members({});
+        $self->kept_bytes(0);
+        $self->pid(undef);
+
+        return $self->_scan_zip(%args) if $format eq 'zip';
+
+        my $span = TRACING && trace_span('archive scan', path => $self->path);
+        $self->_scan_tar($format, $args{want}, sub {
+            my ($ok, $error, $links) = @_;
+            return $args{on_done}->(0, $error) unless $ok;
+
+            my %missing = map { $_ => 1 } grep { !exists $self->members->{$_} } $self->_link_targets($links);
+            if (!%missing) {
+                undef $span;
+                return $args{on_done}->(1);
+            }
+
+            $self->_scan_tar($format, sub { $missing{$_[0]} }, sub {
+                my ($ok, $error) = @_;
+                undef $span;
+                $args{on_done}->($ok, $error);
+            });
+        });
+    }
+
+    sub _scan_tar {
+        my ($self, $format, $want, $on_done) = @_;
+
+        my $state = { buffer => '', want => $want, done => 0, links => [] };
+
+        my $pid = $self->session->spawn_command(
+            command => [@{$DECOMPRESSORS{$format}}, $self->path],
+            label => 'archive scan',
+            discard_stderr => 1,
+            on_data => sub { $self->_feed_tar($state, shift) },
+            on_exit => sub {
+                my $exit_code = shift;
+                # Cancelled: nobody is waiting for the result any more
+                return unless $self->pid;
+                $self->pid(undef);
+                if ($exit_code != 0 && !$state->{done}) {
+                    $on_done->(0, 'Could not read ' . basename($self->path));
+                } elsif ($state->{error}) {
+                    $on_done->(0, $state->{error});
+                } else {
+                    $on_done->(1, undef, $state->{links});
+                }
+            },
+        );
+        return $on_done->(0, 'Could not start the decompressor') unless $pid;
+        $self->pid($pid);
+    }
+
+    # Final targets of the given link members, as archive paths
+    sub _link_targets {
+        my ($self, $links) = @_;
+
+        my @targets;
+        foreach my $name (@$links) {
+            my $target = $name;
+            for (1 .. 8) {
+                my $entry = $self->entries->{$target};
+                last unless $entry && ($entry->{type} eq 'link' || $entry->{type} eq 'hardlink');
+                $target = $self->_link_target($target, $entry);
+                last unless defined $target;
+            }
+            push @targets, $target if defined $target && $target ne $name;
+        }
+        return @targets;
+    }
+
+    sub _link_target {
+        my ($self, $name, $entry) = @_;
+
+        my $target = $entry->{link};
+        if ($entry->{type} eq 'link' && $target !~ m{^/}) {
+            (my $dir = $name) =~ s{/?[^/]+$}{};
+            $target = length $dir ? "$dir/$target" : $target;
+        }
+        return _normalise($target);
+    }
+
+    sub cancel {
+        my $self = shift;
+
+        my $pid = $self->pid;
+        $self->pid(undef);
+        kill 'TERM', $pid if $pid;
+    }
+
+    # Tar parser fed straight from the pipe: headers, then member data that
+    # is either kept or dropped as it streams past
+    sub _feed_tar {
+        my ($self, $state, $chunk) = @_;
+
+        return if $state->{done};
+        $state->{buffer} .= $chunk;
+
+        while (1) {
+            if ($state->{remaining}) {
+                my $take = length $state->{buffer};
+                $take = $state->{remaining} if $take > $state->{remaining};
+                return unless $take;
+
+                if ($state->{keep} && $state->{keep_left} > 0) {
+                    my $keep = $take < $state->{keep_left} ? $take : $state->{keep_left};
+                    $state->{data} .= substr($state->{buffer}, 0, $keep);
+                    $state->{keep_left} -= $keep;
+                }
+                substr($state->{buffer}, 0, $take, '');
+                $state->{remaining} -= $take;
+                return if $state->{remaining};
+
+                $self->_finish_member($state);
+                next;
+            }
+
+            return if length($state->{buffer}) < BLOCK;
+            my $header = substr($state->{buffer}, 0, BLOCK, '');
+
+            if ($header =~ /^\0+$/) {
+                # End of archive
+                $state->{done} = 1;
+                return;
+            }
+
+            my %h;
+            @h{qw(name mode uid gid size mtime chksum type link magic)} =
+                unpack('Z100 a8 a8 a8 a12 a12 a8 a1 Z100 a6', $header);
+            my $prefix = unpack('x345 Z155', $header);
+            if ($h{magic} !~ /^ustar/ && !exists $state->{long_name}) {
+                $state->{error} = basename($self->path) . ' is not a tar archive';
+                $state->{done} = 1;
+                return;
+            }
+
+            my $type = $h{type};
+            my $meta = $type eq 'L' || $type eq 'K' || $type eq 'x' || $type eq 'g';
+
+            my $size = _tar_number($h{size});
+            # Only POSIX headers have a name prefix; GNU ones ("ustar  ")
+            # keep access and change times there
+            my $name = $h{magic} eq "ustar\0" && length $prefix ? "$prefix/$h{name}" : $h{name};
+            my $link = $h{link};
+            # Long names and pax values belong to the next real member; GNU
+            # tar writes a long link before the long name
+            unless ($meta) {
+                $name = delete $state->{long_name} if exists $state->{long_name};
+                $link = delete $state->{long_link} if exists $state->{long_link};
+                $size = delete $state->{pax_size} if exists $state->{pax_size};
+            }
+
+            $state->{member} = { name => _clean($name), link => $link, type => $type, size => $size, meta => $meta };
+            $state->{remaining} = $size + (BLOCK - $size % BLOCK) % BLOCK;
+            $state->{data} = '';
+            $state->{keep} = $meta || (($type eq '0' || $type eq "\0" || $type eq '7')
+                && $size <= $self->max_member_bytes && $state->{want}->($state->{member}{name}));
+            $state->{keep_left} = $size;
+
+            $self->_finish_member($state) unless $state->{remaining};
+        }
+    }
+
+    sub _finish_member {
+        my ($self, $state) = @_;
+
+        my $member = delete $state->{member};
+        my $data = delete $state->{data};
+        my $type = $member->{type};
+
+        if ($type eq 'L') {
+            ($state->{long_name} = $data) =~ s/\0.*//s;
+        } elsif ($type eq 'K') {
+            ($state->{long_link} = $data) =~ s/\0.*//s;
+        } elsif ($type eq 'x') {
+            # PAX records: "<length> <key>=<value>\n"
+            while ($data =~ /\G(\d+) ([^=]+)=/gc) {
+                my ($length, $key) = ($1, $2);
+                my $value_length = $length - length("$length $key=") - 1;
+                my $value = substr($data, pos($data), $value_length);
+                pos($data) = pos($data) + $value_length + 1;
+                $state->{long_name} = $value if $key eq 'path';
+                $state->{long_link} = $value if $key eq 'linkpath';
+                $state->{pax_size} = $value if $key eq 'size';
+            }
+        } elsif ($type ne 'g') {
+            my $name = $member->{name};
+            return unless length $name;
+
+            my $kind = $type eq '2' ? 'link' : $type eq '1' ? 'hardlink' : $type eq '5' ? 'dir' : 'file';
+            $self->entries->{$name} = { type => $kind, size => $member->{size}, link => $member->{link} };
+
+            if (($kind eq 'link' || $kind eq 'hardlink') && $state->{want}->($name)) {
+                push @{$state->{links}}, $name;
+            }
+            if ($kind eq 'file' && $state->{keep}) {
+                $self->members->{$name} = $data;
+                $self->kept_bytes($self->kept_bytes + length $data);
+            }
+        }
+    }
+
+    # Octal, or base-256 for large sizes (GNU extension)
+    sub _tar_number {
+        my $field = shift;
+
+        if (ord($field) & 0x80) {
+            my $value = 0;
+            $value = $value * 256 + ord($_) for split //, substr($field, 1);
+            return $value;
+        }
+        $field =~ s/[\0 ]+$//;
+        $field =~ s/^[\0 ]+//;
+        return length $field ? oct($field) : 0;
+    }
+
+    sub _clean {
+        my $name = shift;
+        $name =~ s{^\./+}{};
+        $name =~ s{/+$}{};
+        return $name;
+    }
+
+    sub _scan_zip {
+        my ($self, %args) = @_;
+
+        my $span = TRACING && trace_span('archive scan', path => $self->path);
+        my $failed = sub {
+            undef $span;
+            $args{on_done}->(0, 'Could not read ' . basename($self->path));
+        };
+
+        # The member list lives at the end of a zip; no decompression needed.
+        # Lines read "<mode> <version> <os> <size> <flags> <method> <time> <name>".
+        my $pid = $self->session->spawn_command(
+            command => ['unzip', '-Z', '-T', $self->path],
+            label => 'archive scan',
+            discard_stderr => 1,
+            on_exit => sub {
+                my ($exit_code, $listing) = @_;
+                # Cancelled: nobody is waiting for the result any more
+                return unless $self->pid;
+                $self->pid(undef);
+                return $failed->() if $exit_code != 0;
+
+                my (@wanted, @links);
+                my $order = 0;
+                foreach my $line (split /\n/, $listing) {
+                    next unless $line =~ /^(\S+)\s+\S+\s+\S+\s+(\d+)\s+\S+\s+\S+\s+\d+\.\d+\s(.+)$/;
+                    my ($mode, $size, $name) = ($1, $2, $3);
+                    my $clean = _clean($name);
+                    next unless length $clean;
+
+                    my $type = $name =~ m{/$} ? 'dir' : $mode =~ /^l/ ? 'link' : 'file';
+                    $self->entries->{$clean} = { type => $type, size => $size, zip_name => $name, order => $order++ };
+                    next unless $type ne 'dir' && $args{want}->($clean);
+                    $type eq 'link' ? push(@links, $clean) : push(@wanted, $clean);
+                }
+
+                $self->_extract_zip([@wanted, @links], sub {
+                    my ($ok, $data) = @_;
+                    return $failed->() unless $ok;
+
+                    # A zipped symlink's data is its target path
+                    $self->entries->{$_}{link} = delete $data->{$_} // '' foreach @links;
+                    $self->_keep_zip_members($data);
+
+                    my @targets = grep { !exists $self->members->{$_} } $self->_link_targets(\@links);
+                    $self->_extract_zip(\@targets, sub {
+                        my ($ok, $data) = @_;
+                        return $failed->() unless $ok;
+
+                        $self->_keep_zip_members($data);
+                        undef $span;
+                        $args{on_done}->(1);
+                    });
+                });
+            },
+        );
+        return $failed->() unless $pid;
+        $self->pid($pid);
+    }
+
+    # Read the named members with a single unzip; $on_done->($ok, \%data)
+    # runs from the main loop. Files over max_member_bytes are skipped.
+    sub _extract_zip {
+        my ($self, $names, $on_done) = @_;
+
+        my %seen;
+        my @entries = sort { $a->[1]{order} <=> $b->[1]{order} }
+            grep { $_->[1] && ($_->[1]{type} eq 'link'
+                || ($_->[1]{type} eq 'file' && $_->[1]{size} <= $self->max_member_bytes)) }
+            map { [$_, $self->entries->{$_}] }
+            grep { !$seen{$_}++ } @$names;
+        return $on_done->(1, {}) unless @entries;
+
+        # unzip treats member names as wildcard patterns
+        my @patterns = map { (my $pattern = $_->[1]{zip_name}) =~ s/([\[\]*?\\])/\\$1/g; $pattern } @entries;
+
+        my $pid = $self->session->spawn_command(
+            command => ['unzip', '-p', $self->path, @patterns],
+            label => 'archive extract',
+            discard_stderr => 1,
+            on_exit => sub {
+                my (undef, $output) = @_;
+                return unless $self->pid;
+                $self->pid(undef);
+
+                # Members come out back to back in archive order, so the
+                # sizes from the listing split them; anything missing or
+                # damaged shows up as a length mismatch
+                my $total = 0;
+                $total += $_->[1]{size} foreach @entries;
+                return $on_done->(0) if length $output != $total;
+
+                my %data;
+                my $offset = 0;
+                foreach my $entry (@entries) {
+                    $data{$entry->[0]} = substr($output, $offset, $entry->[1]{size});
+                    $offset += $entry->[1]{size};
+                }
+                $on_done->(1, \%data);
+            },
+        );
+        return $on_done->(0) unless $pid;
+        $self->pid($pid);
+    }
+
+    sub _keep_zip_members {
+        my ($self, $data) = @_;
+
+        foreach my $name (keys %$data) {
+            $self->members->{$name} = $data->{$name};
+            $self->kept_bytes($self->kept_bytes + length $data->{$name});
+        }
+    }
+
+    # Contents of a kept member, following symlinks and hard links inside
+    # the archive
+    sub member {
+        my ($self, $name) = @_;
+
+        for (1 .. 8) {
+            return $self->members->{$name} if exists $self->members->{$name};
+            my $entry = $self->entries->{$name} or return undef;
+            return undef unless $entry->{type} eq 'link' || $entry->{type} eq 'hardlink';
+
+            $name = $self->_link_target($name, $entry);
+            return undef unless defined $name;
+        }
+        return undef;
+    }
+
+    sub _normalise {
+        my $path = shift;
+
+        my @parts;
+        foreach my $part (split m{/+}, $path) {
+            next if $part eq '' || $part eq '.';
+            if ($part eq '..') {
+                return undef unless @parts;
+                pop @parts;
+            } else {
+                push @parts, $part;
+            }
+        }
+        return join('/', @parts);
+    }
+
+    # Themes found in the index: [{ root, name, display_name, kinds }]. The
+    # root is '' when the archive's top level is the theme itself.
+    sub themes {
+        my $self = shift;
+
+        my %themes;
+        my $add = sub {
+            my ($root, $kind) = @_;
+            $root = '' unless defined $root;
+            $themes{$root}{kinds}{$kind} = 1;
+        };
+
+        foreach my $name (keys %{$self->entries}) {
+            $add->($1, 'cursor') if $name =~ m{^(?:(.*)/)?cursors/[^/]+$};
+            $add->($1, 'gtk') if $name =~ m{^(?:(.*)/)?gtk-3\.0/gtk\.css$};
+            $add->($1, 'cinnamon') if $name =~ m{^(?:(.*)/)?cinnamon/cinnamon\.css$};
+        }
+
+        # Icon themes: an index.theme whose directories hold images
+        foreach my $name (keys %{$self->entries}) {
+            next unless $name =~ m{^(?:(.*)/)?index\.theme$};
+            my $root = defined $1 ? $1 : '';
+            my $index = $self->member($name) // '';
+            next unless $index =~ /^\s*Directories\s*=/m;
+            my $prefix = length $root ? "$root/" : '';
+            $add->($root, 'icon') if grep {
+                index($_, $prefix) == 0 && m{\.(?:png|svg)$} && !m{/cursors/}
+            } keys %{$self->entries};
+        }
+
+        my $archive_name = basename($self->path);
+        $archive_name =~ s/\.(?:zip|tgz|txz|tbz2|tar(?:\.\w+)?)$//i;
+
+        my @themes;
+        foreach my $root (sort keys %themes) {
+            my $name = length $root ? basename($root) : $archive_name;
+            my $index = $self->member(length $root ? "$root/index.theme" : 'index.theme') // '';
+            my ($display_name) = $index =~ /^\s*Name\s*=\s*(.+?)\s*$/m;
+            push @themes, {
+                root => $root,
+                name => $name,
+                display_name => $display_name || $name,
+                kinds => $themes{$root}{kinds},
+            };
+        }
+        return \@themes;
+    }
+
+    # Kept member of a theme by its path inside the theme
+    sub theme_member {
+        my ($self, $theme, $relative) = @_;
+        return $self->member(length $theme->{root} ? "$theme->{root}/$relative" : $relative);
+    }
+
+    # Kept members of a theme, keyed by their path inside the archive
+    sub theme_members {
+        my ($self, $theme) = @_;
+
+        my $prefix = length $theme->{root} ? "$theme->{root}/" : '';
+        return { map { $_ => $self->members->{$_} } grep { index($_, $prefix) == 0 } keys %{$self->members} };
+    }
+
+    # Unpack one theme into $dest_dir/<name>, replacing an existing copy.
+    # $on_done->($ok, $message_or_installed_path) runs from the main loop.
+    sub install {
+        my ($self, %args) = @_;
+
+        my $theme = $args{theme};
+        my $dest_dir = $args{dest_dir};
+        my $target = "$dest_dir/$theme->{name}";
+        my $staging = "$dest_dir/.csm-install-$$-" . time();
+
+        unless ((-d $dest_dir || mkdir $dest_dir) && mkdir $staging) {
+            return $args{on_done}->(0, "Cannot write to $dest_dir: $!");
+        }
+
+        my @command;
+        if (_format($self->path) eq 'zip') {
+            @command = ('unzip', '-q', $self->path, (length $theme->{root} ? ("$theme->{root}/*") : ()), '-d', $staging);
+        } else {
+            @command = ('tar', '-xf', $self->path, '-C', $staging, '--no-same-owner',
+                        (length $theme->{root} ? ('--', $theme->{root}) : ()));
+        }
+
+        my $pid = $self->session->spawn_command(
+            command => \@command,
+            label => "install $theme->{name}",
+            on_exit => sub {
+                my ($exit_code, $output) = @_;
+
+                my $unpacked = length $theme->{root} ? "$staging/$theme->{root}" : $staging;
+                if ($exit_code != 0 || !-d $unpacked) {
+                    remove_tree($staging);
+                    return $args{on_done}->(0, "Unpacking failed:\n$output");
+                }
+
+                # The installed copy is set aside, not deleted, until the
+                # new one is in place, and put back if that fails
+                my $old = "$staging.old";
+                my $replacing = -e $target || -l $target;
+                if ($replacing && !rename($target, $old)) {
+                    my $error = $!;
+                    remove_tree($staging);
+                    return $args{on_done}->(0, "Cannot replace $target: $error");
+                }
+
+                my $ok = rename $unpacked, $target;
+                my $error = $!;
+                if ($replacing) {
+                    if ($ok) {
+                        -l $old ? unlink($old) : remove_tree($old);
+                    } else {
+                        rename $old, $target;
+                    }
+                }
+                remove_tree($staging) if -d $staging;
+                $ok ? $args{on_done}->(1, $target) : $args{on_done}->(0, "Cannot install to $target: $error");
+            },
+        );
+
+        unless ($pid) {
+            remove_tree($staging);
+            $args{on_done}->(0, 'Could not start ' . $command[0]);
+        }
+    }
+}
+
+1;
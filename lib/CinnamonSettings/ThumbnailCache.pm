@@ -0,0 +1,130 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - derived thumbnail cache
+# Stores pre-scaled copies of large theme screenshots in a
+# CinnamonSettings::PreviewCache, keyed by source path, mtime, file size and
+# target size, so a changed screenshot or a new zoom level simply maps to a
+# new file and no validation is needed. Scaling happens in helper processes
+# that decode straight to the target size, keeping full-resolution decodes
+# off the UI thread. A shared system cache built at install time is
+# consulted first when one is given.
+
+package CinnamonSettings::ThumbnailCache {
+    use Moo;
+    use File::Basename qw(basename dirname);
+    use Data::Dumper;
+    use CinnamonSettings::PreviewCache;
+
+    has 'cache_dir' => (is => 'ro', required => 1);
+    # CinnamonSettings::SystemCache section checked before cache_dir
+    has 'shared' => (is => 'ro');
+    # 0 leaves the directory unbounded (the system cache builder)
+    has 'disk_budget' => (is => 'ro', default => sub { 256 * 1024 * 1024 });
+    has 'previews' => (is => 'ro', lazy => 1, builder => '_build_previews');
+
+    sub _build_previews {
+        my $self = shift;
+        return CinnamonSettings::PreviewCache->new(
+            name => 'thumbnails',
+            cache_dir => $self->cache_dir,
+            disk_budget => $self->disk_budget,
+            shared => $self->shared,
+        );
+    }
+
+    sub key_for {
+        my ($self, $source, $width, $height) = @_;
+        return CinnamonSettings::PreviewCache->file_key($source, "-${width}x${height}.png");
+    }
+
+    # Cache file for $source scaled to fit $width x $height, or undef if the
+    # source cannot be stat'ed
+    sub path_for {
+        my ($self, $source, $width, $height) = @_;
+        return $self->previews->path_for($self->key_for($source, $width, $height));
+    }
+
+    # Cached thumbnail path if it has already been generated
+    sub lookup {
+        my ($self, $source, $width, $height) = @_;
+        return $self->previews->lookup($self->key_for($source, $width, $height));
+    }
+
+    # Write a surface rendered in-process (e.g. a synthesized preview) as
+    # the cache entry for $source at this size; returns the cache file
+    sub store_surface {
+        my ($self, $source, $width, $height, $surface) = @_;
+        return $self->previews->store_surface($self->key_for($source, $width, $height), $surface);
+    }
+
+    # Account for a cache file a worker has finished
+    sub adopt {
+        my ($self, $target) = @_;
+        return $self->previews->adopt(basename($target));
+    }
+
+    sub report_stats {
+        my $self = shift;
+        $self->previews->report_stats();
+    }
+
+    # Scale $source to fit $width x $height into the PNG $target; loaders
+    # that support it (JPEG, SVG) decode directly at that size
+    sub scale_file {
+        my ($class, $source, $target, $width, $height) = @_;
+
+        my $ok = eval {
+            my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file_at_scale($source, $width, $height, 1);
+            $pixbuf->savev("$target.part", 'png', [], []);
+            rename("$target.part", $target);
+        };
+        unlink("$target.part") unless $ok;
+        return $ok;
+    }
+
+    # Line sent to a worker running worker_script(); undef if a path
+    # cannot travel in the tab separated protocol
+    sub job_line {
+        my ($self, $job) = @_;
+
+        my @fields = @{$job}{qw(source target width height)};
+        return undef if grep { !defined $_ || /[\t\n]/ } @fields;
+        return join("\t", @fields);
+    }
+
+    # Long-lived helper script: reads job lines from DATA, scales each
+    # source into its cache file and prints "done|failed<TAB>cache_file"
+    sub worker_script {
+        my $self = shift;
+
+        my $lib_dir = dirname(dirname($INC{'CinnamonSettings/ThumbnailCache.pm'}));
+        my $lib_literal = Data::Dumper->new([$lib_dir])->Terse(1)->Useqq(1)->Dump();
+        chomp $lib_literal;
+
+        return <<"SCRIPT" . <<'SCRIPT';
+use strict;
+use warnings;
+use lib $lib_literal;
+SCRIPT
+use Gtk3;
+use CinnamonSettings::ThumbnailCache;
+use CinnamonSettings::Trace qw(TRACING trace_span);
+
+$| = 1;
+
+while (my $line = <DATA>) {
+    chomp $line;
+    my ($source, $target, $width, $height) = split /\t/, $line;
+    next unless defined $height;
+
+    my $span = TRACING && trace_span('thumbnail scale', source => $source, size => "${width}x${height}");
+    my $ok = CinnamonSettings::ThumbnailCache->scale_file($source, $target, $width, $height);
+    print $ok ? "done\t$target\n" : "failed\t$target\n";
+}
+SCRIPT
+    }
+}
+
+1;
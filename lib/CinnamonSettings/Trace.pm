@@ -0,0 +1,121 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - Trace Event tracing
+# Set CSM_TRACE=/path/to/trace.json to record scoped spans from the
+# managers, their Perl helpers and xcursor_extractor into one file in the
+# Trace Event JSON array format (chrome://tracing, Perfetto, Speedscope).
+# The first process to load this module truncates the file and marks
+# itself as the root in CSM_TRACE_ROOT. Helpers inherit both variables and
+# append their own events; single O_APPEND writes keep lines whole.
+#
+# Call sites guard spans with the TRACING constant:
+#     my $span = TRACING && trace_span('cursor.extract', theme => $name);
+# With tracing off the constant folds the expression away at compile time.
+# The span ends when $span goes out of scope or is undefined.
+
+package CinnamonSettings::Trace {
+    use Exporter 'import';
+    use Time::HiRes qw(clock_gettime CLOCK_MONOTONIC);
+    use Fcntl qw(O_WRONLY O_APPEND O_CREAT O_TRUNC);
+    use File::Spec;
+    use File::Basename qw(basename);
+    use JSON ();
+
+    our @EXPORT_OK = qw(TRACING trace_span trace_instant trace_milestone trace_process_name);
+
+    use constant TRACING => ($ENV{CSM_TRACE} ? 1 : 0);
+
+    my ($trace_fh, $is_root);
+    my %milestones;
+    my $json = JSON->new->canonical;
+
+    sub _now_us {
+        return clock_gettime(CLOCK_MONOTONIC) * 1_000_000;
+    }
+
+    sub _emit {
+        my $event = shift;
+        return unless $trace_fh;
+
+        @$event{qw(pid tid)} = ($$, $$);
+        syswrite($trace_fh, $json->encode($event) . ",\n");
+    }
+
+    sub _open_trace {
+        # Helpers may run in another directory
+        my $path = File::Spec->rel2abs($ENV{CSM_TRACE});
+        $ENV{CSM_TRACE} = $path;
+
+        $is_root = !$ENV{CSM_TRACE_ROOT};
+        my $flags = O_WRONLY | O_APPEND | O_CREAT | ($is_root ? O_TRUNC : 0);
+        unless (sysopen($trace_fh, $path, $flags)) {
+            print STDERR "Warning: Cannot open trace file $path: $!\n";
+            undef $trace_fh;
+            return;
+        }
+
+        if ($is_root) {
+            syswrite($trace_fh, "[\n");
+            $ENV{CSM_TRACE_ROOT} = $$;
+        }
+        trace_process_name(basename($0) eq '-' ? 'perl helper' : basename($0));
+    }
+
+    sub trace_process_name {
+        my $name = shift;
+        _emit({ name => 'process_name', ph => 'M', args => { name => $name } });
+    }
+
+    # Complete ("X") event covering the lifetime of the returned guard
+    sub trace_span {
+        my ($name, %args) = @_;
+        return bless [$name, _now_us(), \%args], 'CinnamonSettings::Trace::Span';
+    }
+
+    sub trace_instant {
+        my ($name, %args) = @_;
+        _emit({ name => $name, cat => 'csm', ph => 'i', s => 't', ts => _now_us(), args => \%args });
+    }
+
+    # Instant event recorded at most once per process, e.g. the first frame;
+    # the benchmark in perf/ reads these
+    sub trace_milestone {
+        my $name = shift;
+        return if $milestones{$name}++;
+        trace_instant($name);
+    }
+
+    _open_trace() if TRACING;
+
+    END {
+        # Close the array so strict JSON parsers accept the file too
+        if ($trace_fh && $is_root && $ENV{CSM_TRACE_ROOT} == $$) {
+            syswrite($trace_fh, $json->encode({
+                name => 'trace_end', ph => 'i', s => 'g', ts => _now_us(), pid => $$, tid => $$,
+            }) . "\n]\n");
+        }
+
+        # Spans still alive during global destruction are dropped
+        undef $trace_fh;
+    }
+}
+
+package CinnamonSettings::Trace::Span {
+    sub DESTROY {
+        my $self = shift;
+        my ($name, $start, $args) = @$self;
+
+        CinnamonSettings::Trace::_emit({
+            name => $name,
+            cat  => 'csm',
+            ph   => 'X',
+            ts   => $start,
+            dur  => CinnamonSettings::Trace::_now_us() - $start,
+            args => $args,
+        });
+    }
+}
+
+1;
@@ -0,0 +1,96 @@
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - per-directory view state
+# Everything the grid for one directory knows about its widgets: the item
+# behind each frame and the preview widget inside it, keyed by frame
+# address the way the managers look them up. A manager builds a new view
+# for every directory it shows and releases the old one, so nothing from a
+# previous directory outlives the switch. Widget references are weak and
+# an entry is forgotten as soon as its frame is destroyed, so the maps
+# never keep GTK objects (or a reused address) alive on their own.
+
+package CinnamonSettings::ViewState {
+    use Moo;
+    use Scalar::Util qw(weaken);
+
+    has 'path' => (is => 'ro');
+    has 'paths' => (is => 'rw', default => sub { {} });
+    has 'widgets' => (is => 'rw', default => sub { {} });
+    has 'frames' => (is => 'rw', default => sub { {} });
+    has 'released' => (is => 'rw', default => sub { 0 });
+
+    sub count {
+        return scalar keys %{$_[0]->paths};
+    }
+
+    # Record the item shown by $frame and, optionally, its preview widget
+    sub track {
+        my ($self, $frame, $info, $preview) = @_;
+
+        my $key = $frame + 0;
+        $self->paths->{$key} = $info;
+        $self->set_widget($frame, $preview) if $preview;
+
+        return if $self->frames->{$key};
+        $self->frames->{$key} = $frame;
+        weaken($self->frames->{$key});
+
+        # The handler holds neither the frame nor a strong view reference
+        my $view = $self;
+        weaken($view);
+        $frame->signal_connect(destroy => sub { $view->forget($key) if $view });
+    }
+
+    # Replace the preview widget of an already tracked frame
+    sub set_widget {
+        my ($self, $frame, $widget) = @_;
+
+        my $key = $frame + 0;
+        $self->widgets->{$key} = $widget;
+        weaken($self->widgets->{$key});
+    }
+
+    sub forget {
+        my ($self, $key) = @_;
+
+        delete $self->paths->{$key};
+        delete $self->widgets->{$key};
+        delete $self->frames->{$key};
+    }
+
+    # Called when the manager moves to another directory: destroys frames
+    # that are still around and drops every entry
+    sub release {
+        my $self = shift;
+        return if $self->released;
+
+        $self->released(1);
+        foreach my $frame (grep { defined } values %{$self->frames}) {
+            $frame->destroy();
+        }
+        $self->paths({});
+        $self->widgets({});
+        $self->frames({});
+    }
+
+    # Whether the grid child holding $frame is at least partly inside the
+    # visible area of the scrolled window $scrolled, e.g. to load its
+    # preview first
+    sub frame_visible {
+        my ($class, $frame, $scrolled) = @_;
+
+        my $child = $frame->get_parent() or return 0;
+        my $allocation = $child->get_allocation();
+        return 0 unless $allocation->{height} > 1;
+
+        my $adjustment = $scrolled->get_vadjustment();
+        my $top = $adjustment->get_value();
+        my $bottom = $top + $adjustment->get_page_size();
+
+        return ($allocation->{y} + $allocation->{height} >= $top && $allocation->{y} <= $bottom);
+    }
+}
+
+1;
@@ -0,0 +1,695 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - headless performance benchmark
+# Launches every manager on a private Xvfb display against the synthetic
+# corpus with tracing enabled and derives from its trace file:
+#   time_to_window_ms         first frame of the main window
+#   time_to_first_preview_ms  first scheduler step that put a preview on screen
+#   time_to_all_previews_ms   end of the last traced work before the manager idled
+#   peak_rss_kib              VmHWM of the manager process
+#   spawns                    processes forked on the machine during the run
+#   stalls                    main loop stalls reported by the stall detector
+# Each repetition runs a manager cold (fresh HOME, no caches) and then warm
+# (same HOME again); the median of the repetitions is reported. Every run
+# starts its own preview daemon and stops it afterwards, so warm runs are
+# warm through the disk caches only. Results are written as JSON and, given
+# a baseline, compared with per-metric thresholds.
+#
+# With --soak N each manager instead gets several shelves of the corpus as
+# directories and switches between them N times (CSM_SOAK_SWITCHES); the
+# run fails if resident memory over the last quarter of the switches is
+# still above the second quarter by more than the soak.rss_growth_kib
+# threshold, i.e. if memory does not level off.
+
+use FindBin;
+
+package CinnamonPerfBenchmark {
+    use Moo;
+    use JSON;
+    use Getopt::Long qw(GetOptionsFromArray);
+    use POSIX qw(setsid strftime WNOHANG);
+    use Fcntl qw(F_GETFD F_SETFD FD_CLOEXEC);
+    use File::Temp qw(tempdir);
+    use File::Path qw(make_path remove_tree);
+    use File::Spec;
+    use Time::HiRes qw(clock_gettime CLOCK_MONOTONIC sleep);
+    use Sys::Hostname qw(hostname);
+
+    my @METRICS = qw(
+        time_to_window_ms time_to_first_preview_ms time_to_all_previews_ms
+        peak_rss_kib spawns stalls
+    );
+
+    # preview_task matches the scheduler step spans that show previews
+    my @MANAGERS = (
+        {
+            name => 'settings',
+            script => 'cinnamon-settings-manager.pl',
+            preview_task => qr/^settings: create module rows$/,
+        },
+        {
+            name => 'themes',
+            script => 'cinnamon-themes-manager.pl',
+            config => 'cinnamon-theme-manager',
+            corpus => 'themes',
+            preview_task => qr/^cinnamon themes: create theme widgets$/,
+        },
+        {
+            name => 'application-themes',
+            script => 'cinnamon-application-themes-manager.pl',
+            config => 'cinnamon-application-themes-manager',
+            corpus => 'themes',
+            preview_task => qr/^gtk themes: create theme widgets$/,
+        },
+        {
+            name => 'icons',
+            script => 'cinnamon-icon-themes-manager.pl',
+            config => 'cinnamon-icons-theme-manager',
+            corpus => 'icons',
+            preview_task => qr/^icons: create theme widgets$/,
+        },
+        {
+            name => 'cursors',
+            script => 'cinnamon-cursor-themes-manager.pl',
+            config => 'cinnamon-cursor-theme-manager',
+            corpus => 'cursors',
+            preview_task => qr/^cursor: create theme widgets$/,
+        },
+        {
+            name => 'backgrounds',
+            script => 'cinnamon-backgrounds-manager.pl',
+            config => 'cinnamon-backgrounds-manager',
+            corpus => 'backgrounds',
+            preview_task => qr/^backgrounds: (?:load cached thumbnail|create thumbnail)$/,
+        },
+        {
+            name => 'fonts',
+            script => 'cinnamon-font-manager.pl',
+            config => 'cinnamon-font-manager',
+            corpus => 'fonts',
+            preview_task => qr/^fonts: create font rows$/,
+        },
+    );
+
+    has 'repo_dir' => (is => 'ro', required => 1);
+    has 'corpus' => (is => 'rw');
+    has 'output' => (is => 'rw');
+    has 'baseline' => (is => 'rw');
+    has 'thresholds' => (is => 'rw');
+    has 'repeat' => (is => 'rw', default => sub { 3 });
+    has 'settle_ms' => (is => 'rw', default => sub { 3000 });
+    has 'timeout_s' => (is => 'rw', default => sub { 120 });
+    has 'stall_threshold_ms' => (is => 'rw', default => sub { 50 });
+    has 'only' => (is => 'rw', default => sub { [] });
+    has 'soak' => (is => 'rw', default => sub { 0 });
+    has 'soak_shelves' => (is => 'rw', default => sub { 4 });
+    has 'display' => (is => 'rw');
+    has 'xvfb_pid' => (is => 'rw');
+
+    sub run {
+        my ($self, @argv) = @_;
+
+        my $usage = "Usage: $0 --corpus DIR [--output FILE] [--baseline FILE] [--thresholds FILE]\n"
+                  . "       [--repeat N] [--settle-ms MS] [--timeout S] [--stall-ms MS] [--only NAME]...\n"
+                  . "       [--soak SWITCHES [--shelves N]]\n";
+        my (@only, $help);
+        GetOptionsFromArray(\@argv,
+            'corpus=s'       => sub { $self->corpus($_[1]) },
+            'output=s'       => sub { $self->output($_[1]) },
+            'baseline=s'     => sub { $self->baseline($_[1]) },
+            'thresholds=s'   => sub { $self->thresholds($_[1]) },
+            'repeat=i'       => sub { $self->repeat($_[1]) },
+            'settle-ms=i'    => sub { $self->settle_ms($_[1]) },
+            'timeout=i'      => sub { $self->timeout_s($_[1]) },
+            'stall-ms=i'     => sub { $self->stall_threshold_ms($_[1]) },
+            'soak=i'         => sub { $self->soak($_[1]) },
+            'shelves=i'      => sub { $self->soak_shelves($_[1]) },
+            'only=s'         => \@only,
+            'help'           => \$help,
+        ) or die $usage;
+
+        if ($help) {
+            print $usage;
+            return 0;
+        }
+        $self->only([map { split /,/ } @only]);
+
+        die "Corpus directory not found: " . ($self->corpus || '(none)') . " (run 'make perf-corpus')\n"
+            unless $self->corpus && -d $self->corpus;
+        $self->corpus(File::Spec->rel2abs($self->corpus));
+
+        return $self->_soak_all() ? 0 : 1 if $self->soak;
+
+        my $results = $self->_run_all();
+
+        if ($self->output) {
+            $self->_write_json($self->output, $results);
+            print "Results written to " . $self->output . "\n";
+        }
+
+        return 0 unless $self->baseline;
+        if (!-f $self->baseline) {
+            print "No baseline at " . $self->baseline . "; run 'make perf-baseline' to record one\n";
+            return 0;
+        }
+
+        return $self->_compare($results, _read_json($self->baseline)) ? 0 : 1;
+    }
+
+    sub _selected_managers {
+        my $self = shift;
+
+        my @managers = @MANAGERS;
+        if (@{$self->only}) {
+            my %wanted = map { $_ => 1 } @{$self->only};
+            @managers = grep { $wanted{$_->{name}} } @managers;
+        }
+        return @managers;
+    }
+
+    sub _run_all {
+        my $self = shift;
+
+        my @managers = $self->_selected_managers();
+
+        $self->_start_xvfb();
+
+        my %runs;
+        my $ok = eval {
+            foreach my $manager (@managers) {
+                my (@cold, @warm);
+                for my $round (1 .. $self->repeat) {
+                    my $home = tempdir('csm-perf-XXXXXX', TMPDIR => 1);
+                    $self->_prepare_home($manager, $home);
+
+                    push @cold, $self->_run_once($manager, $home);
+                    push @warm, $self->_run_once($manager, $home);
+
+                    remove_tree($home);
+                }
+
+                $runs{$manager->{name}} = { cold => _median_run(\@cold), warm => _median_run(\@warm) };
+                _print_run($manager->{name}, $runs{$manager->{name}});
+            }
+            1;
+        };
+        my $error = $@;
+        $self->_stop_xvfb();
+        die $error unless $ok;
+
+        return {
+            generated => strftime('%Y-%m-%dT%H:%M:%S', localtime),
+            host => hostname(),
+            perl => sprintf('%vd', $^V),
+            corpus => $self->corpus,
+            repeat => $self->repeat,
+            settle_ms => $self->settle_ms,
+            stall_threshold_ms => $self->stall_threshold_ms,
+            managers => \%runs,
+        };
+    }
+
+    # One soak run per manager that browses directories; returns false if
+    # any of them kept growing
+    sub _soak_all {
+        my $self = shift;
+
+        my $thresholds = $self->thresholds && -f $self->thresholds ? _read_json($self->thresholds) : {};
+        my @managers = grep { $_->{config} } $self->_selected_managers();
+
+        $self->_start_xvfb();
+
+        my (%runs, @failures);
+        my $ok = eval {
+            foreach my $manager (@managers) {
+                my $home = tempdir('csm-soak-XXXXXX', TMPDIR => 1);
+                my @shelves = $self->_prepare_shelves($manager, $home);
+                $self->_prepare_home($manager, $home, @shelves);
+
+                my $run = $self->_soak_once($manager, $home);
+                my $limit = _threshold($thresholds, $manager->{name}, 'soak', 'rss_growth_kib');
+                $run->{plateau} = (defined $run->{rss_growth_kib}
+                    && !$run->{timed_out}
+                    && ($run->{rss_growth_kib} <= $limit->{min_delta}
+                        || $run->{rss_growth_kib} <= $run->{rss_settled_kib} * $limit->{percent} / 100))
+                    ? JSON::true : JSON::false;
+
+                printf "%-20s soak  switches=%s rss_start=%s rss_settled=%s rss_end=%s growth=%s%s\n",
+                    $manager->{name}, map({ defined $_ ? $_ : '-' } @{$run}{qw(switches rss_start_kib rss_settled_kib rss_end_kib rss_growth_kib)}),
+                    $run->{plateau} ? '' : ($run->{timed_out} ? '  TIMED OUT' : '  STILL GROWING');
+                push @failures, $manager->{name} unless $run->{plateau};
+
+                $runs{$manager->{name}} = $run;
+                remove_tree($home);
+            }
+            1;
+        };
+        my $error = $@;
+        $self->_stop_xvfb();
+        die $error unless $ok;
+
+        if ($self->output) {
+            $self->_write_json($self->output, {
+                generated => strftime('%Y-%m-%dT%H:%M:%S', localtime),
+                host => hostname(),
+                corpus => $self->corpus,
+                switches => $self->soak,
+                managers => \%runs,
+            });
+            print "Results written to " . $self->output . "\n";
+        }
+
+        if (@failures) {
+            print "\nMemory did not level off in: @failures\n";
+            return 0;
+        }
+        print "\nMemory levelled off in every manager\n";
+        return 1;
+    }
+
+    # Split the manager's corpus into shelves of symlinks so there are
+    # several directories to switch between
+    sub _prepare_shelves {
+        my ($self, $manager, $home) = @_;
+
+        my $path = $self->corpus . '/' . $manager->{corpus};
+        die "Corpus directory missing: $path\n" unless -d $path;
+
+        opendir(my $dh, $path) or die "Cannot read $path: $!\n";
+        my @entries = sort grep { !/^\./ } readdir($dh);
+        closedir($dh);
+
+        my @shelves = map { "$home/shelves/$manager->{corpus}-$_" } 1 .. $self->soak_shelves;
+        make_path(@shelves);
+        for my $i (0 .. $#entries) {
+            my $shelf = $shelves[$i % @shelves];
+            symlink("$path/$entries[$i]", "$shelf/$entries[$i]") or die "Cannot link into $shelf: $!\n";
+        }
+
+        return @shelves;
+    }
+
+    sub _soak_once {
+        my ($self, $manager, $home) = @_;
+
+        my $trace = "$home/trace.json";
+        my $start = _now_us();
+        my $pid = $self->_spawn_manager($manager, $home, $trace, CSM_SOAK_SWITCHES => $self->soak);
+
+        # The manager closes itself after the last switch
+        my $timed_out = 0;
+        until (waitpid($pid, WNOHANG) == $pid) {
+            sleep(0.5);
+            next if _now_us() - $start < $self->timeout_s * 1_000_000;
+            $timed_out = 1;
+            $self->_stop_manager($pid);
+            last;
+        }
+        $self->_stop_daemon($home, $pid);
+
+        my @samples;
+        if (open my $fh, '<', $trace) {
+            while (my $line = <$fh>) {
+                next unless $line =~ /"soak sample"/;
+                $line =~ s/,?\s*$//;
+                my $event = eval { decode_json($line) } or next;
+                push @samples, $event->{args} if $event->{pid} == $pid;
+            }
+            close $fh;
+        }
+
+        # The second quarter is past the first visit to every shelf and
+        # cache warm-up; a plateau means the last quarter is no higher
+        my @rss = map { $_->{rss_kib} } @samples;
+        my $quarter = int(@rss / 4);
+        my $median = sub { my @v = sort { $a <=> $b } @_; @v ? $v[$#v / 2] : undef };
+        my $settled = $quarter ? $median->(@rss[$quarter .. 2 * $quarter - 1]) : undef;
+        my $end = $quarter ? $median->(@rss[-$quarter .. -1]) : undef;
+
+        return {
+            switches => @samples ? $samples[-1]{switch} : 0,
+            samples => scalar @samples,
+            rss_start_kib => $rss[0],
+            rss_settled_kib => $settled,
+            rss_end_kib => $end,
+            rss_growth_kib => defined $settled ? $end - $settled : undef,
+            timed_out => $timed_out ? JSON::true : JSON::false,
+        };
+    }
+
+    # Xvfb picks a free display and reports it on the -displayfd pipe
+    sub _start_xvfb {
+        my $self = shift;
+
+        die "Xvfb not found; install it (e.g. apt install xvfb) to run the benchmark\n"
+            unless system('command -v Xvfb >/dev/null 2>&1') == 0;
+
+        pipe(my $reader, my $writer) or die "Cannot create pipe: $!";
+        my $pid = fork();
+        die "Cannot fork: $!" unless defined $pid;
+
+        if ($pid == 0) {
+            close $reader;
+            my $flags = fcntl($writer, F_GETFD, 0);
+            fcntl($writer, F_SETFD, $flags & ~FD_CLOEXEC);
+            open STDOUT, '>', '/dev/null';
+            open STDERR, '>', '/dev/null';
+            exec('Xvfb', '-displayfd', fileno($writer), '-screen', '0', '1600x1200x24', '-nolisten', 'tcp')
+                or POSIX::_exit(127);
+        }
+
+        close $writer;
+        my $display = <$reader>;
+        close $reader;
+        die "Xvfb did not start\n" unless defined $display && $display =~ /^(\d+)/;
+
+        $self->display(":$1");
+        $self->xvfb_pid($pid);
+    }
+
+    sub _stop_xvfb {
+        my $self = shift;
+        return unless $self->xvfb_pid;
+
+        kill 'TERM', $self->xvfb_pid;
+        waitpid($self->xvfb_pid, 0);
+        $self->xvfb_pid(undef);
+    }
+
+    # Point the manager at its corpus directory (or the given shelves) and
+    # select the first one on launch
+    sub _prepare_home {
+        my ($self, $manager, $home, @paths) = @_;
+        return unless $manager->{config};
+
+        if (!@paths) {
+            my $path = $self->corpus . '/' . $manager->{corpus};
+            die "Corpus directory missing: $path\n" unless -d $path;
+            @paths = ($path);
+        }
+
+        my $config_dir = "$home/.local/share/$manager->{config}/config";
+        make_path($config_dir);
+        $self->_write_json("$config_dir/settings.json", {
+            custom_directories => [
+                map { { name => @paths > 1 ? "Benchmark shelf " . ($_ + 1) : 'Benchmark corpus', path => $paths[$_] } } 0 .. $#paths
+            ],
+            last_selected_directory => $paths[0],
+        });
+    }
+
+    sub _run_once {
+        my ($self, $manager, $home) = @_;
+
+        my $trace = "$home/trace.json";
+
+        my $forks_before = _forks();
+        my $start = _now_us();
+        my $pid = $self->_spawn_manager($manager, $home, $trace);
+
+        # Wait until the trace has been quiet for settle_ms
+        my ($last_size, $last_change, $peak_rss, $exited, $timed_out) = (0, $start, 0, 0, 0);
+        while (1) {
+            sleep(0.1);
+
+            my $rss = _peak_rss($pid);
+            $peak_rss = $rss if $rss;
+
+            if (waitpid($pid, WNOHANG) == $pid) {
+                $exited = 1;
+                last;
+            }
+
+            my $now = _now_us();
+            my $size = -s $trace || 0;
+            if ($size != $last_size) {
+                ($last_size, $last_change) = ($size, $now);
+            } elsif ($size && $now - $last_change >= $self->settle_ms * 1000) {
+                last;
+            }
+
+            if ($now - $start >= $self->timeout_s * 1_000_000) {
+                $timed_out = 1;
+                last;
+            }
+        }
+
+        my $spawns = _forks() - $forks_before - 1;
+        $self->_stop_manager($pid) unless $exited;
+        $self->_stop_daemon($home, $pid);
+
+        my $run = $self->_analyze_trace($manager, $trace, $pid, $start);
+        $run->{peak_rss_kib} = $peak_rss || undef;
+        $run->{spawns} = $spawns;
+        $run->{timed_out} = $timed_out ? JSON::true : JSON::false;
+        print STDERR "Warning: $manager->{name} exited early, see $home/manager.log\n" if $exited;
+
+        return $run;
+    }
+
+    sub _spawn_manager {
+        my ($self, $manager, $home, $trace, %env) = @_;
+
+        unlink $trace;
+        my $pid = fork();
+        die "Cannot fork: $!" unless defined $pid;
+        return $pid if $pid;
+
+        # Own session so the manager and its helpers can be stopped together
+        setsid();
+        delete @ENV{qw(CSM_TRACE_ROOT CSM_DEBUG CSM_SOAK_SWITCHES DBUS_SESSION_BUS_ADDRESS)};
+        $ENV{HOME} = $home;
+        $ENV{XDG_CONFIG_HOME} = "$home/.config";
+        $ENV{XDG_CACHE_HOME} = "$home/.cache";
+        $ENV{XDG_DATA_HOME} = "$home/.local/share";
+        # A preview daemon of its own, so no run is served by the hot
+        # cache of an earlier one
+        $ENV{XDG_RUNTIME_DIR} = _runtime_dir($home, $$);
+        mkdir($ENV{XDG_RUNTIME_DIR}, 0700);
+        $ENV{DISPLAY} = $self->display;
+        $ENV{GSETTINGS_BACKEND} = 'memory';
+        $ENV{NO_AT_BRIDGE} = 1;
+        $ENV{CSM_TRACE} = $trace;
+        $ENV{CSM_STALL_THRESHOLD_MS} = $self->stall_threshold_ms;
+        @ENV{keys %env} = values %env;
+
+        chdir $self->repo_dir;
+        open STDOUT, '>>', "$home/manager.log";
+        open STDERR, '>&', \*STDOUT;
+        exec($^X, $manager->{script}) or POSIX::_exit(127);
+    }
+
+    sub _stop_manager {
+        my ($self, $pid) = @_;
+
+        kill 'TERM', -$pid;
+        for (1 .. 20) {
+            return if waitpid($pid, WNOHANG) == $pid;
+            sleep(0.1);
+        }
+        kill 'KILL', -$pid;
+        waitpid($pid, 0);
+    }
+
+    # The preview daemon detaches from the manager's session, so it is
+    # found through the pid in its lock file
+    sub _stop_daemon {
+        my ($self, $home, $pid) = @_;
+
+        my $lock = _runtime_dir($home, $pid) . '/cinnamon-settings-manager/daemon.lock';
+        open(my $fh, '<', $lock) or return;
+        my $daemon = <$fh>;
+        close $fh;
+        return unless defined $daemon && $daemon =~ /^(\d+)$/;
+        $daemon = $1;
+
+        kill 'TERM', $daemon or return;
+        for (1 .. 30) {
+            return unless kill 0, $daemon;
+            sleep(0.1);
+        }
+        kill 'KILL', $daemon;
+    }
+
+    sub _runtime_dir {
+        my ($home, $pid) = @_;
+        return "$home/runtime-$pid";
+    }
+
+    # The manager is stopped without running END blocks, so the trace
+    # array is left open; read it line by line instead
+    sub _analyze_trace {
+        my ($self, $manager, $trace, $pid, $start) = @_;
+
+        my ($window, $first_preview, $last_event, $stalls) = (undef, undef, undef, 0);
+
+        open my $fh, '<', $trace or return { stalls => undef };
+        while (my $line = <$fh>) {
+            $line =~ s/,?\s*$//;
+            next unless $line =~ /^\{/;
+            my $event = eval { decode_json($line) } or next;
+            next if $event->{ph} eq 'M' || $event->{name} eq 'trace_end';
+
+            my $end = $event->{ts} + ($event->{dur} || 0);
+            $last_event = $end if !defined $last_event || $end > $last_event;
+            next unless $event->{pid} == $pid;
+
+            if ($event->{name} eq 'window drawn') {
+                $window = $event->{ts} if !defined $window;
+            } elsif ($event->{name} eq 'main loop stall') {
+                $stalls++;
+            } elsif ($event->{ph} eq 'X' && $event->{name} =~ $manager->{preview_task}) {
+                $first_preview = $end if !defined $first_preview || $end < $first_preview;
+            }
+        }
+        close $fh;
+
+        my $ms = sub { defined $_[0] ? int(($_[0] - $start) / 1000 + 0.5) : undef };
+        return {
+            time_to_window_ms => $ms->($window),
+            time_to_first_preview_ms => $ms->($first_preview),
+            time_to_all_previews_ms => $ms->($last_event),
+            stalls => $stalls,
+        };
+    }
+
+    sub _compare {
+        my ($self, $results, $baseline) = @_;
+
+        my $thresholds = $self->thresholds && -f $self->thresholds ? _read_json($self->thresholds) : {};
+        my @regressions;
+
+        printf "\n%-20s %-5s %-25s %10s %10s %8s\n", 'manager', 'phase', 'metric', 'baseline', 'current', 'change';
+        foreach my $name (sort keys %{$results->{managers}}) {
+            my $base_runs = $baseline->{managers}{$name} or next;
+
+            foreach my $phase (qw(cold warm)) {
+                my $current = $results->{managers}{$name}{$phase};
+                my $base = $base_runs->{$phase} or next;
+
+                foreach my $metric (@METRICS) {
+                    next unless defined $base->{$metric};
+                    my $limit = _threshold($thresholds, $name, $phase, $metric);
+                    my $value = $current->{$metric};
+
+                    my ($change, $regressed);
+                    if (!defined $value) {
+                        ($change, $regressed) = ('missing', 1);
+                    } else {
+                        my $delta = $value - $base->{$metric};
+                        $change = $base->{$metric} ? sprintf('%+.0f%%', 100 * $delta / $base->{$metric}) : sprintf('%+d', $delta);
+                        $regressed = $delta > $limit->{min_delta}
+                            && $delta > $base->{$metric} * $limit->{percent} / 100;
+                    }
+
+                    printf "%-20s %-5s %-25s %10s %10s %8s%s\n", $name, $phase, $metric,
+                        $base->{$metric}, defined $value ? $value : '-', $change, $regressed ? '  REGRESSION' : '';
+                    push @regressions, "$name $phase $metric" if $regressed;
+                }
+            }
+        }
+
+        if (@regressions) {
+            print "\n" . @regressions . " regression(s) against " . $self->baseline . ":\n";
+            print "  $_\n" foreach @regressions;
+            return 0;
+        }
+
+        print "\nNo regressions against " . $self->baseline . "\n";
+        return 1;
+    }
+
+    # Most specific entry wins: "manager.phase.metric", "manager.metric",
+    # then the metric default, then the global default
+    sub _threshold {
+        my ($thresholds, $name, $phase, $metric) = @_;
+
+        my $overrides = $thresholds->{overrides} || {};
+        my $limit = $overrides->{"$name.$phase.$metric"}
+            || $overrides->{"$name.$metric"}
+            || ($thresholds->{metrics} || {})->{$metric}
+            || $thresholds->{default}
+            || {};
+
+        return {
+            percent => defined $limit->{percent} ? $limit->{percent} : 10,
+            min_delta => defined $limit->{min_delta} ? $limit->{min_delta} : 0,
+        };
+    }
+
+    sub _median_run {
+        my $runs = shift;
+
+        my %median;
+        foreach my $metric (@METRICS) {
+            my @values = sort { $a <=> $b } grep { defined } map { $_->{$metric} } @$runs;
+            $median{$metric} = @values ? $values[$#values / 2] : undef;
+        }
+        $median{timed_out} = (grep { $_->{timed_out} } @$runs) ? JSON::true : JSON::false;
+
+        return \%median;
+    }
+
+    sub _print_run {
+        my ($name, $run) = @_;
+
+        foreach my $phase (qw(cold warm)) {
+            my $metrics = $run->{$phase};
+            printf "%-20s %-5s %s%s\n", $name, $phase,
+                join(' ', map { "$_=" . (defined $metrics->{$_} ? $metrics->{$_} : '-') } @METRICS),
+                $metrics->{timed_out} ? ' (timed out)' : '';
+        }
+    }
+
+    sub _now_us {
+        return clock_gettime(CLOCK_MONOTONIC) * 1_000_000;
+    }
+
+    # Total forks since boot, from /proc/stat
+    sub _forks {
+        open my $fh, '<', '/proc/stat' or return 0;
+        while (<$fh>) {
+            return $1 if /^processes\s+(\d+)/;
+        }
+        return 0;
+    }
+
+    sub _peak_rss {
+        my $pid = shift;
+
+        open my $fh, '<', "/proc/$pid/status" or return undef;
+        while (<$fh>) {
+            return $1 if /^VmHWM:\s+(\d+)/;
+        }
+        return undef;
+    }
+
+    sub _read_json {
+        my $file = shift;
+
+        open my $fh, '<', $file or die "Cannot read $file: $!\n";
+        my $json = do { local $/; <$fh> };
+        close $fh;
+        return JSON->new->decode($json);
+    }
+
+    sub _write_json {
+        my ($self, $file, $data) = @_;
+
+        open my $fh, '>', "$file.part" or die "Cannot write $file.part: $!\n";
+        print $fh JSON->new->pretty->canonical->encode($data);
+        close $fh;
+        rename "$file.part", $file or die "Cannot rename $file.part: $!\n";
+    }
+}
+
+# Main execution
+if (!caller) {
+    my $benchmark = CinnamonPerfBenchmark->new(repo_dir => "$FindBin::RealBin/..");
+    exit $benchmark->run(@ARGV);
+}
+
+1;
@@ -0,0 +1,996 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use utf8;
+
+# Cinnamon Settings Manager - synthetic corpus generator
+# Writes a deterministic corpus of icon themes, cursor themes, GTK/Cinnamon
+# themes, fonts and wallpapers for the benchmark and for scale testing.
+# Every item is drawn from its own random stream derived from the seed, the
+# kind and its index, so a larger scale adds items without changing the
+# ones a smaller scale produced. Images and Xcursor files are encoded in
+# pure Perl; JPEG, TIFF and BMP wallpapers need gdk-pixbuf (Gtk3) and fall
+# back to PNG without it. Fonts are copies of installed fonts with new name
+# tables and some optional tables dropped.
+
+use FindBin;
+
+package CinnamonCorpusGenerator {
+    use Moo;
+    use JSON;
+    use Encode qw(encode);
+    use Digest::MD5 qw(md5);
+    use Compress::Zlib qw(compress crc32);
+    use File::Find qw(find);
+    use File::Path qw(make_path remove_tree);
+    use File::Basename qw(basename);
+    use File::Spec;
+    use Getopt::Long qw(GetOptionsFromArray);
+    use POSIX qw(floor);
+
+    use constant GENERATOR_VERSION => 1;
+
+    my %PRESETS = (
+        small      => { icon_themes => 12,  cursor_themes => 8,   themes => 16,  fonts => 60,    wallpapers => 80 },
+        medium     => { icon_themes => 60,  cursor_themes => 40,  themes => 60,  fonts => 2000,  wallpapers => 5000 },
+        production => { icon_themes => 300, cursor_themes => 200, themes => 150, fonts => 20000, wallpapers => 50000 },
+    );
+
+    my @NAME_PREFIXES = qw(
+        Arc Mint Nordic Adapta Materia Yaru Orchis Qogir Vimix Matcha Sweet Canta
+        Layan Graphite Fluent Colloid Jasper Lavanda Kripton Obsidian Azure Paper
+        Numix Ant Dracula Gruvbox Solar Everforest Juno Nova Tela Zafiro Papirus
+    );
+    my @NAME_SUFFIXES = ('', '-Dark', '-Light', '-Darker', '-Blue', '-Teal', '-Aqua',
+        '-Grey', '-Compact', '-Round', '-Solid', '-Nord');
+
+    my @ICON_CONTEXTS = (
+        [actions => 'Actions', qw(
+            document-new document-open document-save edit-copy edit-cut edit-paste
+            edit-delete edit-find go-next go-previous go-home view-refresh list-add
+            list-remove window-close)],
+        [apps => 'Applications', qw(
+            firefox thunderbird libreoffice-writer gimp inkscape utilities-terminal
+            nemo system-software-install preferences-desktop accessories-calculator
+            accessories-text-editor vlc rhythmbox)],
+        [categories => 'Categories', qw(
+            applications-accessories applications-games applications-graphics
+            applications-internet applications-multimedia applications-office
+            applications-system preferences-system)],
+        [devices => 'Devices', qw(
+            computer drive-harddisk drive-removable-media media-optical printer
+            input-keyboard input-mouse audio-card camera-photo phone)],
+        [emblems => 'Emblems', qw(
+            emblem-default emblem-favorite emblem-important emblem-readonly
+            emblem-symbolic-link emblem-shared)],
+        [mimetypes => 'MimeTypes', qw(
+            application-x-shellscript application-x-php application-x-ruby
+            text-x-javascript text-plain text-x-generic x-office-document
+            x-office-presentation x-office-spreadsheet application-x-tar
+            application-x-executable application-executable image image-x-generic
+            audio-x-generic video-x-generic application-pdf)],
+        [places => 'Places', qw(
+            folder user-home user-desktop desktop user-trash folder-documents
+            folder-download folder-music folder-pictures folder-videos network-workgroup)],
+        [status => 'Status', qw(
+            dialog-error dialog-information dialog-warning battery-full
+            network-wireless audio-volume-high)],
+    );
+
+    # Names the icon theme manager shows in its previews are always present
+    my %PREVIEW_ICONS = map { $_ => 1 } qw(
+        computer folder desktop user-trash application-x-shellscript application-x-php
+        application-x-ruby text-x-javascript text-plain x-office-document
+        x-office-presentation x-office-spreadsheet application-x-tar image
+        application-executable printer
+    );
+
+    # Cursor shapes and the aliases real themes ship as symlinks
+    my @CURSORS = (
+        [left_ptr => 'arrow', qw(default arrow top_left_arrow)],
+        [hand2 => 'hand', qw(hand1 hand pointer pointing_hand)],
+        [xterm => 'beam', qw(text ibeam)],
+        [watch => 'ring', qw(wait)],
+        [left_ptr_watch => 'ring', qw(progress half-busy)],
+        [cross => 'cross', qw(crosshair tcross)],
+        [fleur => 'cross', qw(size_all move all-scroll)],
+        [sb_h_double_arrow => 'hbar', qw(h_resize col-resize ew-resize)],
+        [sb_v_double_arrow => 'vbar', qw(v_resize row-resize ns-resize)],
+        [top_left_corner => 'corner', qw(nw-resize)],
+        [top_right_corner => 'corner', qw(ne-resize)],
+        [bottom_left_corner => 'corner', qw(sw-resize)],
+        [bottom_right_corner => 'corner', qw(se-resize)],
+        [question_arrow => 'arrow', qw(help whats_this)],
+        [pirate => 'ring', qw(forbidden not-allowed no-drop)],
+        [plus => 'cross', qw(copy dnd-copy)],
+        [grabbing => 'hand', qw(closedhand dnd-move)],
+        [bd_double_arrow => 'hbar', qw(size_bdiag nesw-resize)],
+        [fd_double_arrow => 'hbar', qw(size_fdiag nwse-resize)],
+    );
+
+    my @WALLPAPER_SIZES = (
+        [1920, 1080, 30], [2560, 1440, 15], [3840, 2160, 10], [1366, 768, 10],
+        [1280, 720, 10], [5120, 2880, 3], [1080, 1920, 5], [3440, 1440, 5],
+        [1600, 1200, 5], [800, 600, 7],
+    );
+    my @WALLPAPER_FORMATS = ([jpg => 50], [png => 30], [svg => 10], [tiff => 5], [bmp => 5]);
+
+    my @FONT_WORDS = qw(
+        Aster Brio Calla Delta Ember Fable Garnet Halo Iris Juniper Kestrel Lumen
+        Meridian Nimbus Onyx Pioneer Quartz Ridge Sable Tundra Umber Vesper Willow
+        Xenon Yarrow Zephyr
+    );
+    my @FONT_CLASSES = ('Sans', 'Serif', 'Mono', 'Grotesk', 'Display', 'Rounded', 'Slab', 'Text');
+    my @FONT_STYLES = ('Regular', 'Bold', 'Italic', 'Bold Italic', 'Light', 'Medium',
+        'SemiBold', 'Black', 'Thin', 'Condensed');
+    my @FONT_OPTIONAL_TABLES = qw(GPOS GSUB kern hdmx LTSH VDMX);
+
+    has 'output' => (is => 'rw');
+    has 'seed' => (is => 'rw', default => sub { 1 });
+    has 'scale' => (is => 'rw', default => sub { 'small' });
+    has 'counts' => (is => 'rw', default => sub { {} });
+    has 'css_kb' => (is => 'rw', default => sub { 160 });
+    has 'font_source' => (is => 'rw', default => sub { '/usr/share/fonts' });
+    has 'has_pixbuf' => (is => 'lazy');
+
+    sub _build_has_pixbuf {
+        return eval { require Gtk3; 1 } ? 1 : 0;
+    }
+
+    sub run {
+        my ($self, @argv) = @_;
+
+        my $usage = "Usage: $0 --output DIR [--seed N] [--scale small|medium|production]\n"
+                  . "       [--icon-themes N] [--cursor-themes N] [--themes N] [--fonts N]\n"
+                  . "       [--wallpapers N] [--css-kb N] [--font-source DIR]\n";
+        my (%counts, $help);
+        GetOptionsFromArray(\@argv,
+            'output=s'        => sub { $self->output($_[1]) },
+            'seed=i'          => sub { $self->seed($_[1]) },
+            'scale=s'         => sub { $self->scale($_[1]) },
+            'css-kb=i'        => sub { $self->css_kb($_[1]) },
+            'font-source=s'   => sub { $self->font_source($_[1]) },
+            'icon-themes=i'   => \$counts{icon_themes},
+            'cursor-themes=i' => \$counts{cursor_themes},
+            'themes=i'        => \$counts{themes},
+            'fonts=i'         => \$counts{fonts},
+            'wallpapers=i'    => \$counts{wallpapers},
+            'help'            => \$help,
+        ) or die $usage;
+
+        if ($help) {
+            print $usage;
+            return 0;
+        }
+        die $usage unless $self->output;
+
+        my $preset = $PRESETS{$self->scale} or die "Unknown scale '" . $self->scale . "'\n";
+        $self->counts({ %$preset, map { defined $counts{$_} ? ($_ => $counts{$_}) : () } keys %counts });
+
+        # Build next to the target and swap it in, so an interrupted run
+        # never leaves a half-written corpus behind the benchmark's stamp
+        my $target = File::Spec->rel2abs($self->output);
+        my $work = "$target.tmp-$$";
+        remove_tree($work);
+        make_path($work);
+
+        $self->_generate($work);
+
+        remove_tree($target);
+        rename($work, $target) or die "Cannot rename $work to $target: $!\n";
+        print "Corpus written to $target\n";
+
+        return 0;
+    }
+
+    sub _generate {
+        my ($self, $dir) = @_;
+        my $counts = $self->counts;
+
+        my %generated = (
+            icon_themes => $self->_generate_icon_themes("$dir/icons", $counts->{icon_themes}),
+            cursor_themes => $self->_generate_cursor_themes("$dir/cursors", $counts->{cursor_themes}),
+            themes => $self->_generate_themes("$dir/themes", $counts->{themes}),
+            fonts => $self->_generate_fonts("$dir/fonts", $counts->{fonts}),
+            wallpapers => $self->_generate_wallpapers("$dir/backgrounds", $counts->{wallpapers}),
+        );
+
+        _write_file("$dir/manifest.json", JSON->new->pretty->canonical->encode({
+            generator => GENERATOR_VERSION,
+            seed => $self->seed,
+            scale => $self->scale,
+            css_kb => $self->css_kb,
+            requested => $counts,
+            generated => \%generated,
+        }));
+    }
+
+    # ---- Icon themes ----
+
+    sub _generate_icon_themes {
+        my ($self, $dir, $count) = @_;
+        make_path($dir);
+
+        for my $index (0 .. $count - 1) {
+            my $rng = $self->_rng('icon-theme', $index);
+            my $name = _theme_name($rng, $index);
+            my $palette = _palette($rng);
+
+            my @sizes = (16, 24, 32, 48, grep { $rng->() < 0.6 } 22, 64, 96, 128, 256);
+            @sizes = sort { $a <=> $b } @sizes;
+            my @scales = $rng->() < 0.3 ? (1, 2) : (1);
+
+            my (@directories, $sections);
+            foreach my $context (@ICON_CONTEXTS) {
+                my ($context_dir, $context_name, @icons) = @$context;
+                @icons = grep { $PREVIEW_ICONS{$_} || $rng->() < 0.85 } @icons;
+
+                foreach my $size (@sizes) {
+                    foreach my $scale (@scales) {
+                        next if $scale > 1 && $size > 48;
+                        my $subdir = $scale > 1 ? "${size}x${size}\@$scale/$context_dir" : "${size}x${size}/$context_dir";
+                        push @directories, $subdir;
+                        $sections .= "\n[$subdir]\nSize=$size\n" . ($scale > 1 ? "Scale=$scale\n" : '')
+                            . "Context=$context_name\nType=Fixed\n";
+
+                        make_path("$dir/$name/$subdir");
+                        foreach my $icon (@icons) {
+                            my $pixels = $size * $scale;
+                            _write_file("$dir/$name/$subdir/$icon.png",
+                                _png($pixels, $pixels, 4, _icon_rows($context_dir, $pixels, $palette, $icon)));
+                        }
+                    }
+                }
+
+                my $subdir = "scalable/$context_dir";
+                push @directories, $subdir;
+                $sections .= "\n[$subdir]\nSize=64\nMinSize=8\nMaxSize=512\nContext=$context_name\nType=Scalable\n";
+                make_path("$dir/$name/$subdir");
+                _write_file("$dir/$name/$subdir/$_.svg", _icon_svg($context_dir, $palette, $_)) foreach @icons;
+            }
+
+            _write_file("$dir/$name/index.theme",
+                "[Icon Theme]\nName=$name\nComment=Synthetic icon theme (seed " . $self->seed . ")\n"
+                . "Inherits=hicolor\nExample=folder\n"
+                . "Directories=" . join(',', @directories) . "\n" . $sections);
+
+            _progress('icon themes', $index + 1, $count);
+        }
+
+        return $count;
+    }
+
+    # Flat shapes per context so themes and contexts are told apart
+    sub _icon_rows {
+        my ($context, $size, $palette, $icon) = @_;
+
+        my $fg = pack('C4', @{$palette->{fg}}, 255);
+        my $accent = pack('C4', @{$palette->{accent}}, 255);
+        my $dark = pack('C4', @{$palette->{dark}}, 255);
+        my $s = $size;
+
+        my $spans;
+        if ($context eq 'places') {
+            $spans = sub {
+                my $y = shift;
+                return [int(0.1 * $s), int(0.45 * $s), $accent] if $y >= int(0.18 * $s) && $y < int(0.28 * $s);
+                return [int(0.08 * $s), int(0.92 * $s), $fg] if $y >= int(0.28 * $s) && $y < int(0.85 * $s);
+                return;
+            };
+        } elsif ($context eq 'mimetypes') {
+            # Document with a coloured header and text lines
+            $spans = sub {
+                my $y = shift;
+                return unless $y >= int(0.08 * $s) && $y < int(0.92 * $s);
+                return [int(0.2 * $s), int(0.8 * $s), $accent] if $y < int(0.3 * $s);
+                return ([int(0.2 * $s), int(0.3 * $s), $fg], [int(0.3 * $s), int(0.7 * $s), $dark],
+                        [int(0.7 * $s), int(0.8 * $s), $fg]) if $s >= 24 && $y % 4 == 0;
+                return [int(0.2 * $s), int(0.8 * $s), $fg];
+            };
+        } elsif ($context eq 'devices') {
+            # Monitor on a stand
+            $spans = sub {
+                my $y = shift;
+                return [int(0.4 * $s), int(0.6 * $s), $dark] if $y >= int(0.75 * $s) && $y < int(0.85 * $s);
+                return unless $y >= int(0.2 * $s) && $y < int(0.75 * $s);
+                return [int(0.1 * $s), int(0.9 * $s), $fg] if $y < int(0.26 * $s) || $y >= int(0.69 * $s);
+                return ([int(0.1 * $s), int(0.16 * $s), $fg], [int(0.16 * $s), int(0.84 * $s), $accent],
+                        [int(0.84 * $s), int(0.9 * $s), $fg]);
+            };
+        } else {
+            # Ring with a core; emblems and status icons use a smaller disc
+            my $outer = ($context eq 'emblems' || $context eq 'status') ? 0.3 * $s : 0.42 * $s;
+            my $inner = $outer * (0.35 + (length($icon) % 5) / 20);
+            $spans = _ring_spans($s / 2, $s / 2, $outer, $inner, $fg, $accent);
+        }
+
+        return _raster($s, $s, "\0\0\0\0", $spans);
+    }
+
+    sub _icon_svg {
+        my ($context, $palette, $icon) = @_;
+
+        my ($fg, $accent) = map { sprintf('#%02x%02x%02x', @{$palette->{$_}}) } qw(fg accent);
+        my $shape = $context eq 'places'
+            ? qq(<rect x="5" y="11" width="22" height="4" fill="$accent"/><rect x="3" y="15" width="42" height="26" rx="3" fill="$fg"/>)
+            : $context eq 'mimetypes'
+            ? qq(<path d="M10 4h20l8 8v32H10z" fill="$fg"/><rect x="10" y="4" width="28" height="10" fill="$accent"/>)
+            : qq(<circle cx="24" cy="24" r="20" fill="$fg"/><circle cx="24" cy="24" r="9" fill="$accent"/>);
+
+        return qq(<?xml version="1.0" encoding="UTF-8"?>\n)
+             . qq(<svg xmlns="http://www.w3.org/2000/svg" width="48" height="48" viewBox="0 0 48 48">\n)
+             . qq(  <title>$icon</title>\n  $shape\n</svg>\n);
+    }
+
+    # ---- Cursor themes ----
+
+    sub _generate_cursor_themes {
+        my ($self, $dir, $count) = @_;
+        make_path($dir);
+
+        for my $index (0 .. $count - 1) {
+            my $rng = $self->_rng('cursor-theme', $index);
+            my $name = _theme_name($rng, $index) . '-Cursors';
+            my $palette = _palette($rng);
+
+            my @sizes = (24, 32, 48, grep { $rng->() < 0.5 } 64, 96);
+            my $frames = 8 + int($rng->() * 17);
+            my $delay = 30 + int($rng->() * 40);
+
+            make_path("$dir/$name/cursors");
+            foreach my $cursor (@CURSORS) {
+                my ($cursor_name, $shape, @aliases) = @$cursor;
+                my $animated = $shape eq 'ring' && $cursor_name ne 'pirate';
+
+                my @images;
+                foreach my $size (@sizes) {
+                    foreach my $frame (0 .. ($animated ? $frames - 1 : 0)) {
+                        my $rows = _cursor_rows($shape, $size, $palette, $animated ? $frame / $frames : undef);
+                        my ($xhot, $yhot) = $shape eq 'arrow' ? (int($size / 8), int($size / 8)) : (int($size / 2), int($size / 2));
+                        push @images, {
+                            size => $size, width => $size, height => $size,
+                            xhot => $xhot, yhot => $yhot, delay => $animated ? $delay : 0,
+                            pixels => join('', @$rows),
+                        };
+                    }
+                }
+
+                _write_file("$dir/$name/cursors/$cursor_name", _xcursor(@images));
+                foreach my $alias (@aliases) {
+                    symlink($cursor_name, "$dir/$name/cursors/$alias") unless -e "$dir/$name/cursors/$alias";
+                }
+            }
+
+            _write_file("$dir/$name/index.theme",
+                "[Icon Theme]\nName=$name\nComment=Synthetic cursor theme (seed " . $self->seed . ")\nExample=left_ptr\n");
+            _write_file("$dir/$name/cursor.theme", "[Icon Theme]\nInherits=$name\n") if $rng->() < 0.5;
+
+            _progress('cursor themes', $index + 1, $count);
+        }
+
+        return $count;
+    }
+
+    # Pixels in Xcursor order: little-endian premultiplied ARGB
+    sub _cursor_rows {
+        my ($shape, $s, $palette, $phase) = @_;
+
+        my $argb = sub { pack('V', (255 << 24) | ($_[0] << 16) | ($_[1] << 8) | $_[2]) };
+        my $fg = $argb->(@{$palette->{dark}});
+        my $accent = $argb->(@{$palette->{accent}});
+        my $light = $argb->(@{$palette->{fg}});
+
+        my $spans;
+        if ($shape eq 'arrow') {
+            $spans = sub {
+                my $y = shift;
+                my $top = int($s / 8);
+                return unless $y >= $top && $y < int(0.8 * $s);
+                my $width = int(($y - $top) * 0.6) + 1;
+                return $width > 3
+                    ? ([$top, $top + 1, $light], [$top + 1, $top + $width - 1, $fg], [$top + $width - 1, $top + $width, $light])
+                    : [$top, $top + $width, $light];
+            };
+        } elsif ($shape eq 'hand') {
+            $spans = sub {
+                my $y = shift;
+                return [int(0.42 * $s), int(0.58 * $s), $fg] if $y >= int(0.1 * $s) && $y < int(0.45 * $s);
+                return [int(0.25 * $s), int(0.75 * $s), $fg] if $y >= int(0.45 * $s) && $y < int(0.9 * $s);
+                return;
+            };
+        } elsif ($shape eq 'beam') {
+            $spans = sub {
+                my $y = shift;
+                return [int(0.35 * $s), int(0.65 * $s), $fg] if $y == int(0.15 * $s) || $y == int(0.85 * $s);
+                return [int(0.47 * $s), int(0.53 * $s) + 1, $fg] if $y > int(0.15 * $s) && $y < int(0.85 * $s);
+                return;
+            };
+        } elsif ($shape eq 'cross') {
+            $spans = sub {
+                my $y = shift;
+                return [int(0.1 * $s), int(0.9 * $s), $fg] if abs($y - $s / 2) < $s / 16 + 1;
+                return [int(0.45 * $s), int(0.55 * $s) + 1, $fg] if $y >= int(0.1 * $s) && $y < int(0.9 * $s);
+                return;
+            };
+        } elsif ($shape eq 'hbar' || $shape eq 'vbar') {
+            my $horizontal = $shape eq 'hbar';
+            $spans = sub {
+                my $y = shift;
+                if ($horizontal) {
+                    my $half = $s / 2 - abs($y - $s / 2);
+                    return unless $half > $s / 4;
+                    return [int(0.1 * $s), int(0.9 * $s), abs($y - $s / 2) < $s / 16 ? $accent : $fg];
+                }
+                return [int(0.4 * $s), int(0.6 * $s), $fg] if $y >= int(0.1 * $s) && $y < int(0.9 * $s);
+                return;
+            };
+        } elsif ($shape eq 'corner') {
+            $spans = sub {
+                my $y = shift;
+                return [int(0.15 * $s), int(0.85 * $s), $fg] if $y >= int(0.15 * $s) && $y < int(0.25 * $s);
+                return [int(0.15 * $s), int(0.25 * $s), $fg] if $y >= int(0.25 * $s) && $y < int(0.85 * $s);
+                return;
+            };
+        } else {
+            # Spinner ring; animated frames move a highlighted band
+            my $ring = _ring_spans($s / 2, $s / 2, 0.42 * $s, 0.26 * $s, $fg, undef);
+            $spans = sub {
+                my $y = shift;
+                my @spans = $ring->($y);
+                return @spans unless defined $phase;
+                my $band = int($phase * $s);
+                return ($y >= $band && $y < $band + $s / 6) ? map { [$_->[0], $_->[1], $accent] } @spans : @spans;
+            };
+        }
+
+        return _raster($s, $s, "\0\0\0\0", $spans);
+    }
+
+    sub _xcursor {
+        my @images = @_;
+
+        my $position = 16 + 12 * @images;
+        my ($toc, $chunks) = ('', '');
+        foreach my $image (@images) {
+            $toc .= pack('VVV', 0xfffd0002, $image->{size}, $position);
+            my $chunk = pack('V9', 36, 0xfffd0002, $image->{size}, 1,
+                @{$image}{qw(width height xhot yhot delay)}) . $image->{pixels};
+            $chunks .= $chunk;
+            $position += length $chunk;
+        }
+
+        return 'Xcur' . pack('VVV', 16, 0x10000, scalar @images) . $toc . $chunks;
+    }
+
+    # ---- GTK and Cinnamon themes ----
+
+    sub _generate_themes {
+        my ($self, $dir, $count) = @_;
+        make_path($dir);
+
+        for my $index (0 .. $count - 1) {
+            my $rng = $self->_rng('theme', $index);
+            my $name = _theme_name($rng, $index);
+            my $palette = _palette($rng);
+            my $target = $self->css_kb * 1024 * (0.5 + $rng->());
+
+            make_path("$dir/$name/$_") foreach qw(gtk-2.0 gtk-3.0 cinnamon metacity-1);
+
+            _write_file("$dir/$name/index.theme",
+                "[Desktop Entry]\nType=X-GNOME-Metatheme\nName=$name\n"
+                . "Comment=Synthetic theme (seed " . $self->seed . ")\nEncoding=UTF-8\n\n"
+                . "[X-GNOME-Metatheme]\nGtkTheme=$name\nMetacityTheme=$name\n"
+                . "IconTheme=Adwaita\nCursorTheme=Adwaita\nButtonLayout=menu:minimize,maximize,close\n");
+
+            _write_file("$dir/$name/gtk-3.0/gtk.css", _gtk_css($rng, $palette, $target));
+            _write_file("$dir/$name/gtk-3.0/gtk-dark.css", _gtk_css($rng, _palette($rng, 1), $target / 4))
+                if $rng->() < 0.4;
+            if ($rng->() < 0.5) {
+                make_path("$dir/$name/gtk-4.0");
+                _write_file("$dir/$name/gtk-4.0/gtk.css", _gtk_css($rng, $palette, $target / 2));
+            }
+            _write_file("$dir/$name/gtk-2.0/gtkrc", _gtkrc($palette));
+            _write_file("$dir/$name/cinnamon/cinnamon.css", _cinnamon_css($rng, $palette, $target * 0.7));
+            _write_file("$dir/$name/metacity-1/metacity-theme-3.xml",
+                qq(<?xml version="1.0"?>\n<metacity_theme>\n  <info><name>$name</name></info>\n</metacity_theme>\n));
+
+            # Some themes ship no screenshot so the synthesized preview runs too
+            if ($rng->() < 0.6) {
+                _write_file("$dir/$name/cinnamon/thumbnail.png", _png(200, 150, 3, _thumbnail_rows($palette)));
+            }
+
+            _progress('themes', $index + 1, $count);
+        }
+
+        return $count;
+    }
+
+    sub _gtk_css {
+        my ($rng, $palette, $target) = @_;
+
+        my %colors = (
+            theme_bg_color => $palette->{bg},
+            theme_fg_color => $palette->{fg},
+            theme_base_color => $palette->{base},
+            theme_text_color => $palette->{fg},
+            theme_selected_bg_color => $palette->{accent},
+            theme_selected_fg_color => [255, 255, 255],
+            insensitive_bg_color => $palette->{bg},
+            insensitive_fg_color => $palette->{dark},
+            borders => $palette->{dark},
+            warning_color => [245, 121, 0],
+            error_color => [204, 0, 0],
+            success_color => [78, 154, 6],
+            wm_title => $palette->{fg},
+        );
+        my $css = "/* Synthetic GTK 3 theme */\n";
+        $css .= sprintf("\@define-color %s #%02x%02x%02x;\n", $_, @{$colors{$_}}) foreach sort keys %colors;
+
+        my @widgets = qw(
+            window button entry headerbar treeview notebook scrollbar menu menuitem
+            popover switch checkbutton radiobutton scale progressbar spinbutton
+            combobox toolbar infobar tooltip row sidebar calendar label textview
+            separator placessidebar expander levelbar stackswitcher actionbar
+        );
+        my @states = ('', ':hover', ':active', ':checked', ':disabled', ':backdrop', ':focus', ':selected');
+        my @children = ('', ' > box', ' label', ' image', ' trough', ' slider', ' > button', ' arrow');
+        my @properties = (
+            sub { 'background-color: ' . _pick($rng, map { "\@$_" } sort keys %colors) },
+            sub { 'color: ' . _pick($rng, '@theme_fg_color', '@theme_text_color', '@theme_selected_fg_color') },
+            sub { sprintf('border: %dpx solid alpha(@borders, %.2f)', 1 + int($rng->() * 2), $rng->()) },
+            sub { sprintf('border-radius: %dpx', int($rng->() * 9)) },
+            sub { sprintf('padding: %dpx %dpx', int($rng->() * 8), int($rng->() * 12)) },
+            sub { sprintf('box-shadow: inset 0 1px alpha(white, %.2f)', $rng->() / 4) },
+            sub { sprintf('background-image: linear-gradient(to bottom, shade(@theme_bg_color, %.2f), @theme_bg_color)', 0.9 + $rng->() / 5) },
+            sub { 'transition: all 200ms cubic-bezier(0.25, 0.46, 0.45, 0.94)' },
+            sub { sprintf('min-height: %dpx', 16 + int($rng->() * 20)) },
+            sub { sprintf('outline-offset: -%dpx', 1 + int($rng->() * 3)) },
+        );
+
+        while (length($css) < $target) {
+            my $selector = join(', ', map { _pick($rng, @widgets) . _pick($rng, @states) . _pick($rng, @children) } 1 .. 1 + int($rng->() * 3));
+            $css .= "\n$selector {\n";
+            $css .= "  " . $properties[int($rng->() * @properties)]->() . ";\n" for 1 .. 2 + int($rng->() * 5);
+            $css .= "}\n";
+        }
+
+        return $css;
+    }
+
+    sub _cinnamon_css {
+        my ($rng, $palette, $target) = @_;
+
+        my $rgb = sub { sprintf('#%02x%02x%02x', @{$_[0]}) };
+        my $rgba = sub { sprintf('rgba(%d, %d, %d, %.2f)', @{$_[0]}, $_[1]) };
+
+        # The selectors the synthesized preview reads come first
+        my $css = "/* Synthetic Cinnamon theme */\n"
+            . "stage {\n  font-size: 9pt;\n  color: " . $rgb->($palette->{fg}) . ";\n}\n"
+            . "#panel, .panel-top, .panel-bottom {\n  background-color: " . $rgba->($palette->{dark}, 0.95) . ";\n  color: #ffffff;\n}\n"
+            . ".panel-button, .applet-box {\n  padding: 0 4px;\n  color: #ffffff;\n}\n"
+            . ".window-list-item-box {\n  background-color: " . $rgba->($palette->{bg}, 0.2) . ";\n  border-radius: 3px;\n}\n"
+            . ".window-list-item-box:active, .window-list-item-box:checked, .window-list-item-box:focus {\n"
+            . "  background-color: " . $rgb->($palette->{accent}) . ";\n}\n"
+            . ".menu, .popup-menu, .popup-menu-boxpointer {\n  -arrow-background-color: " . $rgb->($palette->{bg}) . ";\n"
+            . "  background-color: " . $rgb->($palette->{bg}) . ";\n  color: " . $rgb->($palette->{fg}) . ";\n}\n"
+            . ".popup-menu-item:active, .popup-menu-item:hover {\n  background-color: " . $rgb->($palette->{accent}) . ";\n}\n"
+            . ".menu-favorites-box {\n  background-color: " . $rgb->($palette->{base}) . ";\n}\n"
+            . "#menu-search-entry {\n  background-color: " . $rgb->($palette->{base}) . ";\n  border-radius: 4px;\n}\n";
+
+        my @selectors = qw(
+            .calendar .calendar-day-base .notification .notification-button .sound-player
+            .workspace-switcher .workspace-button .sidebar .tooltip .switcher-list
+            .run-dialog .modal-dialog .button .check-box .slider .separator .desklet
+            .overview .window-caption .expo-background .applet-label .system-status-icon
+            .menu-application-button .menu-category-button .popup-sub-menu .info-osd
+        );
+        my @states = ('', ':hover', ':active', ':focus', ':checked', ':insensitive');
+        while (length($css) < $target) {
+            $css .= "\n" . _pick($rng, @selectors) . _pick($rng, @states) . " {\n";
+            $css .= sprintf("  background-color: %s;\n", $rgba->(_pick($rng, @{$palette}{qw(bg base dark accent)}), 0.5 + $rng->() / 2));
+            $css .= sprintf("  border: %dpx solid %s;\n", int($rng->() * 3), $rgb->($palette->{dark})) if $rng->() < 0.6;
+            $css .= sprintf("  border-radius: %dpx;\n", int($rng->() * 8)) if $rng->() < 0.6;
+            $css .= sprintf("  padding: %dpx %dpx;\n", int($rng->() * 10), int($rng->() * 14)) if $rng->() < 0.7;
+            $css .= sprintf("  spacing: %dpx;\n", int($rng->() * 8)) if $rng->() < 0.3;
+            $css .= "  transition-duration: 150ms;\n" if $rng->() < 0.2;
+            $css .= "}\n";
+        }
+
+        return $css;
+    }
+
+    sub _gtkrc {
+        my $palette = shift;
+
+        my ($bg, $fg, $accent) = map { sprintf('#%02x%02x%02x', @{$palette->{$_}}) } qw(bg fg accent);
+        return qq(gtk-color-scheme = "bg_color:$bg\\nfg_color:$fg\\nselected_bg_color:$accent"\n\n)
+             . qq(style "default" {\n  bg[NORMAL] = \@bg_color\n  fg[NORMAL] = \@fg_color\n)
+             . qq(  bg[SELECTED] = \@selected_bg_color\n}\n\nclass "GtkWidget" style "default"\n);
+    }
+
+    # Desktop with a panel and a window, like a theme screenshot
+    sub _thumbnail_rows {
+        my $palette = shift;
+
+        my $desk = pack('C3', @{$palette->{base}});
+        my $panel = pack('C3', @{$palette->{dark}});
+        my $window = pack('C3', @{$palette->{bg}});
+        my $title = pack('C3', @{$palette->{accent}});
+
+        return _raster(200, 150, $desk, sub {
+            my $y = shift;
+            return [0, 200, $panel] if $y >= 135;
+            return [30, 170, $title] if $y >= 20 && $y < 32;
+            return [30, 170, $window] if $y >= 32 && $y < 115;
+            return;
+        });
+    }
+
+    # ---- Fonts ----
+
+    sub _generate_fonts {
+        my ($self, $dir, $count) = @_;
+        return 0 unless $count;
+
+        my @sources;
+        if (-d $self->font_source) {
+            find({ no_chdir => 1, wanted => sub {
+                push @sources, $File::Find::name if -f $_ && /\.(?:ttf|otf)$/i;
+            } }, $self->font_source);
+        }
+        @sources = sort @sources;
+
+        if (!@sources) {
+            print STDERR "Warning: no TrueType/OpenType fonts under " . $self->font_source . ", skipping fonts\n";
+            return 0;
+        }
+
+        make_path($dir);
+        my %source_data;
+        my $written = 0;
+        my ($family, $family_dir, @styles);
+        for my $index (0 .. $count - 1) {
+            # Families of one to six styles, like real font packages
+            if (!@styles) {
+                my $rng = $self->_rng('font-family', $index);
+                $family = sprintf('%s %s %s', _pick($rng, @FONT_WORDS), _pick($rng, @FONT_CLASSES), _base26($index));
+                @styles = ('Regular', grep { $rng->() < 0.35 } @FONT_STYLES[1 .. $#FONT_STYLES]);
+                splice(@styles, 6) if @styles > 6;
+                ($family_dir = $family) =~ s/ //g;
+                make_path("$dir/$family_dir");
+            }
+            my $style = shift @styles;
+
+            my $rng = $self->_rng('font', $index);
+            my $source = $sources[int($rng->() * @sources)];
+            $source_data{$source} //= _read_file($source);
+
+            my $postscript = "$family_dir-" . join('', split / /, $style);
+            my @drop = ('DSIG', grep { $rng->() < 0.3 } @FONT_OPTIONAL_TABLES);
+            my $font = eval {
+                _rename_font($source_data{$source}, {
+                    0 => 'Synthetic corpus font derived from ' . basename($source),
+                    1 => $family,
+                    2 => $style,
+                    3 => "$postscript;" . $self->seed . ";$index",
+                    4 => "$family $style",
+                    5 => 'Version 1.000',
+                    6 => $postscript,
+                    16 => $family,
+                    17 => $style,
+                }, \@drop);
+            };
+            if (!$font) {
+                print STDERR "Warning: cannot rewrite $source: $@";
+                next;
+            }
+
+            my ($extension) = $source =~ /\.(\w+)$/;
+            _write_file("$dir/$family_dir/$postscript." . lc($extension), $font);
+            $written++;
+            _progress('fonts', $index + 1, $count);
+        }
+
+        return $written;
+    }
+
+    # Rebuild an sfnt with a new name table, dropping @$drop tables and
+    # fixing the table checksums and head.checkSumAdjustment
+    sub _rename_font {
+        my ($data, $names, $drop) = @_;
+
+        my ($version, $num_tables) = unpack('Nn', $data);
+        die "not an sfnt font\n" unless $version == 0x00010000 || $version == 0x4F54544F;
+
+        my %tables;
+        for my $i (0 .. $num_tables - 1) {
+            my ($tag, undef, $offset, $length) = unpack('a4NNN', substr($data, 12 + 16 * $i, 16));
+            $tables{$tag} = substr($data, $offset, $length);
+        }
+        die "no head table\n" unless $tables{head};
+
+        delete @tables{@$drop};
+        $tables{name} = _name_table($names);
+        substr($tables{head}, 8, 4) = "\0\0\0\0";
+
+        my @tags = sort keys %tables;
+        my $selector = floor(log(scalar @tags) / log(2));
+        my $search_range = (2 ** $selector) * 16;
+
+        my $offset = 12 + 16 * @tags;
+        my ($directory, $body, $head_offset) = ('', '');
+        foreach my $tag (@tags) {
+            my $table = $tables{$tag};
+            my $padded = $table . ("\0" x ((4 - length($table) % 4) % 4));
+            $directory .= pack('a4NNN', $tag, unpack('%32N*', $padded), $offset, length $table);
+            $head_offset = $offset if $tag eq 'head';
+            $body .= $padded;
+            $offset += length $padded;
+        }
+
+        my $font = pack('Nnnnn', $version, scalar @tags, $search_range, $selector, @tags * 16 - $search_range)
+            . $directory . $body;
+        substr($font, $head_offset + 8, 4) = pack('N', (0xB1B0AFBA - unpack('%32N*', $font)) & 0xFFFFFFFF);
+
+        return $font;
+    }
+
+    # Format 0 name table with Macintosh and Windows records
+    sub _name_table {
+        my $names = shift;
+
+        my (@records, $strings);
+        $strings = '';
+        foreach my $platform ([1, 0, 0], [3, 1, 0x409]) {
+            foreach my $id (sort { $a <=> $b } keys %$names) {
+                my $string = $platform->[0] == 3 ? encode('UTF-16BE', $names->{$id}) : encode('latin1', $names->{$id});
+                push @records, pack('n6', @$platform, $id, length $string, length $strings);
+                $strings .= $string;
+            }
+        }
+
+        return pack('nnn', 0, scalar @records, 6 + 12 * @records) . join('', @records) . $strings;
+    }
+
+    # ---- Wallpapers ----
+
+    sub _generate_wallpapers {
+        my ($self, $dir, $count) = @_;
+        make_path($dir);
+
+        my %formats;
+        for my $index (0 .. $count - 1) {
+            my $rng = $self->_rng('wallpaper', $index);
+            my ($width, $height) = @{_weighted($rng, @WALLPAPER_SIZES)};
+            my $format = _weighted($rng, @WALLPAPER_FORMATS);
+            $format = 'png' if $format =~ /^(?:jpg|tiff|bmp)$/ && !$self->has_pixbuf;
+            my $palette = _palette($rng);
+            my $base = sprintf('%s/%s-%05d-%dx%d', $dir, _pick($rng, @NAME_PREFIXES), $index, $width, $height);
+
+            if ($format eq 'svg') {
+                _write_file("$base.svg", _wallpaper_svg($width, $height, $palette));
+            } else {
+                my $png = _png($width, $height, 3, _wallpaper_rows($rng, $width, $height, $palette));
+                if ($format eq 'png') {
+                    _write_file("$base.png", $png);
+                } else {
+                    # gdk-pixbuf has the JPEG, TIFF and BMP encoders
+                    _write_file("$base.tmp.png", $png);
+                    my $pixbuf = Gtk3::Gdk::Pixbuf->new_from_file("$base.tmp.png");
+                    my $type = $format eq 'jpg' ? 'jpeg' : $format;
+                    my @options = $type eq 'jpeg' ? (['quality'], ['88']) : ([], []);
+                    $pixbuf->savev("$base.$format", $type, @options);
+                    unlink("$base.tmp.png");
+                }
+            }
+
+            $formats{$format}++;
+            _progress('wallpapers', $index + 1, $count);
+        }
+
+        return { count => $count, formats => \%formats };
+    }
+
+    # Vertical gradient with a disc and a band so encoders see some detail
+    sub _wallpaper_rows {
+        my ($rng, $width, $height, $palette) = @_;
+
+        my @top = @{$palette->{dark}};
+        my @bottom = @{$palette->{accent}};
+        my $disc = pack('C3', @{$palette->{fg}});
+        my $band = pack('C3', @{$palette->{base}});
+        my ($cx, $cy, $r) = ($width * (0.2 + 0.6 * $rng->()), $height * (0.2 + 0.6 * $rng->()), $height * (0.1 + 0.2 * $rng->()));
+        my $band_top = int($height * (0.6 + 0.3 * $rng->()));
+        my $ring = _ring_spans($cx, $cy, $r, 0, $disc, undef);
+
+        my @rows;
+        for my $y (0 .. $height - 1) {
+            my $t = $y / ($height - 1 || 1);
+            my $fill = pack('C3', map { int($top[$_] + ($bottom[$_] - $top[$_]) * $t) } 0 .. 2);
+            my @spans = $ring->($y);
+            @spans = ([0, $width, $band]) if !@spans && $y >= $band_top && $y < $band_top + $height / 40;
+            push @rows, @{_raster($width, 1, $fill, sub { @spans })};
+        }
+
+        return \@rows;
+    }
+
+    sub _wallpaper_svg {
+        my ($width, $height, $palette) = @_;
+
+        my ($top, $bottom, $disc) = map { sprintf('#%02x%02x%02x', @{$palette->{$_}}) } qw(dark accent fg);
+        return qq(<?xml version="1.0" encoding="UTF-8"?>\n)
+             . qq(<svg xmlns="http://www.w3.org/2000/svg" width="$width" height="$height">\n)
+             . qq(  <defs><linearGradient id="g" x1="0" y1="0" x2="0" y2="1">)
+             . qq(<stop offset="0" stop-color="$top"/><stop offset="1" stop-color="$bottom"/></linearGradient></defs>\n)
+             . qq(  <rect width="100%" height="100%" fill="url(#g)"/>\n)
+             . sprintf(qq(  <circle cx="%d" cy="%d" r="%d" fill="%s"/>\n), $width / 2, $height / 2, $height / 5, $disc)
+             . qq(</svg>\n);
+    }
+
+    # ---- Raster and PNG helpers ----
+
+    # Rows of $width pixels; $spans->($y) returns [x0, x1, pixel] runs in
+    # ascending order and everything else is $background
+    sub _raster {
+        my ($width, $height, $background, $spans) = @_;
+
+        my @rows;
+        for my $y (0 .. $height - 1) {
+            my ($row, $x) = ('', 0);
+            foreach my $span ($spans->($y)) {
+                my ($x0, $x1, $pixel) = @$span;
+                $x0 = $x if $x0 < $x;
+                $x1 = $width if $x1 > $width;
+                next if $x1 <= $x0;
+                $row .= $background x ($x0 - $x) . $pixel x ($x1 - $x0);
+                $x = $x1;
+            }
+            push @rows, $row . $background x ($width - $x);
+        }
+
+        return \@rows;
+    }
+
+    # Disc of radius $outer around ($cx, $cy), with a hole of radius $inner
+    # filled with $core (or left empty when $core is undef)
+    sub _ring_spans {
+        my ($cx, $cy, $outer, $inner, $pixel, $core) = @_;
+
+        return sub {
+            my $y = shift;
+            my $dy = $y + 0.5 - $cy;
+            return if abs($dy) >= $outer;
+
+            my $wo = sqrt($outer ** 2 - $dy ** 2);
+            return [int($cx - $wo + 0.5), int($cx + $wo + 0.5), $pixel] if abs($dy) >= $inner;
+
+            my $wi = sqrt($inner ** 2 - $dy ** 2);
+            my ($a, $b, $c, $d) = map { int($_ + 0.5) } $cx - $wo, $cx - $wi, $cx + $wi, $cx + $wo;
+            return ([$a, $b, $pixel], ($core ? [$b, $c, $core] : ()), [$c, $d, $pixel]);
+        };
+    }
+
+    # 8-bit PNG with RGB (3) or RGBA (4) rows
+    sub _png {
+        my ($width, $height, $channels, $rows) = @_;
+
+        my $chunk = sub {
+            my ($type, $data) = @_;
+            return pack('N', length $data) . $type . $data . pack('N', crc32($type . $data));
+        };
+
+        return "\x89PNG\r\n\x1a\n"
+             . $chunk->('IHDR', pack('NNCCCCC', $width, $height, 8, $channels == 4 ? 6 : 2, 0, 0, 0))
+             . $chunk->('IDAT', compress(join('', map { "\0$_" } @$rows)))
+             . $chunk->('IEND', '');
+    }
+
+    # ---- Deterministic randomness ----
+
+    # xorshift32 stream seeded from the corpus seed and the item key
+    sub _rng {
+        my ($self, @key) = @_;
+
+        my $state = unpack('N', md5(join("\0", $self->seed, @key))) || 1;
+        return sub {
+            $state ^= ($state << 13) & 0xFFFFFFFF;
+            $state ^= $state >> 17;
+            $state ^= ($state << 5) & 0xFFFFFFFF;
+            return $state / 4294967296;
+        };
+    }
+
+    sub _pick {
+        my ($rng, @items) = @_;
+        return $items[int($rng->() * @items)];
+    }
+
+    # Pick from [value..., weight] entries
+    sub _weighted {
+        my ($rng, @entries) = @_;
+
+        my $total = 0;
+        $total += $_->[-1] foreach @entries;
+        my $roll = $rng->() * $total;
+        foreach my $entry (@entries) {
+            $roll -= $entry->[-1];
+            next if $roll >= 0;
+            return @$entry > 2 ? [@{$entry}[0 .. $#$entry - 1]] : $entry->[0];
+        }
+        return $entries[-1][0];
+    }
+
+    sub _theme_name {
+        my ($rng, $index) = @_;
+        return sprintf('%s%s-%03d', _pick($rng, @NAME_PREFIXES), _pick($rng, @NAME_SUFFIXES), $index);
+    }
+
+    # Letters only, so font family names do not look like style suffixes
+    sub _base26 {
+        my $n = shift;
+
+        my $name = '';
+        do {
+            $name = chr(65 + $n % 26) . $name;
+            $n = int($n / 26);
+        } while ($n > 0);
+        return $name;
+    }
+
+    sub _palette {
+        my ($rng, $dark) = @_;
+
+        my $hue = $rng->() * 360;
+        my $dark_theme = defined $dark ? $dark : $rng->() < 0.4;
+        return {
+            accent => _hsl($hue, 0.55 + 0.3 * $rng->(), 0.5),
+            dark => _hsl($hue, 0.15, 0.15 + 0.1 * $rng->()),
+            bg => _hsl($hue, 0.08, $dark_theme ? 0.2 : 0.93),
+            base => _hsl($hue, 0.05, $dark_theme ? 0.15 : 0.99),
+            fg => _hsl($hue, 0.1, $dark_theme ? 0.9 : 0.25),
+        };
+    }
+
+    sub _hsl {
+        my ($h, $s, $l) = @_;
+
+        my $c = (1 - abs(2 * $l - 1)) * $s;
+        my $x = $c * (1 - abs((($h / 60) - 2 * floor($h / 120)) - 1));
+        my $m = $l - $c / 2;
+        my @rgb = $h < 60 ? ($c, $x, 0) : $h < 120 ? ($x, $c, 0) : $h < 180 ? (0, $c, $x)
+                : $h < 240 ? (0, $x, $c) : $h < 300 ? ($x, 0, $c) : ($c, 0, $x);
+        return [map { int(($_ + $m) * 255 + 0.5) } @rgb];
+    }
+
+    # ---- Files ----
+
+    sub _write_file {
+        my ($file, $data) = @_;
+
+        open my $fh, '>:raw', $file or die "Cannot write $file: $!\n";
+        print $fh $data;
+        close $fh or die "Cannot write $file: $!\n";
+    }
+
+    sub _read_file {
+        my $file = shift;
+
+        open my $fh, '<:raw', $file or die "Cannot read $file: $!\n";
+        local $/;
+        return scalar <$fh>;
+    }
+
+    sub _progress {
+        my ($what, $done, $total) = @_;
+        my $step = $total > 100 ? int($total / 20) : 1;
+        print "  $what: $done/$total\n" if $done == $total || $done % $step == 0;
+    }
+}
+
+# Main execution
+if (!caller) {
+    exit CinnamonCorpusGenerator->new()->run(@ARGV);
+}
+
+1;
@@ -0,0 +1,115 @@
+use strict;
+use warnings;
+use utf8;
+
+# CinnamonSettings::BudgetCache: byte accounting, LRU eviction order and
+# the on_evict callback
+
+use Test::More;
+use CinnamonSettings::BudgetCache;
+
+sub keys_of {
+    my $cache = shift;
+    return [sort keys %{$cache->nodes}];
+}
+
+# Accounting
+{
+    my $cache = CinnamonSettings::BudgetCache->new(budget_bytes => 100);
+    $cache->set(a => 'x', 30);
+    $cache->set(b => 'y', 20);
+    is($cache->bytes, 50, 'stored entries are charged their bytes');
+    is($cache->count, 2, 'both entries kept within budget');
+
+    $cache->set(a => 'z', 10);
+    is($cache->bytes, 30, 'replacing an entry releases its old charge');
+    is($cache->get('a'), 'z', 'replaced value is returned');
+
+    $cache->remove('b');
+    is($cache->bytes, 10, 'removing an entry releases its charge');
+    ok(!$cache->contains('b'), 'removed entry is gone');
+
+    $cache->clear();
+    is($cache->bytes, 0, 'clear releases everything');
+    is($cache->count, 0, 'clear drops every entry');
+    ok(!defined $cache->head && !defined $cache->tail, 'clear empties the list');
+}
+
+# Least recently used entries go first; get() counts as a use
+{
+    my @evicted;
+    my $cache = CinnamonSettings::BudgetCache->new(
+        budget_bytes => 100,
+        on_evict => sub { push @evicted, [@_] },
+    );
+    $cache->set($_ => "value $_", 30) for qw(a b c);
+    $cache->get('a');
+    $cache->set(d => 'value d', 30);
+
+    is_deeply(keys_of($cache), [qw(a c d)], 'least recently used entry evicted');
+    is_deeply(\@evicted, [['b', 'value b']], 'on_evict gets the key and value');
+    is($cache->evictions, 1, 'eviction counted');
+    is($cache->bytes, 90, 'evicted bytes released');
+
+    @evicted = ();
+    $cache->set(e => 'value e', 80);
+    is_deeply([map { $_->[0] } @evicted], [qw(c a d)], 'several entries evicted oldest first');
+    is_deeply(keys_of($cache), ['e'], 'only the new entry remains');
+    is($cache->evictions, 4, 'every eviction counted');
+}
+
+# The entry just stored is kept even when it alone exceeds the budget
+{
+    my @evicted;
+    my $cache = CinnamonSettings::BudgetCache->new(
+        budget_bytes => 50,
+        on_evict => sub { push @evicted, $_[0] },
+    );
+    $cache->set(small => 1, 10);
+    $cache->set(huge => 2, 500);
+
+    is_deeply(\@evicted, ['small'], 'older entries make room for an oversized one');
+    ok($cache->contains('huge'), 'oversized entry kept');
+    is($cache->bytes, 500, 'oversized entry charged in full');
+
+    $cache->set(next => 3, 10);
+    is_deeply(\@evicted, ['small', 'huge'], 'oversized entry goes on the next store');
+    is_deeply(keys_of($cache), ['next'], 'cache back within budget');
+}
+
+# Removing or replacing an entry is not an eviction
+{
+    my @evicted;
+    my $cache = CinnamonSettings::BudgetCache->new(
+        budget_bytes => 100,
+        on_evict => sub { push @evicted, $_[0] },
+    );
+    $cache->set(a => 1, 40);
+    $cache->set(a => 2, 40);
+    $cache->remove('a');
+    is_deeply(\@evicted, [], 'on_evict only runs for budget evictions');
+    is($cache->evictions, 0, 'no evictions counted');
+}
+
+# Size estimates
+{
+    my $short = CinnamonSettings::BudgetCache::estimate_bytes('abc');
+    my $long = CinnamonSettings::BudgetCache::estimate_bytes('abc' x 100);
+    is($long - $short, 297, 'strings are charged by length');
+
+    my $shared = ['x' x 1000];
+    my $twice = CinnamonSettings::BudgetCache::estimate_bytes([$shared, $shared]);
+    my $once = CinnamonSettings::BudgetCache::estimate_bytes([$shared]);
+    ok($twice - $once < 100, 'shared structures are counted once');
+
+    my $cycle = {};
+    $cycle->{self} = $cycle;
+    ok(CinnamonSettings::BudgetCache::estimate_bytes($cycle) > 0, 'cyclic structures terminate');
+
+    my $cache = CinnamonSettings::BudgetCache->new(budget_bytes => 1000);
+    $cache->set(list => [1 .. 10]);
+    is($cache->bytes, CinnamonSettings::BudgetCache::estimate_bytes([1 .. 10]),
+        'set without a size charges the estimate');
+}
+
+done_testing();
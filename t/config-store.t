@@ -0,0 +1,141 @@
+use strict;
+use warnings;
+use utf8;
+
+# CinnamonSettings::ConfigStore: merging another instance's writes into
+# the live hash, and writes that do not overwrite them
+
+use Test::More;
+use File::Temp qw(tempdir);
+use JSON;
+use CinnamonSettings::ConfigStore;
+
+my $dir = tempdir(CLEANUP => 1);
+my $file = "$dir/settings.json";
+my %defaults = (zoom => 128, theme => 'Mint-Y', recent => []);
+
+sub store {
+    my $changes = shift;
+    my $store = CinnamonSettings::ConfigStore->new(file => $file, defaults => \%defaults);
+    $store->on_change(sub { push @$changes, @{$_[0]} }) if $changes;
+    return $store;
+}
+
+sub write_raw {
+    my $content = shift;
+    # A new inode, as any write through a temporary file gives
+    unlink($file);
+    open my $fh, '>', $file or die "Cannot write $file: $!\n";
+    print $fh $content;
+    close $fh;
+}
+
+sub on_disk {
+    open my $fh, '<', $file or die "Cannot read $file: $!\n";
+    local $/;
+    return decode_json(<$fh>);
+}
+
+# Untouched keys follow the other instance; unsaved changes win
+{
+    my @changes;
+    my $mine = store(\@changes);
+    my $theirs = store();
+    my $data = $mine->load();
+    my $their_data = $theirs->load();
+
+    $their_data->{zoom} = 64;
+    $their_data->{theme} = 'Adwaita';
+    $theirs->save();
+    ok($theirs->flush(), 'other instance writes');
+
+    $data->{theme} = 'Mint-Y-Dark';
+    $mine->save();
+    $mine->_check();
+
+    is($data->{zoom}, 64, 'untouched key takes the written value');
+    is($data->{theme}, 'Mint-Y-Dark', 'unsaved change kept');
+    is_deeply(\@changes, ['zoom'], 'on_change gets only the keys that changed');
+
+    @changes = ();
+    $mine->_check();
+    is_deeply(\@changes, [], 'a file already merged is not merged again');
+
+    ok($mine->flush(), 'merged instance writes');
+    is_deeply(on_disk(), { zoom => 64, theme => 'Mint-Y-Dark', recent => [] },
+        'written file holds both instances\' changes');
+}
+
+# A write only replaces the file it last saw
+{
+    my $mine = store();
+    my $theirs = store();
+    my $data = $mine->load();
+    my $their_data = $theirs->load();
+
+    $their_data->{recent} = ['a.png'];
+    $theirs->save();
+    $theirs->flush();
+
+    # Not merged through the monitor yet: flush() finds the file changed
+    $data->{zoom} = 256;
+    $mine->save();
+    ok($mine->flush(), 'write after a concurrent write succeeds');
+    is_deeply(on_disk()->{recent}, ['a.png'], 'concurrent write not overwritten');
+    is(on_disk()->{zoom}, 256, 'own change written');
+    is_deeply($data->{recent}, ['a.png'], 'concurrent write merged into the live hash');
+}
+
+# Keys removed by the other instance
+{
+    my @changes;
+    my $mine = store(\@changes);
+    my $data = $mine->load();
+    $data->{extra} = 'added';
+    $mine->save();
+    $mine->flush();
+
+    my $content = on_disk();
+    delete $content->{extra};
+    write_raw(encode_json($content));
+    $mine->_check();
+    ok(!exists $data->{extra}, 'key deleted by the other instance is removed');
+    is_deeply(\@changes, ['extra'], 'deletion reported');
+}
+
+# Nested values are compared whole
+{
+    my @changes;
+    my $mine = store(\@changes);
+    my $data = $mine->load();
+
+    my $content = on_disk();
+    $content->{recent} = ['a.png', 'b.png'];
+    write_raw(encode_json($content));
+    $mine->_check();
+    is_deeply($data->{recent}, ['a.png', 'b.png'], 'changed list taken');
+    is_deeply(\@changes, ['recent'], 'only the changed list reported');
+}
+
+# Empty and broken files have nothing to merge
+{
+    my @changes;
+    my $mine = store(\@changes);
+    my $data = $mine->load();
+    my %before = %$data;
+
+    for my $content ('', '{"zoom": ', '[1, 2]') {
+        write_raw($content);
+        $mine->_check();
+        is_deeply($data, \%before, "live hash kept for '$content'");
+        is($mine->signature, $mine->_file_signature(), "signature adopted for '$content'");
+    }
+    is_deeply(\@changes, [], 'nothing reported');
+
+    $data->{zoom} = 32;
+    $mine->save();
+    ok($mine->flush(), 'broken file replaced by the next write');
+    is(on_disk()->{zoom}, 32, 'live hash written over it');
+}
+
+done_testing();
@@ -0,0 +1,174 @@
+use strict;
+use warnings;
+use utf8;
+
+# CinnamonSettings::ThemeArchive: the streaming tar parser on POSIX ustar,
+# GNU and pax archives, fed in small chunks as it is from the pipe
+
+use Test::More;
+use CinnamonSettings::ThemeArchive;
+
+use constant BLOCK => 512;
+
+sub padded {
+    my $data = shift;
+    return $data . ("\0" x ((BLOCK - length($data) % BLOCK) % BLOCK));
+}
+
+# One header block; format is 'ustar' (POSIX) or 'gnu'
+sub header {
+    my (%h) = @_;
+
+    my $format = $h{format} // 'ustar';
+    my ($magic, $version) = $format eq 'gnu' ? ('ustar ', " \0") : ("ustar\0", '00');
+    my $size = $h{size_field} // sprintf('%011o', $h{size} // 0);
+    # GNU headers keep the access and change times where POSIX has the prefix
+    my $prefix = $format eq 'gnu' ? pack('a12 a12', '14567112345', '14567112345') : ($h{prefix} // '');
+
+    my $header = pack('a100 a8 a8 a8 a12 a12 a8 a1 a100 a6 a2 a32 a32 a8 a8 a155 a12',
+        $h{name}, '0000644', '0001750', '0001750', $size, '14567112345', ' ' x 8,
+        $h{type} // '0', $h{link} // '', $magic, $version, 'user', 'user', '', '', $prefix, '');
+    substr($header, 148, 8) = sprintf("%06o\0 ", unpack('%32C*', $header));
+    return $header;
+}
+
+sub member {
+    my ($name, $data, %h) = @_;
+    return header(name => $name, size => length $data, %h) . padded($data);
+}
+
+sub pax {
+    my ($name, %records) = @_;
+
+    my $data = '';
+    foreach my $key (sort keys %records) {
+        my $record = " $key=$records{$key}\n";
+        my $length = length($record) + 1;
+        $length++ while length("$length$record") != $length;
+        $data .= "$length$record";
+    }
+    return member($name, $data, type => 'x');
+}
+
+sub archive {
+    return join('', @_) . ("\0" x (2 * BLOCK));
+}
+
+# Parse $tar in $chunk-byte pieces; returns the archive and parser state
+sub parse {
+    my ($tar, %args) = @_;
+
+    my $archive = CinnamonSettings::ThemeArchive->new(
+        path => 'test.tar',
+        session => {},
+        %{$args{options} || {}},
+    );
+    my $want = $args{want} || sub { 1 };
+    my $state = { buffer => '', want => $want, done => 0, links => [] };
+    my $chunk = $args{chunk} || 7;
+    $archive->_feed_tar($state, substr($tar, $_ * $chunk, $chunk)) for 0 .. int(length($tar) / $chunk);
+    return ($archive, $state);
+}
+
+# POSIX ustar, with a name split over the prefix field
+{
+    my $deep = 'Theme/gtk-3.0/' . ('assets/' x 14);
+    my $long_name = "${deep}check.svg";
+    my $tar = archive(
+        member('Theme/', '', type => '5'),
+        member('./Theme/index.theme', "[Desktop Entry]\nName=Theme\n"),
+        member('check.svg', '<svg/>', prefix => substr($deep, 0, -1)),
+        member('Theme/gtk-3.0/gtk.css', 'x' x 1300),
+        member('Theme/gtk-3.0/gtk-dark.css', '', type => '2', link => 'gtk.css'),
+    );
+
+    for my $chunk (1, 7, BLOCK, length $tar) {
+        my ($archive, $state) = parse($tar, chunk => $chunk);
+        ok($state->{done} && !$state->{error}, "ustar: parsed in $chunk-byte chunks");
+        is($archive->entries->{Theme}{type}, 'dir', "ustar: directory entry ($chunk)");
+        is($archive->member('Theme/index.theme'), "[Desktop Entry]\nName=Theme\n",
+            "ustar: leading ./ stripped ($chunk)");
+        is($archive->member($long_name), '<svg/>', "ustar: prefix joined to the name ($chunk)");
+        is($archive->member('Theme/gtk-3.0/gtk.css'), 'x' x 1300, "ustar: multi-block member ($chunk)");
+        is($archive->member('Theme/gtk-3.0/gtk-dark.css'), 'x' x 1300, "ustar: symlink followed ($chunk)");
+        is_deeply($state->{links}, ['Theme/gtk-3.0/gtk-dark.css'], "ustar: wanted links recorded ($chunk)");
+    }
+}
+
+# GNU: long names and link targets in ././@LongLink members, and a prefix
+# field that holds times rather than a name prefix
+{
+    my $long_name = 'Theme/gtk-3.0/' . ('a' x 120) . '.css';
+    my $long_link = 'Theme/gtk-3.0/' . ('b' x 120) . '.css';
+    my $tar = archive(
+        member('././@LongLink', "$long_name\0", type => 'L', format => 'gnu'),
+        member(substr($long_name, 0, 100), 'long', format => 'gnu'),
+        member('Theme/short.css', 'short', format => 'gnu'),
+        member('././@LongLink', "$long_name\0", type => 'K', format => 'gnu'),
+        member('././@LongLink', "$long_link\0", type => 'L', format => 'gnu'),
+        member(substr($long_link, 0, 100), '', type => '1', link => substr($long_name, 0, 100), format => 'gnu'),
+        member('Theme/big.css', 'z' x 3000, size_field => "\x80" . pack('x7 N', 3000), format => 'gnu'),
+    );
+
+    my ($archive, $state) = parse($tar);
+    ok($state->{done} && !$state->{error}, 'gnu: parsed');
+    is($archive->member($long_name), 'long', 'gnu: long name applied to the next member');
+    is($archive->member('Theme/short.css'), 'short', 'gnu: times in the prefix field ignored');
+    is($archive->entries->{$long_link}{link}, $long_name, 'gnu: long link target applied');
+    is($archive->member($long_link), 'long', 'gnu: hard link followed');
+    is($archive->member('Theme/big.css'), 'z' x 3000, 'gnu: base-256 size');
+    ok(!grep(/LongLink/, keys %{$archive->entries}), 'gnu: meta members are not entries');
+}
+
+# pax: extended headers override the path, link target and size
+{
+    my $long_target = 'gtk-3.0/' . ('c' x 150) . '.css';
+    my $long_name = "Theme/$long_target";
+    my $tar = archive(
+        member('pax_global_header', "20 comment=anything\n", type => 'g'),
+        pax('PaxHeaders/long', path => $long_name),
+        member('truncated', 'pax path'),
+        pax('PaxHeaders/size', size => 2000),
+        member('Theme/sized.css', 's' x 2000, size_field => sprintf('%011o', 0)),
+        pax('PaxHeaders/link', linkpath => $long_target, path => 'Theme/link.css'),
+        member('ignored', '', type => '2', link => 'ignored'),
+        member('Theme/plain.css', 'plain'),
+    );
+
+    my ($archive, $state) = parse($tar);
+    ok($state->{done} && !$state->{error}, 'pax: parsed');
+    is($archive->member($long_name), 'pax path', 'pax: path record');
+    is($archive->member('Theme/sized.css'), 's' x 2000, 'pax: size record');
+    is($archive->entries->{'Theme/link.css'}{link}, $long_target, 'pax: linkpath record');
+    is($archive->member('Theme/link.css'), 'pax path', 'pax: symlink followed');
+    is($archive->member('Theme/plain.css'), 'plain', 'pax: headers only apply to the next member');
+    ok(!exists $archive->entries->{truncated}, 'pax: header name replaced');
+    ok(!exists $archive->entries->{pax_global_header}, 'pax: global header is not an entry');
+}
+
+# Members are only kept when wanted and small enough
+{
+    my $tar = archive(
+        member('Theme/wanted.css', 'wanted'),
+        member('Theme/other.png', 'other'),
+        member('Theme/huge.css', 'h' x 5000),
+        member('Theme/after.css', 'after'),
+    );
+
+    my ($archive) = parse($tar, want => sub { $_[0] =~ /\.css$/ }, options => { max_member_bytes => 4096 });
+    is($archive->member('Theme/wanted.css'), 'wanted', 'wanted member kept');
+    ok(!defined $archive->member('Theme/other.png'), 'unwanted member dropped');
+    ok(!defined $archive->member('Theme/huge.css'), 'member over max_member_bytes dropped');
+    is($archive->entries->{'Theme/huge.css'}{size}, 5000, 'dropped member still indexed');
+    is($archive->member('Theme/after.css'), 'after', 'parsing continues past dropped members');
+    is($archive->kept_bytes, length('wanted') + length('after'), 'only kept bytes counted');
+}
+
+# Anything else is rejected
+{
+    my ($archive, $state) = parse(padded('PK' . "\0" x 600));
+    ok($state->{done}, 'non-tar input stops the parser');
+    like($state->{error}, qr/is not a tar archive/, 'non-tar input reported');
+}
+
+done_testing();
@@ -0,0 +1,125 @@
+/*
+ * xcursor_common.c
+ *
+ * Frame selection and pixel conversion for xcursor_extractor.
+ */
+
+#include <stdlib.h>
+#include <endian.h>
+
+#include "xcursor_common.h"
+
+XcursorImage *choose_frame(XcursorImages *images, int target_size)
+{
+    XcursorImage *largest = NULL;
+    XcursorImage *fit = NULL;
+    int largest_size = 0;
+    int fit_size = 0;
+    int i;
+
+    for (i = 0; i < images->nimage; i++) {
+        XcursorImage *img = images->images[i];
+        int size = img->width > img->height ? img->width : img->height;
+
+        if (size > largest_size) {
+            largest_size = size;
+            largest = img;
+        }
+        if (target_size > 0 && size >= target_size && (!fit || size < fit_size)) {
+            fit_size = size;
+            fit = img;
+        }
+    }
+
+    return fit ? fit : largest;
+}
+
+XcursorDim nearest_nominal_size(XcursorImages *images, int target_size)
+{
+    XcursorDim best = 0;
+    int i;
+
+    for (i = 0; i < images->nimage; i++) {
+        XcursorDim size = images->images[i]->size;
+
+        if (best == 0 || target_size <= 0) {
+            if (size > best) best = size;
+            continue;
+        }
+
+        int distance = abs((int)size - target_size);
+        int best_distance = abs((int)best - target_size);
+        if (distance < best_distance || (distance == best_distance && size > best)) {
+            best = size;
+        }
+    }
+
+    return best;
+}
+
+void separate_alpha_pixel(XcursorPixel *pixel)
+{
+    unsigned int alpha, red, green, blue;
+
+    /* Extract components (XCursor format is ARGB) */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    blue  = (*pixel) & 0xFF;
+    green = ((*pixel) >> 8) & 0xFF;
+    red   = ((*pixel) >> 16) & 0xFF;
+    alpha = ((*pixel) >> 24) & 0xFF;
+#else
+    alpha = (*pixel) & 0xFF;
+    red   = ((*pixel) >> 8) & 0xFF;
+    green = ((*pixel) >> 16) & 0xFF;
+    blue  = ((*pixel) >> 24) & 0xFF;
+#endif
+
+    /* If alpha is 0, pixel is fully transparent */
+    if (alpha == 0) {
+        *pixel = 0;
+        return;
+    }
+
+    /* Separate pre-multiplied alpha (same algorithm as GIMP uses) */
+    red   = (red * 255 + alpha / 2) / alpha;
+    green = (green * 255 + alpha / 2) / alpha;
+    blue  = (blue * 255 + alpha / 2) / alpha;
+
+    /* Clamp values */
+    if (red > 255) red = 255;
+    if (green > 255) green = 255;
+    if (blue > 255) blue = 255;
+
+    /* Reconstruct pixel */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    *pixel = blue | (green << 8) | (red << 16) | (alpha << 24);
+#else
+    *pixel = alpha | (red << 8) | (green << 16) | (blue << 24);
+#endif
+}
+
+void frame_row_to_rgba(XcursorImage *image, int y, unsigned char *row)
+{
+    unsigned int x;
+
+    for (x = 0; x < image->width; x++) {
+        XcursorPixel pixel = image->pixels[y * image->width + x];
+
+        /* XCursor uses pre-multiplied alpha, we need to separate it */
+        separate_alpha_pixel(&pixel);
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        /* XCursor format: ARGB (little-endian) */
+        row[x * 4 + 0] = (pixel >> 16) & 0xFF;  /* R */
+        row[x * 4 + 1] = (pixel >> 8) & 0xFF;   /* G */
+        row[x * 4 + 2] = pixel & 0xFF;          /* B */
+        row[x * 4 + 3] = (pixel >> 24) & 0xFF;  /* A */
+#else
+        /* Big-endian systems */
+        row[x * 4 + 0] = (pixel >> 8) & 0xFF;   /* R */
+        row[x * 4 + 1] = (pixel >> 16) & 0xFF;  /* G */
+        row[x * 4 + 2] = (pixel >> 24) & 0xFF;  /* B */
+        row[x * 4 + 3] = pixel & 0xFF;          /* A */
+#endif
+    }
+}
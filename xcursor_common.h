@@ -0,0 +1,26 @@
+/*
+ * xcursor_common.h
+ *
+ * Frame selection and pixel conversion for xcursor_extractor.
+ */
+
+#ifndef XCURSOR_COMMON_H
+#define XCURSOR_COMMON_H
+
+#include <X11/Xcursor/Xcursor.h>
+
+/* First frame of the smallest size covering target_size, or the largest
+ * frame when none does or target_size is 0 */
+XcursorImage *choose_frame(XcursorImages *images, int target_size);
+
+/* Nominal size closest to target_size (the larger one on a tie), or the
+ * largest nominal size when target_size is 0 */
+XcursorDim nearest_nominal_size(XcursorImages *images, int target_size);
+
+/* Undo Xcursor's premultiplied alpha in place */
+void separate_alpha_pixel(XcursorPixel *pixel);
+
+/* Convert row y of a frame to straight-alpha RGBA bytes */
+void frame_row_to_rgba(XcursorImage *image, int y, unsigned char *row);
+
+#endif /* XCURSOR_COMMON_H */
@@ -0,0 +1,774 @@
+/*
+ * xcursor_compiler.c
+ *
+ * The counterpart of xcursor_extractor: builds a complete Xcursor theme
+ * from PNG frames, one cursor per worker thread.
+ *
+ * Usage: ./xcursor_compiler [-j <workers>] <source_directory> <output_theme_directory>
+ *
+ * The source directory holds one xcursorgen style config per cursor,
+ * named <cursor>.cursor, with one line per frame:
+ *
+ *     <size> <xhot> <yhot> <png file> [<delay ms>]
+ *
+ * PNG paths are relative to the source directory. An optional "aliases"
+ * file lists "<alias> <cursor>" pairs, and an optional index.theme is
+ * copied as is. The output directory receives index.theme and cursors/,
+ * with aliases written as symlinks.
+ *
+ * PNG pixels are premultiplied four at a time with SSE2 where available.
+ * Identical frames within a cursor (repeated animation steps, the same
+ * PNG listed twice) are stored once and shared through the table of
+ * contents, and cursors whose configs are identical are written once and
+ * symlinked, like aliases.
+ *
+ * Requires: libpng-dev
+ * Compile: gcc -O2 -pthread -o xcursor_compiler xcursor_compiler.c -lpng
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <png.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define XCURSOR_MAGIC 0x72756358u       /* "Xcur" */
+#define XCURSOR_FILE_VERSION 0x00010000u
+#define XCURSOR_FILE_HEADER_LEN 16
+#define XCURSOR_TOC_LEN 12
+#define XCURSOR_IMAGE_TYPE 0xfffd0002u
+#define XCURSOR_IMAGE_VERSION 1
+#define XCURSOR_IMAGE_HEADER_LEN 36
+#define XCURSOR_IMAGE_MAX_SIZE 0x7fff   /* libXcursor rejects anything larger */
+
+#define MAX_WORKERS 64
+
+typedef struct {
+    unsigned int size, xhot, yhot, delay;
+    char *png;
+    unsigned int width, height;
+    uint32_t *pixels;       /* premultiplied ARGB, native byte order */
+    int pixels_from;        /* frame whose pixel buffer this one borrows, or -1 */
+    int chunk;              /* frame whose chunk this one shares, or -1 */
+    uint64_t hash;
+} Frame;
+
+typedef struct {
+    char name[NAME_MAX + 1];
+    char *config;           /* normalised config text, for finding duplicates */
+    Frame *frames;
+    int nframes;
+    int link_to;            /* identical cursor to symlink to, or -1 */
+    int shared_chunks;
+    int result;
+} CursorJob;
+
+typedef struct {
+    const char *source_dir;
+    char cursors_dir[PATH_MAX];
+    CursorJob *jobs;
+    int njobs;
+    int next_job;           /* taken with an atomic add by the workers */
+} Theme;
+
+/* Function prototypes */
+int compile_theme(const char *source_dir, const char *output_dir, int workers);
+int find_cursor_configs(Theme *theme);
+int parse_cursor_config(const char *path, CursorJob *job);
+void *compile_worker(void *arg);
+int compile_cursor(Theme *theme, CursorJob *job);
+int load_png_frame(const char *path, Frame *frame);
+void premultiply_row(const unsigned char *rgba, uint32_t *out, unsigned int count);
+uint64_t hash_pixels(const uint32_t *pixels, size_t count);
+int write_cursor_file(const char *path, CursorJob *job);
+int write_aliases(Theme *theme);
+int write_index_theme(const char *source_dir, const char *output_dir);
+int create_directory(const char *path);
+int replace_with_symlink(const char *dir, const char *name, const char *target);
+void free_job(CursorJob *job);
+double now_seconds(void);
+void print_usage(const char *program_name);
+
+int main(int argc, char *argv[])
+{
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    int arg = 1;
+
+    if (argc >= 3 && strcmp(argv[1], "-j") == 0) {
+        workers = strtol(argv[2], NULL, 10);
+        arg = 3;
+    }
+
+    if (argc - arg != 2 || workers < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (workers > MAX_WORKERS) {
+        workers = MAX_WORKERS;
+    }
+
+    return compile_theme(argv[arg], argv[arg + 1], (int)workers);
+}
+
+int compile_theme(const char *source_dir, const char *output_dir, int workers)
+{
+    Theme theme;
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+    int failed = 0;
+    int frames = 0, shared = 0, links = 0;
+    double start = now_seconds();
+    int i, j;
+
+    memset(&theme, 0, sizeof(theme));
+    theme.source_dir = source_dir;
+
+    if (find_cursor_configs(&theme) != 0) {
+        return 1;
+    }
+    if (theme.njobs == 0) {
+        fprintf(stderr, "Error: No .cursor configs found in '%s'\n", source_dir);
+        return 1;
+    }
+
+    snprintf(theme.cursors_dir, sizeof(theme.cursors_dir), "%s/cursors", output_dir);
+    if (create_directory(output_dir) != 0 || create_directory(theme.cursors_dir) != 0) {
+        fprintf(stderr, "Error: Cannot create output directory '%s'\n", output_dir);
+        return 1;
+    }
+
+    /* Cursors with the same config would produce the same file */
+    for (i = 0; i < theme.njobs; i++) {
+        for (j = 0; j < i; j++) {
+            if (theme.jobs[j].link_to < 0 && strcmp(theme.jobs[i].config, theme.jobs[j].config) == 0) {
+                theme.jobs[i].link_to = j;
+                break;
+            }
+        }
+    }
+
+    if (workers > theme.njobs) {
+        workers = theme.njobs;
+    }
+    for (i = 1; i < workers; i++) {
+        if (pthread_create(&threads[started], NULL, compile_worker, &theme) == 0) {
+            started++;
+        }
+    }
+    compile_worker(&theme);
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < theme.njobs; i++) {
+        CursorJob *job = &theme.jobs[i];
+
+        if (job->link_to >= 0) {
+            if (replace_with_symlink(theme.cursors_dir, job->name, theme.jobs[job->link_to].name) != 0) {
+                failed++;
+            }
+            links++;
+            continue;
+        }
+        if (job->result != 0) {
+            failed++;
+        }
+        frames += job->nframes;
+        shared += job->shared_chunks;
+    }
+
+    if (write_aliases(&theme) != 0 || write_index_theme(source_dir, output_dir) != 0) {
+        failed++;
+    }
+
+    printf("Compiled %d cursor(s), %d frame(s) (%d shared), %d duplicate(s) linked, "
+           "in %.2fs with %d worker(s) -> '%s'\n",
+           theme.njobs - links, frames, shared, links, now_seconds() - start,
+           started + 1, output_dir);
+
+    for (i = 0; i < theme.njobs; i++) {
+        free_job(&theme.jobs[i]);
+    }
+    free(theme.jobs);
+
+    return failed ? 1 : 0;
+}
+
+int find_cursor_configs(Theme *theme)
+{
+    DIR *dir;
+    struct dirent *entry;
+    char path[PATH_MAX];
+    int capacity = 0;
+
+    dir = opendir(theme->source_dir);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", theme->source_dir, strerror(errno));
+        return 1;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        CursorJob *job;
+
+        if (len <= 7 || strcmp(entry->d_name + len - 7, ".cursor") != 0) {
+            continue;
+        }
+
+        if (theme->njobs == capacity) {
+            CursorJob *grown;
+
+            capacity = capacity ? capacity * 2 : 64;
+            grown = realloc(theme->jobs, capacity * sizeof(CursorJob));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory\n");
+                closedir(dir);
+                return 1;
+            }
+            theme->jobs = grown;
+        }
+
+        job = &theme->jobs[theme->njobs];
+        memset(job, 0, sizeof(*job));
+        job->link_to = -1;
+        snprintf(job->name, sizeof(job->name), "%.*s", (int)(len - 7), entry->d_name);
+
+        snprintf(path, sizeof(path), "%s/%s", theme->source_dir, entry->d_name);
+        if (parse_cursor_config(path, job) != 0) {
+            free_job(job);
+            closedir(dir);
+            return 1;
+        }
+        theme->njobs++;
+    }
+
+    closedir(dir);
+    return 0;
+}
+
+int parse_cursor_config(const char *path, CursorJob *job)
+{
+    FILE *fp;
+    char line[PATH_MAX + 64];
+    char png[PATH_MAX];
+    size_t config_len = 0;
+    int capacity = 0;
+    int line_no = 0;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        Frame *frame;
+        char *normalised;
+        int fields;
+
+        line_no++;
+        if (line[0] == '#' || strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+
+        if (job->nframes == capacity) {
+            Frame *grown;
+
+            capacity = capacity ? capacity * 2 : 16;
+            grown = realloc(job->frames, capacity * sizeof(Frame));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory\n");
+                fclose(fp);
+                return 1;
+            }
+            job->frames = grown;
+        }
+
+        frame = &job->frames[job->nframes];
+        memset(frame, 0, sizeof(*frame));
+        frame->pixels_from = -1;
+        frame->chunk = -1;
+
+        fields = sscanf(line, "%u %u %u %4095s %u", &frame->size, &frame->xhot, &frame->yhot, png, &frame->delay);
+        if (fields < 4 || frame->size == 0 || frame->size > XCURSOR_IMAGE_MAX_SIZE) {
+            fprintf(stderr, "Error: %s:%d: expected '<size> <xhot> <yhot> <png> [<delay>]'\n", path, line_no);
+            fclose(fp);
+            return 1;
+        }
+
+        frame->png = strdup(png);
+        job->nframes++;
+
+        normalised = realloc(job->config, config_len + strlen(line) + 64);
+        if (!frame->png || !normalised) {
+            fprintf(stderr, "Error: Out of memory\n");
+            fclose(fp);
+            return 1;
+        }
+        job->config = normalised;
+        config_len += sprintf(job->config + config_len, "%u %u %u %s %u\n",
+                              frame->size, frame->xhot, frame->yhot, png, frame->delay);
+    }
+
+    fclose(fp);
+
+    if (job->nframes == 0) {
+        fprintf(stderr, "Error: '%s' lists no frames\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+void *compile_worker(void *arg)
+{
+    Theme *theme = arg;
+    int index;
+
+    while ((index = __atomic_fetch_add(&theme->next_job, 1, __ATOMIC_RELAXED)) < theme->njobs) {
+        CursorJob *job = &theme->jobs[index];
+
+        if (job->link_to < 0) {
+            job->result = compile_cursor(theme, job);
+        }
+    }
+
+    return NULL;
+}
+
+int compile_cursor(Theme *theme, CursorJob *job)
+{
+    char path[PATH_MAX + NAME_MAX + 8];
+    char tmp_path[PATH_MAX + NAME_MAX + 8];
+    int i, j;
+
+    for (i = 0; i < job->nframes; i++) {
+        Frame *frame = &job->frames[i];
+
+        /* The same PNG listed twice is decoded once */
+        for (j = 0; j < i; j++) {
+            if (strcmp(job->frames[j].png, frame->png) == 0) {
+                frame->pixels_from = job->frames[j].pixels_from >= 0 ? job->frames[j].pixels_from : j;
+                frame->pixels = job->frames[j].pixels;
+                frame->width = job->frames[j].width;
+                frame->height = job->frames[j].height;
+                frame->hash = job->frames[j].hash;
+                break;
+            }
+        }
+
+        if (!frame->pixels) {
+            snprintf(path, sizeof(path), "%s/%s", theme->source_dir, frame->png);
+            if (load_png_frame(path, frame) != 0) {
+                return 1;
+            }
+            frame->hash = hash_pixels(frame->pixels, (size_t)frame->width * frame->height);
+        }
+
+        if (frame->xhot >= frame->width || frame->yhot >= frame->height) {
+            fprintf(stderr, "Warning: %s: hotspot %u,%u outside %ux%u frame, clamped\n",
+                    job->name, frame->xhot, frame->yhot, frame->width, frame->height);
+            if (frame->xhot >= frame->width) frame->xhot = frame->width - 1;
+            if (frame->yhot >= frame->height) frame->yhot = frame->height - 1;
+        }
+
+        /* Identical frames share one chunk through the table of contents */
+        for (j = 0; j < i; j++) {
+            Frame *other = &job->frames[j];
+
+            if (other->chunk < 0 && other->hash == frame->hash &&
+                other->size == frame->size && other->delay == frame->delay &&
+                other->xhot == frame->xhot && other->yhot == frame->yhot &&
+                other->width == frame->width && other->height == frame->height &&
+                (other->pixels == frame->pixels ||
+                 memcmp(other->pixels, frame->pixels, (size_t)frame->width * frame->height * 4) == 0)) {
+                frame->chunk = j;
+                job->shared_chunks++;
+                break;
+            }
+        }
+    }
+
+    /* Written next to the target and renamed, so a running session never
+     * sees a half-written cursor */
+    snprintf(path, sizeof(path), "%s/%s", theme->cursors_dir, job->name);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.%s.tmp", theme->cursors_dir, job->name);
+    if (write_cursor_file(tmp_path, job) != 0) {
+        unlink(tmp_path);
+        return 1;
+    }
+    unlink(path);
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: Cannot rename '%s': %s\n", tmp_path, strerror(errno));
+        unlink(tmp_path);
+        return 1;
+    }
+
+    return 0;
+}
+
+int load_png_frame(const char *path, Frame *frame)
+{
+    png_image image;
+    unsigned char *rgba;
+    unsigned int y;
+
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&image, path)) {
+        fprintf(stderr, "Error: Cannot read '%s': %s\n", path, image.message);
+        return 1;
+    }
+
+    if (image.width > XCURSOR_IMAGE_MAX_SIZE || image.height > XCURSOR_IMAGE_MAX_SIZE) {
+        fprintf(stderr, "Error: '%s' is larger than an Xcursor frame can be\n", path);
+        png_image_free(&image);
+        return 1;
+    }
+
+    image.format = PNG_FORMAT_RGBA;
+    rgba = malloc(PNG_IMAGE_SIZE(image));
+    frame->pixels = malloc((size_t)image.width * image.height * 4);
+    if (!rgba || !frame->pixels) {
+        fprintf(stderr, "Error: Out of memory loading '%s'\n", path);
+        png_image_free(&image);
+        free(rgba);
+        return 1;
+    }
+
+    if (!png_image_finish_read(&image, NULL, rgba, 0, NULL)) {
+        fprintf(stderr, "Error: Cannot decode '%s': %s\n", path, image.message);
+        free(rgba);
+        return 1;
+    }
+
+    frame->width = image.width;
+    frame->height = image.height;
+    for (y = 0; y < image.height; y++) {
+        premultiply_row(rgba + (size_t)y * image.width * 4,
+                        frame->pixels + (size_t)y * image.width, image.width);
+    }
+
+    free(rgba);
+    return 0;
+}
+
+/* (c * a + 127) / 255 without the divide; exact for 8-bit inputs */
+static inline unsigned int mul_div255(unsigned int c, unsigned int a)
+{
+    unsigned int t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+#if defined(__SSE2__)
+/* Two RGBA pixels widened to 16-bit lanes become premultiplied BGRA,
+ * which is little-endian ARGB */
+static inline __m128i premultiply_pair(__m128i v)
+{
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i bias = _mm_set1_epi16(128);
+    __m128i alpha, t;
+
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 0, 1, 2));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 0, 1, 2));
+
+    /* Colour lanes scale by alpha, the alpha lane by 255/255 */
+    alpha = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_or_si128(_mm_and_si128(alpha, rgb_mask), alpha_one);
+
+    t = _mm_add_epi16(_mm_mullo_epi16(v, alpha), bias);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+void premultiply_row(const unsigned char *rgba, uint32_t *out, unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+        __m128i lo = premultiply_pair(_mm_unpacklo_epi8(px, zero));
+        __m128i hi = premultiply_pair(_mm_unpackhi_epi8(px, zero));
+
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; i < count; i++) {
+        const unsigned char *p = rgba + i * 4;
+        unsigned int a = p[3];
+
+        out[i] = (uint32_t)a << 24 | mul_div255(p[0], a) << 16 |
+                 mul_div255(p[1], a) << 8 | mul_div255(p[2], a);
+    }
+}
+
+/* FNV-1a, only used to skip most byte comparisons between frames */
+uint64_t hash_pixels(const uint32_t *pixels, size_t count)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        hash = (hash ^ pixels[i]) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static int put_u32(FILE *fp, uint32_t value)
+{
+    unsigned char bytes[4] = {
+        value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF
+    };
+    return fwrite(bytes, 1, 4, fp) == 4 ? 0 : -1;
+}
+
+int write_cursor_file(const char *path, CursorJob *job)
+{
+    FILE *fp;
+    uint32_t *positions;
+    uint32_t position;
+    int failed = 0;
+    int i;
+
+    positions = malloc(job->nframes * sizeof(uint32_t));
+    if (!positions) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+
+    /* Lay out the chunks after the header and table of contents */
+    position = XCURSOR_FILE_HEADER_LEN + job->nframes * XCURSOR_TOC_LEN;
+    for (i = 0; i < job->nframes; i++) {
+        Frame *frame = &job->frames[i];
+
+        if (frame->chunk >= 0) {
+            positions[i] = positions[frame->chunk];
+            continue;
+        }
+        positions[i] = position;
+        position += XCURSOR_IMAGE_HEADER_LEN + frame->width * frame->height * 4;
+    }
+
+    fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot create '%s': %s\n", path, strerror(errno));
+        free(positions);
+        return 1;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 16);
+
+    failed |= put_u32(fp, XCURSOR_MAGIC);
+    failed |= put_u32(fp, XCURSOR_FILE_HEADER_LEN);
+    failed |= put_u32(fp, XCURSOR_FILE_VERSION);
+    failed |= put_u32(fp, job->nframes);
+
+    for (i = 0; i < job->nframes; i++) {
+        failed |= put_u32(fp, XCURSOR_IMAGE_TYPE);
+        failed |= put_u32(fp, job->frames[i].size);
+        failed |= put_u32(fp, positions[i]);
+    }
+
+    for (i = 0; i < job->nframes && !failed; i++) {
+        Frame *frame = &job->frames[i];
+        size_t count = (size_t)frame->width * frame->height;
+
+        if (frame->chunk >= 0) {
+            continue;
+        }
+
+        failed |= put_u32(fp, XCURSOR_IMAGE_HEADER_LEN);
+        failed |= put_u32(fp, XCURSOR_IMAGE_TYPE);
+        failed |= put_u32(fp, frame->size);
+        failed |= put_u32(fp, XCURSOR_IMAGE_VERSION);
+        failed |= put_u32(fp, frame->width);
+        failed |= put_u32(fp, frame->height);
+        failed |= put_u32(fp, frame->xhot);
+        failed |= put_u32(fp, frame->yhot);
+        failed |= put_u32(fp, frame->delay);
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        /* Native ARGB already is the file's little-endian layout */
+        if (fwrite(frame->pixels, 4, count, fp) != count) {
+            failed = 1;
+        }
+#else
+        {
+            size_t p;
+            for (p = 0; p < count; p++) {
+                failed |= put_u32(fp, frame->pixels[p]);
+            }
+        }
+#endif
+    }
+
+    if (fclose(fp) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        fprintf(stderr, "Error: Cannot write '%s': %s\n", path, strerror(errno));
+    }
+
+    free(positions);
+    return failed ? 1 : 0;
+}
+
+int write_aliases(Theme *theme)
+{
+    char path[PATH_MAX];
+    char line[2 * NAME_MAX + 16];
+    char alias[NAME_MAX + 1];
+    char target[NAME_MAX + 1];
+    FILE *fp;
+    int failed = 0;
+
+    snprintf(path, sizeof(path), "%s/aliases", theme->source_dir);
+    fp = fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#' || sscanf(line, "%255s %255s", alias, target) != 2) {
+            continue;
+        }
+        if (strchr(alias, '/') || strchr(target, '/') || strcmp(alias, target) == 0) {
+            fprintf(stderr, "Warning: Ignoring alias '%s' -> '%s'\n", alias, target);
+            continue;
+        }
+        if (replace_with_symlink(theme->cursors_dir, alias, target) != 0) {
+            failed = 1;
+        }
+    }
+
+    fclose(fp);
+    return failed;
+}
+
+int write_index_theme(const char *source_dir, const char *output_dir)
+{
+    char source[PATH_MAX];
+    char target[PATH_MAX];
+    char buffer[4096];
+    const char *name;
+    FILE *in, *out;
+    size_t len;
+
+    snprintf(source, sizeof(source), "%s/index.theme", source_dir);
+    snprintf(target, sizeof(target), "%s/index.theme", output_dir);
+
+    out = fopen(target, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Cannot create '%s': %s\n", target, strerror(errno));
+        return 1;
+    }
+
+    in = fopen(source, "r");
+    if (in) {
+        while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            fwrite(buffer, 1, len, out);
+        }
+        fclose(in);
+    } else {
+        name = strrchr(output_dir, '/');
+        name = name && name[1] ? name + 1 : output_dir;
+        fprintf(out, "[Icon Theme]\nName=%s\nComment=%s cursor theme\n", name, name);
+    }
+
+    return fclose(out) == 0 ? 0 : 1;
+}
+
+int create_directory(const char *path)
+{
+    struct stat st = {0};
+
+    /* Check if directory already exists */
+    if (stat(path, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) {
+            return 0; /* Directory exists */
+        } else {
+            fprintf(stderr, "Error: '%s' exists but is not a directory\n", path);
+            return 1;
+        }
+    }
+
+    /* Create directory */
+    if (mkdir(path, 0755) != 0) {
+        fprintf(stderr, "Error: Cannot create directory '%s': %s\n",
+                path, strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
+
+int replace_with_symlink(const char *dir, const char *name, const char *target)
+{
+    char path[PATH_MAX + NAME_MAX + 8];
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    unlink(path);
+    if (symlink(target, path) != 0) {
+        fprintf(stderr, "Error: Cannot link '%s' to '%s': %s\n", path, target, strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
+
+void free_job(CursorJob *job)
+{
+    int i;
+
+    for (i = 0; i < job->nframes; i++) {
+        if (job->frames[i].pixels_from < 0) {
+            free(job->frames[i].pixels);
+        }
+        free(job->frames[i].png);
+    }
+    free(job->frames);
+    free(job->config);
+}
+
+double now_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void print_usage(const char *program_name)
+{
+    printf("XCursor Theme Compiler\n");
+    printf("Usage: %s [-j <workers>] <source_directory> <output_theme_directory>\n", program_name);
+    printf("\n");
+    printf("Builds an Xcursor theme from PNG frames. The source directory holds one\n");
+    printf("<cursor>.cursor config per cursor, in xcursorgen's format:\n");
+    printf("  <size> <xhot> <yhot> <png file> [<delay ms>]\n");
+    printf("plus optional \"aliases\" (\"<alias> <cursor>\" per line) and index.theme files.\n");
+    printf("\n");
+    printf("Example:\n");
+    printf("  %s ./branded-src ~/.icons/Branded\n", program_name);
+    printf("\n");
+    printf("Cursors are compiled in parallel, one worker per CPU unless -j says otherwise.\n");
+}
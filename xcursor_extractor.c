@@ -5,9 +5,34 @@
  * and save them as PNG files for use with other applications.
  * 
  * Usage: ./xcursor_extractor <input_cursor_file> <output_directory>
+ *        ./xcursor_extractor --stdout <input_cursor_file>
+ *        ./xcursor_extractor --argb32 <input_cursor_file> [size]
+ *        ./xcursor_extractor --optimize <theme_dir> <output_dir> [sizes]
+ *
+ * The --stdout mode writes only the largest frame as a PNG stream to
+ * standard output, so callers can read it over a pipe without creating
+ * any temporary files.
+ *
+ * The --argb32 mode writes one frame in Cairo's CAIRO_FORMAT_ARGB32
+ * layout: a text header "ARGB32 <width> <height> <stride>\n" followed by
+ * premultiplied pixels in native byte order. Xcursor already stores
+ * pixels that way, so the frame is copied as is, or box-filtered down to
+ * fit <size> when it is larger; there is no unpremultiply and no encode.
+ * An input file of "-" reads the cursor from standard input, for cursors
+ * that are only held in memory, such as members of an unopened archive.
+ *
+ * The --optimize mode rewrites a whole cursor theme into output_dir so
+ * libXcursor has less to read: byte-identical cursor files become
+ * symlinks, identical consecutive animation frames are folded into one
+ * frame with the summed delay, and with a comma separated size list only
+ * the nominal sizes nearest to those are kept. It reports the size saved
+ * and XcursorLibraryLoadImages time before and after.
+ *
+ * When CSM_TRACE names a trace file started by one of the managers, load
+ * and encode times are appended to it as Trace Event JSON lines.
  * 
  * Requires: libXcursor-dev, libpng-dev
- * Compile: gcc -o xcursor_extractor xcursor_extractor.c -lXcursor -lpng
+ * Compile: gcc -o xcursor_extractor xcursor_extractor.c xcursor_common.c -lXcursor -lpng
  */
 
 #include <stdio.h>
@@ -16,24 +41,96 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/wait.h>
 
 #include <X11/Xcursor/Xcursor.h>
 #include <png.h>
 
+#include "xcursor_common.h"
+
+#define MAX_OPTIMIZE_SIZES 16
+
+typedef struct {
+    int files;
+    int linked;
+    int symlinks;
+    int frames_merged;
+    int frames_stripped;
+    long bytes_before;
+    long bytes_after;
+} OptimizeStats;
+
+typedef struct {
+    char name[NAME_MAX + 1];
+    unsigned char *data;
+    size_t len;
+    unsigned long long hash;
+    int is_link;
+    int linked;
+} CursorFile;
+
 /* Function prototypes */
 int extract_cursor_frames(const char *input_file, const char *output_dir);
+int write_largest_frame(const char *input_file, FILE *out);
 int save_frame_as_png(XcursorImage *image, const char *filename, int frame_num);
+int write_frame_png(XcursorImage *image, FILE *fp);
+int write_frame_argb32(const char *input_file, int target_size, FILE *out);
+int write_argb32(XcursorImage *image, int target_size, FILE *out);
 int create_directory(const char *path);
-void separate_alpha_pixel(XcursorPixel *pixel);
+int optimize_theme(const char *theme_dir, const char *output_dir, const char *size_list);
+int optimize_cursor_file(const unsigned char *data, size_t len, const char *output_path,
+                         const int *sizes, int nsizes, OptimizeStats *stats);
+double measure_theme_load(const char *theme_dir, char **names, int nnames, int size);
+int parse_size_list(const char *list, int *sizes, int max_sizes);
+int read_whole_file(const char *path, unsigned char **data, size_t *len);
+int read_whole_stream(FILE *fp, unsigned char **data, size_t *len);
+int write_whole_file(const char *path, const unsigned char *data, size_t len);
+unsigned long long hash_bytes(const unsigned char *data, size_t len);
+double monotonic_us(void);
 void print_usage(const char *program_name);
+void trace_open(void);
+double trace_now_us(void);
+void trace_span(const char *name, double start_us, const char *file);
+void trace_write(const char *line, int len);
+
+/* Trace file shared with the managers, or -1 when tracing is off */
+static int trace_fd = -1;
 
 int main(int argc, char *argv[])
 {
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--optimize") == 0) {
+        return optimize_theme(argv[2], argv[3], argc == 5 ? argv[4] : NULL);
+    }
+    
+    if (argc == 4 && strcmp(argv[1], "--argb32") == 0) {
+        trace_open();
+        return write_frame_argb32(argv[2], atoi(argv[3]), stdout);
+    }
+    
     if (argc != 3) {
         print_usage(argv[0]);
         return 1;
     }
     
+    trace_open();
+    
+    if (strcmp(argv[1], "--argb32") == 0) {
+        return write_frame_argb32(argv[2], 0, stdout);
+    }
+    
+    if (strcmp(argv[1], "--stdout") == 0) {
+        if (access(argv[2], R_OK) != 0) {
+            fprintf(stderr, "Error: Cannot read input file '%s': %s\n", 
+                    argv[2], strerror(errno));
+            return 1;
+        }
+        return write_largest_frame(argv[2], stdout);
+    }
+    
     const char *input_file = argv[1];
     const char *output_dir = argv[2];
     
@@ -69,6 +166,7 @@ int extract_cursor_frames(const char *input_file, const char *output_dir)
     char output_path[1024];
     char info_file[1024];
     FILE *info_fp;
+    double start;
     
     /* Open cursor file */
     fp = fopen(input_file, "rb");
@@ -78,11 +176,13 @@ int extract_cursor_frames(const char *input_file, const char *output_dir)
     }
     
     /* Load cursor data using libXcursor */
+    start = trace_now_us();
     if (!XcursorFileLoad(fp, &comments, &images)) {
         fprintf(stderr, "Error: '%s' is not a valid XCursor file\n", input_file);
         fclose(fp);
         return 1;
     }
+    trace_span("xcursor load", start, input_file);
     
     fclose(fp);
     
@@ -125,6 +225,7 @@ int extract_cursor_frames(const char *input_file, const char *output_dir)
     }
     
     /* Extract each frame */
+    start = trace_now_us();
     for (i = 0; i < images->nimage; i++) {
         snprintf(output_path, sizeof(output_path), "%s/frame_%03d.png", output_dir, i + 1);
         
@@ -140,6 +241,8 @@ int extract_cursor_frames(const char *input_file, const char *output_dir)
                images->images[i]->size, images->images[i]->delay, output_path);
     }
     
+    trace_span("png encode", start, input_file);
+    
     /* Clean up */
     XcursorImagesDestroy(images);
     if (comments) XcursorCommentsDestroy(comments);
@@ -147,13 +250,190 @@ int extract_cursor_frames(const char *input_file, const char *output_dir)
     return 0;
 }
 
+int write_largest_frame(const char *input_file, FILE *out)
+{
+    FILE *fp;
+    XcursorImages *images;
+    XcursorComments *comments;
+    XcursorImage *best = NULL;
+    int best_size = 0;
+    int result;
+    int i;
+    double start;
+    
+    fp = fopen(input_file, "rb");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", input_file, strerror(errno));
+        return 1;
+    }
+    
+    start = trace_now_us();
+    if (!XcursorFileLoad(fp, &comments, &images)) {
+        fprintf(stderr, "Error: '%s' is not a valid XCursor file\n", input_file);
+        fclose(fp);
+        return 1;
+    }
+    trace_span("xcursor load", start, input_file);
+    
+    fclose(fp);
+    
+    if (!images || images->nimage == 0) {
+        fprintf(stderr, "Error: No images found in cursor file\n");
+        if (images) XcursorImagesDestroy(images);
+        if (comments) XcursorCommentsDestroy(comments);
+        return 1;
+    }
+    
+    /* Pick the first frame of the largest nominal size */
+    for (i = 0; i < images->nimage; i++) {
+        XcursorImage *img = images->images[i];
+        int size = img->width > img->height ? img->width : img->height;
+        
+        if (size > best_size) {
+            best_size = size;
+            best = img;
+        }
+    }
+    
+    start = trace_now_us();
+    result = write_frame_png(best, out);
+    fflush(out);
+    trace_span("png encode", start, input_file);
+    
+    XcursorImagesDestroy(images);
+    if (comments) XcursorCommentsDestroy(comments);
+    
+    return result;
+}
+
+int write_frame_argb32(const char *input_file, int target_size, FILE *out)
+{
+    FILE *fp;
+    XcursorImages *images;
+    XcursorComments *comments;
+    unsigned char *data = NULL;
+    size_t len;
+    int result;
+    double start;
+    
+    if (strcmp(input_file, "-") == 0) {
+        /* libXcursor seeks to the table of contents, which a pipe cannot do */
+        if (read_whole_stream(stdin, &data, &len) != 0) {
+            fprintf(stderr, "Error: Cannot read cursor from standard input\n");
+            return 1;
+        }
+        fp = fmemopen(data, len, "rb");
+    } else {
+        fp = fopen(input_file, "rb");
+    }
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", input_file, strerror(errno));
+        free(data);
+        return 1;
+    }
+    
+    start = trace_now_us();
+    if (!XcursorFileLoad(fp, &comments, &images)) {
+        fprintf(stderr, "Error: '%s' is not a valid XCursor file\n", input_file);
+        fclose(fp);
+        free(data);
+        return 1;
+    }
+    trace_span("xcursor load", start, input_file);
+    
+    fclose(fp);
+    free(data);
+    
+    if (!images || images->nimage == 0) {
+        fprintf(stderr, "Error: No images found in cursor file\n");
+        if (images) XcursorImagesDestroy(images);
+        if (comments) XcursorCommentsDestroy(comments);
+        return 1;
+    }
+    
+    start = trace_now_us();
+    result = write_argb32(choose_frame(images, target_size), target_size, out);
+    fflush(out);
+    trace_span("argb32 copy", start, input_file);
+    
+    XcursorImagesDestroy(images);
+    if (comments) XcursorCommentsDestroy(comments);
+    
+    return result;
+}
+
+int write_argb32(XcursorImage *image, int target_size, FILE *out)
+{
+    int size = image->width > image->height ? image->width : image->height;
+    int width = image->width;
+    int height = image->height;
+    XcursorPixel *scaled;
+    int x, y, sx, sy, shift;
+    int result;
+    
+    /* Scale down to fit target_size keeping the aspect ratio, never up */
+    if (target_size > 0 && size > target_size) {
+        width = image->width * target_size / size;
+        height = image->height * target_size / size;
+        if (width < 1) width = 1;
+        if (height < 1) height = 1;
+    }
+    
+    if (fprintf(out, "ARGB32 %d %d %d\n", width, height, width * 4) < 0) {
+        return 1;
+    }
+    
+    if (width == (int)image->width && height == (int)image->height) {
+        return fwrite(image->pixels, sizeof(XcursorPixel), width * height, out)
+               == (size_t)(width * height) ? 0 : 1;
+    }
+    
+    scaled = malloc(sizeof(XcursorPixel) * width * height);
+    if (!scaled) {
+        return 1;
+    }
+    
+    /* Box filter: each channel is averaged over the source pixels the
+     * target pixel covers. Averages of premultiplied values are still
+     * premultiplied, and working on whole 8-bit lanes of the pixel word
+     * makes this independent of byte order. */
+    for (y = 0; y < height; y++) {
+        int y0 = y * (int)image->height / height;
+        int y1 = (y + 1) * (int)image->height / height;
+        
+        for (x = 0; x < width; x++) {
+            int x0 = x * (int)image->width / width;
+            int x1 = (x + 1) * (int)image->width / width;
+            unsigned int sum[4] = {0, 0, 0, 0};
+            unsigned int count = (x1 - x0) * (y1 - y0);
+            XcursorPixel pixel = 0;
+            
+            for (sy = y0; sy < y1; sy++) {
+                for (sx = x0; sx < x1; sx++) {
+                    XcursorPixel src = image->pixels[sy * image->width + sx];
+                    for (shift = 0; shift < 4; shift++) {
+                        sum[shift] += (src >> (shift * 8)) & 0xFF;
+                    }
+                }
+            }
+            
+            for (shift = 0; shift < 4; shift++) {
+                pixel |= ((sum[shift] + count / 2) / count) << (shift * 8);
+            }
+            scaled[y * width + x] = pixel;
+        }
+    }
+    
+    result = fwrite(scaled, sizeof(XcursorPixel), width * height, out) == (size_t)(width * height) ? 0 : 1;
+    free(scaled);
+    
+    return result;
+}
+
 int save_frame_as_png(XcursorImage *image, const char *filename, int frame_num)
 {
     FILE *fp;
-    png_structp png_ptr;
-    png_infop info_ptr;
-    png_bytep *row_pointers;
-    int x, y;
+    int result;
     
     /* Open output file */
     fp = fopen(filename, "wb");
@@ -162,24 +442,34 @@ int save_frame_as_png(XcursorImage *image, const char *filename, int frame_num)
         return 1;
     }
     
+    result = write_frame_png(image, fp);
+    fclose(fp);
+    
+    return result;
+}
+
+int write_frame_png(XcursorImage *image, FILE *fp)
+{
+    png_structp png_ptr;
+    png_infop info_ptr;
+    png_bytep *row_pointers;
+    int y;
+    
     /* Initialize PNG structures */
     png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png_ptr) {
-        fclose(fp);
         return 1;
     }
     
     info_ptr = png_create_info_struct(png_ptr);
     if (!info_ptr) {
         png_destroy_write_struct(&png_ptr, NULL);
-        fclose(fp);
         return 1;
     }
     
     /* Set up error handling */
     if (setjmp(png_jmpbuf(png_ptr))) {
         png_destroy_write_struct(&png_ptr, &info_ptr);
-        fclose(fp);
         return 1;
     }
     
@@ -202,27 +492,7 @@ int save_frame_as_png(XcursorImage *image, const char *filename, int frame_num)
     
     /* Convert XCursor ARGB data to PNG RGBA data */
     for (y = 0; y < image->height; y++) {
-        png_byte *row = row_pointers[y];
-        for (x = 0; x < image->width; x++) {
-            XcursorPixel pixel = image->pixels[y * image->width + x];
-            
-            /* XCursor uses pre-multiplied alpha, we need to separate it */
-            separate_alpha_pixel(&pixel);
-            
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-            /* XCursor format: ARGB (little-endian) */
-            row[x * 4 + 0] = (pixel >> 16) & 0xFF;  /* R */
-            row[x * 4 + 1] = (pixel >> 8) & 0xFF;   /* G */
-            row[x * 4 + 2] = pixel & 0xFF;          /* B */
-            row[x * 4 + 3] = (pixel >> 24) & 0xFF;  /* A */
-#else
-            /* Big-endian systems */
-            row[x * 4 + 0] = (pixel >> 8) & 0xFF;   /* R */
-            row[x * 4 + 1] = (pixel >> 16) & 0xFF;  /* G */
-            row[x * 4 + 2] = (pixel >> 24) & 0xFF;  /* B */
-            row[x * 4 + 3] = pixel & 0xFF;          /* A */
-#endif
-        }
+        frame_row_to_rgba(image, y, row_pointers[y]);
     }
     
     /* Write PNG data */
@@ -236,52 +506,10 @@ int save_frame_as_png(XcursorImage *image, const char *filename, int frame_num)
     free(row_pointers);
     
     png_destroy_write_struct(&png_ptr, &info_ptr);
-    fclose(fp);
     
     return 0;
 }
 
-void separate_alpha_pixel(XcursorPixel *pixel)
-{
-    unsigned int alpha, red, green, blue;
-    
-    /* Extract components (XCursor format is ARGB) */
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-    blue  = (*pixel) & 0xFF;
-    green = ((*pixel) >> 8) & 0xFF;
-    red   = ((*pixel) >> 16) & 0xFF;
-    alpha = ((*pixel) >> 24) & 0xFF;
-#else
-    alpha = (*pixel) & 0xFF;
-    red   = ((*pixel) >> 8) & 0xFF;
-    green = ((*pixel) >> 16) & 0xFF;
-    blue  = ((*pixel) >> 24) & 0xFF;
-#endif
-    
-    /* If alpha is 0, pixel is fully transparent */
-    if (alpha == 0) {
-        *pixel = 0;
-        return;
-    }
-    
-    /* Separate pre-multiplied alpha (same algorithm as GIMP uses) */
-    red   = (red * 255 + alpha / 2) / alpha;
-    green = (green * 255 + alpha / 2) / alpha;
-    blue  = (blue * 255 + alpha / 2) / alpha;
-    
-    /* Clamp values */
-    if (red > 255) red = 255;
-    if (green > 255) green = 255;
-    if (blue > 255) blue = 255;
-    
-    /* Reconstruct pixel */
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-    *pixel = blue | (green << 8) | (red << 16) | (alpha << 24);
-#else
-    *pixel = alpha | (red << 8) | (green << 16) | (blue << 24);
-#endif
-}
-
 int create_directory(const char *path)
 {
     struct stat st = {0};
@@ -306,10 +534,435 @@ int create_directory(const char *path)
     return 0;
 }
 
+/* Parse "24,32,48" into sizes; returns the count */
+int parse_size_list(const char *list, int *sizes, int max_sizes)
+{
+    int count = 0;
+    char *end;
+    
+    while (list && *list && count < max_sizes) {
+        long size = strtol(list, &end, 10);
+        if (end == list) {
+            break;
+        }
+        if (size > 0) {
+            sizes[count++] = (int)size;
+        }
+        list = *end == ',' ? end + 1 : end;
+    }
+    
+    return count;
+}
+
+int read_whole_file(const char *path, unsigned char **data, size_t *len)
+{
+    FILE *fp;
+    struct stat st;
+    
+    fp = fopen(path, "rb");
+    if (!fp) {
+        return 1;
+    }
+    if (fstat(fileno(fp), &st) != 0) {
+        fclose(fp);
+        return 1;
+    }
+    
+    *len = st.st_size;
+    *data = malloc(*len ? *len : 1);
+    if (!*data || fread(*data, 1, *len, fp) != *len) {
+        free(*data);
+        *data = NULL;
+        fclose(fp);
+        return 1;
+    }
+    
+    fclose(fp);
+    return 0;
+}
+
+int read_whole_stream(FILE *fp, unsigned char **data, size_t *len)
+{
+    size_t capacity = 65536;
+    size_t got;
+    unsigned char *grown;
+    
+    *len = 0;
+    *data = malloc(capacity);
+    if (!*data) {
+        return 1;
+    }
+    
+    while ((got = fread(*data + *len, 1, capacity - *len, fp)) > 0) {
+        *len += got;
+        if (*len == capacity) {
+            capacity *= 2;
+            grown = realloc(*data, capacity);
+            if (!grown) {
+                free(*data);
+                *data = NULL;
+                return 1;
+            }
+            *data = grown;
+        }
+    }
+    
+    if (ferror(fp)) {
+        free(*data);
+        *data = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+int write_whole_file(const char *path, const unsigned char *data, size_t len)
+{
+    FILE *fp = fopen(path, "wb");
+    int result;
+    
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot create '%s': %s\n", path, strerror(errno));
+        return 1;
+    }
+    
+    result = fwrite(data, 1, len, fp) == len ? 0 : 1;
+    if (fclose(fp) != 0) {
+        result = 1;
+    }
+    return result;
+}
+
+/* Rewrite one cursor: keep only the nominal sizes nearest to the wanted
+ * ones and fold identical consecutive frames into one longer frame.
+ * Files libXcursor cannot parse are copied unchanged. */
+int optimize_cursor_file(const unsigned char *data, size_t len, const char *output_path,
+                         const int *sizes, int nsizes, OptimizeStats *stats)
+{
+    FILE *in, *out;
+    XcursorImages *images = NULL;
+    XcursorComments *comments = NULL;
+    XcursorComments no_comments = { 0, NULL };
+    XcursorImages kept;
+    XcursorDim keep_sizes[MAX_OPTIMIZE_SIZES];
+    XcursorImage *last;
+    struct stat st;
+    int i, j, keep;
+    int result = 0;
+    
+    in = fmemopen((void *)data, len, "rb");
+    if (!in || !XcursorFileLoad(in, &comments, &images) || !images || images->nimage == 0) {
+        if (in) fclose(in);
+        if (images) XcursorImagesDestroy(images);
+        if (comments) XcursorCommentsDestroy(comments);
+        stats->bytes_after += len;
+        return write_whole_file(output_path, data, len);
+    }
+    fclose(in);
+    
+    for (i = 0; i < nsizes; i++) {
+        keep_sizes[i] = nearest_nominal_size(images, sizes[i]);
+    }
+    
+    kept.nimage = 0;
+    kept.name = NULL;
+    kept.images = malloc(sizeof(XcursorImage *) * images->nimage);
+    if (!kept.images) {
+        XcursorImagesDestroy(images);
+        if (comments) XcursorCommentsDestroy(comments);
+        return 1;
+    }
+    
+    for (i = 0; i < images->nimage; i++) {
+        XcursorImage *img = images->images[i];
+        
+        keep = nsizes == 0;
+        for (j = 0; j < nsizes && !keep; j++) {
+            keep = img->size == keep_sizes[j];
+        }
+        if (!keep) {
+            stats->frames_stripped++;
+            continue;
+        }
+        
+        /* The previous frame of this size, i.e. the one before it in the
+         * animation */
+        last = NULL;
+        for (j = kept.nimage - 1; j >= 0; j--) {
+            if (kept.images[j]->size == img->size) {
+                last = kept.images[j];
+                break;
+            }
+        }
+        
+        if (last && last->width == img->width && last->height == img->height &&
+            last->xhot == img->xhot && last->yhot == img->yhot &&
+            memcmp(last->pixels, img->pixels, sizeof(XcursorPixel) * img->width * img->height) == 0) {
+            last->delay += img->delay;
+            stats->frames_merged++;
+            continue;
+        }
+        
+        kept.images[kept.nimage++] = img;
+    }
+    
+    out = fopen(output_path, "wb");
+    if (!out || !XcursorFileSave(out, comments ? comments : &no_comments, &kept)) {
+        fprintf(stderr, "Error: Cannot write '%s'\n", output_path);
+        result = 1;
+    }
+    if (out && fclose(out) != 0) {
+        result = 1;
+    }
+    
+    /* Files whose chunks were already shared can only grow when rewritten */
+    if (result == 0 && stat(output_path, &st) == 0 && (size_t)st.st_size >= len) {
+        result = write_whole_file(output_path, data, len);
+        st.st_size = len;
+    }
+    if (result == 0) {
+        stats->bytes_after += st.st_size;
+    }
+    
+    free(kept.images);
+    XcursorImagesDestroy(images);
+    if (comments) XcursorCommentsDestroy(comments);
+    
+    return result;
+}
+
+/* Time XcursorLibraryLoadImages over every cursor name in a theme, the
+ * lookup each X client does. libXcursor reads XCURSOR_PATH once per
+ * process, so each measurement runs in a child of its own. Returns the
+ * fastest of a few rounds in milliseconds, or -1 on failure. */
+double measure_theme_load(const char *theme_dir, char **names, int nnames, int size)
+{
+    char path[PATH_MAX];
+    char *theme;
+    int fds[2];
+    int status;
+    double best = -1;
+    pid_t pid;
+    
+    if (!realpath(theme_dir, path) || pipe(fds) != 0) {
+        return -1;
+    }
+    theme = strrchr(path, '/');
+    *theme++ = '\0';
+    
+    pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    
+    if (pid == 0) {
+        int round, i;
+        
+        close(fds[0]);
+        setenv("XCURSOR_PATH", path[0] ? path : "/", 1);
+        for (round = 0; round < 5; round++) {
+            double start = monotonic_us();
+            double elapsed;
+            
+            for (i = 0; i < nnames; i++) {
+                XcursorImages *images = XcursorLibraryLoadImages(names[i], theme, size);
+                if (images) XcursorImagesDestroy(images);
+            }
+            elapsed = (monotonic_us() - start) / 1000.0;
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        _exit(write(fds[1], &best, sizeof(best)) == (ssize_t)sizeof(best) ? 0 : 1);
+    }
+    
+    close(fds[1]);
+    /* A short read or a child that could not report leaves no measurement */
+    if (read(fds[0], &best, sizeof(best)) != (ssize_t)sizeof(best)) {
+        best = -1;
+    }
+    close(fds[0]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        best = -1;
+    }
+    
+    return best;
+}
+
+int optimize_theme(const char *theme_dir, const char *output_dir, const char *size_list)
+{
+    char cursors_dir[PATH_MAX];
+    char output_cursors[PATH_MAX];
+    char path[PATH_MAX + NAME_MAX + 2];
+    char output_path[PATH_MAX + NAME_MAX + 2];
+    char link_target[PATH_MAX];
+    int sizes[MAX_OPTIMIZE_SIZES];
+    int nsizes = parse_size_list(size_list, sizes, MAX_OPTIMIZE_SIZES);
+    int measure_size = nsizes ? sizes[0] : 24;
+    OptimizeStats stats = {0};
+    CursorFile *files = NULL;
+    char **names = NULL;
+    int nfiles = 0, capacity = 0;
+    int failed = 0;
+    double before_ms, after_ms;
+    struct dirent *entry;
+    struct stat st;
+    DIR *dir;
+    int i, j;
+    
+    snprintf(cursors_dir, sizeof(cursors_dir), "%s/cursors", theme_dir);
+    snprintf(output_cursors, sizeof(output_cursors), "%s/cursors", output_dir);
+    
+    dir = opendir(cursors_dir);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", cursors_dir, strerror(errno));
+        return 1;
+    }
+    if (create_directory(output_dir) != 0 || create_directory(output_cursors) != 0) {
+        closedir(dir);
+        return 1;
+    }
+    
+    while ((entry = readdir(dir)) != NULL) {
+        CursorFile *file;
+        
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if (nfiles == capacity) {
+            CursorFile *grown;
+            
+            capacity = capacity ? capacity * 2 : 128;
+            grown = realloc(files, sizeof(CursorFile) * capacity);
+            if (!grown) {
+                failed = 1;
+                break;
+            }
+            files = grown;
+        }
+        
+        file = &files[nfiles];
+        memset(file, 0, sizeof(*file));
+        snprintf(file->name, sizeof(file->name), "%s", entry->d_name);
+        snprintf(path, sizeof(path), "%s/%s", cursors_dir, entry->d_name);
+        
+        if (lstat(path, &st) != 0) {
+            continue;
+        }
+        if (S_ISLNK(st.st_mode)) {
+            file->is_link = 1;
+        } else if (!S_ISREG(st.st_mode) || read_whole_file(path, &file->data, &file->len) != 0) {
+            continue;
+        }
+        nfiles++;
+    }
+    closedir(dir);
+    
+    names = malloc(sizeof(char *) * (nfiles ? nfiles : 1));
+    if (failed || !names) {
+        fprintf(stderr, "Error: Out of memory\n");
+        goto out;
+    }
+    for (i = 0; i < nfiles; i++) {
+        names[i] = files[i].name;
+    }
+    before_ms = measure_theme_load(theme_dir, names, nfiles, measure_size);
+    
+    for (i = 0; i < nfiles && !failed; i++) {
+        CursorFile *file = &files[i];
+        ssize_t target_len;
+        
+        snprintf(path, sizeof(path), "%s/%s", cursors_dir, file->name);
+        snprintf(output_path, sizeof(output_path), "%s/%s", output_cursors, file->name);
+        unlink(output_path);
+        
+        if (file->is_link) {
+            target_len = readlink(path, link_target, sizeof(link_target) - 1);
+            if (target_len < 0) {
+                continue;
+            }
+            link_target[target_len] = '\0';
+            failed = symlink(link_target, output_path) != 0;
+            stats.symlinks++;
+            continue;
+        }
+        
+        stats.files++;
+        stats.bytes_before += file->len;
+        file->hash = hash_bytes(file->data, file->len);
+        
+        /* A byte-for-byte copy of an earlier cursor becomes a symlink */
+        for (j = 0; j < i; j++) {
+            CursorFile *other = &files[j];
+            if (!other->is_link && !other->linked && other->len == file->len &&
+                other->hash == file->hash && memcmp(other->data, file->data, file->len) == 0) {
+                file->linked = 1;
+                break;
+            }
+        }
+        if (file->linked) {
+            failed = symlink(files[j].name, output_path) != 0;
+            stats.linked++;
+            continue;
+        }
+        
+        failed = optimize_cursor_file(file->data, file->len, output_path, sizes, nsizes, &stats);
+    }
+    
+    if (failed) {
+        fprintf(stderr, "Error: Writing '%s' failed: %s\n", output_dir, strerror(errno));
+        goto out;
+    }
+    
+    /* index.theme, cursor.theme and the like */
+    dir = opendir(theme_dir);
+    while (dir && (entry = readdir(dir)) != NULL) {
+        unsigned char *data;
+        size_t len;
+        
+        snprintf(path, sizeof(path), "%s/%s", theme_dir, entry->d_name);
+        if (entry->d_name[0] == '.' || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (read_whole_file(path, &data, &len) == 0) {
+            snprintf(output_path, sizeof(output_path), "%s/%s", output_dir, entry->d_name);
+            failed |= write_whole_file(output_path, data, len);
+            free(data);
+        }
+    }
+    if (dir) closedir(dir);
+    
+    after_ms = measure_theme_load(output_dir, names, nfiles, measure_size);
+    
+    printf("Optimized %d cursor file(s): %d duplicate(s) symlinked, %d frame(s) merged, "
+           "%d frame(s) outside the kept sizes dropped, %d symlink(s) kept\n",
+           stats.files, stats.linked, stats.frames_merged, stats.frames_stripped, stats.symlinks);
+    printf("Size: %.1f KiB -> %.1f KiB (%.1f%% smaller)\n",
+           stats.bytes_before / 1024.0, stats.bytes_after / 1024.0,
+           stats.bytes_before ? 100.0 * (stats.bytes_before - stats.bytes_after) / stats.bytes_before : 0.0);
+    if (before_ms >= 0 && after_ms >= 0) {
+        printf("XcursorLibraryLoadImages at %dpx, all %d names: %.2f ms -> %.2f ms\n",
+               measure_size, nfiles, before_ms, after_ms);
+    }
+    
+out:
+    for (i = 0; i < nfiles; i++) {
+        free(files[i].data);
+    }
+    free(files);
+    free(names);
+    
+    return failed ? 1 : 0;
+}
+
 void print_usage(const char *program_name)
 {
     printf("XCursor Frame Extractor\n");
     printf("Usage: %s <input_cursor_file> <output_directory>\n", program_name);
+    printf("       %s --stdout <input_cursor_file>\n", program_name);
+    printf("       %s --argb32 <input_cursor_file> [size]\n", program_name);
+    printf("       %s --optimize <theme_dir> <output_dir> [size,size,...]\n", program_name);
     printf("\n");
     printf("Extracts all frames from an XCursor file and saves them as PNG images.\n");
     printf("\n");
@@ -319,4 +972,123 @@ void print_usage(const char *program_name)
     printf("Output files:\n");
     printf("  frame_001.png, frame_002.png, ... - Individual cursor frames\n");
     printf("  cursor_info.txt - Metadata about the cursor\n");
+    printf("\n");
+    printf("With --stdout, only the largest frame is written to standard output as PNG.\n");
+    printf("With --argb32, one frame scaled to fit size is written to standard output as\n");
+    printf("premultiplied native-endian ARGB32 (Cairo's image layout) after a header line\n");
+    printf("\"ARGB32 <width> <height> <stride>\". An input file of - is read from stdin.\n");
+    printf("With --optimize, a copy of the theme is written to output_dir with duplicate\n");
+    printf("cursors symlinked, repeated frames merged and, given sizes, other nominal sizes\n");
+    printf("dropped; the size and load time saved are reported.\n");
+}
+
+void trace_open(void)
+{
+    const char *path = getenv("CSM_TRACE");
+    char line[128];
+    int len;
+    
+    if (!path || !*path) {
+        return;
+    }
+    
+    /* Only join a trace a manager has already started */
+    trace_fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (trace_fd < 0) {
+        return;
+    }
+    
+    len = snprintf(line, sizeof(line),
+                   "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                   "\"args\":{\"name\":\"xcursor_extractor\"}},\n",
+                   (int)getpid(), (int)getpid());
+    if (len > 0 && len < (int)sizeof(line)) {
+        trace_write(line, len);
+    }
+}
+
+/* Append one event line; tracing stops if the file cannot take it */
+void trace_write(const char *line, int len)
+{
+    while (len > 0) {
+        ssize_t written = write(trace_fd, line, len);
+        
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            close(trace_fd);
+            trace_fd = -1;
+            return;
+        }
+        line += written;
+        len -= written;
+    }
+}
+
+double trace_now_us(void)
+{
+    if (trace_fd < 0) {
+        return 0;
+    }
+    
+    return monotonic_us();
+}
+
+double monotonic_us(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* FNV-1a, only used to skip most byte comparisons between files */
+unsigned long long hash_bytes(const unsigned char *data, size_t len)
+{
+    unsigned long long hash = 0xcbf29ce484222325ull;
+    size_t i;
+    
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    
+    return hash;
+}
+
+/* Append a complete ("X") event from start_us until now */
+void trace_span(const char *name, double start_us, const char *file)
+{
+    char escaped[1024];
+    char line[1536];
+    size_t i, j = 0;
+    int len;
+    
+    if (trace_fd < 0) {
+        return;
+    }
+    
+    /* JSON-escape the file argument, dropping control characters */
+    for (i = 0; file[i] && j < sizeof(escaped) - 2; i++) {
+        unsigned char c = (unsigned char)file[i];
+        if (c < 0x20) {
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            escaped[j++] = '\\';
+        }
+        escaped[j++] = c;
+    }
+    escaped[j] = '\0';
+    
+    len = snprintf(line, sizeof(line),
+                   "{\"name\":\"%s\",\"cat\":\"csm\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,"
+                   "\"pid\":%d,\"tid\":%d,\"args\":{\"file\":\"%s\"}},\n",
+                   name, start_us, trace_now_us() - start_us,
+                   (int)getpid(), (int)getpid(), escaped);
+    
+    /* One write per event keeps lines whole next to other writers */
+    if (len > 0 && len < (int)sizeof(line)) {
+        trace_write(line, len);
+    }
 }